@@ -16,6 +16,7 @@
 #include <beast/core/buffers_adapter.hpp>
 #include <beast/core/consuming_buffers.hpp>
 #include <beast/core/error.hpp>
+#include <beast/core/flat_streambuf.hpp>
 #include <beast/core/handler_alloc.hpp>
 #include <beast/core/handler_concepts.hpp>
 #include <beast/core/placeholders.hpp>
@@ -250,10 +250,35 @@ public:
     void
     commit(size_type n);
 
-    /// Remove bytes from the input sequence.
+    /** Remove bytes from the input sequence.
+
+        If this leaves both the input and the output sequence empty,
+        the storage is rewound: the next output sequence starts at
+        the beginning of the last allocated buffer, instead of where
+        the input sequence ended. A call to `prepare(0)` empties the
+        output sequence, so `prepare(0)` followed by `consume(0)`
+        rewinds a buffer whose input sequence is empty.
+
+        @note Buffers representing the input sequence acquired prior to
+        this call remain valid, except those for the bytes removed.
+    */
     void
     consume(size_type n);
 
+    /** Make room for an output sequence of `n` bytes in one buffer.
+
+        After this call, a call to `prepare` for no more than `n`
+        bytes returns a single buffer, unless the input sequence
+        ends inside an allocated buffer with less than `n` bytes
+        of space after it. Unused buffers which are too small are
+        released.
+
+        @note Buffers representing the input sequence acquired prior to
+        this call remain valid.
+    */
+    void
+    reserve(size_type n);
+
     // Helper for boost::asio::read_until
     template<class OtherAllocator>
     friend
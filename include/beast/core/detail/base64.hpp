@@ -9,6 +9,8 @@
 #define BEAST_DETAIL_BASE64_HPP
 
 #include <cctype>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace beast {
@@ -112,6 +114,53 @@ base64_encode (std::uint8_t const* data,
 
 }
 
+/// Returns the number of characters needed to encode `len` bytes
+inline
+std::size_t constexpr
+base64_encoded_size(std::size_t len)
+{
+    return 4 * ((len + 2) / 3);
+}
+
+/** Encode into a caller provided buffer.
+
+    `dest` must have room for `base64_encoded_size(len)`
+    characters. No null terminator is written.
+
+    @return The number of characters written.
+*/
+template <class = void>
+std::size_t
+base64_encode (char* dest, std::uint8_t const* data,
+    std::size_t len)
+{
+    char const* alphabet (base64_alphabet().data());
+    auto out = dest;
+    for(; len >= 3; len -= 3, data += 3)
+    {
+        *out++ = alphabet[data[0] >> 2];
+        *out++ = alphabet[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+        *out++ = alphabet[((data[1] & 0x0f) << 2) | (data[2] >> 6)];
+        *out++ = alphabet[data[2] & 0x3f];
+    }
+    if(len > 0)
+    {
+        *out++ = alphabet[data[0] >> 2];
+        if(len == 1)
+        {
+            *out++ = alphabet[(data[0] & 0x03) << 4];
+            *out++ = '=';
+        }
+        else
+        {
+            *out++ = alphabet[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+            *out++ = alphabet[(data[1] & 0x0f) << 2];
+        }
+        *out++ = '=';
+    }
+    return static_cast<std::size_t>(out - dest);
+}
+
 template <class = void>
 std::string
 base64_encode (std::string const& s)
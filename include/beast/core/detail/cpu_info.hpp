@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_DETAIL_CPU_INFO_HPP
+#define BEAST_DETAIL_CPU_INFO_HPP
+
+// Define BEAST_NO_SIMD to disable all vectorized code paths
+//
+#ifndef BEAST_NO_SIMD
+# if defined(__x86_64__) || defined(_M_X64) || \
+    (defined(__i386__) && defined(__SSE2__)) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define BEAST_SIMD_X86 1
+# endif
+#endif
+
+#ifndef BEAST_SIMD_X86
+# define BEAST_SIMD_X86 0
+#endif
+
+#if BEAST_SIMD_X86
+# if defined(_MSC_VER)
+#  include <intrin.h>
+#  define BEAST_TARGET_SSE42
+#  define BEAST_TARGET_AVX2
+# else
+#  include <immintrin.h>
+#  define BEAST_TARGET_SSE42 __attribute__((target("sse4.2")))
+#  define BEAST_TARGET_AVX2 __attribute__((target("avx2")))
+# endif
+#endif
+
+namespace beast {
+namespace detail {
+
+// Instruction set extensions available at runtime
+//
+struct cpu_info
+{
+    bool sse2 = false;
+    bool sse42 = false;
+    bool avx2 = false;
+
+    cpu_info();
+};
+
+inline
+cpu_info::cpu_info()
+{
+#if BEAST_SIMD_X86
+# if defined(_MSC_VER)
+    int r[4];
+    __cpuid(r, 0);
+    auto const max_leaf = r[0];
+    __cpuid(r, 1);
+    sse2  = (r[3] & (1 << 26)) != 0;
+    sse42 = (r[2] & (1 << 20)) != 0;
+    // AVX also requires the OS to save the YMM registers
+    bool const os_avx =
+        (r[2] & (1 << 27)) != 0 &&      // OSXSAVE
+        (r[2] & (1 << 28)) != 0 &&      // AVX
+        (_xgetbv(0) & 6) == 6;
+    if(os_avx && max_leaf >= 7)
+    {
+        __cpuidex(r, 7, 0);
+        avx2 = (r[1] & (1 << 5)) != 0;
+    }
+# else
+    __builtin_cpu_init();
+    sse2  = __builtin_cpu_supports("sse2") != 0;
+    sse42 = __builtin_cpu_supports("sse4.2") != 0;
+    avx2  = __builtin_cpu_supports("avx2") != 0;
+# endif
+#endif
+}
+
+// Returns the instruction sets supported by the CPU.
+// The detection happens once, on first use.
+//
+template<class = void>
+cpu_info const&
+get_cpu_info()
+{
+    static cpu_info const ci;
+    return ci;
+}
+
+} // detail
+} // beast
+
+#endif
@@ -0,0 +1,199 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_FLAT_STREAMBUF_HPP
+#define BEAST_FLAT_STREAMBUF_HPP
+
+#include <beast/core/detail/empty_base_optimization.hpp>
+#include <boost/asio/buffer.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace beast {
+
+/** A @b `DynamicBuffer` that uses a single contiguous buffer.
+
+    The input and output sequences are kept in one character array,
+    so that each is always represented by a single buffer. When there
+    is no room after the output sequence, the input sequence is first
+    moved to the front of the array, and the array is reallocated
+    only when that is not enough.
+
+    Nothing is allocated until the first call to `prepare`, and an
+    idle buffer may return its memory with @ref shrink_to_fit.
+
+    @note Meets the requirements of @b `DynamicBuffer`.
+
+    @tparam Allocator The allocator to use for managing memory.
+*/
+template<class Allocator>
+class basic_flat_streambuf
+#if ! GENERATING_DOCS
+    : private detail::empty_base_optimization<
+        typename std::allocator_traits<Allocator>::
+            template rebind_alloc<std::uint8_t>>
+#endif
+{
+public:
+#if GENERATING_DOCS
+    /// The type of allocator used.
+    using allocator_type = Allocator;
+#else
+    using allocator_type = typename
+        std::allocator_traits<Allocator>::
+            template rebind_alloc<std::uint8_t>;
+#endif
+
+private:
+    using alloc_traits = std::allocator_traits<allocator_type>;
+
+    std::uint8_t* begin_ = nullptr;
+    std::uint8_t* in_ = nullptr;
+    std::uint8_t* out_ = nullptr;
+    std::uint8_t* last_ = nullptr;
+    std::uint8_t* end_ = nullptr;
+
+public:
+    /// The type used to represent the input sequence as a list of buffers.
+    using const_buffers_type = boost::asio::const_buffers_1;
+
+    /// The type used to represent the output sequence as a list of buffers.
+    using mutable_buffers_type = boost::asio::mutable_buffers_1;
+
+    /// Destructor.
+    ~basic_flat_streambuf();
+
+    /** Move constructor.
+
+        The new object will have the input sequence of
+        the other stream buffer, and an empty output sequence.
+
+        @note After the move, the moved-from object will have
+        an empty input and output sequence, with no internal
+        buffer allocated.
+    */
+    basic_flat_streambuf(basic_flat_streambuf&&);
+
+    /** Move assignment.
+
+        This object will have the input sequence of
+        the other stream buffer, and an empty output sequence.
+
+        @note After the move, the moved-from object will have
+        an empty input and output sequence, with no internal
+        buffer allocated.
+    */
+    basic_flat_streambuf&
+    operator=(basic_flat_streambuf&&);
+
+    basic_flat_streambuf(basic_flat_streambuf const&) = delete;
+    basic_flat_streambuf& operator=(basic_flat_streambuf const&) = delete;
+
+    /** Construct a stream buffer.
+
+        @param alloc The allocator to use. If this parameter is
+        unspecified, a default constructed allocator will be used.
+    */
+    explicit
+    basic_flat_streambuf(Allocator const& alloc = allocator_type{});
+
+    /// Returns a copy of the associated allocator.
+    allocator_type
+    get_allocator() const
+    {
+        return this->member();
+    }
+
+    /// Returns the size of the input sequence.
+    std::size_t
+    size() const
+    {
+        return static_cast<std::size_t>(out_ - in_);
+    }
+
+    /// Returns the permitted maximum sum of the sizes of the input and output sequence.
+    std::size_t
+    max_size() const
+    {
+        return alloc_traits::max_size(this->member());
+    }
+
+    /// Returns the maximum sum of the sizes of the input sequence and output sequence the buffer can hold without requiring reallocation.
+    std::size_t
+    capacity() const
+    {
+        return static_cast<std::size_t>(end_ - begin_);
+    }
+
+    /// Get a list of buffers that represents the input sequence.
+    const_buffers_type
+    data() const
+    {
+        return {in_, size()};
+    }
+
+    /** Get a list of buffers that represents the output sequence, with the given size.
+
+        @throws std::length_error if the size would exceed the limit
+        imposed by the allocator.
+
+        @note Buffers representing the input sequence acquired prior
+        to this call are invalidated.
+    */
+    mutable_buffers_type
+    prepare(std::size_t n);
+
+    /// Move bytes from the output sequence to the input sequence.
+    void
+    commit(std::size_t n)
+    {
+        out_ += std::min<std::size_t>(n, last_ - out_);
+    }
+
+    /// Remove bytes from the input sequence.
+    void
+    consume(std::size_t n);
+
+    /** Release the memory not used by the input sequence.
+
+        The buffer is reallocated to fit the input sequence exactly,
+        and freed when the input sequence is empty. Buffers acquired
+        prior to this call are invalidated.
+    */
+    void
+    shrink_to_fit();
+
+private:
+    void
+    move_assign(basic_flat_streambuf& other, std::false_type);
+
+    void
+    move_assign(basic_flat_streambuf& other, std::true_type);
+
+    void
+    steal(basic_flat_streambuf& other);
+
+    void
+    reallocate(std::size_t size);
+};
+
+// Helper for boost::asio::read_until
+template<class Allocator>
+std::size_t
+read_size_helper(basic_flat_streambuf<
+    Allocator> const& streambuf, std::size_t max_size);
+
+/// A flat stream buffer using the default allocator.
+using flat_streambuf = basic_flat_streambuf<std::allocator<char>>;
+
+} // beast
+
+#include <beast/core/impl/flat_streambuf.ipp>
+
+#endif
@@ -716,8 +716,9 @@ basic_streambuf<Allocator>::consume(size_type n)
                 }
                 else
                 {
-                    // Input and output sequences are empty, reuse buffer.
-                    // Alternatively we could deallocate it.
+                    // Input and output sequences are empty, reuse
+                    // buffer. This rewind is part of the contract,
+                    // streams rely on it to avoid allocations.
                     in_pos_ = 0;
                     out_pos_ = 0;
                     out_end_ = 0;
@@ -729,6 +730,40 @@ basic_streambuf<Allocator>::consume(size_type n)
     }
 }
 
+template<class Allocator>
+void
+basic_streambuf<Allocator>::reserve(size_type n)
+{
+    if(out_ == list_.end())
+    {
+        // prepare allocates a new buffer of at least n
+        return;
+    }
+    if(out_->size() - out_pos_ >= n)
+        return;
+    if(out_pos_ > 0)
+    {
+        // the output sequence must continue the input
+        return;
+    }
+    // The buffers from out_ on hold no input,
+    // release them so prepare allocates one of n.
+    for(auto it = out_; it != list_.end();)
+    {
+        auto& e = *it++;
+        list_.erase(list_.iterator_to(e));
+        auto const len = e.size() + sizeof(e);
+        alloc_traits::destroy(this->member(), &e);
+        alloc_traits::deallocate(this->member(),
+            reinterpret_cast<std::uint8_t*>(&e), len);
+    }
+    out_ = list_.end();
+    if(list_.empty())
+        in_pos_ = 0;
+    out_end_ = 0;
+    debug_check();
+}
+
 template<class Allocator>
 void
 basic_streambuf<Allocator>::
@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_IMPL_FLAT_STREAMBUF_IPP
+#define BEAST_IMPL_FLAT_STREAMBUF_IPP
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace beast {
+
+template<class Allocator>
+basic_flat_streambuf<Allocator>::
+~basic_flat_streambuf()
+{
+    if(begin_)
+        alloc_traits::deallocate(
+            this->member(), begin_, capacity());
+}
+
+template<class Allocator>
+basic_flat_streambuf<Allocator>::
+basic_flat_streambuf(basic_flat_streambuf&& other)
+    : detail::empty_base_optimization<allocator_type>(
+        std::move(other.member()))
+{
+    steal(other);
+}
+
+template<class Allocator>
+auto
+basic_flat_streambuf<Allocator>::
+operator=(basic_flat_streambuf&& other) ->
+    basic_flat_streambuf&
+{
+    if(this != &other)
+        move_assign(other, std::integral_constant<bool,
+            alloc_traits::propagate_on_container_move_assignment::value>{});
+    return *this;
+}
+
+template<class Allocator>
+basic_flat_streambuf<Allocator>::
+basic_flat_streambuf(Allocator const& alloc)
+    : detail::empty_base_optimization<allocator_type>(alloc)
+{
+}
+
+template<class Allocator>
+auto
+basic_flat_streambuf<Allocator>::
+prepare(std::size_t n) ->
+    mutable_buffers_type
+{
+    if(n <= static_cast<std::size_t>(end_ - out_))
+    {
+        last_ = out_ + n;
+        return {out_, n};
+    }
+    auto const len = size();
+    if(n <= capacity() - len)
+    {
+        // make room by moving the input sequence to the front
+        if(len > 0)
+            std::memmove(begin_, in_, len);
+        in_ = begin_;
+        out_ = in_ + len;
+        last_ = out_ + n;
+        return {out_, n};
+    }
+    if(n > max_size() - len)
+        throw std::length_error{"flat_streambuf overflow"};
+    reallocate(std::max<std::size_t>(len + n,
+        std::min<std::size_t>(2 * capacity(), max_size())));
+    last_ = out_ + n;
+    return {out_, n};
+}
+
+template<class Allocator>
+void
+basic_flat_streambuf<Allocator>::
+consume(std::size_t n)
+{
+    if(n >= size())
+    {
+        // rewind, so the whole buffer is available
+        in_ = begin_;
+        out_ = begin_;
+        last_ = begin_;
+        return;
+    }
+    in_ += n;
+}
+
+template<class Allocator>
+void
+basic_flat_streambuf<Allocator>::
+shrink_to_fit()
+{
+    if(size() == capacity())
+        return;
+    reallocate(size());
+    last_ = out_;
+}
+
+template<class Allocator>
+void
+basic_flat_streambuf<Allocator>::
+move_assign(basic_flat_streambuf& other, std::false_type)
+{
+    if(this->member() != other.member())
+    {
+        // the memory cannot change hands, copy the input sequence
+        auto const len = other.size();
+        consume(size());
+        if(len > 0)
+        {
+            auto const mb = prepare(len);
+            std::memcpy(boost::asio::buffer_cast<void*>(mb),
+                other.in_, len);
+            commit(len);
+        }
+        other.consume(len);
+        other.shrink_to_fit();
+        return;
+    }
+    move_assign(other, std::true_type{});
+}
+
+template<class Allocator>
+void
+basic_flat_streambuf<Allocator>::
+move_assign(basic_flat_streambuf& other, std::true_type)
+{
+    if(begin_)
+        alloc_traits::deallocate(
+            this->member(), begin_, capacity());
+    this->member() = std::move(other.member());
+    steal(other);
+}
+
+template<class Allocator>
+void
+basic_flat_streambuf<Allocator>::
+steal(basic_flat_streambuf& other)
+{
+    begin_ = other.begin_;
+    in_ = other.in_;
+    out_ = other.out_;
+    last_ = other.out_;
+    end_ = other.end_;
+    other.begin_ = nullptr;
+    other.in_ = nullptr;
+    other.out_ = nullptr;
+    other.last_ = nullptr;
+    other.end_ = nullptr;
+}
+
+template<class Allocator>
+void
+basic_flat_streambuf<Allocator>::
+reallocate(std::size_t size)
+{
+    auto const len = this->size();
+    std::uint8_t* p = nullptr;
+    if(size > 0)
+    {
+        p = alloc_traits::allocate(this->member(), size);
+        if(len > 0)
+            std::memcpy(p, in_, len);
+    }
+    if(begin_)
+        alloc_traits::deallocate(
+            this->member(), begin_, capacity());
+    begin_ = p;
+    in_ = p;
+    out_ = p + len;
+    last_ = out_;
+    end_ = p + size;
+}
+
+template<class Allocator>
+std::size_t
+read_size_helper(basic_flat_streambuf<
+    Allocator> const& streambuf, std::size_t max_size)
+{
+    auto const avail = streambuf.capacity() - streambuf.size();
+    if(avail == 0)
+        return std::min(max_size,
+            std::max<std::size_t>(512, streambuf.capacity()));
+    return std::min(max_size, avail);
+}
+
+} // beast
+
+#endif
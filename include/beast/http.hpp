@@ -12,9 +12,12 @@
 #include <beast/http/basic_parser_v1.hpp>
 #include <beast/http/body_type.hpp>
 #include <beast/http/empty_body.hpp>
+#include <beast/http/field.hpp>
+#include <beast/http/flat_headers.hpp>
 #include <beast/http/headers.hpp>
 #include <beast/http/message.hpp>
 #include <beast/http/message_v1.hpp>
+#include <beast/http/message_view.hpp>
 #include <beast/http/parse_error.hpp>
 #include <beast/http/parser_v1.hpp>
 #include <beast/http/read.hpp>
@@ -23,6 +26,7 @@
 #include <beast/http/rfc7230.hpp>
 #include <beast/http/streambuf_body.hpp>
 #include <beast/http/string_body.hpp>
+#include <beast/http/view_parser_v1.hpp>
 #include <beast/http/write.hpp>
 
 #endif
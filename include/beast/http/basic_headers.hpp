@@ -10,11 +10,13 @@
 
 #include <beast/core/detail/ci_char_traits.hpp>
 #include <beast/core/detail/empty_base_optimization.hpp>
+#include <beast/http/field.hpp>
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/utility/string_ref.hpp>
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <memory>
 #include <string>
@@ -70,10 +72,12 @@ protected:
                 boost::intrusive::normal_link>>
     {
         value_type data;
+        field id;
 
-        element(boost::string_ref const& name,
+        element(field id_, boost::string_ref const& name,
                 boost::string_ref const& value)
             : data(name, value)
+            , id(id_)
         {
         }
     };
@@ -109,14 +113,48 @@ protected:
         element, boost::intrusive::constant_time_size<true>,
             boost::intrusive::compare<less>>::type;
 
+    // The first element of each well-known field in insertion
+    // order, indexed by enum value. The slot for field::unknown
+    // is always null.
+    using known_t = std::array<element*, field_count + 1>;
+
     // data
     set_t set_;
     list_t list_;
+    known_t known_;
+
+    basic_headers_base()
+    {
+        known_.fill(nullptr);
+    }
+
+    basic_headers_base(basic_headers_base&& other)
+        : set_(std::move(other.set_))
+        , list_(std::move(other.list_))
+        , known_(other.known_)
+    {
+        other.known_.fill(nullptr);
+    }
+
+    void
+    move_from(basic_headers_base& other)
+    {
+        set_ = std::move(other.set_);
+        list_ = std::move(other.list_);
+        known_ = other.known_;
+        other.known_.fill(nullptr);
+    }
 
-    basic_headers_base(set_t&& set, list_t&& list)
-        : set_(std::move(set))
-        , list_(std::move(list))
+    element*&
+    known(field f)
     {
+        return known_[static_cast<std::size_t>(f)];
+    }
+
+    element const*
+    known(field f) const
+    {
+        return known_[static_cast<std::size_t>(f)];
     }
 
 public:
@@ -124,8 +162,6 @@ public:
 
     using iterator = const_iterator;
 
-    basic_headers_base() = default;
-
     /// Returns an iterator to the beginning of the field sequence.
     iterator
     begin() const;
@@ -248,6 +284,10 @@ public:
     as a std::multiset; there will be a separate value for each occurrence
     of the field name.
 
+    Names in the list of well-known fields are recognized on insertion,
+    and the first occurrence of each is remembered. Lookups of these
+    fields, either by @ref field value or by name, take constant time.
+
     @note Meets the requirements of @b `FieldSequence`.
 */
 template<class Allocator>
@@ -294,6 +334,13 @@ class basic_headers
             insert(e.first, e.second);
     }
 
+    void
+    insert(field f, boost::string_ref const& name,
+        boost::string_ref value);
+
+    void
+    erase(element& e);
+
 public:
     /// The type of allocator used.
     using allocator_type = Allocator;
@@ -361,15 +408,23 @@ public:
 
     /// Returns `true` if the specified field exists.
     bool
-    exists(boost::string_ref const& name) const
+    exists(boost::string_ref const& name) const;
+
+    /// Returns `true` if the specified well-known field exists.
+    bool
+    exists(field f) const
     {
-        return set_.find(name, less{}) != set_.end();
+        return known(f) != nullptr;
     }
 
     /// Returns the number of values for the specified field.
     std::size_t
     count(boost::string_ref const& name) const;
 
+    /// Returns the number of values for the specified well-known field.
+    std::size_t
+    count(field f) const;
+
     /** Returns an iterator to the case-insensitive matching field name.
 
         If more than one field with the specified name exists, the
@@ -378,6 +433,14 @@ public:
     iterator
     find(boost::string_ref const& name) const;
 
+    /** Returns an iterator to the specified well-known field.
+
+        If more than one field with the specified name exists, the
+        first field defined by insertion order is returned.
+    */
+    iterator
+    find(field f) const;
+
     /** Returns the value for a case-insensitive matching header, or `""`.
 
         If more than one field with the specified name exists, the
@@ -386,6 +449,14 @@ public:
     boost::string_ref
     operator[](boost::string_ref const& name) const;
 
+    /** Returns the value for the specified well-known field, or `""`.
+
+        If more than one field with the specified name exists, the
+        first field defined by insertion order is returned.
+    */
+    boost::string_ref
+    operator[](field f) const;
+
     /// Clear the contents of the basic_headers.
     void
     clear() noexcept;
@@ -402,6 +473,18 @@ public:
     std::size_t
     erase(boost::string_ref const& name);
 
+    /** Remove a well-known field.
+
+        If more than one field with the specified name exists, all
+        matching fields will be removed.
+
+        @param f The field to remove.
+
+        @return The number of fields removed.
+    */
+    std::size_t
+    erase(field f);
+
     /** Insert a field value.
 
         If a field with the same name already exists, the
@@ -415,6 +498,23 @@ public:
     void
     insert(boost::string_ref const& name, boost::string_ref value);
 
+    /** Insert a well-known field value.
+
+        The field is inserted with its canonical name. If a field
+        with the same name already exists, the existing field is
+        untouched and a new field value pair is inserted into the
+        container.
+
+        @param f The field, which may not be @ref field::unknown.
+
+        @param value A string holding the value of the field.
+    */
+    void
+    insert(field f, boost::string_ref value)
+    {
+        insert(f, to_string(f), value);
+    }
+
     /** Insert a field value.
 
         If a field with the same name already exists, the
@@ -434,6 +534,26 @@ public:
         insert(name, boost::lexical_cast<std::string>(value));
     }
 
+    /** Insert a well-known field value.
+
+        The field is inserted with its canonical name. If a field
+        with the same name already exists, the existing field is
+        untouched and a new field value pair is inserted into the
+        container.
+
+        @param f The field, which may not be @ref field::unknown.
+
+        @param value The value of the field. The object will be
+        converted to a string using `boost::lexical_cast`.
+    */
+    template<class T>
+    typename std::enable_if<
+        ! std::is_constructible<boost::string_ref, T>::value>::type
+    insert(field f, T const& value)
+    {
+        insert(f, boost::lexical_cast<std::string>(value));
+    }
+
     /** Replace a field value.
 
         First removes any values with matching field names, then
@@ -446,6 +566,18 @@ public:
     void
     replace(boost::string_ref const& name, boost::string_ref value);
 
+    /** Replace a well-known field value.
+
+        First removes any values with matching field names, then
+        inserts the new field value.
+
+        @param f The field, which may not be @ref field::unknown.
+
+        @param value A string holding the value of the field.
+    */
+    void
+    replace(field f, boost::string_ref value);
+
     /** Replace a field value.
 
         First removes any values with matching field names, then
@@ -464,6 +596,24 @@ public:
         replace(name,
             boost::lexical_cast<std::string>(value));
     }
+
+    /** Replace a well-known field value.
+
+        First removes any values with matching field names, then
+        inserts the new field value.
+
+        @param f The field, which may not be @ref field::unknown.
+
+        @param value The value of the field. The object will be
+        converted to a string using `boost::lexical_cast`.
+    */
+    template<class T>
+    typename std::enable_if<
+        ! std::is_constructible<boost::string_ref, T>::value>::type
+    replace(field f, T const& value)
+    {
+        replace(f, boost::lexical_cast<std::string>(value));
+    }
 };
 
 } // http
@@ -150,6 +150,11 @@ static std::uint64_t constexpr no_content_length =
         the parser is ready to parse another message if keep_alive
         would return `true`.
 
+    @li `void on_reset()`
+
+        Called when @ref basic_parser_v1::reset is called, so that the
+        derived class may discard the state it holds for the message.
+
     The return value of `on_headers` is special, it controls whether
     or not the parser should expect a body. These are the return values:
 
@@ -418,6 +423,18 @@ public:
     void
     write_eof(error_code& ec);
 
+    /** Reset the parser to begin a new message.
+
+        All state from the message being parsed, if any, is
+        discarded. Options set on the parser keep their values.
+        This may be called at any time, including after an error
+        or after a message which did not keep the connection open.
+        Derived classes which hold state of their own reset it in
+        the `on_reset` callback.
+    */
+    void
+    reset();
+
 private:
     Derived&
     impl()
@@ -426,25 +443,17 @@ private:
     }
 
     void
-    reset(std::true_type)
+    reset_state(std::true_type)
     {
         s_ = s_req_start;
     }
 
     void
-    reset(std::false_type)
+    reset_state(std::false_type)
     {
         s_ = s_res_start;
     }
 
-    void
-    reset()
-    {
-        h_left_ = h_max_;
-        b_left_ = b_max_;
-        reset(std::integral_constant<bool, isRequest>{});
-    }
-
     void
     init(std::true_type)
     {
@@ -465,9 +474,12 @@ private:
     init()
     {
         init(std::integral_constant<bool, isRequest>{});
-        reset();
+        reset_state();
     }
 
+    void
+    reset_state();
+
     bool
     needs_eof(std::true_type) const;
 
@@ -589,7 +601,7 @@ private:
     class has_on_field_t
     {
         template<class T, class R =
-            decltype(std::declval<T>().on_uri(
+            decltype(std::declval<T>().on_field(
                 std::declval<boost::string_ref const&>(),
                 std::declval<error_code&>()),
                     std::true_type{})>
@@ -608,7 +620,7 @@ private:
     class has_on_value_t
     {
         template<class T, class R =
-            decltype(std::declval<T>().on_uri(
+            decltype(std::declval<T>().on_value(
                 std::declval<boost::string_ref const&>(),
                 std::declval<error_code&>()),
                     std::true_type{})>
@@ -677,6 +689,23 @@ private:
     using has_on_complete =
         std::integral_constant<bool, has_on_complete_t<C>::value>;
 
+    template<class C>
+    class has_on_reset_t
+    {
+        template<class T, class R =
+            decltype(std::declval<T>().on_reset(),
+                std::true_type{})>
+        static R check(int);
+        template <class>
+        static std::false_type check(...);
+        using type = decltype(check<C>(0));
+    public:
+        static bool const value = type::value;
+    };
+    template<class C>
+    using has_on_reset =
+        std::integral_constant<bool, has_on_reset_t<C>::value>;
+
     void call_on_start(error_code& ec, std::true_type)
     {
         impl().on_start(ec);
@@ -899,6 +928,20 @@ private:
     {
         call_on_complete(ec, has_on_complete<Derived>{});
     }
+
+    void call_on_reset(std::true_type)
+    {
+        impl().on_reset();
+    }
+
+    void call_on_reset(std::false_type)
+    {
+    }
+
+    void call_on_reset()
+    {
+        call_on_reset(has_on_reset<Derived>{});
+    }
 };
 
 } // http
@@ -0,0 +1,181 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_HTTP_DETAIL_SCAN_HPP
+#define BEAST_HTTP_DETAIL_SCAN_HPP
+
+#include <beast/core/detail/cpu_info.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace beast {
+namespace http {
+namespace detail {
+
+/*  Skipping runs of plain text
+
+    In the request-target, the reason-phrase and most header
+    values the parser has nothing to do for a character until
+    it finds one of: a CTL other than HTAB, DEL, or an octet
+    below `lo`, which is SP for the request-target. These
+    kernels return the position of the first such character,
+    or `end`. The parser then handles that character itself.
+*/
+
+using scan_kernel_type =
+    char const*(*)(char const*, char const*, char);
+
+inline
+bool
+is_scan_stop(char c, char lo)
+{
+    auto const u = static_cast<std::uint8_t>(c);
+    return (u < static_cast<std::uint8_t>(lo) && u != '\t') ||
+        u == 0x7f;
+}
+
+// A byte at a time
+//
+inline
+char const*
+scan_bytes(char const* p, char const* end, char lo)
+{
+    while(p != end && ! is_scan_stop(*p, lo))
+        ++p;
+    return p;
+}
+
+#if BEAST_SIMD_X86
+
+inline
+unsigned
+scan_ctz(std::uint32_t m)
+{
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return static_cast<unsigned>(i);
+#else
+    return static_cast<unsigned>(__builtin_ctz(m));
+#endif
+}
+
+// 16 bytes at a time, using a range search
+//
+template<class = void>
+BEAST_TARGET_SSE42
+char const*
+scan_bytes_sse42(char const* p, char const* end, char lo)
+{
+    // inclusive ranges of the octets ending a run
+    auto const ranges = _mm_setr_epi8(
+        0x00, 0x08, 0x0a, static_cast<char>(lo - 1),
+        0x7f, 0x7f, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    for(; end - p >= 16; p += 16)
+    {
+        auto const v = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(p));
+        auto const i = _mm_cmpestri(ranges, 6, v, 16,
+            _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES |
+                _SIDD_LEAST_SIGNIFICANT);
+        if(i != 16)
+            return p + i;
+    }
+    return scan_bytes(p, end, lo);
+}
+
+// 32 bytes at a time, using unsigned compares
+//
+template<class = void>
+BEAST_TARGET_AVX2
+char const*
+scan_bytes_avx2(char const* p, char const* end, char lo)
+{
+    auto const vlo = _mm256_set1_epi8(lo);
+    auto const tab = _mm256_set1_epi8('\t');
+    auto const del = _mm256_set1_epi8(0x7f);
+    for(; end - p >= 32; p += 32)
+    {
+        auto const v = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const*>(p));
+        // an octet passes when it is at least lo or
+        // HTAB, and is not DEL
+        auto const pass = _mm256_or_si256(
+            _mm256_cmpeq_epi8(_mm256_max_epu8(v, vlo), v),
+            _mm256_cmpeq_epi8(v, tab));
+        auto const stop =
+            ~static_cast<std::uint32_t>(_mm256_movemask_epi8(pass)) |
+            static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(v, del)));
+        if(stop != 0)
+            return p + scan_ctz(stop);
+    }
+    if(end - p >= 16)
+    {
+        auto const v = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(p));
+        auto const pass = _mm_or_si128(
+            _mm_cmpeq_epi8(_mm_max_epu8(v,
+                _mm256_castsi256_si128(vlo)), v),
+            _mm_cmpeq_epi8(v, _mm256_castsi256_si128(tab)));
+        auto const stop = (~static_cast<std::uint32_t>(
+            _mm_movemask_epi8(pass)) & 0xffff) |
+            static_cast<std::uint32_t>(_mm_movemask_epi8(
+                _mm_cmpeq_epi8(v, _mm256_castsi256_si128(del))));
+        if(stop != 0)
+            return p + scan_ctz(stop);
+        p += 16;
+    }
+    return scan_bytes(p, end, lo);
+}
+
+#endif
+
+// Returns the fastest kernel supported by the CPU.
+// The selection is made once, on first use.
+//
+template<class = void>
+scan_kernel_type
+scan_kernel()
+{
+    static scan_kernel_type const f =
+        []() -> scan_kernel_type
+        {
+        #if BEAST_SIMD_X86
+            auto const& ci = beast::detail::get_cpu_info();
+            if(ci.avx2)
+                return &scan_bytes_avx2<>;
+            if(ci.sse42)
+                return &scan_bytes_sse42<>;
+        #endif
+            return &scan_bytes;
+        }();
+    return f;
+}
+
+// Below this size the dispatch costs more than it saves
+std::ptrdiff_t constexpr scan_kernel_min = 16;
+
+/** Return the first character at or after `p` ending a run of text.
+
+    @param lo The smallest octet, other than HTAB,
+    which does not end the run.
+*/
+inline
+char const*
+scan_text(char const* p, char const* end, char lo)
+{
+    if(end - p < scan_kernel_min)
+        return scan_bytes(p, end, lo);
+    return scan_kernel()(p, end, lo);
+}
+
+} // detail
+} // http
+} // beast
+
+#endif
@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_HTTP_FIELD_HPP
+#define BEAST_HTTP_FIELD_HPP
+
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace beast {
+namespace http {
+
+/** Well-known HTTP field names.
+
+    Names in this list are recognized by @ref string_to_field in
+    constant time. @ref basic_headers remembers the value for each
+    field it holds, so that lookups using the enumeration are
+    integer compares. Any other name is @ref field::unknown.
+*/
+enum class field : std::uint8_t
+{
+    unknown = 0,
+
+    accept,
+    accept_charset,
+    accept_encoding,
+    accept_language,
+    accept_ranges,
+    access_control_allow_origin,
+    age,
+    allow,
+    authorization,
+    cache_control,
+    connection,
+    content_disposition,
+    content_encoding,
+    content_language,
+    content_length,
+    content_location,
+    content_range,
+    content_type,
+    cookie,
+    date,
+    dnt,
+    etag,
+    expect,
+    expires,
+    from,
+    host,
+    if_match,
+    if_modified_since,
+    if_none_match,
+    if_range,
+    if_unmodified_since,
+    keep_alive,
+    last_modified,
+    link,
+    location,
+    max_forwards,
+    origin,
+    pragma,
+    proxy_authenticate,
+    proxy_authorization,
+    proxy_connection,
+    range,
+    referer,
+    retry_after,
+    sec_websocket_accept,
+    sec_websocket_extensions,
+    sec_websocket_key,
+    sec_websocket_protocol,
+    sec_websocket_version,
+    server,
+    set_cookie,
+    strict_transport_security,
+    te,
+    trailer,
+    transfer_encoding,
+    upgrade,
+    upgrade_insecure_requests,
+    user_agent,
+    vary,
+    via,
+    warning,
+    www_authenticate,
+    x_forwarded_for,
+    x_requested_with
+};
+
+/// The number of well-known fields, not counting @ref field::unknown
+static std::size_t constexpr field_count = 64;
+
+/** Returns the canonical text for a well-known field name.
+
+    If `f` is @ref field::unknown, an empty string is returned.
+*/
+boost::string_ref
+to_string(field f);
+
+/** Returns the well-known field matching a name.
+
+    The comparison is case-insensitive. If the name is not in the
+    list of well-known fields, @ref field::unknown is returned.
+*/
+field
+string_to_field(boost::string_ref const& s);
+
+} // http
+} // beast
+
+#include <beast/http/impl/field.ipp>
+
+#endif
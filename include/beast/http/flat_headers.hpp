@@ -0,0 +1,483 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_HTTP_FLAT_HEADERS_HPP
+#define BEAST_HTTP_FLAT_HEADERS_HPP
+
+#include <beast/http/field.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace beast {
+namespace http {
+
+/** A container for storing HTTP headers in contiguous memory.
+
+    This container offers the interface of @ref basic_headers with
+    a different layout. Names and values are appended to a single
+    character array, and each field is described by a small record
+    in a vector kept in insertion order. Inserting a field usually
+    allocates nothing, and serializing the fields walks memory in
+    order.
+
+    Well-known names are recognized on insertion. Lookups compare
+    the @ref field value of each record, or the name ignoring case
+    for other names. When the number of fields exceeds
+    @ref index_threshold, an open addressing hash index is built so
+    that lookups no longer take time proportional to the number of
+    fields.
+
+    Field names are stored as-is, but comparison are case-insensitive.
+    When the container is iterated, the fields are presented in the order
+    of insertion. There will be a separate value for each occurrence
+    of the field name.
+
+    Erasing fields leaves their text in place until it accounts for
+    more than half of the character array, at which point the array
+    is compacted. Inserting or erasing fields may invalidate
+    iterators, and the names and values previously returned.
+
+    @note Meets the requirements of @b `FieldSequence`.
+*/
+template<class Allocator>
+class basic_flat_headers
+{
+    struct entry
+    {
+        std::uint32_t pos;      // offset of the name
+        std::uint32_t nsize;    // size of the name
+        std::uint32_t vsize;    // size of the value, after the name
+        field id;
+    };
+
+    template<class T>
+    using rebind_alloc = typename std::allocator_traits<
+        Allocator>::template rebind_alloc<T>;
+
+    std::vector<char, rebind_alloc<char>> a_;
+    std::vector<entry, rebind_alloc<entry>> v_;
+    std::vector<std::uint32_t, rebind_alloc<std::uint32_t>> h_;
+    std::size_t dead_ = 0;
+
+public:
+    /// The type of allocator used.
+    using allocator_type = Allocator;
+
+    /// The number of fields above which a hash index is kept.
+    static std::size_t constexpr index_threshold = 16;
+
+    /// The type of each field in the sequence.
+    class value_type
+    {
+        boost::string_ref name_;
+        boost::string_ref value_;
+
+        friend class basic_flat_headers;
+
+        value_type(boost::string_ref const& name,
+                boost::string_ref const& value)
+            : name_(name)
+            , value_(value)
+        {
+        }
+
+    public:
+        value_type() = default;
+
+        /// Returns the field name.
+        boost::string_ref
+        name() const
+        {
+            return name_;
+        }
+
+        /// Returns the field value.
+        boost::string_ref
+        value() const
+        {
+            return value_;
+        }
+    };
+
+#if GENERATING_DOCS
+    /// A const iterator to the field sequence
+    using iterator = implementation_defined;
+
+    /// A const iterator to the field sequence
+    using const_iterator = implementation_defined;
+#else
+    class const_iterator;
+
+    using iterator = const_iterator;
+#endif
+
+    /// Default constructor.
+    basic_flat_headers() = default;
+
+    /** Construct the headers.
+
+        @param alloc The allocator to use.
+    */
+    explicit
+    basic_flat_headers(Allocator const& alloc);
+
+    /** Move constructor.
+
+        The moved-from object becomes an empty field sequence.
+
+        @param other The object to move from.
+    */
+    basic_flat_headers(basic_flat_headers&& other);
+
+    /** Move assignment.
+
+        The moved-from object becomes an empty field sequence.
+
+        @param other The object to move from.
+    */
+    basic_flat_headers& operator=(basic_flat_headers&& other);
+
+    /// Copy constructor.
+    basic_flat_headers(basic_flat_headers const&) = default;
+
+    /// Copy assignment.
+    basic_flat_headers& operator=(basic_flat_headers const&) = default;
+
+    /// Construct from a field sequence.
+    template<class FwdIt>
+    basic_flat_headers(FwdIt first, FwdIt last);
+
+    /// Returns an iterator to the beginning of the field sequence.
+    iterator
+    begin() const;
+
+    /// Returns an iterator to the end of the field sequence.
+    iterator
+    end() const;
+
+    /// Returns an iterator to the beginning of the field sequence.
+    iterator
+    cbegin() const;
+
+    /// Returns an iterator to the end of the field sequence.
+    iterator
+    cend() const;
+
+    /// Returns `true` if the field sequence contains no elements.
+    bool
+    empty() const
+    {
+        return v_.empty();
+    }
+
+    /// Returns the number of elements in the field sequence.
+    std::size_t
+    size() const
+    {
+        return v_.size();
+    }
+
+    /** Reserve storage for fields.
+
+        @param fields The number of fields to make room for.
+
+        @param bytes The number of octets of names and values
+        to make room for.
+    */
+    void
+    reserve(std::size_t fields, std::size_t bytes);
+
+    /// Returns `true` if the specified field exists.
+    bool
+    exists(boost::string_ref const& name) const
+    {
+        return find(name) != end();
+    }
+
+    /// Returns `true` if the specified well-known field exists.
+    bool
+    exists(field f) const
+    {
+        return find(f) != end();
+    }
+
+    /// Returns the number of values for the specified field.
+    std::size_t
+    count(boost::string_ref const& name) const
+    {
+        return count(string_to_field(name), name);
+    }
+
+    /// Returns the number of values for the specified well-known field.
+    std::size_t
+    count(field f) const
+    {
+        return count(f, to_string(f));
+    }
+
+    /** Returns an iterator to the case-insensitive matching field name.
+
+        If more than one field with the specified name exists, the
+        first field defined by insertion order is returned.
+    */
+    iterator
+    find(boost::string_ref const& name) const;
+
+    /** Returns an iterator to the specified well-known field.
+
+        If more than one field with the specified name exists, the
+        first field defined by insertion order is returned.
+    */
+    iterator
+    find(field f) const;
+
+    /** Returns the value for a case-insensitive matching header, or `""`.
+
+        If more than one field with the specified name exists, the
+        first field defined by insertion order is returned.
+    */
+    boost::string_ref
+    operator[](boost::string_ref const& name) const;
+
+    /** Returns the value for the specified well-known field, or `""`.
+
+        If more than one field with the specified name exists, the
+        first field defined by insertion order is returned.
+    */
+    boost::string_ref
+    operator[](field f) const;
+
+    /** Clear the contents of the basic_flat_headers.
+
+        The storage is kept, to be reused by fields inserted later.
+    */
+    void
+    clear() noexcept;
+
+    /** Remove a field.
+
+        If more than one field with the specified name exists, all
+        matching fields will be removed.
+
+        @param name The name of the field(s) to remove.
+
+        @return The number of fields removed.
+    */
+    std::size_t
+    erase(boost::string_ref const& name)
+    {
+        return erase(string_to_field(name), name, size());
+    }
+
+    /** Remove a well-known field.
+
+        If more than one field with the specified name exists, all
+        matching fields will be removed.
+
+        @param f The field to remove.
+
+        @return The number of fields removed.
+    */
+    std::size_t
+    erase(field f)
+    {
+        return erase(f, to_string(f), size());
+    }
+
+    /** Insert a field value.
+
+        If a field with the same name already exists, the
+        existing field is untouched and a new field value pair
+        is inserted into the container.
+
+        @param name The name of the field.
+
+        @param value A string holding the value of the field.
+    */
+    void
+    insert(boost::string_ref const& name, boost::string_ref value)
+    {
+        insert(string_to_field(name), name, value);
+    }
+
+    /** Insert a field value.
+
+        If a field with the same name already exists, the
+        existing field is untouched and a new field value pair
+        is inserted into the container.
+
+        @param name The name of the field
+
+        @param value The value of the field. The object will be
+        converted to a string using `boost::lexical_cast`.
+    */
+    template<class T>
+    typename std::enable_if<
+        ! std::is_constructible<boost::string_ref, T>::value>::type
+    insert(boost::string_ref name, T const& value)
+    {
+        insert(name, boost::lexical_cast<std::string>(value));
+    }
+
+    /** Insert a well-known field value.
+
+        The field is inserted with its canonical name. If a field
+        with the same name already exists, the existing field is
+        untouched and a new field value pair is inserted into the
+        container.
+
+        @param f The field, which may not be @ref field::unknown.
+
+        @param value A string holding the value of the field.
+    */
+    void
+    insert(field f, boost::string_ref value)
+    {
+        insert(f, to_string(f), value);
+    }
+
+    /** Insert a well-known field value.
+
+        The field is inserted with its canonical name. If a field
+        with the same name already exists, the existing field is
+        untouched and a new field value pair is inserted into the
+        container.
+
+        @param f The field, which may not be @ref field::unknown.
+
+        @param value The value of the field. The object will be
+        converted to a string using `boost::lexical_cast`.
+    */
+    template<class T>
+    typename std::enable_if<
+        ! std::is_constructible<boost::string_ref, T>::value>::type
+    insert(field f, T const& value)
+    {
+        insert(f, boost::lexical_cast<std::string>(value));
+    }
+
+    /** Replace a field value.
+
+        First removes any values with matching field names, then
+        inserts the new field value.
+
+        @param name The name of the field.
+
+        @param value A string holding the value of the field.
+    */
+    void
+    replace(boost::string_ref const& name, boost::string_ref value);
+
+    /** Replace a field value.
+
+        First removes any values with matching field names, then
+        inserts the new field value.
+
+        @param name The name of the field
+
+        @param value The value of the field. The object will be
+        converted to a string using `boost::lexical_cast`.
+    */
+    template<class T>
+    typename std::enable_if<
+        ! std::is_constructible<boost::string_ref, T>::value>::type
+    replace(boost::string_ref const& name, T const& value)
+    {
+        replace(name,
+            boost::lexical_cast<std::string>(value));
+    }
+
+    /** Replace a well-known field value.
+
+        First removes any values with matching field names, then
+        inserts the new field value.
+
+        @param f The field, which may not be @ref field::unknown.
+
+        @param value A string holding the value of the field.
+    */
+    void
+    replace(field f, boost::string_ref value)
+    {
+        replace(to_string(f), value);
+    }
+
+    /** Replace a well-known field value.
+
+        First removes any values with matching field names, then
+        inserts the new field value.
+
+        @param f The field, which may not be @ref field::unknown.
+
+        @param value The value of the field. The object will be
+        converted to a string using `boost::lexical_cast`.
+    */
+    template<class T>
+    typename std::enable_if<
+        ! std::is_constructible<boost::string_ref, T>::value>::type
+    replace(field f, T const& value)
+    {
+        replace(f, boost::lexical_cast<std::string>(value));
+    }
+
+private:
+    boost::string_ref
+    name(entry const& e) const
+    {
+        return {a_.data() + e.pos, e.nsize};
+    }
+
+    boost::string_ref
+    value(entry const& e) const
+    {
+        return {a_.data() + e.pos + e.nsize, e.vsize};
+    }
+
+    bool
+    match(entry const& e, field f,
+        boost::string_ref const& name) const;
+
+    std::size_t
+    find(field f, boost::string_ref const& name) const;
+
+    std::size_t
+    count(field f, boost::string_ref const& name) const;
+
+    std::size_t
+    erase(field f, boost::string_ref const& name, std::size_t n);
+
+    void
+    insert(field f, boost::string_ref const& name,
+        boost::string_ref value);
+
+    void
+    index(std::size_t i);
+
+    void
+    rebuild();
+
+    void
+    compact();
+};
+
+/// A typical HTTP header fields container with contiguous storage.
+using flat_headers =
+    basic_flat_headers<std::allocator<char>>;
+
+} // http
+} // beast
+
+#include <beast/http/impl/flat_headers.ipp>
+
+#endif
@@ -79,8 +79,7 @@ move_assign(basic_headers& other, std::false_type)
     }
     else
     {
-        set_ = std::move(other.set_);
-        list_ = std::move(other.list_);
+        this->move_from(other);
     }
 }
 
@@ -91,8 +90,7 @@ basic_headers<Allocator>::
 move_assign(basic_headers& other, std::true_type)
 {
     this->member() = std::move(other.member());
-    set_ = std::move(other.set_);
-    list_ = std::move(other.list_);
+    this->move_from(other);
 }
 
 template<class Allocator>
@@ -136,8 +134,7 @@ basic_headers<Allocator>::
 basic_headers(basic_headers&& other)
     : beast::detail::empty_base_optimization<alloc_type>(
         std::move(other.member()))
-    , detail::basic_headers_base(
-        std::move(other.set_), std::move(other.list_))
+    , detail::basic_headers_base(std::move(other))
 {
 }
 
@@ -205,11 +202,51 @@ basic_headers(FwdIt first, FwdIt last)
         insert(first->name(), first->value());
 }
 
+template<class Allocator>
+void
+basic_headers<Allocator>::
+insert(field f, boost::string_ref const& name,
+    boost::string_ref value)
+{
+    value = detail::trim(value);
+    auto const p = alloc_traits::allocate(this->member(), 1);
+    alloc_traits::construct(this->member(), p, f, name, value);
+    set_.insert_before(set_.upper_bound(name, less{}), *p);
+    list_.push_back(*p);
+    if(f != field::unknown && ! known(f))
+        known(f) = p;
+}
+
+template<class Allocator>
+void
+basic_headers<Allocator>::
+erase(element& e)
+{
+    set_.erase(set_.iterator_to(e));
+    list_.erase(list_.iterator_to(e));
+    alloc_traits::destroy(this->member(), &e);
+    alloc_traits::deallocate(this->member(), &e, 1);
+}
+
+template<class Allocator>
+bool
+basic_headers<Allocator>::
+exists(boost::string_ref const& name) const
+{
+    auto const f = string_to_field(name);
+    if(f != field::unknown)
+        return exists(f);
+    return set_.find(name, less{}) != set_.end();
+}
+
 template<class Allocator>
 std::size_t
 basic_headers<Allocator>::
 count(boost::string_ref const& name) const
 {
+    auto const f = string_to_field(name);
+    if(f != field::unknown)
+        return count(f);
     auto const it = set_.find(name, less{});
     if(it == set_.end())
         return 0;
@@ -217,18 +254,50 @@ count(boost::string_ref const& name) const
     return static_cast<std::size_t>(std::distance(it, last));
 }
 
+template<class Allocator>
+std::size_t
+basic_headers<Allocator>::
+count(field f) const
+{
+    auto const p = known(f);
+    if(! p)
+        return 0;
+    // equal names are adjacent in the set, the
+    // first inserted is the first in set order
+    std::size_t n = 0;
+    for(auto it = set_.iterator_to(*p);
+            it != set_.end() && it->id == f; ++it)
+        ++n;
+    return n;
+}
+
 template<class Allocator>
 auto
 basic_headers<Allocator>::
 find(boost::string_ref const& name) const ->
     iterator
 {
+    auto const f = string_to_field(name);
+    if(f != field::unknown)
+        return find(f);
     auto const it = set_.find(name, less{});
     if(it == set_.end())
         return list_.end();
     return list_.iterator_to(*it);
 }
 
+template<class Allocator>
+auto
+basic_headers<Allocator>::
+find(field f) const ->
+    iterator
+{
+    auto const p = known(f);
+    if(! p)
+        return list_.end();
+    return list_.iterator_to(*p);
+}
+
 template<class Allocator>
 boost::string_ref
 basic_headers<Allocator>::
@@ -240,6 +309,17 @@ operator[](boost::string_ref const& name) const
     return it->second;
 }
 
+template<class Allocator>
+boost::string_ref
+basic_headers<Allocator>::
+operator[](field f) const
+{
+    auto const p = known(f);
+    if(! p)
+        return {};
+    return p->data.second;
+}
+
 template<class Allocator>
 void
 basic_headers<Allocator>::
@@ -248,6 +328,7 @@ clear() noexcept
     delete_all();
     list_.clear();
     set_.clear();
+    known_.fill(nullptr);
 }
 
 template<class Allocator>
@@ -255,6 +336,9 @@ std::size_t
 basic_headers<Allocator>::
 erase(boost::string_ref const& name)
 {
+    auto const f = string_to_field(name);
+    if(f != field::unknown)
+        return erase(f);
     auto it = set_.find(name, less{});
     if(it == set_.end())
         return 0;
@@ -262,11 +346,7 @@ erase(boost::string_ref const& name)
     std::size_t n = 1;
     for(;;)
     {
-        auto& e = *it++;
-        set_.erase(set_.iterator_to(e));
-        list_.erase(list_.iterator_to(e));
-        alloc_traits::destroy(this->member(), &e);
-        alloc_traits::deallocate(this->member(), &e, 1);
+        erase(*it++);
         if(it == last)
             break;
         ++n;
@@ -274,17 +354,33 @@ erase(boost::string_ref const& name)
     return n;
 }
 
+template<class Allocator>
+std::size_t
+basic_headers<Allocator>::
+erase(field f)
+{
+    auto const p = known(f);
+    if(! p)
+        return 0;
+    auto it = set_.iterator_to(*p);
+    std::size_t n = 0;
+    do
+    {
+        erase(*it++);
+        ++n;
+    }
+    while(it != set_.end() && it->id == f);
+    known(f) = nullptr;
+    return n;
+}
+
 template<class Allocator>
 void
 basic_headers<Allocator>::
 insert(boost::string_ref const& name,
     boost::string_ref value)
 {
-    value = detail::trim(value);
-    auto const p = alloc_traits::allocate(this->member(), 1);
-    alloc_traits::construct(this->member(), p, name, value);
-    set_.insert_before(set_.upper_bound(name, less{}), *p);
-    list_.push_back(*p);
+    insert(string_to_field(name), name, value);
 }
 
 template<class Allocator>
@@ -298,6 +394,15 @@ replace(boost::string_ref const& name,
     insert(name, value);
 }
 
+template<class Allocator>
+void
+basic_headers<Allocator>::
+replace(field f, boost::string_ref value)
+{
+    erase(f);
+    insert(f, value);
+}
+
 } // http
 } // beast
 
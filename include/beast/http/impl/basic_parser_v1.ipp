@@ -37,6 +37,7 @@
 #define BEAST_HTTP_IMPL_BASIC_PARSER_V1_IPP
 
 #include <beast/http/detail/rfc7230.hpp>
+#include <beast/http/detail/scan.hpp>
 #include <beast/core/buffer_concepts.hpp>
 #include <cassert>
 
@@ -50,6 +51,34 @@ basic_parser_v1()
     init();
 }
 
+template<bool isRequest, class Derived>
+void
+basic_parser_v1<isRequest, Derived>::
+reset()
+{
+    reset_state();
+    call_on_reset();
+}
+
+template<bool isRequest, class Derived>
+void
+basic_parser_v1<isRequest, Derived>::
+reset_state()
+{
+    h_left_ = h_max_;
+    b_left_ = b_max_;
+    content_length_ = no_content_length;
+    cb_ = nullptr;
+    flags_ = 0;
+    fs_ = 0;
+    pos_ = 0;
+    http_major_ = 0;
+    http_minor_ = 0;
+    status_code_ = 0;
+    upgrade_ = false;
+    reset_state(std::integral_constant<bool, isRequest>{});
+}
+
 template<bool isRequest, class Derived>
 bool
 basic_parser_v1<isRequest, Derived>::
@@ -201,6 +230,14 @@ write(boost::asio::const_buffer const& buffer, error_code& ec)
         }
 
         case s_req_url:
+            // skip to the next SP or CTL
+            p = detail::scan_text(p, end, '!');
+            if(p == end)
+            {
+                --p;
+                break;
+            }
+            ch = *p;
             if(ch == ' ')
             {
                 if(cb(nullptr))
@@ -383,6 +420,14 @@ write(boost::asio::const_buffer const& buffer, error_code& ec)
             break;
 
         case s_res_reason:
+            // skip to the next CTL
+            p = detail::scan_text(p, end, ' ');
+            if(p == end)
+            {
+                --p;
+                break;
+            }
+            ch = *p;
             if(ch == '\r')
             {
                 if(cb(nullptr))
@@ -558,6 +603,14 @@ write(boost::asio::const_buffer const& buffer, error_code& ec)
         {
             for(; p != end; ++p)
             {
+                if(fs_ == h_general)
+                {
+                    // nothing to match, skip to the next
+                    // character which is not plain text
+                    p = detail::scan_text(p, end, ' ');
+                    if(p == end)
+                        break;
+                }
                 ch = *p;
                 if(ch == '\r')
                 {
@@ -1117,8 +1170,9 @@ write(boost::asio::const_buffer const& buffer, error_code& ec)
             return used();
 
         case s_restart:
+            // the derived class keeps the finished message
             if(keep_alive())
-                reset();
+                reset_state();
             else
                 s_ = s_dead;
             goto redo;
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_HTTP_IMPL_FIELD_IPP
+#define BEAST_HTTP_IMPL_FIELD_IPP
+
+#include <beast/core/detail/ci_char_traits.hpp>
+#include <array>
+
+namespace beast {
+namespace http {
+
+namespace detail {
+
+// Names of the well-known fields, indexed by enum value
+template<class = void>
+boost::string_ref const*
+field_names()
+{
+    static boost::string_ref const names[] = {
+        "",
+        "Accept",
+        "Accept-Charset",
+        "Accept-Encoding",
+        "Accept-Language",
+        "Accept-Ranges",
+        "Access-Control-Allow-Origin",
+        "Age",
+        "Allow",
+        "Authorization",
+        "Cache-Control",
+        "Connection",
+        "Content-Disposition",
+        "Content-Encoding",
+        "Content-Language",
+        "Content-Length",
+        "Content-Location",
+        "Content-Range",
+        "Content-Type",
+        "Cookie",
+        "Date",
+        "DNT",
+        "ETag",
+        "Expect",
+        "Expires",
+        "From",
+        "Host",
+        "If-Match",
+        "If-Modified-Since",
+        "If-None-Match",
+        "If-Range",
+        "If-Unmodified-Since",
+        "Keep-Alive",
+        "Last-Modified",
+        "Link",
+        "Location",
+        "Max-Forwards",
+        "Origin",
+        "Pragma",
+        "Proxy-Authenticate",
+        "Proxy-Authorization",
+        "Proxy-Connection",
+        "Range",
+        "Referer",
+        "Retry-After",
+        "Sec-WebSocket-Accept",
+        "Sec-WebSocket-Extensions",
+        "Sec-WebSocket-Key",
+        "Sec-WebSocket-Protocol",
+        "Sec-WebSocket-Version",
+        "Server",
+        "Set-Cookie",
+        "Strict-Transport-Security",
+        "TE",
+        "Trailer",
+        "Transfer-Encoding",
+        "Upgrade",
+        "Upgrade-Insecure-Requests",
+        "User-Agent",
+        "Vary",
+        "Via",
+        "Warning",
+        "WWW-Authenticate",
+        "X-Forwarded-For",
+        "X-Requested-With"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) ==
+        field_count + 1, "field names mismatch");
+    return &names[0];
+}
+
+// With the octets folded to lowercase,
+//
+//      (size * 21 + first + last * 11) mod 256
+//
+// has no collisions among the well-known names. The
+// unit test checks this still holds when names are added.
+//
+inline
+std::uint8_t
+field_hash(boost::string_ref const& s)
+{
+    auto const first = static_cast<std::uint8_t>(
+        beast::detail::tolower(s.front()));
+    auto const last = static_cast<std::uint8_t>(
+        beast::detail::tolower(s.back()));
+    return static_cast<std::uint8_t>(
+        s.size() * 21 + first + last * 11);
+}
+
+// Maps each hash to the enum value of the only well-known
+// name which can have it, or zero. Built once, on first use.
+//
+template<class = void>
+std::uint8_t const*
+field_slots()
+{
+    static std::array<std::uint8_t, 256> const tab =
+        []() -> std::array<std::uint8_t, 256>
+        {
+            std::array<std::uint8_t, 256> t;
+            t.fill(0);
+            for(std::size_t i = 1; i <= field_count; ++i)
+                t[field_hash(field_names()[i])] =
+                    static_cast<std::uint8_t>(i);
+            return t;
+        }();
+    return tab.data();
+}
+
+} // detail
+
+inline
+boost::string_ref
+to_string(field f)
+{
+    return detail::field_names()[static_cast<std::size_t>(f)];
+}
+
+inline
+field
+string_to_field(boost::string_ref const& s)
+{
+    if(s.empty())
+        return field::unknown;
+    auto const i = detail::field_slots()[detail::field_hash(s)];
+    if(i == 0 || ! beast::detail::ci_equal(
+            detail::field_names()[i], s))
+        return field::unknown;
+    return static_cast<field>(i);
+}
+
+} // http
+} // beast
+
+#endif
@@ -0,0 +1,465 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_HTTP_IMPL_FLAT_HEADERS_IPP
+#define BEAST_HTTP_IMPL_FLAT_HEADERS_IPP
+
+#include <beast/core/detail/ci_char_traits.hpp>
+#include <beast/http/detail/rfc7230.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace beast {
+namespace http {
+
+namespace detail {
+
+// Case-insensitive FNV-1a
+inline
+std::uint32_t
+ci_hash(boost::string_ref const& s)
+{
+    std::uint32_t h = 2166136261u;
+    for(auto const c : s)
+    {
+        h ^= static_cast<std::uint8_t>(
+            beast::detail::tolower(c));
+        h *= 16777619u;
+    }
+    return h;
+}
+
+} // detail
+
+template<class Allocator>
+class basic_flat_headers<Allocator>::const_iterator
+{
+    basic_flat_headers const* h_ = nullptr;
+    std::size_t i_ = 0;
+    mutable typename basic_flat_headers::value_type v_;
+
+    friend class basic_flat_headers;
+
+    const_iterator(basic_flat_headers const& h, std::size_t i)
+        : h_(&h)
+        , i_(i)
+    {
+    }
+
+public:
+    using value_type =
+        typename basic_flat_headers::value_type;
+    using pointer = value_type const*;
+    using reference = value_type const&;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category =
+        std::bidirectional_iterator_tag;
+
+    const_iterator() = default;
+    const_iterator(const_iterator&& other) = default;
+    const_iterator(const_iterator const& other) = default;
+    const_iterator& operator=(const_iterator&& other) = default;
+    const_iterator& operator=(const_iterator const& other) = default;
+
+    bool
+    operator==(const_iterator const& other) const
+    {
+        return h_ == other.h_ && i_ == other.i_;
+    }
+
+    bool
+    operator!=(const_iterator const& other) const
+    {
+        return !(*this == other);
+    }
+
+    reference
+    operator*() const
+    {
+        auto const& e = h_->v_[i_];
+        v_ = value_type{h_->name(e), h_->value(e)};
+        return v_;
+    }
+
+    pointer
+    operator->() const
+    {
+        return &**this;
+    }
+
+    const_iterator&
+    operator++()
+    {
+        ++i_;
+        return *this;
+    }
+
+    const_iterator
+    operator++(int)
+    {
+        auto temp = *this;
+        ++(*this);
+        return temp;
+    }
+
+    const_iterator&
+    operator--()
+    {
+        --i_;
+        return *this;
+    }
+
+    const_iterator
+    operator--(int)
+    {
+        auto temp = *this;
+        --(*this);
+        return temp;
+    }
+};
+
+//------------------------------------------------------------------------------
+
+template<class Allocator>
+basic_flat_headers<Allocator>::
+basic_flat_headers(Allocator const& alloc)
+    : a_(alloc)
+    , v_(alloc)
+    , h_(alloc)
+{
+}
+
+template<class Allocator>
+basic_flat_headers<Allocator>::
+basic_flat_headers(basic_flat_headers&& other)
+    : a_(std::move(other.a_))
+    , v_(std::move(other.v_))
+    , h_(std::move(other.h_))
+    , dead_(other.dead_)
+{
+    other.dead_ = 0;
+}
+
+template<class Allocator>
+auto
+basic_flat_headers<Allocator>::
+operator=(basic_flat_headers&& other) ->
+    basic_flat_headers&
+{
+    if(this == &other)
+        return *this;
+    a_ = std::move(other.a_);
+    v_ = std::move(other.v_);
+    h_ = std::move(other.h_);
+    dead_ = other.dead_;
+    other.clear();
+    return *this;
+}
+
+template<class Allocator>
+template<class FwdIt>
+basic_flat_headers<Allocator>::
+basic_flat_headers(FwdIt first, FwdIt last)
+{
+    for(;first != last; ++first)
+        insert(first->name(), first->value());
+}
+
+template<class Allocator>
+auto
+basic_flat_headers<Allocator>::
+begin() const ->
+    iterator
+{
+    return {*this, 0};
+}
+
+template<class Allocator>
+auto
+basic_flat_headers<Allocator>::
+end() const ->
+    iterator
+{
+    return {*this, v_.size()};
+}
+
+template<class Allocator>
+auto
+basic_flat_headers<Allocator>::
+cbegin() const ->
+    iterator
+{
+    return begin();
+}
+
+template<class Allocator>
+auto
+basic_flat_headers<Allocator>::
+cend() const ->
+    iterator
+{
+    return end();
+}
+
+template<class Allocator>
+void
+basic_flat_headers<Allocator>::
+reserve(std::size_t fields, std::size_t bytes)
+{
+    v_.reserve(fields);
+    a_.reserve(bytes);
+}
+
+template<class Allocator>
+auto
+basic_flat_headers<Allocator>::
+find(boost::string_ref const& name) const ->
+    iterator
+{
+    return {*this, find(string_to_field(name), name)};
+}
+
+template<class Allocator>
+auto
+basic_flat_headers<Allocator>::
+find(field f) const ->
+    iterator
+{
+    return {*this, find(f, to_string(f))};
+}
+
+template<class Allocator>
+boost::string_ref
+basic_flat_headers<Allocator>::
+operator[](boost::string_ref const& name) const
+{
+    auto const i = find(string_to_field(name), name);
+    if(i == v_.size())
+        return {};
+    return value(v_[i]);
+}
+
+template<class Allocator>
+boost::string_ref
+basic_flat_headers<Allocator>::
+operator[](field f) const
+{
+    auto const i = find(f, to_string(f));
+    if(i == v_.size())
+        return {};
+    return value(v_[i]);
+}
+
+template<class Allocator>
+void
+basic_flat_headers<Allocator>::
+clear() noexcept
+{
+    a_.clear();
+    v_.clear();
+    h_.clear();
+    dead_ = 0;
+}
+
+template<class Allocator>
+void
+basic_flat_headers<Allocator>::
+replace(boost::string_ref const& name,
+    boost::string_ref value)
+{
+    // Insert first, in case value refers to a field
+    // being replaced, then erase the older fields.
+    // Growing the arena may invalidate name, so match
+    // against the copy held by the new field.
+    auto const f = string_to_field(name);
+    auto const n = v_.size();
+    insert(f, name, value);
+    erase(f, this->name(v_.back()), n);
+}
+
+//------------------------------------------------------------------------------
+
+template<class Allocator>
+bool
+basic_flat_headers<Allocator>::
+match(entry const& e, field f,
+    boost::string_ref const& name) const
+{
+    if(f != field::unknown)
+        return e.id == f;
+    return e.id == field::unknown &&
+        beast::detail::ci_equal(this->name(e), name);
+}
+
+template<class Allocator>
+std::size_t
+basic_flat_headers<Allocator>::
+find(field f, boost::string_ref const& name) const
+{
+    if(h_.empty())
+    {
+        for(std::size_t i = 0; i < v_.size(); ++i)
+            if(match(v_[i], f, name))
+                return i;
+        return v_.size();
+    }
+    // Equal names probe the same slots in insertion
+    // order, so the first match is the first inserted.
+    auto const mask = h_.size() - 1;
+    for(auto i = detail::ci_hash(name) & mask;
+        h_[i] != 0; i = (i + 1) & mask)
+    {
+        auto const j = h_[i] - 1;
+        if(match(v_[j], f, name))
+            return j;
+    }
+    return v_.size();
+}
+
+template<class Allocator>
+std::size_t
+basic_flat_headers<Allocator>::
+count(field f, boost::string_ref const& name) const
+{
+    std::size_t n = 0;
+    for(auto const& e : v_)
+        if(match(e, f, name))
+            ++n;
+    return n;
+}
+
+template<class Allocator>
+std::size_t
+basic_flat_headers<Allocator>::
+erase(field f, boost::string_ref const& name, std::size_t n)
+{
+    std::size_t erased = 0;
+    auto const last = v_.begin() + n;
+    auto const it = std::remove_if(v_.begin(), last,
+        [&](entry const& e)
+        {
+            if(! match(e, f, name))
+                return false;
+            dead_ += e.nsize + e.vsize;
+            ++erased;
+            return true;
+        });
+    if(erased == 0)
+        return 0;
+    v_.erase(std::move(last, v_.end(), it), v_.end());
+    if(dead_ > a_.size() / 2)
+        compact();
+    if(! h_.empty())
+        rebuild();
+    return erased;
+}
+
+template<class Allocator>
+void
+basic_flat_headers<Allocator>::
+insert(field f, boost::string_ref const& name,
+    boost::string_ref value)
+{
+    value = detail::trim(value);
+    if(name.size() + value.size() >
+            std::numeric_limits<std::uint32_t>::max() - a_.size())
+        throw std::length_error("flat_headers too long");
+    entry e;
+    e.pos = static_cast<std::uint32_t>(a_.size());
+    e.nsize = static_cast<std::uint32_t>(name.size());
+    e.vsize = static_cast<std::uint32_t>(value.size());
+    e.id = f;
+    // The name or value may refer to the arena
+    auto const base = a_.data();
+    auto const off =
+        [&](boost::string_ref const& s) -> std::ptrdiff_t
+        {
+            if(! a_.empty() && s.data() >= base &&
+                    s.data() < base + a_.size())
+                return s.data() - base;
+            return -1;
+        };
+    auto const noff = off(name);
+    auto const voff = off(value);
+    a_.resize(a_.size() + name.size() + value.size());
+    auto const p = &a_[e.pos];
+    std::memcpy(p, noff < 0 ? name.data() :
+        a_.data() + noff, name.size());
+    std::memcpy(p + name.size(), voff < 0 ? value.data() :
+        a_.data() + voff, value.size());
+    v_.push_back(e);
+    if(! h_.empty())
+    {
+        if(v_.size() * 2 > h_.size())
+            rebuild();
+        else
+            index(v_.size() - 1);
+    }
+    else if(v_.size() > index_threshold)
+    {
+        rebuild();
+    }
+}
+
+template<class Allocator>
+void
+basic_flat_headers<Allocator>::
+index(std::size_t i)
+{
+    auto const mask = h_.size() - 1;
+    auto j = detail::ci_hash(name(v_[i])) & mask;
+    while(h_[j] != 0)
+        j = (j + 1) & mask;
+    h_[j] = static_cast<std::uint32_t>(i + 1);
+}
+
+template<class Allocator>
+void
+basic_flat_headers<Allocator>::
+rebuild()
+{
+    if(v_.size() <= index_threshold)
+    {
+        h_.clear();
+        return;
+    }
+    // start at most a quarter full, insert
+    // rebuilds when more than half full
+    std::size_t n = 2 * index_threshold;
+    while(n < 4 * v_.size())
+        n *= 2;
+    h_.assign(n, 0);
+    for(std::size_t i = 0; i < v_.size(); ++i)
+        index(i);
+}
+
+template<class Allocator>
+void
+basic_flat_headers<Allocator>::
+compact()
+{
+    // Fields are appended in insertion order, so moving
+    // each one down in turn never overwrites another.
+    std::uint32_t pos = 0;
+    for(auto& e : v_)
+    {
+        auto const n = e.nsize + e.vsize;
+        if(e.pos != pos)
+            std::memmove(&a_[pos], &a_[e.pos], n);
+        e.pos = pos;
+        pos += n;
+    }
+    a_.resize(pos);
+    dead_ = 0;
+}
+
+} // http
+} // beast
+
+#endif
@@ -0,0 +1,283 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_HTTP_MESSAGE_VIEW_HPP
+#define BEAST_HTTP_MESSAGE_VIEW_HPP
+
+#include <beast/core/detail/ci_char_traits.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+namespace beast {
+namespace http {
+
+/** A field in a @ref fields_view.
+
+    The name and value refer to the buffer the field was parsed
+    from, and are valid for as long as that buffer.
+
+    @note Meets the requirements of @b `Field`.
+*/
+class field_view
+{
+    boost::string_ref name_;
+    boost::string_ref value_;
+
+public:
+    /// Default constructor
+    field_view() = default;
+
+    /// Construct the field from a name and value.
+    field_view(boost::string_ref const& name,
+            boost::string_ref const& value)
+        : name_(name)
+        , value_(value)
+    {
+    }
+
+    /// Returns the field name.
+    boost::string_ref
+    name() const
+    {
+        return name_;
+    }
+
+    /// Returns the field value.
+    boost::string_ref
+    value() const
+    {
+        return value_;
+    }
+};
+
+/** A sequence of fields of fixed capacity.
+
+    Fields are kept in the order inserted, in storage held within
+    the object, so that inserting allocates no memory. Names and
+    values are not copied.
+
+    @note Meets the requirements of @b `FieldSequence`.
+
+    @tparam N The largest number of fields held.
+*/
+template<std::size_t N>
+class fields_view
+{
+    std::size_t n_ = 0;
+    std::array<field_view, N> v_;
+
+public:
+    /// The type of each field
+    using value_type = field_view;
+
+    /// A const iterator to the field sequence
+    using iterator = field_view const*;
+
+    /// A const iterator to the field sequence
+    using const_iterator = iterator;
+
+    /// Default constructor
+    fields_view() = default;
+
+    /// Returns the largest number of fields held.
+    static
+    std::size_t constexpr
+    capacity()
+    {
+        return N;
+    }
+
+    /// Returns the number of fields.
+    std::size_t
+    size() const
+    {
+        return n_;
+    }
+
+    /// Returns `true` if there are no fields.
+    bool
+    empty() const
+    {
+        return n_ == 0;
+    }
+
+    /// Returns a const iterator to the beginning of the field sequence.
+    iterator
+    begin() const
+    {
+        return v_.data();
+    }
+
+    /// Returns a const iterator to the end of the field sequence.
+    iterator
+    end() const
+    {
+        return v_.data() + n_;
+    }
+
+    /// Returns a const iterator to the beginning of the field sequence.
+    iterator
+    cbegin() const
+    {
+        return begin();
+    }
+
+    /// Returns a const iterator to the end of the field sequence.
+    iterator
+    cend() const
+    {
+        return end();
+    }
+
+    /// Returns `true` if the specified field exists.
+    bool
+    exists(boost::string_ref const& name) const
+    {
+        return find(name) != end();
+    }
+
+    /** Returns an iterator to the case-insensitive matching field name.
+
+        If more than one field with the specified name exists, the
+        first field defined by insertion order is returned.
+    */
+    iterator
+    find(boost::string_ref const& name) const
+    {
+        for(auto it = begin(); it != end(); ++it)
+            if(beast::detail::ci_equal(it->name(), name))
+                return it;
+        return end();
+    }
+
+    /** Returns the value for a case-insensitive matching header, or `""`.
+
+        If more than one field with the specified name exists, the
+        first field defined by insertion order is returned.
+    */
+    boost::string_ref
+    operator[](boost::string_ref const& name) const
+    {
+        auto const it = find(name);
+        if(it == end())
+            return {};
+        return it->value();
+    }
+
+    /// Clear the contents of the fields_view.
+    void
+    clear()
+    {
+        n_ = 0;
+    }
+
+    /** Insert a field.
+
+        The name and value are not copied, and must remain valid
+        for as long as the field is used.
+
+        @return `false` if the sequence is full, in which case
+        the field is not inserted.
+    */
+    bool
+    insert(boost::string_ref const& name,
+        boost::string_ref const& value)
+    {
+        if(n_ == N)
+            return false;
+        v_[n_++] = field_view{name, value};
+        return true;
+    }
+};
+
+namespace detail {
+
+struct message_view_request
+{
+    /// The Request Method
+    boost::string_ref method;
+
+    /// The Request URI
+    boost::string_ref url;
+};
+
+struct message_view_response
+{
+    /// The Response Status-Code
+    int status = 0;
+
+    /// The Response Reason-Phrase
+    boost::string_ref reason;
+};
+
+} // detail
+
+/** A HTTP/1 message header which refers to the buffer it was parsed from.
+
+    Unlike @ref message_v1, no part of the message is copied. The
+    start line and the fields are references into the input, and are
+    valid for as long as the buffer holding the header is unchanged.
+    Objects of this type are produced by @ref view_parser_v1.
+
+    @tparam isRequest `true` if this is a request.
+
+    @tparam N The largest number of fields held.
+*/
+template<bool isRequest, std::size_t N = 64>
+struct message_view
+#if ! GENERATING_DOCS
+    : std::conditional<isRequest,
+        detail::message_view_request,
+            detail::message_view_response>::type
+#endif
+{
+#if GENERATING_DOCS
+    /** The Request Method
+
+        @note This field is present only if `isRequest == true`.
+    */
+    boost::string_ref method;
+
+    /** The Request URI
+
+        @note This field is present only if `isRequest == true`.
+    */
+    boost::string_ref url;
+
+    /** The Response Status-Code
+
+        @note This field is present only if `isRequest == false`.
+    */
+    int status;
+
+    /** The Response Reason-Phrase
+
+        @note This field is present only if `isRequest == false`.
+    */
+    boost::string_ref reason;
+#endif
+
+    /// Indicates if the message is a request.
+    using is_request =
+        std::integral_constant<bool, isRequest>;
+
+    /// The type of the field sequence.
+    using fields_type = fields_view<N>;
+
+    /// HTTP version as in @ref message_v1::version
+    int version = 0;
+
+    /// The message fields.
+    fields_type fields;
+};
+
+} // http
+} // beast
+
+#endif
@@ -39,6 +39,7 @@ enum class parse_error
     headers_too_big,
     body_too_big,
     short_read,
+    non_contiguous,
 
     general
 };
@@ -114,6 +115,9 @@ public:
         case parse_error::short_read:
             return "unexpected end of data";
 
+        case parse_error::non_contiguous:
+            return "element not contiguous in the input";
+
         default:
             return "parse error";
         }
@@ -12,6 +12,7 @@
 #include <beast/http/concepts.hpp>
 #include <beast/http/message_v1.hpp>
 #include <beast/core/error.hpp>
+#include <boost/optional.hpp>
 #include <functional>
 #include <string>
 #include <type_traits>
@@ -33,6 +34,31 @@ struct parser_response
     std::string reason_;
 };
 
+// Clear a body, keeping its storage where the type allows
+
+template<class T>
+auto
+clear_body(T& t, int) ->
+    decltype(t.consume(t.size()), void())
+{
+    t.consume(t.size());
+}
+
+template<class T>
+auto
+clear_body(T& t, long) ->
+    decltype(t.clear(), void())
+{
+    t.clear();
+}
+
+template<class T>
+void
+clear_body(T& t, ...)
+{
+    t = T{};
+}
+
 } // detail
 
 /** Skip body option.
@@ -71,7 +97,12 @@ struct skip_body
     This class uses the basic HTTP/1 wire format parser to convert
     a series of octets into a `message_v1`.
 
-    @note A new instance of the parser is required for each message.
+    To parse another message, call @ref reset. The storage already
+    allocated by the parser and the message is kept where the types
+    allow, so that a parser reused for each message on a persistent
+    connection stops allocating once its storage is large enough.
+    A message previously taken with @ref release may be given back
+    to be reused in the same way.
 */
 template<bool isRequest, class Body, class Headers>
 class parser_v1
@@ -92,7 +123,7 @@ private:
     std::string field_;
     std::string value_;
     message_type m_;
-    typename message_type::body_type::reader r_;
+    boost::optional<typename message_type::body_type::reader> r_;
     std::uint8_t skip_body_ = 0;
 
 public:
@@ -109,8 +140,8 @@ public:
     explicit
     parser_v1(Args&&... args)
         : m_(std::forward<Args>(args)...)
-        , r_(m_)
     {
+        r_.emplace(m_);
     }
 
     /// Set the expect body option.
@@ -156,6 +187,37 @@ public:
         return std::move(m_);
     }
 
+    /** Reset the parser to parse a new message.
+
+        The message is cleared. Its strings, fields and body keep
+        the storage they have allocated where their types allow:
+        strings and bodies with a `clear` member, and dynamic buffer
+        bodies, keep their capacity, and so do the fields of
+        @ref flat_headers. Options keep their values.
+    */
+#if GENERATING_DOCS
+    void
+    reset();
+#else
+    using basic_parser_v1<isRequest, parser_v1>::reset;
+#endif
+
+    /** Reset the parser to parse a new message into a recycled message.
+
+        The message is moved into the parser, then cleared as by
+        @ref reset, so that the storage it holds is reused for the
+        next message. This is typically a message obtained earlier
+        from @ref release.
+
+        @param m The message to reuse.
+    */
+    void
+    reset(message_type&& m)
+    {
+        m_ = std::move(m);
+        reset();
+    }
+
 private:
     friend class basic_parser_v1<isRequest, parser_v1>;
 
@@ -169,8 +231,21 @@ private:
         }
     }
 
+    void on_reset()
+    {
+        field_.clear();
+        value_.clear();
+        clear(std::integral_constant<bool, isRequest>{});
+        m_.version = 0;
+        m_.headers.clear();
+        detail::clear_body(m_.body, 0);
+        r_.emplace(m_);
+    }
+
     void on_start(error_code&)
     {
+        start(std::integral_constant<
+            bool, isRequest>{});
     }
 
     void on_method(boost::string_ref const& s, error_code&)
@@ -199,16 +274,44 @@ private:
         value_.append(s.data(), s.size());
     }
 
+    // The strings are swapped, so that the storage of
+    // a recycled message is used for the next message.
+
     void set(std::true_type)
     {
-        m_.method = std::move(this->method_);
-        m_.url = std::move(this->uri_);
+        using std::swap;
+        swap(m_.method, this->method_);
+        swap(m_.url, this->uri_);
     }
 
     void set(std::false_type)
     {
+        using std::swap;
         m_.status = this->status_code();
-        m_.reason = std::move(this->reason_);
+        swap(m_.reason, this->reason_);
+    }
+
+    void clear(std::true_type)
+    {
+        m_.method.clear();
+        m_.url.clear();
+    }
+
+    void clear(std::false_type)
+    {
+        m_.status = 0;
+        m_.reason.clear();
+    }
+
+    void start(std::true_type)
+    {
+        this->method_.clear();
+        this->uri_.clear();
+    }
+
+    void start(std::false_type)
+    {
+        this->reason_.clear();
     }
 
     int on_headers(std::uint64_t, error_code&)
@@ -232,7 +335,7 @@ private:
 
     void on_body(boost::string_ref const& s, error_code& ec)
     {
-        r_.write(s.data(), s.size(), ec);
+        r_->write(s.data(), s.size(), ec);
     }
 
     void on_complete(error_code&)
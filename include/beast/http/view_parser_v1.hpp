@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_HTTP_VIEW_PARSER_V1_HPP
+#define BEAST_HTTP_VIEW_PARSER_V1_HPP
+
+#include <beast/http/basic_parser_v1.hpp>
+#include <beast/http/message_view.hpp>
+#include <beast/http/parse_error.hpp>
+#include <beast/core/error.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace beast {
+namespace http {
+
+/** A parser for producing HTTP/1 message views.
+
+    This class uses the basic HTTP/1 wire format parser to convert
+    the header of a message into a @ref message_view. Nothing is
+    copied and no memory is allocated: the start line and each field
+    name and value refer to the octets presented to the parser, which
+    must remain unchanged for as long as the view is used.
+
+    The header may be presented in more than one call to `write`,
+    as long as each call continues the same contiguous buffer from
+    where the previous one left off. Each element of the header must
+    be contiguous in the input. A value continued with the obsolete
+    line folding, or an element split across separate buffers,
+    fails with @ref parse_error::non_contiguous. When a message has
+    more fields than the view can hold, parsing fails with
+    @ref parse_error::headers_too_big.
+
+    The body is not parsed. Once the header is complete, `complete()`
+    returns `true` and the value returned by the final call to `write`
+    leaves the input positioned at the first octet of the body, if
+    any. The body is described by @ref content_length and by the
+    flags of the parser.
+
+    Example:
+    @code
+        view_parser_v1<true> p;
+        auto const n = p.write(sb.data(), ec);
+        if(! ec && p.complete())
+        {
+            auto const& m = p.get();
+            if(m.method == "GET")
+                ...
+            sb.consume(n);  // invalidates m
+        }
+    @endcode
+
+    To parse another message, call @ref reset, which also clears
+    the message view.
+
+    @tparam isRequest `true` to parse a request.
+
+    @tparam N The largest number of fields in the message.
+*/
+template<bool isRequest, std::size_t N = 64>
+class view_parser_v1
+    : public basic_parser_v1<isRequest,
+        view_parser_v1<isRequest, N>>
+{
+public:
+    /// The type of message this parser produces.
+    using message_type = message_view<isRequest, N>;
+
+private:
+    message_type m_;
+    boost::string_ref field_;
+    boost::string_ref value_;
+    std::uint64_t content_length_ = no_content_length;
+    bool in_value_ = false;
+
+public:
+    view_parser_v1(view_parser_v1 const&) = default;
+    view_parser_v1& operator=(view_parser_v1 const&) = default;
+
+    /// Default constructor
+    view_parser_v1() = default;
+
+    /** Returns the parsed message.
+
+        Only valid if `complete()` would return `true`.
+    */
+    message_type const&
+    get() const
+    {
+        return m_;
+    }
+
+    /** Returns the Content-Length of the body.
+
+        If the message has no Content-Length field, the value
+        @ref no_content_length is returned. Only valid if
+        `complete()` would return `true`.
+    */
+    std::uint64_t
+    content_length() const
+    {
+        return content_length_;
+    }
+
+private:
+    friend class basic_parser_v1<isRequest, view_parser_v1>;
+
+    void on_reset()
+    {
+        m_ = message_type{};
+        field_.clear();
+        value_.clear();
+        content_length_ = no_content_length;
+        in_value_ = false;
+    }
+
+    // Extend `v` with the next piece of the same element
+    static
+    bool
+    append(boost::string_ref& v, boost::string_ref const& s)
+    {
+        if(s.empty())
+            return true;
+        if(v.empty())
+        {
+            v = s;
+            return true;
+        }
+        if(v.data() + v.size() != s.data())
+            return false;
+        v = boost::string_ref{v.data(), v.size() + s.size()};
+        return true;
+    }
+
+    void flush(error_code& ec)
+    {
+        if(field_.empty())
+            return;
+        if(! m_.fields.insert(field_, value_))
+        {
+            ec = parse_error::headers_too_big;
+            return;
+        }
+        field_.clear();
+        value_.clear();
+        in_value_ = false;
+    }
+
+    void on_method(boost::string_ref const& s, error_code& ec)
+    {
+        if(! append(m_.method, s))
+            ec = parse_error::non_contiguous;
+    }
+
+    void on_uri(boost::string_ref const& s, error_code& ec)
+    {
+        if(! append(m_.url, s))
+            ec = parse_error::non_contiguous;
+    }
+
+    void on_reason(boost::string_ref const& s, error_code& ec)
+    {
+        if(! append(m_.reason, s))
+            ec = parse_error::non_contiguous;
+    }
+
+    void on_field(boost::string_ref const& s, error_code& ec)
+    {
+        if(in_value_)
+        {
+            flush(ec);
+            if(ec)
+                return;
+        }
+        if(! append(field_, s))
+            ec = parse_error::non_contiguous;
+    }
+
+    void on_value(boost::string_ref const& s, error_code& ec)
+    {
+        in_value_ = true;
+        if(! append(value_, s))
+            ec = parse_error::non_contiguous;
+    }
+
+    void set(std::true_type)
+    {
+    }
+
+    void set(std::false_type)
+    {
+        m_.status = this->status_code();
+    }
+
+    int on_headers(std::uint64_t content_length, error_code& ec)
+    {
+        flush(ec);
+        content_length_ = content_length;
+        m_.version = 10 * this->http_major() + this->http_minor();
+        set(std::integral_constant<bool, isRequest>{});
+        // The body is left in the input
+        return 1;
+    }
+};
+
+} // http
+} // beast
+
+#endif
@@ -9,7 +9,9 @@
 #define BEAST_WEBSOCKET_HPP
 
 #include <beast/websocket/error.hpp>
+#include <beast/websocket/frame_codec.hpp>
 #include <beast/websocket/option.hpp>
+#include <beast/websocket/prepared_message.hpp>
 #include <beast/websocket/rfc6455.hpp>
 #include <beast/websocket/stream.hpp>
 #include <beast/websocket/teardown.hpp>
@@ -163,6 +163,90 @@ write(DynamicBuffer& db, frame_header const& fh)
         db.prepare(n), buffer(b)));
 }
 
+// Returns the size of the frame header at the front of
+// the buffers, or 2 if the size cannot be determined yet.
+//
+template<class ConstBufferSequence>
+std::size_t
+fh_size(ConstBufferSequence const& bs)
+{
+    using boost::asio::buffer;
+    using boost::asio::buffer_copy;
+    std::uint8_t b[2];
+    if(buffer_copy(buffer(b), bs) < sizeof(b))
+        return 2;
+    std::size_t n = 2;
+    switch(b[1] & 0x7f)
+    {
+        case 126: n += 2; break;
+        case 127: n += 8; break;
+        default:
+            break;
+    }
+    if(b[1] & 0x80)
+        n += 4;
+    return n;
+}
+
+// Returns `true` if all the frames of the data message at the
+// front of the buffers are present, and sets `size` to the sum
+// of their payloads. Returns `false` if the message is incomplete,
+// or if a control frame or a compressed frame comes first. The
+// frames are not otherwise checked.
+//
+template<class ConstBufferSequence>
+bool
+is_message_buffered(ConstBufferSequence const& bs,
+    std::uint64_t& size)
+{
+    using boost::asio::buffer;
+    using boost::asio::buffer_copy;
+    using boost::asio::buffer_size;
+    using namespace boost::endian;
+    consuming_buffers<ConstBufferSequence> cb(bs);
+    auto remain = buffer_size(bs);
+    size = 0;
+    for(;;)
+    {
+        std::uint8_t b[10];
+        auto const n = buffer_copy(buffer(b), cb);
+        if(n < 2)
+            return false;
+        if(is_control(static_cast<opcode>(b[0] & 0x0f)) ||
+                (b[0] & 0x40))
+            return false;
+        std::size_t need = 2;
+        std::uint64_t len = b[1] & 0x7f;
+        switch(len)
+        {
+        case 126:
+            need += 2;
+            if(n < need)
+                return false;
+            len = big_uint16_to_native(&b[2]);
+            break;
+        case 127:
+            need += 8;
+            if(n < need)
+                return false;
+            len = big_uint64_to_native(&b[2]);
+            break;
+        default:
+            break;
+        }
+        if(b[1] & 0x80)
+            need += 4;
+        if(remain < need || len > remain - need)
+            return false;
+        auto const used = need + static_cast<std::size_t>(len);
+        cb.consume(used);
+        remain -= used;
+        size += len;
+        if(b[0] & 0x80)
+            return true;
+    }
+}
+
 // Read fixed frame header
 // Requires at least 2 bytes
 //
@@ -200,8 +284,9 @@ read_fh1(frame_header& fh, DynamicBuffer& db,
         code = close_code::protocol_error;
         return 0;
     }
-    // reserved bits not cleared
-    if(fh.rsv1 || fh.rsv2 || fh.rsv3)
+    // reserved bits not cleared, rsv1 on a data
+    // frame is checked against the negotiated extensions
+    if((fh.rsv1 && is_control(fh.op)) || fh.rsv2 || fh.rsv3)
     {
         code = close_code::protocol_error;
         return 0;
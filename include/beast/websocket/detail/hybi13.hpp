@@ -10,18 +10,25 @@
 
 #include <beast/core/detail/base64.hpp>
 #include <beast/core/detail/sha1.hpp>
+#include <beast/core/static_string.hpp>
 #include <boost/utility/string_ref.hpp>
+#include <array>
 #include <cstdint>
-#include <string>
 #include <type_traits>
 
 namespace beast {
 namespace websocket {
 namespace detail {
 
+using sec_ws_key_type = static_string<
+    beast::detail::base64_encoded_size(16)>;
+
+using sec_ws_accept_type = static_string<
+    beast::detail::base64_encoded_size(20)>;
+
 template<class Gen>
-std::string
-make_sec_ws_key(Gen& g)
+void
+make_sec_ws_key(sec_ws_key_type& key, Gen& g)
 {
     union U
     {
@@ -31,22 +38,27 @@ make_sec_ws_key(Gen& g)
     U u;
     for(int i = 0; i < 4; ++i)
         u.a4[i] = g();
-    return beast::detail::base64_encode(u.a16.data(), u.a16.size());
+    key.resize(key.max_size());
+    beast::detail::base64_encode(key.data(),
+        u.a16.data(), u.a16.size());
 }
 
 template<class = void>
-std::string
-make_sec_ws_accept(boost::string_ref const& key)
+void
+make_sec_ws_accept(sec_ws_accept_type& accept,
+    boost::string_ref const& key)
 {
-    std::string s(key.data(), key.size());
-    s += "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    static char constexpr guid[] =
+        "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
     beast::detail::sha1_context ctx;
     beast::detail::init(ctx);
-    beast::detail::update(ctx, s.data(), s.size());
+    beast::detail::update(ctx, key.data(), key.size());
+    beast::detail::update(ctx, guid, sizeof(guid) - 1);
     std::array<std::uint8_t,
         beast::detail::sha1_context::digest_size> digest;
     beast::detail::finish(ctx, digest.data());
-    return beast::detail::base64_encode(
+    accept.resize(accept.max_size());
+    beast::detail::base64_encode(accept.data(),
         digest.data(), digest.size());
 }
 
@@ -113,6 +113,13 @@ public:
         return *this;
     }
 
+    // Returns `true` if an operation is waiting
+    explicit
+    operator bool() const
+    {
+        return base_ != nullptr;
+    }
+
     template<class F>
     void
     emplace(F&& f);
@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_DETAIL_KEEPALIVE_SERVICE_HPP
+#define BEAST_WEBSOCKET_DETAIL_KEEPALIVE_SERVICE_HPP
+
+#include <beast/websocket/detail/timer_wheel.hpp>
+#include <beast/core/error.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+template<class T>
+class is_closable
+{
+    template<class U, class R = decltype(
+        std::declval<U&>().close(std::declval<error_code&>()))>
+    static std::true_type check(int);
+    template<class>
+    static std::false_type check(...);
+    using type = decltype(check<T>(0));
+public:
+    static bool constexpr value = type::value;
+};
+
+// Close the lowest layer of a stream which stopped responding.
+// Streams which cannot be closed are only marked as failed.
+template<class Stream>
+void
+close_lowest_layer(Stream& stream, std::true_type)
+{
+    error_code ignored;
+    stream.lowest_layer().close(ignored);
+}
+
+template<class Stream>
+void
+close_lowest_layer(Stream&, std::false_type)
+{
+}
+
+// Drives the automatic pings of every stream on an io_service
+// from a single timer. Streams schedule themselves on a timing
+// wheel which the timer advances once per tick, so the cost of
+// a check does not depend on the number of streams, and nothing
+// is added to the io_service's timer queue per stream.
+//
+// The timer runs only while streams are scheduled, so that an
+// idle service does not keep io_service::run from returning.
+//
+class keepalive_service
+    : public boost::asio::detail::service_base<keepalive_service>
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+private:
+    timer_wheel wheel_;
+    boost::asio::basic_waitable_timer<clock_type> timer_;
+    clock_type::time_point next_;
+    bool running_ = false;
+
+public:
+    explicit
+    keepalive_service(boost::asio::io_service& ios)
+        : boost::asio::detail::service_base<
+            keepalive_service>(ios)
+        , wheel_(512)
+        , timer_(ios)
+    {
+    }
+
+    // The resolution of the wheel
+    static
+    clock_type::duration
+    tick()
+    {
+        return std::chrono::milliseconds(100);
+    }
+
+    // Schedule a hook to expire after at least `d`
+    void
+    schedule(timer_wheel::hook& h, clock_type::duration d)
+    {
+        auto const n = (d + tick() - clock_type::duration{1}) / tick();
+        wheel_.insert(h, n > 0 ? static_cast<std::size_t>(n) : 1);
+        if(running_)
+            return;
+        running_ = true;
+        next_ = clock_type::now() + tick();
+        wait();
+    }
+
+private:
+    void
+    shutdown_service() override
+    {
+        wheel_.clear();
+        error_code ec;
+        timer_.cancel(ec);
+    }
+
+    void
+    wait()
+    {
+        timer_.expires_at(next_);
+        timer_.async_wait(
+            [this](error_code const& ec)
+            {
+                on_timer(ec);
+            });
+    }
+
+    void
+    on_timer(error_code const& ec)
+    {
+        if(ec == boost::asio::error::operation_aborted)
+        {
+            running_ = false;
+            return;
+        }
+        // catch up when the timer completes late
+        auto const now = clock_type::now();
+        while(next_ <= now && wheel_.size() > 0)
+        {
+            wheel_.advance();
+            next_ += tick();
+        }
+        if(wheel_.size() == 0)
+        {
+            running_ = false;
+            return;
+        }
+        if(next_ <= now)
+            next_ = now + tick();
+        wait();
+    }
+};
+
+} // detail
+} // websocket
+} // beast
+
+#endif
@@ -8,10 +8,13 @@
 #ifndef BEAST_WEBSOCKET_DETAIL_MASK_HPP
 #define BEAST_WEBSOCKET_DETAIL_MASK_HPP
 
+#include <beast/core/detail/cpu_info.hpp>
 #include <boost/asio/buffer.hpp>
+#include <algorithm>
 #include <array>
 #include <climits>
 #include <cstdint>
+#include <cstring>
 #include <random>
 #include <type_traits>
 
@@ -67,7 +70,118 @@ maskgen_t<_>::rekey()
     g_.seed(ss);
 }
 
-using maskgen = maskgen_t<std::mt19937>;
+// ChaCha20 keystream (rfc7539) as a source of 32-bit values.
+// It is cryptographically secure, and much smaller than the
+// Mersenne Twister: 136 bytes instead of several kilobytes.
+//
+class chacha20
+{
+    std::uint32_t s_[16];   // constants, key, counter, nonce
+    std::uint32_t b_[16];   // current block of output
+    std::size_t i_ = 16;    // next word of output
+
+public:
+    using result_type = std::uint32_t;
+
+    static
+    constexpr
+    result_type
+    min()
+    {
+        return 0;
+    }
+
+    static
+    constexpr
+    result_type
+    max()
+    {
+        return 0xffffffff;
+    }
+
+    chacha20()
+        : s_{ 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 }
+    {
+    }
+
+    // Key and nonce are taken from the seed sequence
+    template<class SeedSeq>
+    void
+    seed(SeedSeq& ss)
+    {
+        std::uint32_t v[10];
+        ss.generate(&v[0], &v[10]);
+        std::copy(&v[0], &v[8], &s_[4]);
+        s_[12] = 0;
+        s_[13] = 0;
+        s_[14] = v[8];
+        s_[15] = v[9];
+        i_ = 16;
+    }
+
+    result_type
+    operator()() noexcept
+    {
+        if(i_ == 16)
+            refill();
+        return b_[i_++];
+    }
+
+private:
+    static
+    std::uint32_t
+    rotl(std::uint32_t x, unsigned n) noexcept
+    {
+        return (x << n) | (x >> (32 - n));
+    }
+
+    static
+    void
+    qr(std::uint32_t* x, int a, int b, int c, int d) noexcept
+    {
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a],  8);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c],  7);
+    }
+
+    void
+    refill() noexcept
+    {
+        std::copy(&s_[0], &s_[16], &b_[0]);
+        for(int i = 0; i < 10; ++i)
+        {
+            qr(b_, 0, 4,  8, 12);
+            qr(b_, 1, 5,  9, 13);
+            qr(b_, 2, 6, 10, 14);
+            qr(b_, 3, 7, 11, 15);
+            qr(b_, 0, 5, 10, 15);
+            qr(b_, 1, 6, 11, 12);
+            qr(b_, 2, 7,  8, 13);
+            qr(b_, 3, 4,  9, 14);
+        }
+        for(int i = 0; i < 16; ++i)
+            b_[i] += s_[i];
+        // 64-bit block counter
+        if(++s_[12] == 0)
+            ++s_[13];
+        i_ = 0;
+    }
+};
+
+using maskgen = maskgen_t<chacha20>;
+
+// Returns the mask key generator for the calling thread.
+// It is seeded from std::random_device on first use, so
+// streams neither store nor seed a generator themselves.
+//
+template<class = void>
+maskgen&
+thread_maskgen()
+{
+    static thread_local maskgen g;
+    return g;
+}
 
 //------------------------------------------------------------------------------
 
@@ -173,13 +287,161 @@ mask_inplace_general(
     }
 }
 
+//------------------------------------------------------------------------------
+
+// The kernels below operate on a 32-bit key whose low
+// order byte applies to the first byte of the range.
+// On return the key is rotated to apply to the byte
+// following the range, so a message may be masked in
+// pieces of any size.
+//
+using mask_kernel_type =
+    void(*)(std::uint8_t*, std::size_t, std::uint32_t&);
+
+// Byte at a time
+//
+inline
+void
+mask_bytes(std::uint8_t* p, std::size_t n, std::uint32_t& key)
+{
+    for(; n; --n, ++p)
+    {
+        *p ^= key;
+        key = ror(key, 8);
+    }
+}
+
+// Word at a time, portable
+//
+template<class = void>
+void
+mask_bytes_word(std::uint8_t* p, std::size_t n, std::uint32_t& key)
+{
+    using word_type = prepared_key_type;
+    auto const head = std::min(n, static_cast<std::size_t>(
+        (sizeof(word_type) - reinterpret_cast<std::uintptr_t>(
+            p) % sizeof(word_type)) % sizeof(word_type)));
+    mask_bytes(p, head, key);
+    p += head;
+    n -= head;
+    // Lay out the key in memory order so the
+    // result is independent of the host endianness.
+    std::uint8_t kb[sizeof(word_type)];
+    for(std::size_t i = 0; i < sizeof(kb); ++i)
+        kb[i] = static_cast<std::uint8_t>(key >> (8 * (i % 4)));
+    word_type k;
+    std::memcpy(&k, kb, sizeof(k));
+    for(; n >= sizeof(word_type); n -= sizeof(word_type))
+    {
+        word_type w;
+        std::memcpy(&w, p, sizeof(w));
+        w ^= k;
+        std::memcpy(p, &w, sizeof(w));
+        p += sizeof(word_type);
+    }
+    mask_bytes(p, n, key);
+}
+
+#if BEAST_SIMD_X86
+
+// 16 bytes at a time
+//
+template<class = void>
+void
+mask_bytes_sse2(std::uint8_t* p, std::size_t n, std::uint32_t& key)
+{
+    auto const head = std::min(n, static_cast<std::size_t>(
+        (16 - reinterpret_cast<std::uintptr_t>(p) % 16) % 16));
+    mask_bytes(p, head, key);
+    p += head;
+    n -= head;
+    auto const k = _mm_set1_epi32(static_cast<int>(key));
+    for(; n >= 64; n -= 64, p += 64)
+    {
+        auto const v = reinterpret_cast<__m128i*>(p);
+        _mm_store_si128(v + 0, _mm_xor_si128(_mm_load_si128(v + 0), k));
+        _mm_store_si128(v + 1, _mm_xor_si128(_mm_load_si128(v + 1), k));
+        _mm_store_si128(v + 2, _mm_xor_si128(_mm_load_si128(v + 2), k));
+        _mm_store_si128(v + 3, _mm_xor_si128(_mm_load_si128(v + 3), k));
+    }
+    for(; n >= 16; n -= 16, p += 16)
+    {
+        auto const v = reinterpret_cast<__m128i*>(p);
+        _mm_store_si128(v, _mm_xor_si128(_mm_load_si128(v), k));
+    }
+    mask_bytes(p, n, key);
+}
+
+// 32 bytes at a time
+//
+template<class = void>
+BEAST_TARGET_AVX2
+void
+mask_bytes_avx2(std::uint8_t* p, std::size_t n, std::uint32_t& key)
+{
+    auto const head = std::min(n, static_cast<std::size_t>(
+        (32 - reinterpret_cast<std::uintptr_t>(p) % 32) % 32));
+    mask_bytes(p, head, key);
+    p += head;
+    n -= head;
+    auto const k = _mm256_set1_epi32(static_cast<int>(key));
+    for(; n >= 128; n -= 128, p += 128)
+    {
+        auto const v = reinterpret_cast<__m256i*>(p);
+        _mm256_store_si256(v + 0, _mm256_xor_si256(_mm256_load_si256(v + 0), k));
+        _mm256_store_si256(v + 1, _mm256_xor_si256(_mm256_load_si256(v + 1), k));
+        _mm256_store_si256(v + 2, _mm256_xor_si256(_mm256_load_si256(v + 2), k));
+        _mm256_store_si256(v + 3, _mm256_xor_si256(_mm256_load_si256(v + 3), k));
+    }
+    for(; n >= 32; n -= 32, p += 32)
+    {
+        auto const v = reinterpret_cast<__m256i*>(p);
+        _mm256_store_si256(v, _mm256_xor_si256(_mm256_load_si256(v), k));
+    }
+    mask_bytes(p, n, key);
+}
+
+#endif
+
+// Returns the fastest kernel supported by the CPU.
+// The selection is made once, on first use.
+//
+template<class = void>
+mask_kernel_type
+mask_kernel()
+{
+    static mask_kernel_type const f =
+        []() -> mask_kernel_type
+        {
+        #if BEAST_SIMD_X86
+            auto const& ci = beast::detail::get_cpu_info();
+            if(ci.avx2)
+                return &mask_bytes_avx2<>;
+            if(ci.sse2)
+                return &mask_bytes_sse2<>;
+        #endif
+            return &mask_bytes_word<>;
+        }();
+    return f;
+}
+
+// Below this size the dispatch costs more than it saves
+std::size_t constexpr mask_kernel_min = 32;
+
 inline
 void
 mask_inplace(
     boost::asio::mutable_buffer const& b,
         std::uint32_t& key)
 {
-    mask_inplace_general(b, key);
+    using boost::asio::buffer_cast;
+    using boost::asio::buffer_size;
+    auto const n = buffer_size(b);
+    auto const p = buffer_cast<std::uint8_t*>(b);
+    if(n < mask_kernel_min)
+        mask_bytes(p, n, key);
+    else
+        mask_kernel()(p, n, key);
 }
 
 inline
@@ -188,7 +450,17 @@ mask_inplace(
     boost::asio::mutable_buffer const& b,
         std::uint64_t& key)
 {
-    mask_inplace_general(b, key);
+    using boost::asio::buffer_cast;
+    using boost::asio::buffer_size;
+    auto const n = buffer_size(b);
+    auto const p = buffer_cast<std::uint8_t*>(b);
+    // The prepared key repeats every 32 bits
+    auto k = static_cast<std::uint32_t>(key);
+    if(n < mask_kernel_min)
+        mask_bytes(p, n, k);
+    else
+        mask_kernel()(p, n, k);
+    prepare_key(key, k);
 }
 
 // Apply mask in place
@@ -202,6 +474,174 @@ mask_inplace(
         mask_inplace(b, key);
 }
 
+//------------------------------------------------------------------------------
+
+// The kernels below copy a range while masking it, so that
+// payload leaving the read buffer is touched only once. The
+// key works as for the in place kernels. The ranges must not
+// overlap.
+//
+using mask_copy_kernel_type = void(*)(std::uint8_t*,
+    std::uint8_t const*, std::size_t, std::uint32_t&);
+
+// Byte at a time
+//
+inline
+void
+mask_copy_bytes(std::uint8_t* dest, std::uint8_t const* src,
+    std::size_t n, std::uint32_t& key)
+{
+    for(; n; --n, ++dest, ++src)
+    {
+        *dest = *src ^ static_cast<std::uint8_t>(key);
+        key = ror(key, 8);
+    }
+}
+
+// Word at a time, portable
+//
+template<class = void>
+void
+mask_copy_word(std::uint8_t* dest, std::uint8_t const* src,
+    std::size_t n, std::uint32_t& key)
+{
+    using word_type = prepared_key_type;
+    auto const head = std::min(n, static_cast<std::size_t>(
+        (sizeof(word_type) - reinterpret_cast<std::uintptr_t>(
+            dest) % sizeof(word_type)) % sizeof(word_type)));
+    mask_copy_bytes(dest, src, head, key);
+    dest += head;
+    src += head;
+    n -= head;
+    std::uint8_t kb[sizeof(word_type)];
+    for(std::size_t i = 0; i < sizeof(kb); ++i)
+        kb[i] = static_cast<std::uint8_t>(key >> (8 * (i % 4)));
+    word_type k;
+    std::memcpy(&k, kb, sizeof(k));
+    for(; n >= sizeof(word_type); n -= sizeof(word_type))
+    {
+        word_type w;
+        std::memcpy(&w, src, sizeof(w));
+        w ^= k;
+        std::memcpy(dest, &w, sizeof(w));
+        dest += sizeof(word_type);
+        src += sizeof(word_type);
+    }
+    mask_copy_bytes(dest, src, n, key);
+}
+
+#if BEAST_SIMD_X86
+
+// 16 bytes at a time, aligned stores
+//
+template<class = void>
+void
+mask_copy_sse2(std::uint8_t* dest, std::uint8_t const* src,
+    std::size_t n, std::uint32_t& key)
+{
+    auto const head = std::min(n, static_cast<std::size_t>(
+        (16 - reinterpret_cast<std::uintptr_t>(dest) % 16) % 16));
+    mask_copy_bytes(dest, src, head, key);
+    dest += head;
+    src += head;
+    n -= head;
+    auto const k = _mm_set1_epi32(static_cast<int>(key));
+    for(; n >= 64; n -= 64, dest += 64, src += 64)
+    {
+        auto const d = reinterpret_cast<__m128i*>(dest);
+        auto const s = reinterpret_cast<__m128i const*>(src);
+        _mm_store_si128(d + 0, _mm_xor_si128(_mm_loadu_si128(s + 0), k));
+        _mm_store_si128(d + 1, _mm_xor_si128(_mm_loadu_si128(s + 1), k));
+        _mm_store_si128(d + 2, _mm_xor_si128(_mm_loadu_si128(s + 2), k));
+        _mm_store_si128(d + 3, _mm_xor_si128(_mm_loadu_si128(s + 3), k));
+    }
+    for(; n >= 16; n -= 16, dest += 16, src += 16)
+    {
+        auto const d = reinterpret_cast<__m128i*>(dest);
+        auto const s = reinterpret_cast<__m128i const*>(src);
+        _mm_store_si128(d, _mm_xor_si128(_mm_loadu_si128(s), k));
+    }
+    mask_copy_bytes(dest, src, n, key);
+}
+
+// 32 bytes at a time, aligned stores
+//
+template<class = void>
+BEAST_TARGET_AVX2
+void
+mask_copy_avx2(std::uint8_t* dest, std::uint8_t const* src,
+    std::size_t n, std::uint32_t& key)
+{
+    auto const head = std::min(n, static_cast<std::size_t>(
+        (32 - reinterpret_cast<std::uintptr_t>(dest) % 32) % 32));
+    mask_copy_bytes(dest, src, head, key);
+    dest += head;
+    src += head;
+    n -= head;
+    auto const k = _mm256_set1_epi32(static_cast<int>(key));
+    for(; n >= 128; n -= 128, dest += 128, src += 128)
+    {
+        auto const d = reinterpret_cast<__m256i*>(dest);
+        auto const s = reinterpret_cast<__m256i const*>(src);
+        _mm256_store_si256(d + 0, _mm256_xor_si256(_mm256_loadu_si256(s + 0), k));
+        _mm256_store_si256(d + 1, _mm256_xor_si256(_mm256_loadu_si256(s + 1), k));
+        _mm256_store_si256(d + 2, _mm256_xor_si256(_mm256_loadu_si256(s + 2), k));
+        _mm256_store_si256(d + 3, _mm256_xor_si256(_mm256_loadu_si256(s + 3), k));
+    }
+    for(; n >= 32; n -= 32, dest += 32, src += 32)
+    {
+        auto const d = reinterpret_cast<__m256i*>(dest);
+        auto const s = reinterpret_cast<__m256i const*>(src);
+        _mm256_store_si256(d, _mm256_xor_si256(_mm256_loadu_si256(s), k));
+    }
+    mask_copy_bytes(dest, src, n, key);
+}
+
+#endif
+
+// Returns the fastest copying kernel supported by the CPU.
+// The selection is made once, on first use.
+//
+template<class = void>
+mask_copy_kernel_type
+mask_copy_kernel()
+{
+    static mask_copy_kernel_type const f =
+        []() -> mask_copy_kernel_type
+        {
+        #if BEAST_SIMD_X86
+            auto const& ci = beast::detail::get_cpu_info();
+            if(ci.avx2)
+                return &mask_copy_avx2<>;
+            if(ci.sse2)
+                return &mask_copy_sse2<>;
+        #endif
+            return &mask_copy_word<>;
+        }();
+    return f;
+}
+
+inline
+void
+mask_copy(std::uint8_t* dest, std::uint8_t const* src,
+    std::size_t n, std::uint32_t& key)
+{
+    if(n < mask_kernel_min)
+        mask_copy_bytes(dest, src, n, key);
+    else
+        mask_copy_kernel()(dest, src, n, key);
+}
+
+inline
+void
+mask_copy(std::uint8_t* dest, std::uint8_t const* src,
+    std::size_t n, std::uint64_t& key)
+{
+    auto k = static_cast<std::uint32_t>(key);
+    mask_copy(dest, src, n, k);
+    prepare_key(key, k);
+}
+
 } // detail
 } // websocket
 } // beast
@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_DETAIL_OP_POOL_HPP
+#define BEAST_WEBSOCKET_DETAIL_OP_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+// Recycles the memory holding the state of the composed
+// operations of one stream. Each block is kept after it is
+// released and handed out again to a request of the same or
+// smaller size, so once warmed up the read and write loops of
+// a stream do not touch the heap for their own state. Requests
+// beyond the number of blocks fall back to operator new.
+//
+// The state is released by whichever thread destroys the last
+// copy of a handler, which is not necessarily inside the
+// stream's strand, so blocks are claimed atomically.
+//
+class op_pool
+{
+    struct block
+    {
+        std::atomic<bool> used{false};
+        std::atomic<void*> p{nullptr};
+        std::atomic<std::size_t> size{0};
+    };
+
+    static std::size_t constexpr N = 16;
+
+    block v_[N];
+
+public:
+    op_pool() = default;
+    op_pool(op_pool const&) = delete;
+    op_pool& operator=(op_pool const&) = delete;
+
+    ~op_pool()
+    {
+        for(auto& b : v_)
+            ::operator delete(b.p.load());
+    }
+
+    void*
+    allocate(std::size_t size)
+    {
+        // Prefer a free block which is large enough
+        for(auto& b : v_)
+            if(b.size.load(std::memory_order_relaxed) >= size &&
+                    claim(b))
+                return b.size.load(std::memory_order_relaxed) >= size ?
+                    b.p.load(std::memory_order_relaxed) : grow(b, size);
+        for(auto& b : v_)
+            if(claim(b))
+                return grow(b, size);
+        return ::operator new(size);
+    }
+
+    void
+    deallocate(void* p, std::size_t)
+    {
+        for(auto& b : v_)
+        {
+            if(b.p.load(std::memory_order_acquire) == p)
+            {
+                b.used.store(false, std::memory_order_release);
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+private:
+    static
+    bool
+    claim(block& b)
+    {
+        return ! b.used.load(std::memory_order_relaxed) &&
+            ! b.used.exchange(true, std::memory_order_acquire);
+    }
+
+    static
+    void*
+    grow(block& b, std::size_t size)
+    {
+        void* p;
+        try
+        {
+            p = ::operator new(size);
+        }
+        catch(...)
+        {
+            b.used.store(false, std::memory_order_release);
+            throw;
+        }
+        // Publish the new block before freeing the old one. Once
+        // freed, its address may be handed to a fallback allocation
+        // on another thread, which deallocate must not mistake for
+        // this block.
+        auto const old = b.p.load(std::memory_order_relaxed);
+        b.size.store(size, std::memory_order_relaxed);
+        b.p.store(p, std::memory_order_release);
+        ::operator delete(old);
+        return p;
+    }
+};
+
+// An allocator drawing from an op_pool, which it keeps
+// alive so that operations may outlive their stream.
+//
+template<class T>
+class op_alloc
+{
+    template<class U>
+    friend class op_alloc;
+
+    std::shared_ptr<op_pool> pool_;
+
+public:
+    using value_type = T;
+    using is_always_equal = std::false_type;
+
+    explicit
+    op_alloc(std::shared_ptr<op_pool> pool)
+        : pool_(std::move(pool))
+    {
+    }
+
+    template<class U>
+    op_alloc(op_alloc<U> const& other)
+        : pool_(other.pool_)
+    {
+    }
+
+    value_type*
+    allocate(std::size_t n)
+    {
+        return static_cast<value_type*>(
+            pool_->allocate(n * sizeof(T)));
+    }
+
+    void
+    deallocate(value_type* p, std::size_t n)
+    {
+        pool_->deallocate(p, n * sizeof(T));
+    }
+
+    template<class U>
+    bool
+    operator==(op_alloc<U> const& other) const
+    {
+        return pool_ == other.pool_;
+    }
+
+    template<class U>
+    bool
+    operator!=(op_alloc<U> const& other) const
+    {
+        return pool_ != other.pool_;
+    }
+};
+
+} // detail
+} // websocket
+} // beast
+
+#endif
@@ -0,0 +1,616 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_DETAIL_PMD_EXTENSION_HPP
+#define BEAST_WEBSOCKET_DETAIL_PMD_EXTENSION_HPP
+
+#include <beast/http/detail/rfc7230.hpp>
+#include <beast/core/detail/ci_char_traits.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <zlib.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+// permessage-deflate offer parameters (rfc7692)
+//
+// The same structure holds the local settings, a received
+// offer or response, and the parameters finally negotiated.
+//
+struct pmd_offer
+{
+    bool accept = false;
+
+    // 0 = absent, or 8..15
+    int server_max_window_bits = 0;
+
+    // -1 = present without a value
+    // 0 = absent, or 8..15
+    int client_max_window_bits = 0;
+
+    bool server_no_context_takeover = false;
+    bool client_no_context_takeover = false;
+};
+
+// Reads a Sec-WebSocket-Extensions field value. Unlike the
+// rfc7230 parameter lists, extension parameters may omit
+// the value (rfc6455 section 9.1):
+//
+//  extension-list  = 1#extension
+//  extension       = extension-token *( OWS ";" OWS extension-param )
+//  extension-param = token [ OWS "=" OWS ( token / quoted-string ) ]
+//
+class ext_reader
+{
+    using iter_type = boost::string_ref::const_iterator;
+
+    iter_type it_;
+    iter_type end_;
+    bool first_ = true;
+    bool error_ = false;
+
+public:
+    explicit
+    ext_reader(boost::string_ref const& s)
+        : it_(s.begin())
+        , end_(s.end())
+    {
+    }
+
+    // `true` if the field value is malformed
+    bool
+    error() const
+    {
+        return error_;
+    }
+
+    // Advance to the next extension, skipping the
+    // remaining parameters of the current one.
+    // Returns `false` at the end or on error.
+    template<class = void>
+    bool
+    next(boost::string_ref& token);
+
+    // Read the next parameter of the current extension.
+    // Returns `false` when there are none left or on error.
+    template<class = void>
+    bool
+    param(boost::string_ref& name, std::string& value);
+};
+
+template<class>
+bool
+ext_reader::next(boost::string_ref& token)
+{
+    using http::detail::is_tchar;
+    using http::detail::skip_ows;
+    if(! first_)
+    {
+        boost::string_ref name;
+        std::string value;
+        while(param(name, value))
+            ;
+        if(error_)
+            return false;
+        skip_ows(it_, end_);
+        if(it_ == end_)
+            return false;
+        if(*it_ != ',')
+        {
+            error_ = true;
+            return false;
+        }
+    }
+    first_ = false;
+    // skip empty list elements
+    for(;;)
+    {
+        skip_ows(it_, end_);
+        if(it_ == end_)
+            return false;
+        if(*it_ != ',')
+            break;
+        ++it_;
+    }
+    if(! is_tchar(*it_))
+    {
+        error_ = true;
+        return false;
+    }
+    auto const p0 = it_;
+    while(it_ != end_ && is_tchar(*it_))
+        ++it_;
+    token = {&*p0, static_cast<std::size_t>(it_ - p0)};
+    return true;
+}
+
+template<class>
+bool
+ext_reader::param(boost::string_ref& name, std::string& value)
+{
+    using http::detail::is_qdchar;
+    using http::detail::is_qpchar;
+    using http::detail::is_tchar;
+    using http::detail::skip_ows;
+    auto const err =
+        [&]
+        {
+            error_ = true;
+            return false;
+        };
+    if(error_)
+        return false;
+    auto it = it_;
+    skip_ows(it, end_);
+    if(it == end_ || *it != ';')
+        return false;
+    ++it;
+    skip_ows(it, end_);
+    if(it == end_ || ! is_tchar(*it))
+        return err();
+    auto const p0 = it;
+    while(it != end_ && is_tchar(*it))
+        ++it;
+    name = {&*p0, static_cast<std::size_t>(it - p0)};
+    value.clear();
+    it_ = it;
+    skip_ows(it, end_);
+    if(it == end_ || *it != '=')
+        return true;
+    ++it;
+    skip_ows(it, end_);
+    if(it == end_)
+        return err();
+    if(*it == '"')
+    {
+        // quoted-string
+        ++it;
+        for(;;)
+        {
+            if(it == end_)
+                return err();
+            auto c = *it++;
+            if(c == '"')
+                break;
+            if(c == '\\')
+            {
+                if(it == end_)
+                    return err();
+                c = *it++;
+                if(! is_qpchar(c))
+                    return err();
+            }
+            else if(! is_qdchar(c))
+            {
+                return err();
+            }
+            value.push_back(c);
+        }
+    }
+    else
+    {
+        // token
+        if(! is_tchar(*it))
+            return err();
+        auto const p1 = it;
+        while(it != end_ && is_tchar(*it))
+            ++it;
+        value.assign(&*p1, it - p1);
+    }
+    it_ = it;
+    return true;
+}
+
+// Parse a window bits parameter value,
+// returns 0 if the value is not valid.
+//
+template<class = void>
+int
+pmd_parse_bits(boost::string_ref const& s)
+{
+    if(s.empty() || s.size() > 2 || s[0] == '0')
+        return 0;
+    int i = 0;
+    for(auto c : s)
+    {
+        if(c < '0' || c > '9')
+            return 0;
+        i = 10 * i + (c - '0');
+    }
+    if(i < 8 || i > 15)
+        return 0;
+    return i;
+}
+
+// Parse the parameters of the current permessage-deflate
+// extension. Returns `false` on unknown, duplicate, or malformed
+// parameters, which means the extension must be declined.
+//
+template<class = void>
+bool
+pmd_read(pmd_offer& offer, ext_reader& r)
+{
+    using beast::detail::ci_equal;
+    offer = pmd_offer{};
+    boost::string_ref name;
+    std::string value;
+    while(r.param(name, value))
+    {
+        if(ci_equal(name, "server_max_window_bits"))
+        {
+            if(offer.server_max_window_bits != 0)
+                return false;
+            offer.server_max_window_bits =
+                pmd_parse_bits(value);
+            if(offer.server_max_window_bits == 0)
+                return false;
+        }
+        else if(ci_equal(name, "client_max_window_bits"))
+        {
+            if(offer.client_max_window_bits != 0)
+                return false;
+            if(value.empty())
+            {
+                offer.client_max_window_bits = -1;
+            }
+            else
+            {
+                offer.client_max_window_bits =
+                    pmd_parse_bits(value);
+                if(offer.client_max_window_bits == 0)
+                    return false;
+            }
+        }
+        else if(ci_equal(name, "server_no_context_takeover"))
+        {
+            if(offer.server_no_context_takeover ||
+                    ! value.empty())
+                return false;
+            offer.server_no_context_takeover = true;
+        }
+        else if(ci_equal(name, "client_no_context_takeover"))
+        {
+            if(offer.client_no_context_takeover ||
+                    ! value.empty())
+                return false;
+            offer.client_no_context_takeover = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if(r.error())
+        return false;
+    offer.accept = true;
+    return true;
+}
+
+// Produce the Sec-WebSocket-Extensions field value for an offer
+//
+template<class = void>
+std::string
+pmd_write(pmd_offer const& offer)
+{
+    std::string s = "permessage-deflate";
+    if(offer.server_max_window_bits != 0)
+    {
+        s += "; server_max_window_bits=";
+        s += std::to_string(offer.server_max_window_bits);
+    }
+    if(offer.client_max_window_bits == -1)
+    {
+        s += "; client_max_window_bits";
+    }
+    else if(offer.client_max_window_bits != 0)
+    {
+        s += "; client_max_window_bits=";
+        s += std::to_string(offer.client_max_window_bits);
+    }
+    if(offer.server_no_context_takeover)
+        s += "; server_no_context_takeover";
+    if(offer.client_no_context_takeover)
+        s += "; client_no_context_takeover";
+    return s;
+}
+
+// Produce the client offer from the local settings.
+//
+// `ours` holds the configured window bits (9..15)
+// and context takeover preferences.
+//
+template<class = void>
+std::string
+pmd_offer_request(pmd_offer const& ours)
+{
+    pmd_offer offer;
+    if(ours.server_max_window_bits < 15)
+        offer.server_max_window_bits =
+            ours.server_max_window_bits;
+    // Always indicate that the server may limit our window
+    offer.client_max_window_bits =
+        ours.client_max_window_bits < 15 ?
+            ours.client_max_window_bits : -1;
+    offer.server_no_context_takeover =
+        ours.server_no_context_takeover;
+    offer.client_no_context_takeover =
+        ours.client_no_context_takeover;
+    return pmd_write(offer);
+}
+
+// Returns about the number of bytes zlib allocates for a
+// stream which inflates with a window of `inflate_bits`, and
+// deflates with `deflate_bits` and `mem_level` (see zconf.h).
+//
+template<class = void>
+std::size_t
+pmd_memory(int inflate_bits, int deflate_bits, int mem_level)
+{
+    return (std::size_t{1} << inflate_bits) + 7 * 1024 +
+        (std::size_t{1} << (deflate_bits + 2)) +
+        (std::size_t{1} << (mem_level + 9));
+}
+
+// Lowers the window bits and the memory level, the largest
+// consumer first, until a stream in either role fits in
+// `limit` bytes. Returns `false` if the smallest settings
+// do not fit.
+//
+template<class = void>
+bool
+pmd_limit(int& server_bits, int& client_bits,
+    int& mem_level, std::size_t limit)
+{
+    auto bits = std::max(server_bits, client_bits);
+    while(pmd_memory(bits, bits, mem_level) > limit)
+    {
+        if(bits > 9 && (mem_level == 1 ||
+            (std::size_t{5} << bits) >=
+                (std::size_t{1} << (mem_level + 9))))
+            --bits;
+        else if(mem_level > 1)
+            --mem_level;
+        else
+            return false;
+    }
+    server_bits = std::min(server_bits, bits);
+    client_bits = std::min(client_bits, bits);
+    return true;
+}
+
+// Server: choose the first acceptable offer in the client's
+// Sec-WebSocket-Extensions field value. On success `config`
+// holds the negotiated window bits, which are never absent,
+// and the returned string is the response field value.
+// Otherwise `config.accept` is `false` and the string is empty.
+//
+// When `strict` is set, offers from clients whose window
+// cannot be limited to `ours.client_max_window_bits` are
+// declined, so that the inflater stays within its budget.
+//
+template<class = void>
+std::string
+pmd_negotiate(pmd_offer& config,
+    boost::string_ref const& field, pmd_offer const& ours,
+        bool strict = false)
+{
+    using beast::detail::ci_equal;
+    config = pmd_offer{};
+    ext_reader r{field};
+    boost::string_ref token;
+    while(r.next(token))
+    {
+        if(! ci_equal(token, "permessage-deflate"))
+            continue;
+        pmd_offer offer;
+        if(! pmd_read(offer, r))
+            continue;
+        // A client which can't be limited would exceed the budget
+        if(strict && offer.client_max_window_bits == 0 &&
+                ours.client_max_window_bits < 15)
+            continue;
+        pmd_offer res;
+        if(offer.server_max_window_bits != 0)
+        {
+            // zlib cannot produce a window of 8 bits
+            if(offer.server_max_window_bits < 9)
+                continue;
+            res.server_max_window_bits = std::min(
+                offer.server_max_window_bits,
+                    ours.server_max_window_bits);
+            config.server_max_window_bits =
+                res.server_max_window_bits;
+        }
+        else
+        {
+            // A smaller window than the client
+            // expects is always safe to use.
+            config.server_max_window_bits =
+                ours.server_max_window_bits;
+        }
+        if(offer.client_max_window_bits != 0)
+        {
+            auto const bits =
+                offer.client_max_window_bits == -1 ?
+                    15 : offer.client_max_window_bits;
+            if(ours.client_max_window_bits < bits)
+            {
+                res.client_max_window_bits =
+                    ours.client_max_window_bits;
+                config.client_max_window_bits =
+                    ours.client_max_window_bits;
+            }
+            else
+            {
+                config.client_max_window_bits = bits;
+            }
+        }
+        else
+        {
+            // The client can't be limited
+            config.client_max_window_bits = 15;
+        }
+        res.server_no_context_takeover =
+            offer.server_no_context_takeover ||
+                ours.server_no_context_takeover;
+        res.client_no_context_takeover =
+            offer.client_no_context_takeover ||
+                ours.client_no_context_takeover;
+        config.server_no_context_takeover =
+            res.server_no_context_takeover;
+        config.client_no_context_takeover =
+            res.client_no_context_takeover;
+        config.accept = true;
+        return pmd_write(res);
+    }
+    return {};
+}
+
+// Client: validate the server's Sec-WebSocket-Extensions field
+// value against the offer made from `ours`. Returns `false` if
+// the connection must be failed. On success `config` holds the
+// negotiated parameters, with `config.accept` set to `true`
+// only if the server accepted the extension.
+//
+template<class = void>
+bool
+pmd_accept(pmd_offer& config,
+    boost::string_ref const& field, pmd_offer const& ours)
+{
+    using beast::detail::ci_equal;
+    config = pmd_offer{};
+    ext_reader r{field};
+    boost::string_ref token;
+    while(r.next(token))
+    {
+        // we only offered one extension, once
+        if(! ci_equal(token, "permessage-deflate"))
+            return false;
+        if(config.accept)
+            return false;
+        pmd_offer res;
+        if(! pmd_read(res, r))
+            return false;
+        if(res.server_max_window_bits != 0)
+        {
+            if(ours.server_max_window_bits < 15 &&
+                    res.server_max_window_bits >
+                        ours.server_max_window_bits)
+                return false;
+            config.server_max_window_bits =
+                res.server_max_window_bits;
+        }
+        else
+        {
+            // a limit we asked for must be acknowledged
+            if(ours.server_max_window_bits < 15)
+                return false;
+            config.server_max_window_bits = 15;
+        }
+        if(res.client_max_window_bits != 0)
+        {
+            // a value is required, and zlib
+            // cannot produce a window of 8 bits
+            if(res.client_max_window_bits < 9 ||
+                    res.client_max_window_bits >
+                        ours.client_max_window_bits)
+                return false;
+            config.client_max_window_bits =
+                res.client_max_window_bits;
+        }
+        else
+        {
+            config.client_max_window_bits =
+                ours.client_max_window_bits;
+        }
+        config.server_no_context_takeover =
+            res.server_no_context_takeover;
+        config.client_no_context_takeover =
+            res.client_no_context_takeover ||
+                ours.client_no_context_takeover;
+        config.accept = true;
+    }
+    if(r.error())
+    {
+        config.accept = false;
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// permessage-deflate per-stream state
+//
+// Memory use is roughly (1 << rd_bits) + 7KB for the inflater
+// and (1 << (wr_bits + 2)) + (1 << (mem_level + 9)) for the
+// deflater, plus the compressed payload buffer.
+//
+struct pmd_t
+{
+    std::uint64_t rd_size;              // inflated size of current message
+    bool rd_set;                        // current message is compressed
+    bool rd_reset;                      // reset inflater after each message
+    bool wr_reset;                      // reset deflater after each message
+    z_stream zi;                        // inflater
+    z_stream zo;                        // deflater
+    std::uint8_t rd_buf[4096];          // compressed payload
+
+    pmd_t(pmd_t const&) = delete;
+    pmd_t& operator=(pmd_t const&) = delete;
+
+    pmd_t(int rd_bits, bool rd_reset_, int wr_bits,
+        bool wr_reset_, int level, int mem_level);
+
+    ~pmd_t();
+};
+
+inline
+pmd_t::pmd_t(int rd_bits, bool rd_reset_, int wr_bits,
+        bool wr_reset_, int level, int mem_level)
+    : rd_size(0)
+    , rd_set(false)
+    , rd_reset(rd_reset_)
+    , wr_reset(wr_reset_)
+{
+    zi.zalloc = Z_NULL;
+    zi.zfree = Z_NULL;
+    zi.opaque = Z_NULL;
+    zi.next_in = Z_NULL;
+    zi.avail_in = 0;
+    // negative window bits selects raw deflate
+    if(inflateInit2(&zi, -rd_bits) != Z_OK)
+        throw std::bad_alloc{};
+    zo.zalloc = Z_NULL;
+    zo.zfree = Z_NULL;
+    zo.opaque = Z_NULL;
+    if(deflateInit2(&zo, level, Z_DEFLATED,
+        -wr_bits, mem_level, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        inflateEnd(&zi);
+        throw std::bad_alloc{};
+    }
+}
+
+inline
+pmd_t::~pmd_t()
+{
+    deflateEnd(&zo);
+    inflateEnd(&zi);
+}
+
+} // detail
+} // websocket
+} // beast
+
+#endif
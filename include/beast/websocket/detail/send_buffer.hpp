@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_DETAIL_SEND_BUFFER_HPP
+#define BEAST_WEBSOCKET_DETAIL_SEND_BUFFER_HPP
+
+#include <beast/websocket/rfc6455.hpp>
+#include <beast/core/streambuf.hpp>
+#include <boost/asio/buffer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+// A complete unmasked frame, encoded once
+// and shared by every stream sending it.
+//
+struct shared_frame
+{
+    opcode op;
+    std::size_t header_size;
+    std::size_t size;
+    std::unique_ptr<std::uint8_t[]> data;
+
+    boost::asio::const_buffers_1
+    buffer() const
+    {
+        return {data.get(), size};
+    }
+
+    boost::asio::const_buffers_1
+    payload() const
+    {
+        return {data.get() + header_size,
+            size - header_size};
+    }
+};
+
+// Outgoing frames waiting to be written. Frames copied into
+// the buffer are interleaved with references to shared frames,
+// so a broadcast costs each stream only a reference count.
+//
+class send_buffer
+{
+    using frame_ptr = std::shared_ptr<shared_frame const>;
+
+    streambuf sb_;
+    std::vector<std::pair<std::size_t, frame_ptr>> v_;
+    std::vector<boost::asio::const_buffer> bufs_;
+    std::size_t size_ = 0;
+
+public:
+    // A view of the buffers built by data(), cheap to copy
+    // into the write operations which hold a sequence.
+    class const_buffers_type
+    {
+        boost::asio::const_buffer const* begin_;
+        boost::asio::const_buffer const* end_;
+
+    public:
+        using value_type = boost::asio::const_buffer;
+        using const_iterator = boost::asio::const_buffer const*;
+
+        const_buffers_type(
+                boost::asio::const_buffer const* first,
+                boost::asio::const_buffer const* last)
+            : begin_(first)
+            , end_(last)
+        {
+        }
+
+        const_iterator
+        begin() const
+        {
+            return begin_;
+        }
+
+        const_iterator
+        end() const
+        {
+            return end_;
+        }
+    };
+
+    // Total bytes, copied and shared
+    std::size_t
+    size() const
+    {
+        return size_;
+    }
+
+    streambuf::mutable_buffers_type
+    prepare(std::size_t n)
+    {
+        return sb_.prepare(n);
+    }
+
+    void
+    commit(std::size_t n)
+    {
+        sb_.commit(n);
+        size_ += n;
+    }
+
+    // Append a reference to a shared frame
+    void
+    append(frame_ptr const& p)
+    {
+        v_.emplace_back(sb_.size(), p);
+        size_ += p->size;
+    }
+
+    // Returns the frames in order. The sequence stays valid
+    // until the buffer is modified, and the capacity used to
+    // build it is kept for the next call.
+    const_buffers_type
+    data()
+    {
+        using boost::asio::buffer_size;
+        bufs_.clear();
+        auto it = v_.begin();
+        std::size_t pos = 0;
+        for(auto b : sb_.data())
+        {
+            // splice in the shared frames
+            // starting within this buffer
+            for(; it != v_.end() &&
+                it->first < pos + buffer_size(b); ++it)
+            {
+                auto const k = it->first - pos;
+                if(k > 0)
+                    bufs_.push_back(boost::asio::buffer(b, k));
+                b = b + k;
+                pos += k;
+                bufs_.push_back(it->second->buffer());
+            }
+            if(buffer_size(b) > 0)
+                bufs_.push_back(b);
+            pos += buffer_size(b);
+        }
+        for(; it != v_.end(); ++it)
+            bufs_.push_back(it->second->buffer());
+        return {bufs_.data(), bufs_.data() + bufs_.size()};
+    }
+
+    // Remove everything, releasing the shared frames
+    void
+    clear()
+    {
+        sb_.consume(sb_.size());
+        v_.clear();
+        size_ = 0;
+    }
+};
+
+} // detail
+} // websocket
+} // beast
+
+#endif
@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_DETAIL_SENDFILE_HPP
+#define BEAST_WEBSOCKET_DETAIL_SENDFILE_HPP
+
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/error.hpp>
+#include <boost/asio/basic_stream_socket.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/config.hpp>
+#include <cerrno>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#ifndef BEAST_HAS_SENDFILE
+# if defined(__linux__)
+#  define BEAST_HAS_SENDFILE 1
+# endif
+#endif
+
+#ifndef BEAST_HAS_SENDFILE
+# define BEAST_HAS_SENDFILE 0
+#endif
+
+#if ! defined(BOOST_WINDOWS)
+# include <unistd.h>
+#endif
+#if BEAST_HAS_SENDFILE
+# include <sys/sendfile.h>
+#endif
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+// Returns `true` if the kernel can copy from
+// a file directly to a stream of type T.
+template<class T>
+struct is_sendfile_stream : std::false_type
+{
+};
+
+template<class Service>
+struct is_sendfile_stream<boost::asio::basic_stream_socket<
+        boost::asio::ip::tcp, Service>>
+    : std::integral_constant<bool, BEAST_HAS_SENDFILE>
+{
+};
+
+// Read up to `n` bytes at `offset` from a file.
+// Returns zero at the end of the file.
+inline
+std::size_t
+read_file(int fd, std::uint64_t offset,
+    void* dest, std::size_t n, error_code& ec)
+{
+#if defined(BOOST_WINDOWS)
+    ec = boost::asio::error::operation_not_supported;
+    return 0;
+#else
+    for(;;)
+    {
+        auto const result = ::pread(fd, dest, n,
+            static_cast<off_t>(offset));
+        if(result >= 0)
+        {
+            ec = {};
+            return static_cast<std::size_t>(result);
+        }
+        if(errno != EINTR)
+        {
+            ec = error_code{errno,
+                boost::system::system_category()};
+            return 0;
+        }
+    }
+#endif
+}
+
+// Copy up to `n` bytes at `offset` from a file to a stream,
+// without blocking. The error is `would_block` when the
+// stream cannot accept more data.
+template<class Stream>
+std::size_t
+send_file(Stream&, int, std::uint64_t, std::size_t, error_code& ec)
+{
+    ec = boost::asio::error::operation_not_supported;
+    return 0;
+}
+
+// Wait until a stream is ready for writing
+template<class Stream>
+void
+wait_write(Stream&, error_code& ec)
+{
+    ec = boost::asio::error::operation_not_supported;
+}
+
+template<class Stream, class Handler>
+void
+async_wait_write(Stream& stream, Handler&& handler)
+{
+    stream.get_io_service().post(bind_handler(
+        std::forward<Handler>(handler),
+            boost::asio::error::operation_not_supported,
+                std::size_t{0}));
+}
+
+#if BEAST_HAS_SENDFILE
+
+template<class Service>
+std::size_t
+send_file(boost::asio::basic_stream_socket<
+    boost::asio::ip::tcp, Service>& sock, int fd,
+        std::uint64_t offset, std::size_t n, error_code& ec)
+{
+    // Only the internal mode changes, synchronous
+    // operations on the socket still block.
+    sock.native_non_blocking(true, ec);
+    if(ec)
+        return 0;
+    // The kernel copies at most this much per call
+    std::size_t const limit = 0x7ffff000;
+    auto off = static_cast<off_t>(offset);
+    for(;;)
+    {
+        auto const result = ::sendfile(sock.native_handle(),
+            fd, &off, n < limit ? n : limit);
+        if(result >= 0)
+        {
+            ec = {};
+            return static_cast<std::size_t>(result);
+        }
+        if(errno != EINTR)
+        {
+            ec = error_code{errno,
+                boost::system::system_category()};
+            return 0;
+        }
+    }
+}
+
+template<class Service>
+void
+wait_write(boost::asio::basic_stream_socket<
+    boost::asio::ip::tcp, Service>& sock, error_code& ec)
+{
+    sock.write_some(boost::asio::null_buffers{}, ec);
+}
+
+template<class Service, class Handler>
+void
+async_wait_write(boost::asio::basic_stream_socket<
+    boost::asio::ip::tcp, Service>& sock, Handler&& handler)
+{
+    sock.async_write_some(boost::asio::null_buffers{},
+        std::forward<Handler>(handler));
+}
+
+#endif
+
+} // detail
+} // websocket
+} // beast
+
+#endif
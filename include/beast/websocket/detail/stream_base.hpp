@@ -14,16 +14,26 @@
 #include <beast/websocket/detail/frame.hpp>
 #include <beast/websocket/detail/invokable.hpp>
 #include <beast/websocket/detail/mask.hpp>
+#include <beast/websocket/detail/op_pool.hpp>
+#include <beast/websocket/detail/pmd_extension.hpp>
+#include <beast/websocket/detail/send_buffer.hpp>
 #include <beast/websocket/detail/utf8_checker.hpp>
+#include <beast/core/consuming_buffers.hpp>
 #include <beast/http/empty_body.hpp>
 #include <beast/http/message.hpp>
 #include <beast/http/string_body.hpp>
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/error.hpp>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace beast {
 namespace websocket {
@@ -49,8 +59,42 @@ clamp(UInt x, std::size_t limit)
     return static_cast<std::size_t>(x);
 }
 
+// Dynamic buffers which can make room for a single
+// contiguous output sequence, such as basic_streambuf.
+template<class T, class = void>
+struct has_reserve : std::false_type
+{
+};
+
+template<class T>
+struct has_reserve<T, decltype(std::declval<T&>().reserve(
+    std::declval<std::size_t>()), void())> : std::true_type
+{
+};
+
+template<class DynamicBuffer>
+void
+reserve(DynamicBuffer& db, std::size_t n, std::true_type)
+{
+    db.reserve(n);
+}
+
+template<class DynamicBuffer>
+void
+reserve(DynamicBuffer&, std::size_t, std::false_type)
+{
+}
+
+// Received payload is unmasked and validated in pieces
+// small enough that the utf8 check finds them in the cache.
+std::size_t constexpr rd_piece_size = 4096;
+
 using pong_cb = std::function<void(ping_data const&)>;
 
+using mask_gen = std::function<std::uint32_t()>;
+
+using send_queue_cb = std::function<void(bool)>;
+
 //------------------------------------------------------------------------------
 
 struct stream_base
@@ -58,17 +102,24 @@ struct stream_base
 protected:
     struct op {};
 
-    detail::maskgen maskgen_;           // source of mask keys
-    decorator_type d_;                  // adorns http messages
-    bool keep_alive_ = false;           // close on failed upgrade
+    // Members are grouped by purpose, with the smaller ones at the
+    // end of each group to keep padding down. Buffers which only some
+    // connections need are allocated on first use, see the budget in
+    // test/websocket/footprint_bench.cpp.
+
+    mask_gen maskgen_;                  // source of mask keys, if set
+    decorator_type d_;                  // adorns http messages, if set
+    pong_cb pong_cb_;                   // pong callback
+    send_queue_cb sq_cb_;               // watermark callback
     std::size_t rd_msg_max_ =
         16 * 1024 * 1024;               // max message size
     std::size_t
         wr_frag_size_ = 16 * 1024;      // size of auto-fragments
     std::size_t mask_buf_size_ = 4096;  // mask buffer size
-    opcode wr_opcode_ = opcode::text;   // outgoing message type
-    pong_cb pong_cb_;                   // pong callback
+    std::size_t rd_buf_size_ = 0;       // read buffer size
     role_type role_;                    // server or client
+    opcode wr_opcode_ = opcode::text;   // outgoing message type
+    bool keep_alive_ = false;           // close on failed upgrade
     bool failed_;                       // the connection failed
 
     detail::frame_header rd_fh_;        // current frame header
@@ -76,35 +127,229 @@ protected:
     detail::utf8_checker rd_utf8_check_;// for current text msg
     std::uint64_t rd_size_;             // size of the current message so far
     std::uint64_t rd_need_ = 0;         // bytes left in msg frame payload
+    std::size_t rd_view_ = 0;           // read buffer bytes lent to a view
     opcode rd_opcode_;                  // opcode of current msg
     bool rd_cont_;                      // expecting a continuation frame
 
     bool wr_close_;                     // sent close frame
     bool wr_cont_;                      // next write is continuation frame
+    bool wr_ctrl_ = false;              // wr_op_ holds a ping or close
+    std::unique_ptr<
+        std::uint8_t[]> wr_buf_;        // mask and deflate output
+    std::size_t wr_buf_size_ = 0;       // size of wr_buf_
     op* wr_block_;                      // op currenly writing
 
     ping_data* pong_data_;              // where to put pong payload
     invokable rd_op_;                   // invoked after write completes
     invokable wr_op_;                   // invoked after read completes
-    close_reason cr_;                   // set from received close frame
+    invokable wr_yield_;                // message write between fragments
+    std::unique_ptr<close_reason> cr_;  // set from received close frame
+
+    pmd_offer pmd_config_;              // negotiated permessage-deflate
+    std::unique_ptr<pmd_t> pmd_;        // compression state, if negotiated
+
+    std::shared_ptr<op_pool> op_pool_;  // memory for async operations
+
+    std::unique_ptr<
+        send_buffer[]> sq_;             // queued frames, and those in flight
+    std::size_t sq_limit_ =
+        16 * 1024 * 1024;               // max bytes queued
+    std::size_t sq_high_ = 64 * 1024;   // high watermark
+    std::size_t sq_low_ = 16 * 1024;    // low watermark
+    int sq_i_ = 0;                      // index of the buffer being filled
+    bool sq_above_ = false;             // high watermark reached
+    bool sq_disconnect_ = false;        // close when the limit is hit
+
+    std::chrono::steady_clock::duration
+        ka_interval_{};                 // idle time before a ping, or zero
+    std::chrono::steady_clock::duration
+        ka_timeout_{};                  // time allowed for a response
+    std::chrono::steady_clock::time_point
+        ka_sent_;                       // when the last auto ping was sent
+    std::chrono::steady_clock::duration
+        ka_rtt_{};                      // round trip of the last auto ping
+    std::shared_ptr<
+        stream_base*> ka_self_;         // reached by auto pings in flight
+    std::uint32_t ka_seq_ = 0;          // identifies the last auto ping
+    bool ka_rx_ = false;                // received data since the last check
+    bool ka_wait_ = false;              // auto ping sent, no reply yet
+    bool ka_ping_ = false;              // auto ping waits for the write block
 
     stream_base(stream_base&&) = default;
     stream_base(stream_base const&) = delete;
     stream_base& operator=(stream_base&&) = default;
     stream_base& operator=(stream_base const&) = delete;
 
-    stream_base()
-        : d_(new decorator<default_decorator>{})
+    stream_base() = default;
+
+    // Apply the user's decorator, or the default one
+    template<class Message>
+    void
+    decorate(Message& m)
     {
+        if(d_)
+            (*d_)(m);
+        else
+            default_decorator{}(m);
     }
 
     template<class = void>
     void
-    open(role_type role);
+    prepare_fh(close_code::value& code);
 
-    template<class = void>
+    // Returns the next masking key
+    std::uint32_t
+    mask_key()
+    {
+        if(maskgen_)
+            return maskgen_();
+        return thread_maskgen()();
+    }
+
+    // Number of bytes to read ahead into the stream's
+    // buffer when at least `needed` more are required.
+    // Even when reads are unbuffered this covers a frame
+    // header and a small payload in one call.
+    std::size_t
+    rd_refill_size(std::size_t needed) const
+    {
+        return std::max<std::size_t>(needed, std::max<
+            std::size_t>(rd_buf_size_, 2 + 8 + 4 + 125));
+    }
+
+    // Returns the stream's buffer prepared to read ahead at
+    // least `needed` bytes. A drained buffer is rewound first,
+    // as documented for basic_streambuf::consume, so the refill
+    // reuses the storage it already holds rather than spilling
+    // into a newly allocated block. Other dynamic buffers are
+    // left as they were by the empty prepare and consume.
+    template<class DynamicBuffer>
+    typename DynamicBuffer::mutable_buffers_type
+    rd_refill(DynamicBuffer& sb, std::size_t needed) const
+    {
+        if(sb.size() == 0)
+        {
+            sb.prepare(0);
+            sb.consume(0);
+        }
+        return sb.prepare(rd_refill_size(needed));
+    }
+
+    // Returns the scratch buffer for outgoing payloads,
+    // grown to at least `size` bytes. Only the holder
+    // of the write block may use it.
+    std::uint8_t*
+    wr_buf(std::size_t size)
+    {
+        if(wr_buf_size_ < size)
+        {
+            wr_buf_.reset(new std::uint8_t[size]);
+            wr_buf_size_ = size;
+        }
+        return wr_buf_.get();
+    }
+
+    // Returns the memory pool for asynchronous operations
+    std::shared_ptr<op_pool> const&
+    get_op_pool()
+    {
+        if(! op_pool_)
+            op_pool_ = std::make_shared<op_pool>();
+        return op_pool_;
+    }
+
+    // Number of bytes queued by send, including
+    // those being written by a pending flush.
+    std::size_t
+    sq_size() const
+    {
+        if(! sq_)
+            return 0;
+        return sq_[0].size() + sq_[1].size();
+    }
+
+    // Returns the send queue buffers,
+    // allocating them on first use.
+    send_buffer*
+    sq()
+    {
+        if(! sq_)
+            sq_.reset(new send_buffer[2]);
+        return sq_.get();
+    }
+
+    // Returns the storage for a received close
+    // reason, allocating it on first use.
+    close_reason&
+    rd_close_reason()
+    {
+        if(! cr_)
+            cr_.reset(new close_reason);
+        return *cr_;
+    }
+
+    // Invokes the send queue callback
+    // when a watermark is crossed.
     void
-    prepare_fh(close_code::value& code);
+    sq_notify()
+    {
+        auto const n = sq_size();
+        if(! sq_above_ && n >= sq_high_)
+        {
+            sq_above_ = true;
+            if(sq_cb_)
+                sq_cb_(true);
+        }
+        else if(sq_above_ && n <= sq_low_)
+        {
+            sq_above_ = false;
+            if(sq_cb_)
+                sq_cb_(false);
+        }
+    }
+
+    // Returns the payload of automatic ping `seq`
+    static
+    ping_data
+    ka_payload(std::uint32_t seq)
+    {
+        ping_data payload;
+        payload.resize(sizeof(seq));
+        std::memcpy(payload.data(), &seq, sizeof(seq));
+        return payload;
+    }
+
+    // Called for each received pong
+    void
+    ka_pong(ping_data const& payload)
+    {
+        if(ka_wait_ && payload.compare(ka_payload(ka_seq_)) == 0)
+        {
+            ka_rtt_ = std::chrono::steady_clock::now() - ka_sent_;
+            ka_wait_ = false;
+        }
+    }
+
+    // Size of the buffer receiving compressed output
+    std::size_t
+    pmd_buf_size() const
+    {
+        return std::max<std::size_t>(mask_buf_size_, 16);
+    }
+
+    template<class DynamicBuffer>
+    void
+    rd_reserve(DynamicBuffer& db);
+
+    template<class DynamicBuffer>
+    void
+    rd_inflate(DynamicBuffer& db, boost::asio::const_buffer in,
+        bool fin, close_code::value& code);
+
+    template<class Buffers>
+    std::size_t
+    wr_deflate(std::uint8_t* buf, std::size_t size, std::size_t& used,
+        consuming_buffers<Buffers>& cb, bool fin, bool& done);
 
     template<class DynamicBuffer>
     void
@@ -0,0 +1,231 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_DETAIL_TIMER_WHEEL_HPP
+#define BEAST_WEBSOCKET_DETAIL_TIMER_WHEEL_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+// A hashed timing wheel.
+//
+// Timers are kept in intrusive lists, one per slot, indexed
+// by their expiry tick modulo the number of slots. Each timer
+// also counts the full turns of the wheel left before it is
+// due. Inserting, removing and expiring a timer take constant
+// time, however many are pending, at the cost of a resolution
+// of one tick.
+//
+class timer_wheel
+{
+    struct node
+    {
+        node* prev;
+        node* next;
+
+        void
+        init()
+        {
+            prev = this;
+            next = this;
+        }
+
+        void
+        push_back(node& n)
+        {
+            n.prev = prev;
+            n.next = this;
+            prev->next = &n;
+            prev = &n;
+        }
+
+        void
+        unlink()
+        {
+            prev->next = next;
+            next->prev = prev;
+        }
+    };
+
+public:
+    // Base for objects which may be scheduled on the wheel.
+    // Moving or destroying a hook removes it from the wheel,
+    // use take to hand a scheduled hook's place to another.
+    class hook : private node
+    {
+        friend class timer_wheel;
+
+        timer_wheel* w_ = nullptr;
+        std::size_t rounds_;
+
+        // Called after the hook is removed
+        virtual
+        void
+        on_expire() = 0;
+
+    public:
+        hook() = default;
+
+        hook(hook&& other)
+        {
+            other.cancel();
+        }
+
+        hook&
+        operator=(hook&& other)
+        {
+            cancel();
+            other.cancel();
+            return *this;
+        }
+
+        virtual
+        ~hook()
+        {
+            cancel();
+        }
+
+        bool
+        linked() const
+        {
+            return w_ != nullptr;
+        }
+
+        void
+        cancel()
+        {
+            if(w_)
+                w_->remove(*this);
+        }
+
+        // Take the place of `other` on its wheel, if any.
+        // This hook then expires when `other` would have.
+        void
+        take(hook& other)
+        {
+            assert(! w_);
+            if(! other.w_)
+                return;
+            prev = other.prev;
+            next = other.next;
+            prev->next = this;
+            next->prev = this;
+            rounds_ = other.rounds_;
+            w_ = other.w_;
+            other.w_ = nullptr;
+        }
+    };
+
+private:
+    std::size_t n_;
+    std::size_t cur_ = 0;
+    std::size_t size_ = 0;
+    std::unique_ptr<node[]> v_;
+    node expired_;
+
+public:
+    timer_wheel(timer_wheel const&) = delete;
+    timer_wheel& operator=(timer_wheel const&) = delete;
+
+    explicit
+    timer_wheel(std::size_t slots)
+        : n_(slots)
+        , v_(new node[slots])
+    {
+        assert(slots > 0);
+        for(std::size_t i = 0; i < n_; ++i)
+            v_[i].init();
+        expired_.init();
+    }
+
+    ~timer_wheel()
+    {
+        clear();
+    }
+
+    // Number of hooks scheduled
+    std::size_t
+    size() const
+    {
+        return size_;
+    }
+
+    // Schedule a hook to expire after `ticks` calls to
+    // advance. A hook is always scheduled at least one
+    // tick ahead, even when `ticks` is zero. A hook which
+    // is already scheduled is moved to the new time.
+    void
+    insert(hook& h, std::size_t ticks)
+    {
+        h.cancel();
+        if(ticks == 0)
+            ticks = 1;
+        v_[(cur_ + ticks % n_) % n_].push_back(h);
+        h.rounds_ = (ticks - 1) / n_;
+        h.w_ = this;
+        ++size_;
+    }
+
+    void
+    remove(hook& h)
+    {
+        assert(h.w_ == this);
+        h.unlink();
+        h.w_ = nullptr;
+        --size_;
+    }
+
+    // Remove all hooks without expiring them
+    void
+    clear()
+    {
+        for(std::size_t i = 0; i < n_; ++i)
+            while(v_[i].next != &v_[i])
+                remove(static_cast<hook&>(*v_[i].next));
+        while(expired_.next != &expired_)
+            remove(static_cast<hook&>(*expired_.next));
+    }
+
+    // Move the wheel forward one tick, expiring the hooks
+    // which are due. Expired hooks may insert themselves
+    // again, and may remove other hooks.
+    void
+    advance()
+    {
+        cur_ = (cur_ + 1) % n_;
+        auto& head = v_[cur_];
+        for(auto p = head.next; p != &head;)
+        {
+            auto& h = static_cast<hook&>(*p);
+            p = p->next;
+            if(h.rounds_ > 0)
+            {
+                --h.rounds_;
+                continue;
+            }
+            h.unlink();
+            expired_.push_back(h);
+        }
+        while(expired_.next != &expired_)
+        {
+            auto& h = static_cast<hook&>(*expired_.next);
+            remove(h);
+            h.on_expire();
+        }
+    }
+};
+
+} // detail
+} // websocket
+} // beast
+
+#endif
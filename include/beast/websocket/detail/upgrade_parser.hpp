@@ -0,0 +1,251 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_DETAIL_UPGRADE_PARSER_HPP
+#define BEAST_WEBSOCKET_DETAIL_UPGRADE_PARSER_HPP
+
+#include <beast/http/basic_parser_v1.hpp>
+#include <beast/core/error.hpp>
+#include <beast/core/detail/ci_char_traits.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstring>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+// A field value held in storage of fixed size.
+// Text which does not fit is dropped, and remembered.
+template<std::size_t N>
+class upgrade_value
+{
+    std::size_t n_ = 0;
+    bool exists_ = false;
+    bool truncated_ = false;
+    char buf_[N];
+
+public:
+    upgrade_value() = default;
+    upgrade_value(upgrade_value const&) = delete;
+    upgrade_value& operator=(upgrade_value const&) = delete;
+
+    // `true` if the field appeared in the message
+    bool
+    exists() const
+    {
+        return exists_;
+    }
+
+    // `true` if some of the value was dropped
+    bool
+    truncated() const
+    {
+        return truncated_;
+    }
+
+    boost::string_ref
+    str() const
+    {
+        return {buf_, n_};
+    }
+
+    void
+    clear()
+    {
+        n_ = 0;
+        truncated_ = false;
+    }
+
+    // Called before the first piece of each occurrence
+    void
+    start()
+    {
+        // rfc7230 3.2.2: repeated fields form one list
+        if(exists_)
+            append(", ");
+        exists_ = true;
+    }
+
+    void
+    append(boost::string_ref const& s)
+    {
+        auto n = s.size();
+        if(n > N - n_)
+        {
+            n = N - n_;
+            truncated_ = true;
+        }
+        std::memcpy(&buf_[n_], s.data(), n);
+        n_ += n;
+    }
+};
+
+/*  Parses the HTTP/1 message of a WebSocket upgrade.
+
+    Only the request method, the status, and the fields which take
+    part in the opening handshake are kept, in storage of fixed size,
+    so that parsing the message allocates no memory. Other fields
+    and the body are discarded. Field names longer than any of those
+    recognized are ignored, and values too long to keep are marked
+    as truncated.
+*/
+template<bool isRequest>
+class upgrade_parser
+    : public http::basic_parser_v1<isRequest,
+        upgrade_parser<isRequest>>
+{
+    friend class http::basic_parser_v1<
+        isRequest, upgrade_parser>;
+
+public:
+    struct fields_type
+    {
+        upgrade_value<128> host;
+        upgrade_value<64> upgrade;
+        upgrade_value<32> key;          // Sec-WebSocket-Key
+        upgrade_value<8> version;       // Sec-WebSocket-Version
+        upgrade_value<256> extensions;  // Sec-WebSocket-Extensions
+        upgrade_value<32> accept;       // Sec-WebSocket-Accept
+    };
+
+private:
+    enum field_id
+    {
+        id_none,
+        id_host,
+        id_upgrade,
+        id_key,
+        id_version,
+        id_extensions,
+        id_accept
+    };
+
+    fields_type f_;
+    upgrade_value<8> method_;
+    upgrade_value<32> name_;
+    field_id id_ = id_none;
+    bool value_ = false;
+
+public:
+    upgrade_parser() = default;
+
+    /// Returns the request method
+    boost::string_ref
+    method() const
+    {
+        return method_.str();
+    }
+
+    /// Returns the HTTP version as in `message_v1::version`
+    int
+    version() const
+    {
+        return 10 * this->http_major() + this->http_minor();
+    }
+
+    /// Returns `true` if the Connection field has the upgrade token
+    bool
+    connection_upgrade() const
+    {
+        return version() >= 11 && (this->flags() &
+            http::parse_flag::connection_upgrade) != 0;
+    }
+
+    /// Returns `true` if the Connection field has the close token
+    bool
+    connection_close() const
+    {
+        return (this->flags() &
+            http::parse_flag::connection_close) != 0;
+    }
+
+    /// Returns the fields of the opening handshake
+    fields_type const&
+    fields() const
+    {
+        return f_;
+    }
+
+private:
+    static
+    field_id
+    lookup(boost::string_ref const& name)
+    {
+        using beast::detail::ci_equal;
+        if(ci_equal(name, "Host"))
+            return id_host;
+        if(ci_equal(name, "Upgrade"))
+            return id_upgrade;
+        if(ci_equal(name, "Sec-WebSocket-Key"))
+            return id_key;
+        if(ci_equal(name, "Sec-WebSocket-Version"))
+            return id_version;
+        if(ci_equal(name, "Sec-WebSocket-Extensions"))
+            return id_extensions;
+        if(ci_equal(name, "Sec-WebSocket-Accept"))
+            return id_accept;
+        return id_none;
+    }
+
+    template<std::size_t N>
+    void
+    append(upgrade_value<N>& v,
+        boost::string_ref const& s, bool first)
+    {
+        if(first)
+            v.start();
+        v.append(s);
+    }
+
+    void
+    on_method(boost::string_ref const& s, error_code&)
+    {
+        method_.append(s);
+    }
+
+    void
+    on_field(boost::string_ref const& s, error_code&)
+    {
+        if(value_)
+        {
+            value_ = false;
+            name_.clear();
+        }
+        name_.append(s);
+    }
+
+    void
+    on_value(boost::string_ref const& s, error_code&)
+    {
+        // the name is complete when its value begins
+        bool const first = ! value_;
+        if(first)
+        {
+            value_ = true;
+            id_ = name_.truncated() ?
+                id_none : lookup(name_.str());
+        }
+        switch(id_)
+        {
+        case id_host:       append(f_.host, s, first); break;
+        case id_upgrade:    append(f_.upgrade, s, first); break;
+        case id_key:        append(f_.key, s, first); break;
+        case id_version:    append(f_.version, s, first); break;
+        case id_extensions: append(f_.extensions, s, first); break;
+        case id_accept:     append(f_.accept, s, first); break;
+        case id_none:
+            break;
+        }
+    }
+};
+
+} // detail
+} // websocket
+} // beast
+
+#endif
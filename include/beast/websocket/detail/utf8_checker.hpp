@@ -8,8 +8,10 @@
 #ifndef BEAST_WEBSOCKET_DETAIL_UTF8_CHECKER_HPP
 #define BEAST_WEBSOCKET_DETAIL_UTF8_CHECKER_HPP
 
+#include <beast/core/detail/cpu_info.hpp>
 #include <boost/asio/buffer.hpp>
 #include <cstdint>
+#include <cstring>
 #include <string> // DEPRECATED
 
 namespace beast {
@@ -69,6 +71,11 @@ class utf8_checker_t
         return tab;
     }
 
+    // Returns the first byte in [p, end) which is not ASCII
+    static
+    std::uint8_t const*
+    skip_ascii(std::uint8_t const* p, std::uint8_t const* end);
+
     std::uint32_t state_ = 0;
     std::uint32_t codepoint_ = 0;
 
@@ -98,14 +105,61 @@ utf8_checker_t<_>::reset()
     codepoint_ = 0;
 }
 
+template<class _>
+std::uint8_t const*
+utf8_checker_t<_>::skip_ascii(
+    std::uint8_t const* p, std::uint8_t const* end)
+{
+#if BEAST_SIMD_X86
+    while(end - p >= 32)
+    {
+        auto const v0 = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(p));
+        auto const v1 = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(p + 16));
+        if(_mm_movemask_epi8(_mm_or_si128(v0, v1)) != 0)
+            break;
+        p += 32;
+    }
+    while(end - p >= 16)
+    {
+        auto const v = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(p));
+        if(_mm_movemask_epi8(v) != 0)
+            break;
+        p += 16;
+    }
+#else
+    while(end - p >= 16)
+    {
+        std::uint64_t w[2];
+        std::memcpy(&w[0], p, sizeof(w));
+        if(((w[0] | w[1]) & 0x8080808080808080ULL) != 0)
+            break;
+        p += 16;
+    }
+#endif
+    while(p != end && *p < 0x80)
+        ++p;
+    return p;
+}
+
 template<class _>
 bool
 utf8_checker_t<_>::write(void const* buffer, std::size_t size)
 {
     auto p = static_cast<std::uint8_t const*>(buffer);
+    auto const end = p + size;
     auto plut = &lut()[0];
-    while(size)
+    while(p != end)
     {
+        // Between code points, skip runs of ASCII
+        if(state_ == 0 && *p < 0x80)
+        {
+            p = skip_ascii(p + 1, end);
+            if(p == end)
+                break;
+        }
         auto const byte = *p;
         auto const type = plut[byte];
         if(state_)
@@ -119,7 +173,6 @@ utf8_checker_t<_>::write(void const* buffer, std::size_t size)
             return false;
         }
         ++p;
-        --size;
     }
     return true;
 }
@@ -0,0 +1,380 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_FRAME_CODEC_HPP
+#define BEAST_WEBSOCKET_FRAME_CODEC_HPP
+
+#include <beast/websocket/rfc6455.hpp>
+#include <beast/websocket/detail/frame.hpp>
+#include <beast/websocket/detail/mask.hpp>
+#include <beast/websocket/detail/utf8_checker.hpp>
+#include <beast/core/buffer_concepts.hpp>
+#include <boost/asio/buffer.hpp>
+#include <cstdint>
+
+namespace beast {
+namespace websocket {
+
+/// Identifies the role of a WebSocket endpoint.
+#if GENERATING_DOCS
+enum class role_type
+{
+    /// The endpoint is a client, it masks the frames it sends.
+    client,
+
+    /// The endpoint is a server, it receives masked frames.
+    server
+};
+#else
+using role_type = detail::role_type;
+#endif
+
+/** An incremental WebSocket frame decoder.
+
+    Objects of this type decode the frames of a WebSocket
+    connection from raw bytes supplied by the caller, without
+    performing any I/O. The decoder checks the frames against
+    the rules of rfc6455 as @ref stream does, unmasks payloads
+    received by servers, validates the UTF-8 of text messages,
+    and enforces a limit on the size of messages.
+
+    Input is presented to @ref write, which consumes bytes and
+    reports at most one @ref event per call. Data frame payloads
+    are reported as spans of the caller's input, unmasked in
+    place, so no payload is copied. Control frames are gathered
+    into storage owned by the decoder, and reported once they
+    are complete.
+
+    No extensions are supported, a frame with any reserved bit
+    set is a protocol error.
+
+    @par Example
+    Decoding the bytes received on a connection.
+    @code
+    void on_data(frame_decoder& d, char* p, std::size_t n)
+    {
+        while(n > 0)
+        {
+            frame_decoder::event ev;
+            close_code::value code;
+            auto const used = d.write(
+                boost::asio::buffer(p, n), ev, code);
+            if(code != close_code::none)
+                return fail(code);
+            p += used;
+            n -= used;
+            if(ev == frame_decoder::event::payload)
+                handle(d.op(), d.payload(), d.is_message_done());
+        }
+    }
+    @endcode
+*/
+class frame_decoder
+{
+public:
+    /// The kinds of event reported by @ref write.
+    enum class event
+    {
+        /// All of the input was consumed, more is needed.
+        need_more,
+
+        /// The header of a data frame was decoded.
+        header,
+
+        /// Part of the payload of a data frame is available.
+        payload,
+
+        /// A complete control frame is available.
+        control
+    };
+
+private:
+    detail::frame_header fh_;
+    detail::fh_streambuf fh_buf_;
+    detail::prepared_key_type key_;
+    detail::utf8_checker utf8_;
+    close_reason cr_;
+    boost::asio::const_buffer payload_;
+    std::uint64_t size_ = 0;
+    std::uint64_t remain_ = 0;
+    std::size_t msg_max_ = 16 * 1024 * 1024;
+    std::size_t cn_ = 0;
+    role_type role_;
+    opcode msg_op_ = opcode::text;
+    bool cont_ = false;
+    bool in_payload_ = false;
+    bool done_ = false;
+    std::uint8_t cb_[125];
+
+public:
+    /** Constructor
+
+        @param role The role of the endpoint receiving the frames.
+    */
+    explicit
+    frame_decoder(role_type role);
+
+    /// Copy constructor (disallowed)
+    frame_decoder(frame_decoder const&) = delete;
+
+    /// Copy assignment (disallowed)
+    frame_decoder& operator=(frame_decoder const&) = delete;
+
+    /** Set the maximum size of incoming messages.
+
+        A message whose total payload exceeds this size causes
+        @ref write to report @ref close_code::too_big. A value
+        of zero means no limit. The default is 16 megabytes.
+    */
+    void
+    read_message_max(std::size_t n)
+    {
+        msg_max_ = n;
+    }
+
+    /// Returns the maximum size of incoming messages.
+    std::size_t
+    read_message_max() const
+    {
+        return msg_max_;
+    }
+
+    /** Return the decoder to its initial state.
+
+        Any partially decoded frame or message is discarded.
+    */
+    void
+    reset();
+
+    /** Decode bytes.
+
+        Bytes are consumed from the front of the input until an
+        event occurs or the input is exhausted. The payload of
+        a masked data frame is unmasked in place, which is why
+        the input must be writable.
+
+        After a @ref event::payload or @ref event::control, the
+        span returned by @ref payload remains valid until the
+        next call to @ref write or @ref reset. Data frame spans
+        refer to the input.
+
+        @param buffer The bytes to decode.
+
+        @param ev Set to the event which occurred.
+
+        @param code Set to the close code to send when the input
+        violates the protocol, otherwise @ref close_code::none.
+        Once a violation is reported the decoder must be @ref
+        reset before it is used again.
+
+        @return The number of bytes consumed from the input.
+    */
+    std::size_t
+    write(boost::asio::mutable_buffer const& buffer,
+        event& ev, close_code::value& code);
+
+    /** Returns the opcode of the current frame.
+
+        For data frames this is the opcode of the message,
+        continuation frames report the opcode of the first
+        frame.
+    */
+    opcode
+    op() const
+    {
+        return detail::is_control(fh_.op) ? fh_.op : msg_op_;
+    }
+
+    /// Returns `true` if the current frame is the last of its message.
+    bool
+    fin() const
+    {
+        return fh_.fin;
+    }
+
+    /// Returns the payload size of the current frame.
+    std::uint64_t
+    size() const
+    {
+        return fh_.len;
+    }
+
+    /// Returns the payload bytes of the current frame not yet reported.
+    std::uint64_t
+    remain() const
+    {
+        return remain_;
+    }
+
+    /** Returns `true` if the last event completed a data message.
+
+        This is the case after the last payload of the final frame
+        of a message, or after the header of a final frame with no
+        payload.
+    */
+    bool
+    is_message_done() const
+    {
+        return done_;
+    }
+
+    /// Returns the payload reported by the last event.
+    boost::asio::const_buffer
+    payload() const
+    {
+        return payload_;
+    }
+
+    /** Returns the decoded close frame.
+
+        This is valid after an @ref event::control with an
+        opcode of @ref opcode::close.
+    */
+    close_reason const&
+    reason() const
+    {
+        return cr_;
+    }
+
+private:
+    void
+    on_header(event& ev, close_code::value& code);
+
+    void
+    on_control(event& ev, close_code::value& code);
+};
+
+/** A WebSocket frame encoder.
+
+    Objects of this type serialize WebSocket frames into storage
+    provided by the caller, without performing any I/O. Frames
+    sent by clients are masked with a key chosen for each frame
+    from the calling thread's generator, as for @ref stream.
+
+    A frame is written either whole, with @ref frame, or in
+    pieces: @ref header first, then calls to @ref payload for
+    exactly the size declared in the header.
+
+    Data messages may be fragmented. The opcode passed for each
+    fragment is the opcode of the message, the encoder sends the
+    second and later fragments as continuation frames. Control
+    frames may be sent between the fragments of a message.
+*/
+class frame_encoder
+{
+    detail::prepared_key_type key_;
+    std::uint64_t remain_ = 0;
+    role_type role_;
+    bool mask_ = false;
+    bool cont_ = false;
+
+public:
+    /// The largest possible size of a frame header.
+    static std::size_t constexpr max_header_size = 14;
+
+    /** Constructor
+
+        @param role The role of the endpoint sending the frames.
+    */
+    explicit
+    frame_encoder(role_type role)
+        : role_(role)
+    {
+    }
+
+    /// Returns the size of a frame header for a given payload size.
+    std::size_t
+    header_size(std::uint64_t size) const
+    {
+        return (size <= 125 ? 2 : size <= 65535 ? 4 : 10) +
+            (role_ == role_type::client ? 4 : 0);
+    }
+
+    /// Returns the payload bytes declared by the last header not yet written.
+    std::uint64_t
+    remain() const
+    {
+        return remain_;
+    }
+
+    /** Serialize a frame header.
+
+        @param dest Storage for the header, which must hold at
+        least @ref header_size bytes.
+
+        @param op The opcode of the message or control frame.
+
+        @param fin `true` if this is the last frame of the message.
+
+        @param size The size of the payload which follows.
+
+        @return The number of bytes written.
+
+        @throws std::domain_error if the opcode is reserved, or if
+        a control frame is fragmented or larger than 125 bytes.
+    */
+    std::size_t
+    header(void* dest, opcode op, bool fin, std::uint64_t size);
+
+    /** Serialize part of a frame payload.
+
+        The bytes are copied, and masked when the role is
+        @ref role_type::client.
+
+        @param dest Storage for the payload, which must hold at
+        least `buffer_size(buffers)` bytes.
+
+        @param buffers The payload bytes, which must not exceed
+        @ref remain.
+
+        @return The number of bytes written.
+    */
+    template<class ConstBufferSequence>
+    std::size_t
+    payload(void* dest, ConstBufferSequence const& buffers);
+
+    /** Serialize a complete frame.
+
+        @param dest Storage for the frame, which must hold at least
+        `header_size(buffer_size(buffers)) + buffer_size(buffers)`
+        bytes.
+
+        @param op The opcode of the message or control frame.
+
+        @param fin `true` if this is the last frame of the message.
+
+        @param buffers The frame payload.
+
+        @return The number of bytes written.
+
+        @throws std::domain_error as for @ref header.
+    */
+    template<class ConstBufferSequence>
+    std::size_t
+    frame(void* dest, opcode op, bool fin,
+        ConstBufferSequence const& buffers);
+
+    /** Serialize a close frame.
+
+        @param dest Storage for the frame, which must hold at
+        least 2 + 4 + 125 bytes.
+
+        @param cr The reason for the close. If the close code is
+        @ref close_code::none the frame has no payload.
+
+        @return The number of bytes written.
+    */
+    std::size_t
+    close(void* dest, close_reason const& cr);
+};
+
+} // websocket
+} // beast
+
+#include <beast/websocket/impl/frame_codec.ipp>
+
+#endif
@@ -10,10 +10,11 @@
 
 #include <beast/websocket/impl/response_op.ipp>
 #include <beast/http/message_v1.hpp>
-#include <beast/http/parser_v1.hpp>
 #include <beast/http/read.hpp>
+#include <beast/websocket/detail/upgrade_parser.hpp>
 #include <beast/core/handler_alloc.hpp>
 #include <beast/core/prepare_buffers.hpp>
+#include <beast/core/static_streambuf.hpp>
 #include <cassert>
 #include <memory>
 #include <type_traits>
@@ -23,23 +24,25 @@ namespace websocket {
 
 // read and respond to an upgrade request
 //
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
-class stream<NextLayer>::accept_op
+class stream<NextLayer, ReadBuffer>::accept_op
 {
     using alloc_type =
         handler_alloc<char, Handler>;
 
     struct data
     {
-        stream<NextLayer>& ws;
-        http::request_v1<http::string_body> req;
+        stream<NextLayer, ReadBuffer>& ws;
+        detail::upgrade_parser<true> p;
+        static_streambuf_n<512> sb;
         Handler h;
+        error_code final_ec;
         bool cont;
         int state = 0;
 
         template<class DeducedHandler, class Buffers>
-        data(DeducedHandler&& h_, stream<NextLayer>& ws_,
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
                 Buffers const& buffers)
             : ws(ws_)
             , h(std::forward<DeducedHandler>(h_))
@@ -63,7 +66,7 @@ public:
 
     template<class DeducedHandler, class... Args>
     accept_op(DeducedHandler&& h,
-            stream<NextLayer>& ws, Args&&... args)
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
         : d_(std::allocate_shared<data>(alloc_type{h},
             std::forward<DeducedHandler>(h), ws,
                 std::forward<Args>(args)...))
@@ -76,7 +79,7 @@ public:
         (*this)(ec, 0);
     }
 
-    void operator()(error_code const& ec,
+    void operator()(error_code ec,
         std::size_t bytes_transferred, bool again = true);
 
     friend
@@ -110,11 +113,11 @@ public:
     }
 };
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
 void 
-stream<NextLayer>::accept_op<Handler>::
-operator()(error_code const& ec,
+stream<NextLayer, ReadBuffer>::accept_op<Handler>::
+operator()(error_code ec,
     std::size_t bytes_transferred, bool again)
 {
     auto& d = *d_;
@@ -126,23 +129,35 @@ operator()(error_code const& ec,
         case 0:
             // read message
             d.state = 1;
-            http::async_read(d.ws.next_layer(),
-                d.ws.stream_.buffer(), d.req,
+            http::async_parse(d.ws.next_layer(),
+                d.ws.stream_.buffer(), d.p,
                     std::move(*this));
             return;
 
         // got message
         case 1:
             // respond to request
-#if 1
-            // VFALCO I have no idea why passing std::move(*this) crashes
-            d.state = 99;
-            d.ws.async_accept(d.req, *this);
-#else
-            response_op<Handler>{
-                std::move(d.h), d.ws, d.req, true};
-#endif
+            if(d.ws.d_)
+            {
+                // the decorator needs a message to adorn
+                // VFALCO I have no idea why passing std::move(*this) crashes
+                d.state = 99;
+                d.ws.async_accept(d.ws.build_request(d.p), *this);
+                return;
+            }
+            d.final_ec = d.ws.build_response(d.sb, d.p);
+            d.state = 2;
+            boost::asio::async_write(d.ws.next_layer(),
+                d.sb.data(), std::move(*this));
             return;
+
+        // sent response
+        case 2:
+            d.state = 99;
+            ec = d.final_ec;
+            if(! ec)
+                d.ws.open(detail::role_type::server);
+            break;
         }
     }
     d.h(ec);
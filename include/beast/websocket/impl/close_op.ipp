@@ -17,9 +17,9 @@ namespace websocket {
 
 // send the close message and wait for the response
 //
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
-class stream<NextLayer>::close_op
+class stream<NextLayer, ReadBuffer>::close_op
 {
     using alloc_type = handler_alloc<char, Handler>;
 
@@ -27,7 +27,7 @@ class stream<NextLayer>::close_op
 
     struct data : op
     {
-        stream<NextLayer>& ws;
+        stream<NextLayer, ReadBuffer>& ws;
         close_reason cr;
         Handler h;
         fb_type fb;
@@ -35,7 +35,7 @@ class stream<NextLayer>::close_op
         int state = 0;
 
         template<class DeducedHandler>
-        data(DeducedHandler&& h_, stream<NextLayer>& ws_,
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
                 close_reason const& cr_)
             : ws(ws_)
             , cr(cr_)
@@ -56,7 +56,7 @@ public:
 
     template<class DeducedHandler, class... Args>
     close_op(DeducedHandler&& h,
-            stream<NextLayer>& ws, Args&&... args)
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
         : d_(std::allocate_shared<data>(alloc_type{h},
             std::forward<DeducedHandler>(h), ws,
                 std::forward<Args>(args)...))
@@ -106,10 +106,10 @@ public:
     }
 };
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
 void 
-stream<NextLayer>::close_op<Handler>::
+stream<NextLayer, ReadBuffer>::close_op<Handler>::
 operator()(error_code ec, std::size_t)
 {
     auto& d = *d_;
@@ -118,10 +118,10 @@ operator()(error_code ec, std::size_t)
     (*this)(ec);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
 void 
-stream<NextLayer>::close_op<Handler>::
+stream<NextLayer, ReadBuffer>::close_op<Handler>::
 operator()(error_code ec, bool again)
 {
     auto& d = *d_;
@@ -137,6 +137,7 @@ operator()(error_code ec, bool again)
             {
                 // suspend
                 d.state = 2;
+                d.ws.wr_ctrl_ = true;
                 d.ws.wr_op_.template emplace<
                     close_op>(std::move(*this));
                 return;
@@ -174,6 +175,15 @@ operator()(error_code ec, bool again)
                 ec = boost::asio::error::operation_aborted;
                 goto upcall;
             }
+            if(d.ws.wr_block_)
+            {
+                // taken while resuming, suspend again
+                d.state = 2;
+                d.ws.wr_ctrl_ = true;
+                d.ws.wr_op_.template emplace<
+                    close_op>(std::move(*this));
+                return;
+            }
             d.state = 1;
             break;
 
@@ -185,6 +195,7 @@ upcall:
     if(d.ws.wr_block_ == &d)
         d.ws.wr_block_ = nullptr;
     d.ws.rd_op_.maybe_invoke();
+    d.ws.wr_yield_.maybe_invoke();
     d.h(ec);
 }
 
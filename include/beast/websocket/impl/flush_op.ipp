@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_IMPL_FLUSH_OP_HPP
+#define BEAST_WEBSOCKET_IMPL_FLUSH_OP_HPP
+
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/handler_alloc.hpp>
+#include <beast/websocket/detail/op_pool.hpp>
+#include <cassert>
+#include <memory>
+
+namespace beast {
+namespace websocket {
+
+// write the send queue
+//
+// Frames queued while a write is in flight collect
+// in the other buffer, and go out together in the
+// next write once the current one completes.
+//
+template<class NextLayer, class ReadBuffer>
+template<class Handler>
+class stream<NextLayer, ReadBuffer>::flush_op
+{
+    struct data : op
+    {
+        stream<NextLayer, ReadBuffer>& ws;
+        Handler h;
+        bool cont;
+        int state = 0;
+
+        template<class DeducedHandler>
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_)
+            : ws(ws_)
+            , h(std::forward<DeducedHandler>(h_))
+            , cont(boost_asio_handler_cont_helpers::
+                is_continuation(h))
+        {
+        }
+    };
+
+    std::shared_ptr<data> d_;
+
+public:
+    flush_op(flush_op&&) = default;
+    flush_op(flush_op const&) = default;
+
+    template<class DeducedHandler>
+    flush_op(DeducedHandler&& h, stream<NextLayer, ReadBuffer>& ws)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
+            std::forward<DeducedHandler>(h), ws))
+    {
+        (*this)(error_code{}, false);
+    }
+
+    void operator()()
+    {
+        (*this)(error_code{});
+    }
+
+    void operator()(error_code ec, std::size_t);
+
+    void operator()(error_code ec, bool again = true);
+
+    friend
+    void* asio_handler_allocate(
+        std::size_t size, flush_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            allocate(size, op->d_->h);
+    }
+
+    friend
+    void asio_handler_deallocate(
+        void* p, std::size_t size, flush_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            deallocate(p, size, op->d_->h);
+    }
+
+    friend
+    bool asio_handler_is_continuation(flush_op* op)
+    {
+        return op->d_->cont;
+    }
+
+    template <class Function>
+    friend
+    void asio_handler_invoke(Function&& f, flush_op* op)
+    {
+        return boost_asio_handler_invoke_helpers::
+            invoke(f, op->d_->h);
+    }
+};
+
+template<class NextLayer, class ReadBuffer>
+template<class Handler>
+void
+stream<NextLayer, ReadBuffer>::
+flush_op<Handler>::
+operator()(error_code ec, std::size_t)
+{
+    auto& d = *d_;
+    if(ec)
+        d.ws.failed_ = true;
+    (*this)(ec);
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class Handler>
+void
+stream<NextLayer, ReadBuffer>::
+flush_op<Handler>::
+operator()(error_code ec, bool again)
+{
+    auto& d = *d_;
+    d.cont = d.cont || again;
+    if(ec)
+        goto upcall;
+    for(;;)
+    {
+        switch(d.state)
+        {
+        case 0:
+            if(d.ws.wr_block_)
+            {
+                // suspend
+                d.state = 3;
+                d.ws.wr_op_.template emplace<
+                    flush_op>(std::move(*this));
+                return;
+            }
+            if(d.ws.failed_ || d.ws.wr_close_)
+            {
+                // call handler
+                d.state = 99;
+                d.ws.get_io_service().post(
+                    bind_handler(std::move(*this),
+                        boost::asio::error::operation_aborted));
+                return;
+            }
+            if(d.ws.wr_cont_)
+            {
+                // a message started with write_frame is incomplete
+                d.state = 99;
+                d.ws.get_io_service().post(
+                    bind_handler(std::move(*this),
+                        boost::system::errc::make_error_code(
+                            boost::system::errc::operation_not_permitted)));
+                return;
+            }
+            // fall through
+
+        case 1:
+            if(! d.ws.sq_ || d.ws.sq_[d.ws.sq_i_].size() == 0)
+            {
+                if(! again)
+                {
+                    // nothing queued, call handler
+                    d.state = 99;
+                    d.ws.get_io_service().post(
+                        bind_handler(std::move(*this), ec));
+                    return;
+                }
+                goto upcall;
+            }
+            // send everything queued so far
+            d.state = 2;
+            assert(! d.ws.wr_block_ || d.ws.wr_block_ == &d);
+            d.ws.wr_block_ = &d;
+            d.ws.sq_i_ ^= 1;
+            boost::asio::async_write(d.ws.stream_,
+                d.ws.sq_[d.ws.sq_i_ ^ 1].data(),
+                    std::move(*this));
+            return;
+
+        // sent queued frames
+        case 2:
+        {
+            auto& sb = d.ws.sq_[d.ws.sq_i_ ^ 1];
+            sb.clear();
+            d.ws.sq_notify();
+            d.state = 1;
+            break;
+        }
+
+        case 3:
+            d.state = 4;
+            d.ws.get_io_service().post(bind_handler(
+                std::move(*this), ec));
+            return;
+
+        case 4:
+            if(d.ws.failed_ || d.ws.wr_close_)
+            {
+                // call handler
+                ec = boost::asio::error::operation_aborted;
+                goto upcall;
+            }
+            if(d.ws.wr_cont_)
+            {
+                // a message started with write_frame is incomplete
+                ec = boost::system::errc::make_error_code(
+                    boost::system::errc::operation_not_permitted);
+                goto upcall;
+            }
+            if(d.ws.wr_block_)
+            {
+                // taken while resuming, suspend again
+                d.state = 3;
+                d.ws.wr_op_.template emplace<
+                    flush_op>(std::move(*this));
+                return;
+            }
+            d.state = 1;
+            break;
+
+        case 99:
+            goto upcall;
+        }
+    }
+upcall:
+    if(d.ws.wr_block_ == &d)
+        d.ws.wr_block_ = nullptr;
+    d.ws.rd_op_.maybe_invoke();
+    d.h(ec);
+}
+
+} // websocket
+} // beast
+
+#endif
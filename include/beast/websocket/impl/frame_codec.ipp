@@ -0,0 +1,315 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_IMPL_FRAME_CODEC_IPP
+#define BEAST_WEBSOCKET_IMPL_FRAME_CODEC_IPP
+
+#include <boost/endian/buffers.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace beast {
+namespace websocket {
+
+inline
+frame_decoder::
+frame_decoder(role_type role)
+    : role_(role)
+{
+    fh_.op = opcode::text;
+    fh_.fin = false;
+    fh_.len = 0;
+}
+
+inline
+void
+frame_decoder::
+reset()
+{
+    fh_buf_.reset();
+    utf8_.reset();
+    payload_ = {};
+    size_ = 0;
+    remain_ = 0;
+    cn_ = 0;
+    cont_ = false;
+    in_payload_ = false;
+    done_ = false;
+}
+
+inline
+std::size_t
+frame_decoder::
+write(boost::asio::mutable_buffer const& buffer,
+    event& ev, close_code::value& code)
+{
+    using boost::asio::buffer_cast;
+    using boost::asio::buffer_copy;
+    using boost::asio::buffer_size;
+    auto const p = buffer_cast<std::uint8_t*>(buffer);
+    auto const n = buffer_size(buffer);
+    std::size_t used = 0;
+    ev = event::need_more;
+    code = close_code::none;
+    done_ = false;
+    payload_ = {};
+    if(! in_payload_)
+    {
+        // gather the header, it may arrive in pieces
+        for(;;)
+        {
+            auto const have = fh_buf_.size();
+            auto const need = detail::fh_size(fh_buf_.data());
+            if(have >= need)
+                break;
+            if(used == n)
+                return used;
+            auto const m = (std::min)(need - have, n - used);
+            fh_buf_.commit(buffer_copy(fh_buf_.prepare(m),
+                boost::asio::buffer(p + used, m)));
+            used += m;
+        }
+        on_header(ev, code);
+        return used;
+    }
+    auto const m = remain_ < n ?
+        static_cast<std::size_t>(remain_) : n;
+    if(detail::is_control(fh_.op))
+    {
+        std::memcpy(&cb_[cn_], p, m);
+        cn_ += m;
+        remain_ -= m;
+        used += m;
+        if(remain_ > 0)
+            return used;
+        on_control(ev, code);
+        return used;
+    }
+    if(m == 0)
+        return used;
+    boost::asio::mutable_buffer const mb{p, m};
+    if(fh_.mask)
+        detail::mask_inplace(mb, key_);
+    remain_ -= m;
+    used += m;
+    done_ = remain_ == 0 && fh_.fin;
+    if(msg_op_ == opcode::text)
+    {
+        if(! utf8_.write(p, m) ||
+            (done_ && ! utf8_.finish()))
+        {
+            code = close_code::bad_payload;
+            return used;
+        }
+    }
+    if(remain_ == 0)
+        in_payload_ = false;
+    payload_ = mb;
+    ev = event::payload;
+    return used;
+}
+
+inline
+void
+frame_decoder::
+on_header(event& ev, close_code::value& code)
+{
+    detail::read_fh1(fh_, fh_buf_, role_, code);
+    if(code != close_code::none)
+        return;
+    detail::read_fh2(fh_, fh_buf_, role_, code);
+    if(code != close_code::none)
+        return;
+    fh_buf_.reset();
+    // no extensions are negotiated
+    if(fh_.rsv1)
+    {
+        code = close_code::protocol_error;
+        return;
+    }
+    // continuation without an active message
+    if(! cont_ && fh_.op == opcode::cont)
+    {
+        code = close_code::protocol_error;
+        return;
+    }
+    // new data frame when continuation expected
+    if(cont_ && ! detail::is_control(fh_.op) &&
+        fh_.op != opcode::cont)
+    {
+        code = close_code::protocol_error;
+        return;
+    }
+    if(fh_.mask)
+        detail::prepare_key(key_, fh_.key);
+    remain_ = fh_.len;
+    if(detail::is_control(fh_.op))
+    {
+        cn_ = 0;
+        if(remain_ > 0)
+            in_payload_ = true;
+        else
+            on_control(ev, code);
+        return;
+    }
+    if(fh_.op != opcode::cont)
+    {
+        size_ = fh_.len;
+        msg_op_ = fh_.op;
+    }
+    else
+    {
+        if(size_ > std::numeric_limits<
+            std::uint64_t>::max() - fh_.len)
+        {
+            code = close_code::too_big;
+            return;
+        }
+        size_ += fh_.len;
+    }
+    if(msg_max_ && size_ > msg_max_)
+    {
+        code = close_code::too_big;
+        return;
+    }
+    cont_ = ! fh_.fin;
+    in_payload_ = remain_ > 0;
+    done_ = remain_ == 0 && fh_.fin;
+    if(done_ && msg_op_ == opcode::text && ! utf8_.finish())
+    {
+        code = close_code::bad_payload;
+        return;
+    }
+    ev = event::header;
+}
+
+inline
+void
+frame_decoder::
+on_control(event& ev, close_code::value& code)
+{
+    in_payload_ = false;
+    boost::asio::mutable_buffer const mb{cb_, cn_};
+    if(fh_.mask)
+        detail::mask_inplace(mb, key_);
+    if(fh_.op == opcode::close)
+    {
+        detail::read(cr_, boost::asio::const_buffers_1{mb}, code);
+        if(code != close_code::none)
+            return;
+    }
+    payload_ = mb;
+    ev = event::control;
+}
+
+//------------------------------------------------------------------------------
+
+inline
+std::size_t
+frame_encoder::
+header(void* dest, opcode op, bool fin, std::uint64_t size)
+{
+    using boost::asio::buffer_copy;
+    if(! detail::is_valid(op) || detail::is_reserved(op) ||
+            op == opcode::cont)
+        throw std::domain_error("invalid opcode");
+    detail::frame_header fh;
+    if(detail::is_control(op))
+    {
+        if(! fin || size > 125)
+            throw std::domain_error("invalid control frame");
+        fh.op = op;
+    }
+    else
+    {
+        fh.op = cont_ ? opcode::cont : op;
+        cont_ = ! fin;
+    }
+    fh.fin = fin;
+    fh.rsv1 = false;
+    fh.rsv2 = false;
+    fh.rsv3 = false;
+    fh.len = size;
+    fh.mask = role_ == role_type::client;
+    if(fh.mask)
+    {
+        fh.key = detail::thread_maskgen()();
+        detail::prepare_key(key_, fh.key);
+    }
+    detail::fh_streambuf fh_buf;
+    detail::write(fh_buf, fh);
+    remain_ = size;
+    return buffer_copy(boost::asio::buffer(
+        dest, max_header_size), fh_buf.data());
+}
+
+template<class ConstBufferSequence>
+std::size_t
+frame_encoder::
+payload(void* dest, ConstBufferSequence const& buffers)
+{
+    static_assert(beast::is_ConstBufferSequence<
+        ConstBufferSequence>::value,
+            "ConstBufferSequence requirements not met");
+    using boost::asio::buffer_cast;
+    using boost::asio::buffer_size;
+    auto out = static_cast<std::uint8_t*>(dest);
+    std::size_t total = 0;
+    for(auto const& b : buffers)
+    {
+        auto const n = buffer_size(b);
+        auto const src = buffer_cast<std::uint8_t const*>(b);
+        if(role_ == role_type::client)
+            detail::mask_copy(out, src, n, key_);
+        else if(n > 0)
+            std::memcpy(out, src, n);
+        out += n;
+        total += n;
+    }
+    assert(total <= remain_);
+    remain_ -= total;
+    return total;
+}
+
+template<class ConstBufferSequence>
+std::size_t
+frame_encoder::
+frame(void* dest, opcode op, bool fin,
+    ConstBufferSequence const& buffers)
+{
+    static_assert(beast::is_ConstBufferSequence<
+        ConstBufferSequence>::value,
+            "ConstBufferSequence requirements not met");
+    auto const n = header(dest, op, fin,
+        boost::asio::buffer_size(buffers));
+    return n + payload(
+        static_cast<std::uint8_t*>(dest) + n, buffers);
+}
+
+inline
+std::size_t
+frame_encoder::
+close(void* dest, close_reason const& cr)
+{
+    using namespace boost::endian;
+    if(cr.code == close_code::none)
+        return header(dest, opcode::close, true, 0);
+    std::uint8_t b[125];
+    ::new(&b[0]) big_uint16_buf_t{
+        static_cast<std::uint16_t>(cr.code)};
+    std::memcpy(&b[2], cr.reason.data(), cr.reason.size());
+    return frame(dest, opcode::close, true,
+        boost::asio::buffer(b, 2 + cr.reason.size()));
+}
+
+} // websocket
+} // beast
+
+#endif
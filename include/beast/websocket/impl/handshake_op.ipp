@@ -12,7 +12,10 @@
 #include <beast/http/message_v1.hpp>
 #include <beast/http/read.hpp>
 #include <beast/http/write.hpp>
+#include <beast/websocket/detail/hybi13.hpp>
+#include <beast/websocket/detail/upgrade_parser.hpp>
 #include <beast/core/handler_alloc.hpp>
+#include <beast/core/static_streambuf.hpp>
 #include <cassert>
 #include <memory>
 
@@ -21,33 +24,36 @@ namespace websocket {
 
 // send the upgrade request and process the response
 //
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
-class stream<NextLayer>::handshake_op
+class stream<NextLayer, ReadBuffer>::handshake_op
 {
     using alloc_type =
         handler_alloc<char, Handler>;
 
     struct data
     {
-        stream<NextLayer>& ws;
+        stream<NextLayer, ReadBuffer>& ws;
         Handler h;
-        std::string key;
-        http::request_v1<http::empty_body> req;
-        http::response_v1<http::string_body> resp;
+        detail::sec_ws_key_type key;
+        static_streambuf_n<1024> sb;
+        std::unique_ptr<http::request_v1<http::empty_body>> req;
+        detail::upgrade_parser<false> p;
         bool cont;
         int state = 0;
 
         template<class DeducedHandler>
-        data(DeducedHandler&& h_, stream<NextLayer>& ws_,
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
             boost::string_ref const& host,
                 boost::string_ref const& resource)
             : ws(ws_)
             , h(std::forward<DeducedHandler>(h_))
-            , req(ws.build_request(host, resource, key))
             , cont(boost_asio_handler_cont_helpers::
                 is_continuation(h))
         {
+            if(! ws.build_request(sb, host, resource, key))
+                req.reset(new http::request_v1<http::empty_body>(
+                    ws.build_request(host, resource, key)));
             ws.reset();
         }
     };
@@ -60,7 +66,7 @@ public:
 
     template<class DeducedHandler, class... Args>
     handshake_op(DeducedHandler&& h,
-            stream<NextLayer>& ws, Args&&... args)
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
         : d_(std::allocate_shared<data>(alloc_type{h},
             std::forward<DeducedHandler>(h), ws,
                 std::forward<Args>(args)...))
@@ -68,6 +74,12 @@ public:
         (*this)(error_code{}, false);
     }
 
+    void
+    operator()(error_code ec, std::size_t)
+    {
+        (*this)(ec);
+    }
+
     void
     operator()(error_code ec, bool again = true);
 
@@ -102,10 +114,10 @@ public:
     }
 };
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
 void
-stream<NextLayer>::handshake_op<Handler>::
+stream<NextLayer, ReadBuffer>::handshake_op<Handler>::
 operator()(error_code ec, bool again)
 {
     auto& d = *d_;
@@ -115,29 +127,30 @@ operator()(error_code ec, bool again)
         switch(d.state)
         {
         case 0:
-        {
             // send http upgrade
             d.state = 1;
-            // VFALCO Do we need the ability to move
-            //        a message on the async_write?
-            http::async_write(d.ws.stream_,
-                d.req, std::move(*this));
+            if(d.req)
+                http::async_write(d.ws.stream_,
+                    *d.req, std::move(*this));
+            else
+                boost::asio::async_write(d.ws.stream_,
+                    d.sb.data(), std::move(*this));
             return;
-        }
 
         // sent upgrade
         case 1:
             // read http response
             d.state = 2;
-            http::async_read(d.ws.next_layer(),
-                d.ws.stream_.buffer(), d.resp,
+            http::async_parse(d.ws.next_layer(),
+                d.ws.stream_.buffer(), d.p,
                     std::move(*this));
             return;
 
         // got response
         case 2:
         {
-            d.ws.do_response(d.resp, d.key, ec);
+            d.ws.do_response(d.p, boost::string_ref{
+                d.key.data(), d.key.size()}, ec);
             // call handler
             d.state = 99;
             break;
@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_IMPL_KA_PING_OP_HPP
+#define BEAST_WEBSOCKET_IMPL_KA_PING_OP_HPP
+
+#include <beast/websocket/detail/frame.hpp>
+#include <cassert>
+#include <memory>
+
+namespace beast {
+namespace websocket {
+
+// write an automatic ping frame
+//
+// There is no caller to notify, so the operation owns its
+// memory. It is only started while the write block is free.
+// The stream may be moved or destroyed before the write
+// completes, so the operation reaches it only through the
+// stream's keepalive state, which follows it when moved.
+//
+template<class NextLayer, class ReadBuffer>
+class stream<NextLayer, ReadBuffer>::ka_ping_op
+{
+    struct data : op
+    {
+        std::weak_ptr<detail::stream_base*> self;
+        detail::frame_streambuf fb;
+
+        data(stream<NextLayer, ReadBuffer>& ws, ping_data const& payload)
+            : self(ws.ka_self_)
+        {
+            ws.template write_ping<static_streambuf>(
+                fb, opcode::ping, payload);
+        }
+    };
+
+    std::shared_ptr<data> d_;
+
+public:
+    ka_ping_op(ka_ping_op&&) = default;
+    ka_ping_op(ka_ping_op const&) = default;
+
+    ka_ping_op(stream<NextLayer, ReadBuffer>& ws, ping_data const& payload)
+        : d_(std::make_shared<data>(ws, payload))
+    {
+        auto& d = *d_;
+        assert(! ws.wr_block_);
+        ws.wr_block_ = &d;
+        boost::asio::async_write(ws.stream_,
+            d.fb.data(), std::move(*this));
+    }
+
+    void operator()(error_code const& ec, std::size_t);
+};
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::ka_ping_op::
+operator()(error_code const& ec, std::size_t)
+{
+    auto& d = *d_;
+    auto const self = d.self.lock();
+    if(! self)
+        return;
+    auto& ws = static_cast<stream&>(**self);
+    if(ec)
+        ws.failed_ = true;
+    if(ws.wr_block_ == &d)
+        ws.wr_block_ = nullptr;
+    // resume operations which waited on the block
+    ws.rd_op_.maybe_invoke();
+    ws.wr_ctrl_ = false;
+    ws.wr_op_.maybe_invoke();
+    ws.wr_yield_.maybe_invoke();
+}
+
+} // websocket
+} // beast
+
+#endif
@@ -18,23 +18,23 @@ namespace websocket {
 
 // write a ping frame
 //
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
-class stream<NextLayer>::ping_op
+class stream<NextLayer, ReadBuffer>::ping_op
 {
     using alloc_type =
         handler_alloc<char, Handler>;
 
     struct data : op
     {
-        stream<NextLayer>& ws;
+        stream<NextLayer, ReadBuffer>& ws;
         Handler h;
         detail::frame_streambuf fb;
         bool cont;
         int state = 0;
 
         template<class DeducedHandler>
-        data(DeducedHandler&& h_, stream<NextLayer>& ws_,
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
                 ping_data const& payload)
             : ws(ws_)
             , h(std::forward<DeducedHandler>(h_))
@@ -56,8 +56,8 @@ public:
 
     template<class DeducedHandler, class... Args>
     ping_op(DeducedHandler&& h,
-            stream<NextLayer>& ws, Args&&... args)
-        : d_(std::make_shared<data>(
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
+        : d_(std::allocate_shared<data>(alloc_type{h},
             std::forward<DeducedHandler>(h), ws,
                 std::forward<Args>(args)...))
     {
@@ -104,10 +104,10 @@ public:
     }
 };
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
 void 
-stream<NextLayer>::ping_op<Handler>::
+stream<NextLayer, ReadBuffer>::ping_op<Handler>::
 operator()(error_code ec, std::size_t)
 {
     auto& d = *d_;
@@ -116,10 +116,10 @@ operator()(error_code ec, std::size_t)
     (*this)(ec);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 ping_op<Handler>::
 operator()(error_code ec, bool again)
 {
@@ -136,6 +136,7 @@ operator()(error_code ec, bool again)
             {
                 // suspend
                 d.state = 2;
+                d.ws.wr_ctrl_ = true;
                 d.ws.wr_op_.template emplace<
                     ping_op>(std::move(*this));
                 return;
@@ -173,6 +174,15 @@ operator()(error_code ec, bool again)
                 ec = boost::asio::error::operation_aborted;
                 goto upcall;
             }
+            if(d.ws.wr_block_)
+            {
+                // taken while resuming, suspend again
+                d.state = 2;
+                d.ws.wr_ctrl_ = true;
+                d.ws.wr_op_.template emplace<
+                    ping_op>(std::move(*this));
+                return;
+            }
             d.state = 1;
             break;
 
@@ -184,6 +194,7 @@ upcall:
     if(d.ws.wr_block_ == &d)
         d.ws.wr_block_ = nullptr;
     d.ws.rd_op_.maybe_invoke();
+    d.ws.wr_yield_.maybe_invoke();
     d.h(ec);
 }
 
@@ -0,0 +1,182 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_IMPL_READ_BATCH_OP_HPP
+#define BEAST_WEBSOCKET_IMPL_READ_BATCH_OP_HPP
+
+#include <beast/websocket/detail/op_pool.hpp>
+#include <beast/core/handler_alloc.hpp>
+#include <memory>
+#include <vector>
+
+namespace beast {
+namespace websocket {
+
+// read a message, then every complete message already buffered
+//
+// Frames after the first message are read by operations started
+// from this operation's own completion, and those which complete
+// from buffered data return here without a trip through the
+// io_service. A loop takes the place of the recursion.
+//
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer, class Handler>
+class stream<NextLayer, ReadBuffer>::read_batch_op
+{
+    using read_frame_type =
+        read_frame_op<DynamicBuffer, read_batch_op>;
+
+    struct data
+    {
+        stream<NextLayer, ReadBuffer>& ws;
+        std::vector<batch_message>& v;
+        DynamicBuffer& db;
+        Handler h;
+        frame_info fi;
+        error_code ec;
+        std::size_t max_messages;
+        std::size_t max_bytes;
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+        std::size_t offset = 0;
+        bool cont;
+        bool nested = false;
+        int state = 0;
+
+        template<class DeducedHandler>
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
+                std::vector<batch_message>& v_, DynamicBuffer& db_,
+                    std::size_t max_messages_, std::size_t max_bytes_)
+            : ws(ws_)
+            , v(v_)
+            , db(db_)
+            , h(std::forward<DeducedHandler>(h_))
+            , max_messages(max_messages_)
+            , max_bytes(max_bytes_)
+            , cont(boost_asio_handler_cont_helpers::
+                is_continuation(h))
+        {
+        }
+    };
+
+    std::shared_ptr<data> d_;
+
+public:
+    read_batch_op(read_batch_op&&) = default;
+    read_batch_op(read_batch_op const&) = default;
+
+    template<class DeducedHandler, class... Args>
+    read_batch_op(DeducedHandler&& h,
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
+            std::forward<DeducedHandler>(h), ws,
+                std::forward<Args>(args)...))
+    {
+        (*this)(error_code{}, false);
+    }
+
+    void operator()(error_code const& ec)
+    {
+        auto& d = *d_;
+        if(d.nested)
+        {
+            // completed from buffered data, the loop resumes
+            d.nested = false;
+            d.ec = ec;
+            return;
+        }
+        (*this)(ec, true);
+    }
+
+    void operator()(error_code ec, bool again);
+
+    friend
+    void* asio_handler_allocate(
+        std::size_t size, read_batch_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            allocate(size, op->d_->h);
+    }
+
+    friend
+    void asio_handler_deallocate(
+        void* p, std::size_t size, read_batch_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            deallocate(p, size, op->d_->h);
+    }
+
+    friend
+    bool asio_handler_is_continuation(read_batch_op* op)
+    {
+        return op->d_->cont;
+    }
+
+    template <class Function>
+    friend
+    void asio_handler_invoke(Function&& f, read_batch_op* op)
+    {
+        return boost_asio_handler_invoke_helpers::
+            invoke(f, op->d_->h);
+    }
+};
+
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer, class Handler>
+void
+stream<NextLayer, ReadBuffer>::read_batch_op<DynamicBuffer, Handler>::
+operator()(error_code ec, bool again)
+{
+    auto& d = *d_;
+    d.cont = d.cont || again;
+    while(! ec)
+    {
+        switch(d.state)
+        {
+        case 0:
+            // read the first frame, buffered data
+            // still completes through the io_service
+            d.state = 1;
+            d.offset = d.db.size();
+            read_frame_type{*this, d.ws, d.fi, d.db};
+            return;
+
+        // got a frame
+        case 1:
+            if(d.fi.fin)
+            {
+                auto const size = d.db.size() - d.offset;
+                d.v.push_back({d.fi.op, d.offset, size});
+                ++d.count;
+                d.bytes += size;
+                if(! d.ws.rd_batch_next(d.count, d.bytes,
+                        d.max_messages, d.max_bytes))
+                    goto upcall;
+                d.offset = d.db.size();
+            }
+            d.nested = true;
+            read_frame_type{typename read_frame_type::resume_t{},
+                *this, d.ws, d.fi, d.db};
+            if(d.nested)
+            {
+                // waiting for the next layer
+                d.nested = false;
+                return;
+            }
+            ec = d.ec;
+            break;
+        }
+    }
+upcall:
+    d.h(ec, d.count);
+}
+
+} // websocket
+} // beast
+
+#endif
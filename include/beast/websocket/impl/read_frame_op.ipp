@@ -9,11 +9,14 @@
 #define BEAST_WEBSOCKET_IMPL_READ_FRAME_OP_HPP
 
 #include <beast/websocket/teardown.hpp>
+#include <beast/websocket/detail/op_pool.hpp>
 #include <beast/core/handler_alloc.hpp>
 #include <beast/core/prepare_buffers.hpp>
 #include <beast/core/static_streambuf.hpp>
 #include <boost/optional.hpp>
+#include <algorithm>
 #include <cassert>
+#include <limits>
 #include <memory>
 
 namespace beast {
@@ -22,13 +25,16 @@ namespace websocket {
 // Reads a single message frame,
 // processes any received control frames.
 //
-template<class NextLayer>
+// When a limit is given, the operation completes as soon as
+// some payload is received, with no more than limit bytes.
+//
+// In view mode, the payload of an uncompressed frame is left in
+// the stream's read buffer, unmasked, instead of being copied.
+//
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer, class Handler>
-class stream<NextLayer>::read_frame_op
+class stream<NextLayer, ReadBuffer>::read_frame_op
 {
-    using alloc_type =
-        handler_alloc<char, Handler>;
-
     using fb_type =
         detail::frame_streambuf;
 
@@ -40,23 +46,31 @@ class stream<NextLayer>::read_frame_op
 
     struct data : op
     {
-        stream<NextLayer>& ws;
+        stream<NextLayer, ReadBuffer>& ws;
         frame_info& fi;
         DynamicBuffer& db;
         Handler h;
         fb_type fb;
         boost::optional<dmb_type> dmb;
         boost::optional<fmb_type> fmb;
+        std::size_t limit;
+        bool some;
+        bool view;
         bool cont;
         int state = 0;
 
         template<class DeducedHandler>
-        data(DeducedHandler&& h_, stream<NextLayer>& ws_,
-                frame_info& fi_, DynamicBuffer& sb_)
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
+                frame_info& fi_, DynamicBuffer& sb_,
+                    std::size_t limit_ = 0, bool view_ = false)
             : ws(ws_)
             , fi(fi_)
             , db(sb_)
             , h(std::forward<DeducedHandler>(h_))
+            , limit(limit_ > 0 ? limit_ :
+                std::numeric_limits<std::size_t>::max())
+            , some(limit_ > 0)
+            , view(view_)
             , cont(boost_asio_handler_cont_helpers::
                 is_continuation(h))
         {
@@ -71,14 +85,31 @@ public:
 
     template<class DeducedHandler, class... Args>
     read_frame_op(DeducedHandler&& h,
-            stream<NextLayer>& ws, Args&&... args)
-        : d_(std::allocate_shared<data>(alloc_type{h},
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
             std::forward<DeducedHandler>(h), ws,
                 std::forward<Args>(args)...))
     {
         (*this)(error_code{}, 0, false);
     }
 
+    // Used when starting from a completion handler of the
+    // caller, so that a frame which is already buffered
+    // completes without going through the io_service.
+    struct resume_t {};
+
+    template<class DeducedHandler, class... Args>
+    read_frame_op(resume_t, DeducedHandler&& h,
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
+            std::forward<DeducedHandler>(h), ws,
+                std::forward<Args>(args)...))
+    {
+        (*this)(error_code{}, 0, true);
+    }
+
     void operator()()
     {
         (*this)(error_code{}, 0, true);
@@ -126,10 +157,10 @@ public:
     }
 };
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer, class Handler>
 void
-stream<NextLayer>::read_frame_op<DynamicBuffer, Handler>::
+stream<NextLayer, ReadBuffer>::read_frame_op<DynamicBuffer, Handler>::
 operator()(error_code ec, std::size_t bytes_transferred)
 {
     auto& d = *d_;
@@ -138,10 +169,10 @@ operator()(error_code ec, std::size_t bytes_transferred)
     (*this)(ec, bytes_transferred, true);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer, class Handler>
 void
-stream<NextLayer>::read_frame_op<DynamicBuffer, Handler>::
+stream<NextLayer, ReadBuffer>::read_frame_op<DynamicBuffer, Handler>::
 operator()(error_code ec,std::size_t bytes_transferred, bool again)
 {
     enum
@@ -157,15 +188,22 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
         do_close_resume = 13,
         do_close = 15,
         do_fail = 18,
+        do_inflate_payload = 24,
+        do_read_view = 26,
 
         do_call_handler = 99
     };
 
+    using boost::asio::buffer_copy;
     auto& d = *d_;
     if(! ec)
     {
         d.cont = d.cont || again;
         close_code::value code = close_code::none;
+        // set when payload was unmasked while
+        // moving it out of the read buffer
+        bool drained = false;
+        bool valid = true;
         do
         {
             switch(d.state)
@@ -179,6 +217,7 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                             boost::asio::error::operation_aborted, 0));
                     return;
                 }
+                d.ws.rd_release_view();
                 d.state =  d.ws.rd_need_ > 0 ?
                     do_read_payload : do_read_fh;
                 break;
@@ -186,9 +225,40 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
             //------------------------------------------------------------------
 
             case do_read_payload:
+                if(d.ws.pmd_ && d.ws.pmd_->rd_set)
+                {
+                    // receive compressed payload data
+                    d.state = do_inflate_payload;
+                    auto const mb = boost::asio::buffer(
+                        d.ws.pmd_->rd_buf, detail::clamp(d.ws.rd_need_,
+                            std::min(sizeof(d.ws.pmd_->rd_buf), d.limit)));
+                    if(d.ws.stream_.buffer().size() > 0)
+                    {
+                        bytes_transferred =
+                            d.ws.rd_drain(mb, valid);
+                        drained = true;
+                        break;
+                    }
+                    d.ws.stream_.async_read_some(
+                        mb, std::move(*this));
+                    return;
+                }
+                if(d.view)
+                {
+                    d.state = do_read_view;
+                    break;
+                }
                 d.state = do_read_payload + 1;
                 d.dmb = d.db.prepare(
-                    detail::clamp(d.ws.rd_need_));
+                    detail::clamp(d.ws.rd_need_, d.limit));
+                if(d.ws.stream_.buffer().size() > 0)
+                {
+                    // payload data is already buffered
+                    bytes_transferred =
+                        d.ws.rd_drain(*d.dmb, valid);
+                    drained = true;
+                    break;
+                }
                 // receive payload data
                 d.ws.stream_.async_read_some(
                     *d.dmb, std::move(*this));
@@ -196,25 +266,23 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
 
             case do_read_payload + 1:
             {
+                d.ws.ka_rx_ = true;
                 d.ws.rd_need_ -= bytes_transferred;
-                auto const pb = prepare_buffers(
-                    bytes_transferred, *d.dmb);
-                if(d.ws.rd_fh_.mask)
-                    detail::mask_inplace(pb, d.ws.rd_key_);
-                if(d.ws.rd_opcode_ == opcode::text)
+                if(! drained)
+                    valid = d.ws.rd_unmask(prepare_buffers(
+                        bytes_transferred, *d.dmb));
+                drained = false;
+                if(! valid || (d.ws.rd_opcode_ == opcode::text &&
+                    d.ws.rd_need_ == 0 && d.ws.rd_fh_.fin &&
+                        ! d.ws.rd_utf8_check_.finish()))
                 {
-                    if(! d.ws.rd_utf8_check_.write(pb) ||
-                        (d.ws.rd_need_ == 0 && d.ws.rd_fh_.fin &&
-                            ! d.ws.rd_utf8_check_.finish()))
-                    {
-                        // invalid utf8
-                        code = close_code::bad_payload;
-                        d.state = do_fail;
-                        break;
-                    }
+                    // invalid utf8
+                    code = close_code::bad_payload;
+                    d.state = do_fail;
+                    break;
                 }
                 d.db.commit(bytes_transferred);
-                if(d.ws.rd_need_ > 0)
+                if(d.ws.rd_need_ > 0 && ! d.some)
                 {
                     d.state = do_read_payload;
                     break;
@@ -229,45 +297,43 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                 d.fi.op = d.ws.rd_opcode_;
                 d.fi.fin = d.ws.rd_fh_.fin &&
                     d.ws.rd_need_ == 0;
+                d.fi.frame_end = d.ws.rd_need_ == 0;
                 goto upcall;
 
             //------------------------------------------------------------------
 
             case do_read_fh:
-                d.state = do_read_fh + 1;
-                boost::asio::async_read(d.ws.stream_,
-                    d.fb.prepare(2), std::move(*this));
-                return;
-
-            case do_read_fh + 1:
             {
-                d.fb.commit(bytes_transferred);
-                code = close_code::none;
-                auto const n = detail::read_fh1(
-                    d.ws.rd_fh_, d.fb, d.ws.role_, code);
-                if(code != close_code::none)
-                {
-                    // protocol error
-                    d.state = do_fail;
-                    break;
-                }
-                d.state = do_read_fh + 2;
-                if (n == 0)
+                // Headers are decoded from the stream's buffer,
+                // reading ahead so that frames arriving together
+                // are handled without going back to the socket.
+                auto& sb = d.ws.stream_.buffer();
+                auto const n = detail::fh_size(sb.data());
+                if(sb.size() >= n)
                 {
-                    bytes_transferred = 0;
+                    d.state = do_read_fh + 2;
                     break;
                 }
-                // read variable header
-                boost::asio::async_read(d.ws.stream_,
-                    d.fb.prepare(n), std::move(*this));
+                d.state = do_read_fh + 1;
+                d.ws.stream_.next_layer().async_read_some(
+                    d.ws.rd_refill(sb, n - sb.size()),
+                        std::move(*this));
                 return;
             }
 
+            case do_read_fh + 1:
+                d.ws.stream_.buffer().commit(bytes_transferred);
+                d.state = do_read_fh;
+                break;
+
             case do_read_fh + 2:
-                d.fb.commit(bytes_transferred);
+                d.ws.ka_rx_ = true;
                 code = close_code::none;
-                detail::read_fh2(d.ws.rd_fh_,
-                    d.fb, d.ws.role_, code);
+                detail::read_fh1(d.ws.rd_fh_,
+                    d.ws.stream_.buffer(), d.ws.role_, code);
+                if(code == close_code::none)
+                    detail::read_fh2(d.ws.rd_fh_,
+                        d.ws.stream_.buffer(), d.ws.role_, code);
                 if(code == close_code::none)
                     d.ws.prepare_fh(code);
                 if(code != close_code::none)
@@ -284,6 +350,15 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                         d.state = do_control_payload;
                         d.fmb = d.fb.prepare(static_cast<
                             std::size_t>(d.ws.rd_fh_.len));
+                        if(d.ws.stream_.buffer().size() >=
+                            d.ws.rd_fh_.len)
+                        {
+                            bytes_transferred = buffer_copy(*d.fmb,
+                                d.ws.stream_.buffer().data());
+                            d.ws.stream_.buffer().consume(
+                                bytes_transferred);
+                            break;
+                        }
                         boost::asio::async_read(d.ws.stream_,
                             *d.fmb, std::move(*this));
                         return;
@@ -293,9 +368,20 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                 }
                 if(d.ws.rd_need_ > 0)
                 {
+                    if(! d.some && ! d.view && ! (
+                            d.ws.pmd_ && d.ws.pmd_->rd_set))
+                        d.ws.rd_reserve(d.db);
                     d.state = do_read_payload;
                     break;
                 }
+                if(d.ws.pmd_ && d.ws.pmd_->rd_set &&
+                    d.ws.rd_fh_.fin)
+                {
+                    // empty frame ending a compressed message
+                    d.state = do_inflate_payload;
+                    bytes_transferred = 0;
+                    break;
+                }
                 // empty frame
                 d.state = do_frame_done;
                 break;
@@ -343,6 +429,7 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                     code = close_code::none;
                     ping_data payload;
                     detail::read(payload, d.fb.data());
+                    d.ws.ka_pong(payload);
                     if(d.ws.pong_cb_)
                         d.ws.pong_cb_(payload);
                     d.fb.reset();
@@ -351,7 +438,8 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                 }
                 assert(d.ws.rd_fh_.op == opcode::close);
                 {
-                    detail::read(d.ws.cr_, d.fb.data(), code);
+                    detail::read(d.ws.rd_close_reason(),
+                        d.fb.data(), code);
                     if(code != close_code::none)
                     {
                         // protocol error
@@ -360,7 +448,7 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                     }
                     if(! d.ws.wr_close_)
                     {
-                        auto cr = d.ws.cr_;
+                        auto cr = *d.ws.cr_;
                         if(cr.code == close_code::none)
                             cr.code = close_code::normal;
                         cr.reason = "";
@@ -398,6 +486,14 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                     ec = boost::asio::error::operation_aborted;
                     goto upcall;
                 }
+                if(d.ws.wr_block_)
+                {
+                    // taken while resuming, suspend again
+                    d.state = do_pong_resume;
+                    d.ws.rd_op_.template emplace<
+                        read_frame_op>(std::move(*this));
+                    return;
+                }
                 d.state = do_pong;
                 break; // VFALCO fall through?
 
@@ -423,6 +519,9 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                 d.fb.reset();
                 d.state = do_read_fh;
                 d.ws.wr_block_ = nullptr;
+                d.ws.wr_ctrl_ = false;
+                d.ws.wr_op_.maybe_invoke();
+                d.ws.wr_yield_.maybe_invoke();
                 break;
 
             //------------------------------------------------------------------
@@ -447,6 +546,14 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                     ec = error::closed;
                     goto upcall;
                 }
+                if(d.ws.wr_block_)
+                {
+                    // taken while resuming, suspend again
+                    d.state = do_close_resume;
+                    d.ws.rd_op_.template emplace<
+                        read_frame_op>(std::move(*this));
+                    return;
+                }
                 d.state = do_close;
                 break;
 
@@ -516,6 +623,14 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
                     d.state = do_fail + 5;
                     break;
                 }
+                if(d.ws.wr_block_)
+                {
+                    // taken while resuming, suspend again
+                    d.state = do_fail + 2;
+                    d.ws.rd_op_.template emplace<
+                        read_frame_op>(std::move(*this));
+                    return;
+                }
                 d.state = do_fail + 1;
                 break;
 
@@ -532,6 +647,65 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
 
             //------------------------------------------------------------------
 
+            case do_inflate_payload:
+            {
+                d.ws.ka_rx_ = true;
+                d.ws.rd_need_ -= bytes_transferred;
+                boost::asio::mutable_buffers_1 mb{
+                    d.ws.pmd_->rd_buf, bytes_transferred};
+                if(! drained)
+                    d.ws.rd_unmask(mb);
+                drained = false;
+                d.ws.rd_inflate(d.db, mb, d.ws.rd_fh_.fin &&
+                    d.ws.rd_need_ == 0, code);
+                if(code != close_code::none)
+                {
+                    d.state = do_fail;
+                    break;
+                }
+                if(d.ws.rd_need_ > 0 && ! d.some)
+                {
+                    d.state = do_read_payload;
+                    break;
+                }
+                d.state = do_frame_done;
+                break;
+            }
+
+            //------------------------------------------------------------------
+
+            case do_read_view:
+            {
+                // receive the whole frame into the read buffer
+                auto& sb = d.ws.stream_.buffer();
+                auto const n = detail::clamp(d.ws.rd_need_);
+                if(sb.size() < n)
+                {
+                    d.state = do_read_view + 1;
+                    d.ws.stream_.next_layer().async_read_some(
+                        d.ws.rd_refill(sb, n - sb.size()),
+                            std::move(*this));
+                    return;
+                }
+                d.ws.ka_rx_ = true;
+                d.ws.rd_need_ = 0;
+                d.ws.rd_view_payload(n, code);
+                if(code != close_code::none)
+                {
+                    d.state = do_fail;
+                    break;
+                }
+                d.state = do_frame_done;
+                break;
+            }
+
+            case do_read_view + 1:
+                d.ws.stream_.buffer().commit(bytes_transferred);
+                d.state = do_read_view;
+                break;
+
+            //------------------------------------------------------------------
+
             case do_call_handler:
                 goto upcall;
             }
@@ -539,9 +713,20 @@ operator()(error_code ec,std::size_t bytes_transferred, bool again)
         while(! ec);
     }
 upcall:
+    if(! again)
+    {
+        // Completed from buffered data, the handler
+        // must not be invoked from the initiating function.
+        d.state = do_call_handler;
+        d.ws.get_io_service().post(bind_handler(
+            std::move(*this), ec, 0, true));
+        return;
+    }
     if(d.ws.wr_block_ == &d)
         d.ws.wr_block_ = nullptr;
+    d.ws.wr_ctrl_ = false;
     d.ws.wr_op_.maybe_invoke();
+    d.ws.wr_yield_.maybe_invoke();
     d.h(ec);
 }
 
@@ -8,6 +8,7 @@
 #ifndef BEAST_WEBSOCKET_IMPL_READ_OP_HPP
 #define BEAST_WEBSOCKET_IMPL_READ_OP_HPP
 
+#include <beast/websocket/detail/op_pool.hpp>
 #include <beast/core/handler_alloc.hpp>
 #include <memory>
 
@@ -16,16 +17,13 @@ namespace websocket {
 
 // read an entire message
 //
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer, class Handler>
-class stream<NextLayer>::read_op
+class stream<NextLayer, ReadBuffer>::read_op
 {
-    using alloc_type =
-        handler_alloc<char, Handler>;
-
     struct data
     {
-        stream<NextLayer>& ws;
+        stream<NextLayer, ReadBuffer>& ws;
         opcode& op;
         DynamicBuffer& db;
         Handler h;
@@ -35,7 +33,7 @@ class stream<NextLayer>::read_op
 
         template<class DeducedHandler>
         data(DeducedHandler&& h_,
-            stream<NextLayer>& ws_, opcode& op_,
+            stream<NextLayer, ReadBuffer>& ws_, opcode& op_,
                 DynamicBuffer& sb_)
             : ws(ws_)
             , op(op_)
@@ -55,8 +53,9 @@ public:
 
     template<class DeducedHandler, class... Args>
     read_op(DeducedHandler&& h,
-            stream<NextLayer>& ws, Args&&... args)
-        : d_(std::allocate_shared<data>(alloc_type{h},
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
             std::forward<DeducedHandler>(h), ws,
                 std::forward<Args>(args)...))
     {
@@ -97,10 +96,10 @@ public:
     }
 };
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer, class Handler>
 void
-stream<NextLayer>::read_op<DynamicBuffer, Handler>::
+stream<NextLayer, ReadBuffer>::read_op<DynamicBuffer, Handler>::
 operator()(error_code const& ec, bool again)
 {
     auto& d = *d_;
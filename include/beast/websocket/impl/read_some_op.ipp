@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_IMPL_READ_SOME_OP_HPP
+#define BEAST_WEBSOCKET_IMPL_READ_SOME_OP_HPP
+
+#include <beast/websocket/detail/op_pool.hpp>
+#include <beast/core/handler_alloc.hpp>
+#include <limits>
+#include <memory>
+
+namespace beast {
+namespace websocket {
+
+// read some message data
+//
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer, class Handler>
+class stream<NextLayer, ReadBuffer>::read_some_op
+{
+    struct data
+    {
+        DynamicBuffer& db;
+        Handler h;
+        std::size_t size;
+        bool cont;
+
+        template<class DeducedHandler>
+        data(DeducedHandler&& h_, DynamicBuffer& sb_)
+            : db(sb_)
+            , h(std::forward<DeducedHandler>(h_))
+            , size(db.size())
+            , cont(boost_asio_handler_cont_helpers::
+                is_continuation(h))
+        {
+        }
+    };
+
+    std::shared_ptr<data> d_;
+
+public:
+    read_some_op(read_some_op&&) = default;
+    read_some_op(read_some_op const&) = default;
+
+    template<class DeducedHandler>
+    read_some_op(DeducedHandler&& h, stream<NextLayer, ReadBuffer>& ws,
+            frame_info& fi, DynamicBuffer& db, std::size_t limit)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
+            std::forward<DeducedHandler>(h), db))
+    {
+        read_frame_op<DynamicBuffer, read_some_op>{*this, ws, fi, db,
+            limit > 0 ? limit : std::numeric_limits<std::size_t>::max()};
+    }
+
+    void operator()(error_code const& ec)
+    {
+        auto& d = *d_;
+        d.h(ec, ec ? 0 : d.db.size() - d.size);
+    }
+
+    friend
+    void* asio_handler_allocate(
+        std::size_t size, read_some_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            allocate(size, op->d_->h);
+    }
+
+    friend
+    void asio_handler_deallocate(
+        void* p, std::size_t size, read_some_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            deallocate(p, size, op->d_->h);
+    }
+
+    friend
+    bool asio_handler_is_continuation(read_some_op* op)
+    {
+        return op->d_->cont;
+    }
+
+    template <class Function>
+    friend
+    void asio_handler_invoke(Function&& f, read_some_op* op)
+    {
+        return boost_asio_handler_invoke_helpers::
+            invoke(f, op->d_->h);
+    }
+};
+
+} // websocket
+} // beast
+
+#endif
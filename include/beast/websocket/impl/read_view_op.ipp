@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_IMPL_READ_VIEW_OP_HPP
+#define BEAST_WEBSOCKET_IMPL_READ_VIEW_OP_HPP
+
+#include <beast/websocket/detail/op_pool.hpp>
+#include <beast/core/handler_alloc.hpp>
+#include <memory>
+
+namespace beast {
+namespace websocket {
+
+// read a frame into the stream's own buffers
+//
+template<class NextLayer, class ReadBuffer>
+template<class Handler>
+class stream<NextLayer, ReadBuffer>::read_view_op
+{
+    struct data
+    {
+        stream<NextLayer, ReadBuffer>& ws;
+        Handler h;
+        bool cont;
+
+        template<class DeducedHandler>
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_)
+            : ws(ws_)
+            , h(std::forward<DeducedHandler>(h_))
+            , cont(boost_asio_handler_cont_helpers::
+                is_continuation(h))
+        {
+        }
+    };
+
+    std::shared_ptr<data> d_;
+
+public:
+    read_view_op(read_view_op&&) = default;
+    read_view_op(read_view_op const&) = default;
+
+    template<class DeducedHandler>
+    read_view_op(DeducedHandler&& h,
+            stream<NextLayer, ReadBuffer>& ws, frame_info& fi)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
+            std::forward<DeducedHandler>(h), ws))
+    {
+        read_frame_op<ReadBuffer, read_view_op>{*this, ws, fi,
+            ws.rd_inflated(), 0, true};
+    }
+
+    void operator()(error_code const& ec)
+    {
+        auto& d = *d_;
+        if(ec)
+            d.h(ec, prepare_buffers(0, d.ws.stream_.buffer().data()));
+        else
+            d.h(ec, d.ws.rd_view());
+    }
+
+    friend
+    void* asio_handler_allocate(
+        std::size_t size, read_view_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            allocate(size, op->d_->h);
+    }
+
+    friend
+    void asio_handler_deallocate(
+        void* p, std::size_t size, read_view_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            deallocate(p, size, op->d_->h);
+    }
+
+    friend
+    bool asio_handler_is_continuation(read_view_op* op)
+    {
+        return op->d_->cont;
+    }
+
+    template <class Function>
+    friend
+    void asio_handler_invoke(Function&& f, read_view_op* op)
+    {
+        return boost_asio_handler_invoke_helpers::
+            invoke(f, op->d_->h);
+    }
+};
+
+} // websocket
+} // beast
+
+#endif
@@ -18,16 +18,16 @@ namespace beast {
 namespace websocket {
 
 // Respond to an upgrade HTTP request
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
-class stream<NextLayer>::response_op
+class stream<NextLayer, ReadBuffer>::response_op
 {
     using alloc_type =
         handler_alloc<char, Handler>;
 
     struct data
     {
-        stream<NextLayer>& ws;
+        stream<NextLayer, ReadBuffer>& ws;
         http::response_v1<http::string_body> resp;
         Handler h;
         error_code final_ec;
@@ -36,7 +36,7 @@ class stream<NextLayer>::response_op
 
         template<class DeducedHandler,
             class Body, class Headers>
-        data(DeducedHandler&& h_, stream<NextLayer>& ws_,
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
             http::request_v1<Body, Headers> const& req,
                 bool cont_)
             : ws(ws_)
@@ -60,7 +60,7 @@ public:
 
     template<class DeducedHandler, class... Args>
     response_op(DeducedHandler&& h,
-            stream<NextLayer>& ws, Args&&... args)
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
         : d_(std::allocate_shared<data>(alloc_type{h},
             std::forward<DeducedHandler>(h), ws,
                 std::forward<Args>(args)...))
@@ -102,10 +102,10 @@ public:
     }
 };
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Handler>
 void 
-stream<NextLayer>::response_op<Handler>::
+stream<NextLayer, ReadBuffer>::response_op<Handler>::
 operator()(error_code ec, bool again)
 {
     auto& d = *d_;
@@ -12,12 +12,17 @@
 #include <beast/websocket/detail/hybi13.hpp>
 #include <beast/websocket/impl/accept_op.ipp>
 #include <beast/websocket/impl/close_op.ipp>
+#include <beast/websocket/impl/flush_op.ipp>
 #include <beast/websocket/impl/handshake_op.ipp>
+#include <beast/websocket/impl/ka_ping_op.ipp>
 #include <beast/websocket/impl/ping_op.ipp>
 #include <beast/websocket/impl/read_op.ipp>
+#include <beast/websocket/impl/read_batch_op.ipp>
 #include <beast/websocket/impl/read_frame_op.ipp>
+#include <beast/websocket/impl/read_some_op.ipp>
+#include <beast/websocket/impl/read_view_op.ipp>
 #include <beast/websocket/impl/response_op.ipp>
-#include <beast/websocket/impl/write_op.ipp>
+#include <beast/websocket/impl/write_file_op.ipp>
 #include <beast/websocket/impl/write_frame_op.ipp>
 #include <beast/http/read.hpp>
 #include <beast/http/write.hpp>
@@ -29,9 +34,12 @@
 #include <beast/core/prepare_buffers.hpp>
 #include <beast/core/static_streambuf.hpp>
 #include <beast/core/stream_concepts.hpp>
+#include <beast/core/write_dynabuf.hpp>
 #include <boost/endian/buffers.hpp>
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <utility>
 
@@ -40,17 +48,17 @@ namespace websocket {
 
 namespace detail {
 
-template<class _>
-void
-stream_base::open(role_type role)
-{
-    role_ = role;
-}
-
 template<class _>
 void
 stream_base::prepare_fh(close_code::value& code)
 {
+    // rsv1 without permessage-deflate, or not on
+    // the first frame of a message
+    if(rd_fh_.rsv1 && (! pmd_ || rd_fh_.op == opcode::cont))
+    {
+        code = close_code::protocol_error;
+        return;
+    }
     // continuation without an active message
     if(! rd_cont_ && rd_fh_.op == opcode::cont)
     {
@@ -72,6 +80,11 @@ stream_base::prepare_fh(close_code::value& code)
         {
             rd_size_ = rd_fh_.len;
             rd_opcode_ = rd_fh_.op;
+            if(pmd_)
+            {
+                pmd_->rd_set = rd_fh_.rsv1;
+                pmd_->rd_size = 0;
+            }
         }
         else
         {
@@ -93,6 +106,173 @@ stream_base::prepare_fh(close_code::value& code)
     }
 }
 
+// Called at the start of an uncompressed data frame read in
+// full. The length in the header was checked against the
+// message size limit, so when there is a limit the payload
+// is given one contiguous region instead of growing into it.
+template<class DynamicBuffer>
+void
+stream_base::rd_reserve(DynamicBuffer& db)
+{
+    if(rd_msg_max_ == 0 || rd_need_ == 0)
+        return;
+    detail::reserve(db, detail::clamp(rd_need_),
+        detail::has_reserve<DynamicBuffer>{});
+}
+
+template<class DynamicBuffer>
+void
+stream_base::rd_inflate(DynamicBuffer& db,
+    boost::asio::const_buffer in, bool fin,
+        close_code::value& code)
+{
+    using boost::asio::buffer_cast;
+    using boost::asio::buffer_size;
+    // Removed by the sender at the end of each message
+    static std::uint8_t constexpr tail[4] = {
+        0x00, 0x00, 0xff, 0xff };
+    auto& zi = pmd_->zi;
+    zi.next_in = const_cast<Bytef*>(
+        buffer_cast<Bytef const*>(in));
+    zi.avail_in = static_cast<uInt>(buffer_size(in));
+    bool more = false;
+    bool flushed = false;
+    for(;;)
+    {
+        if(zi.avail_in == 0 && ! more)
+        {
+            if(! fin || flushed)
+                break;
+            flushed = true;
+            zi.next_in = const_cast<Bytef*>(&tail[0]);
+            zi.avail_in = sizeof(tail);
+        }
+        auto const mb = db.prepare(sizeof(pmd_->rd_buf));
+        std::size_t n = 0;
+        int result = Z_OK;
+        for(auto const& b : mb)
+        {
+            auto const size = buffer_size(b);
+            zi.next_out = buffer_cast<Bytef*>(b);
+            zi.avail_out = static_cast<uInt>(size);
+            result = inflate(&zi, Z_SYNC_FLUSH);
+            n += size - zi.avail_out;
+            if(result != Z_OK || zi.avail_out != 0)
+                break;
+        }
+        more = result == Z_OK && zi.avail_out == 0;
+        if(result == Z_STREAM_END)
+        {
+            // The sender finished the deflate stream,
+            // any remaining input starts a new one.
+            inflateReset(&zi);
+        }
+        else if(result != Z_OK && result != Z_BUF_ERROR)
+        {
+            code = close_code::protocol_error;
+            return;
+        }
+        pmd_->rd_size += n;
+        if(rd_msg_max_ && pmd_->rd_size > rd_msg_max_)
+        {
+            code = close_code::too_big;
+            return;
+        }
+        if(rd_opcode_ == opcode::text &&
+            ! rd_utf8_check_.write(prepare_buffers(n, mb)))
+        {
+            code = close_code::bad_payload;
+            return;
+        }
+        db.commit(n);
+    }
+    if(fin)
+    {
+        if(rd_opcode_ == opcode::text &&
+            ! rd_utf8_check_.finish())
+        {
+            code = close_code::bad_payload;
+            return;
+        }
+        if(pmd_->rd_reset)
+            inflateReset(&zi);
+    }
+}
+
+template<class Buffers>
+std::size_t
+stream_base::wr_deflate(std::uint8_t* buf, std::size_t size,
+    std::size_t& used, consuming_buffers<Buffers>& cb,
+        bool fin, bool& done)
+{
+    using boost::asio::buffer_cast;
+    using boost::asio::buffer_size;
+    // The caller keeps unsent output at the front of buf
+    assert(used + 4 < size);
+    auto& zo = pmd_->zo;
+    zo.next_out = buf + used;
+    zo.avail_out = static_cast<uInt>(size - used);
+    for(;;)
+    {
+        auto it = cb.begin();
+        auto const end = cb.end();
+        while(it != end && buffer_size(*it) == 0)
+            ++it;
+        boost::asio::const_buffer in;
+        bool last = true;
+        if(it != end)
+        {
+            in = *it;
+            while(++it != end)
+            {
+                if(buffer_size(*it) > 0)
+                {
+                    last = false;
+                    break;
+                }
+            }
+        }
+        auto const n = buffer_size(in);
+        zo.next_in = const_cast<Bytef*>(
+            buffer_cast<Bytef const*>(in));
+        zo.avail_in = static_cast<uInt>(n);
+        auto const result = deflate(&zo,
+            (fin && last) ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+        assert(result == Z_OK || result == Z_BUF_ERROR);
+        (void)result;
+        cb.consume(n - zo.avail_in);
+        if(zo.avail_out == 0 || last)
+            break;
+    }
+    used = size - zo.avail_out;
+    // All input consumed, and the flush completed
+    done = zo.avail_out != 0;
+    if(! fin)
+        return used;
+    if(! done)
+    {
+        // Hold back what may be part of the
+        // empty block ending the flush.
+        return used - 4;
+    }
+    // Remove the empty block 00 00 ff ff. Nothing is
+    // produced if the previous message already flushed
+    // everything, in which case the payload is a single
+    // empty stored block header (rfc7692 section 7.2.3.6).
+    if(used >= 4)
+    {
+        used -= 4;
+    }
+    else
+    {
+        buf[0] = 0x00;
+        used = 1;
+    }
+    if(pmd_->wr_reset)
+        deflateReset(&zo);
+    return used;
+}
+
 template<class DynamicBuffer>
 void
 stream_base::write_close(
@@ -109,7 +289,7 @@ stream_base::write_close(
         0 : 2 + cr.reason.size();
     fh.mask = role_ == detail::role_type::client;
     if(fh.mask)
-        fh.key = maskgen_();
+        fh.key = mask_key();
     detail::write(db, fh);
     if(cr.code != close_code::none)
     {
@@ -154,7 +334,7 @@ stream_base::write_ping(DynamicBuffer& db,
     fh.len = data.size();
     fh.mask = role_ == role_type::client;
     if(fh.mask)
-        fh.key = maskgen_();
+        fh.key = mask_key();
     detail::write(db, fh);
     if(data.empty())
         return;
@@ -174,17 +354,53 @@ stream_base::write_ping(DynamicBuffer& db,
 
 //------------------------------------------------------------------------------
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
+stream<NextLayer, ReadBuffer>::
+stream(stream&& other)
+    : detail::stream_base(std::move(other))
+    , stream_(std::move(other.stream_))
+    , rd_inflated_(std::move(other.rd_inflated_))
+    , pmd_opts_(other.pmd_opts_)
+{
+    // the next automatic ping keeps its schedule,
+    // and pings in flight now reach this object
+    ka_.ws = this;
+    ka_.take(other.ka_);
+    if(ka_self_)
+        *ka_self_ = this;
+}
+
+template<class NextLayer, class ReadBuffer>
+auto
+stream<NextLayer, ReadBuffer>::
+operator=(stream&& other) ->
+    stream&
+{
+    detail::stream_base::operator=(std::move(other));
+    stream_ = std::move(other.stream_);
+    rd_inflated_ = std::move(other.rd_inflated_);
+    pmd_opts_ = other.pmd_opts_;
+    // the next automatic ping keeps its schedule,
+    // and pings in flight now reach this object
+    ka_.cancel();
+    ka_.ws = this;
+    ka_.take(other.ka_);
+    if(ka_self_)
+        *ka_self_ = this;
+    return *this;
+}
+
+template<class NextLayer, class ReadBuffer>
 template<class... Args>
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 stream(Args&&... args)
     : stream_(std::forward<Args>(args)...)
 {
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 accept()
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -195,9 +411,9 @@ accept()
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 accept(error_code& ec)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -205,11 +421,11 @@ accept(error_code& ec)
     accept(boost::asio::null_buffers{}, ec);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class AcceptHandler>
 typename async_completion<
     AcceptHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_accept(AcceptHandler&& handler)
 {
     static_assert(is_AsyncStream<next_layer_type>::value,
@@ -218,10 +434,10 @@ async_accept(AcceptHandler&& handler)
         std::forward<AcceptHandler>(handler));
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 accept(ConstBufferSequence const& buffers)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -235,10 +451,10 @@ accept(ConstBufferSequence const& buffers)
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 accept(ConstBufferSequence const& buffers, error_code& ec)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -252,18 +468,29 @@ accept(ConstBufferSequence const& buffers, error_code& ec)
     stream_.buffer().commit(buffer_copy(
         stream_.buffer().prepare(
             buffer_size(buffers)), buffers));
-    http::request_v1<http::string_body> m;
-    http::read(next_layer(), stream_.buffer(), m, ec);
+    detail::upgrade_parser<true> p;
+    http::parse(next_layer(), stream_.buffer(), p, ec);
+    if(ec)
+        return;
+    // The decorator needs a message to adorn
+    if(d_)
+        return accept(build_request(p), ec);
+    static_streambuf_n<512> sb;
+    auto const result = build_response(sb, p);
+    boost::asio::write(stream_, sb.data(), ec);
+    if(ec)
+        return;
+    ec = result;
     if(ec)
         return;
-    accept(m, ec);
+    open(detail::role_type::server);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence, class AcceptHandler>
 typename async_completion<
     AcceptHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_accept(ConstBufferSequence const& bs, AcceptHandler&& handler)
 {
     static_assert(is_AsyncStream<next_layer_type>::value,
@@ -279,10 +506,10 @@ async_accept(ConstBufferSequence const& bs, AcceptHandler&& handler)
     return completion.result.get();
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Body, class Headers>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 accept(http::request_v1<Body, Headers> const& request)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -293,10 +520,10 @@ accept(http::request_v1<Body, Headers> const& request)
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Body, class Headers>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 accept(http::request_v1<Body, Headers> const& req,
     error_code& ec)
 {
@@ -317,11 +544,11 @@ accept(http::request_v1<Body, Headers> const& req,
     open(detail::role_type::server);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Body, class Headers, class AcceptHandler>
 typename async_completion<
     AcceptHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_accept(http::request_v1<Body, Headers> const& req,
     AcceptHandler&& handler)
 {
@@ -338,9 +565,9 @@ async_accept(http::request_v1<Body, Headers> const& req,
     return completion.result.get();
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 handshake(boost::string_ref const& host,
     boost::string_ref const& resource)
 {
@@ -352,32 +579,39 @@ handshake(boost::string_ref const& host,
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 handshake(boost::string_ref const& host,
     boost::string_ref const& resource, error_code& ec)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
         "SyncStream requirements not met");
     reset();
-    std::string key;
-    http::write(stream_,
-        build_request(host, resource, key), ec);
+    detail::sec_ws_key_type key;
+    {
+        static_streambuf_n<1024> sb;
+        if(build_request(sb, host, resource, key))
+            boost::asio::write(stream_, sb.data(), ec);
+        else
+            http::write(stream_,
+                build_request(host, resource, key), ec);
+    }
     if(ec)
         return;
-    http::response_v1<http::string_body> res;
-    http::read(next_layer(), stream_.buffer(), res, ec);
+    detail::upgrade_parser<false> p;
+    http::parse(next_layer(), stream_.buffer(), p, ec);
     if(ec)
         return;
-    do_response(res, key, ec);
+    do_response(p, boost::string_ref{
+        key.data(), key.size()}, ec);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class HandshakeHandler>
 typename async_completion<
     HandshakeHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_handshake(boost::string_ref const& host,
     boost::string_ref const& resource, HandshakeHandler&& handler)
 {
@@ -391,9 +625,9 @@ async_handshake(boost::string_ref const& host,
     return completion.result.get();
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 close(close_reason const& cr)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -404,9 +638,9 @@ close(close_reason const& cr)
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 close(close_reason const& cr, error_code& ec)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -419,11 +653,11 @@ close(close_reason const& cr, error_code& ec)
     failed_ = ec != 0;
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class CloseHandler>
 typename async_completion<
     CloseHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_close(close_reason const& cr, CloseHandler&& handler)
 {
     static_assert(is_AsyncStream<next_layer_type>::value,
@@ -436,9 +670,9 @@ async_close(close_reason const& cr, CloseHandler&& handler)
     return completion.result.get();
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 ping(ping_data const& payload)
 {
     error_code ec;
@@ -447,9 +681,9 @@ ping(ping_data const& payload)
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 ping(ping_data const& payload, error_code& ec)
 {
     detail::frame_streambuf db;
@@ -458,11 +692,11 @@ ping(ping_data const& payload, error_code& ec)
     boost::asio::write(stream_, db.data(), ec);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class PingHandler>
 typename async_completion<
     PingHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_ping(ping_data const& payload, PingHandler&& handler)
 {
     static_assert(is_AsyncStream<next_layer_type>::value,
@@ -475,10 +709,10 @@ async_ping(ping_data const& payload, PingHandler&& handler)
     return completion.result.get();
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 read(opcode& op, DynamicBuffer& dynabuf)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -491,10 +725,10 @@ read(opcode& op, DynamicBuffer& dynabuf)
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 read(opcode& op, DynamicBuffer& dynabuf, error_code& ec)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -513,11 +747,11 @@ read(opcode& op, DynamicBuffer& dynabuf, error_code& ec)
     }
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer, class ReadHandler>
 typename async_completion<
     ReadHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_read(opcode& op,
     DynamicBuffer& dynabuf, ReadHandler&& handler)
 {
@@ -533,10 +767,82 @@ async_read(opcode& op,
     return completion.result.get();
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer>
+std::size_t
+stream<NextLayer, ReadBuffer>::
+read_batch(std::vector<batch_message>& messages,
+    DynamicBuffer& dynabuf, std::size_t max_messages,
+        std::size_t max_bytes)
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    static_assert(beast::is_DynamicBuffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+    error_code ec;
+    auto const n = read_batch(
+        messages, dynabuf, max_messages, max_bytes, ec);
+    if(ec)
+        throw system_error{ec};
+    return n;
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer>
+std::size_t
+stream<NextLayer, ReadBuffer>::
+read_batch(std::vector<batch_message>& messages,
+    DynamicBuffer& dynabuf, std::size_t max_messages,
+        std::size_t max_bytes, error_code& ec)
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    static_assert(beast::is_DynamicBuffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+    std::size_t count = 0;
+    std::size_t bytes = 0;
+    do
+    {
+        auto const offset = dynabuf.size();
+        opcode op;
+        read(op, dynabuf, ec);
+        if(ec)
+            break;
+        auto const size = dynabuf.size() - offset;
+        messages.push_back({op, offset, size});
+        ++count;
+        bytes += size;
+    }
+    while(rd_batch_next(count, bytes, max_messages, max_bytes));
+    return count;
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer, class ReadHandler>
+typename async_completion<
+    ReadHandler, void(error_code, std::size_t)>::result_type
+stream<NextLayer, ReadBuffer>::
+async_read_batch(std::vector<batch_message>& messages,
+    DynamicBuffer& dynabuf, std::size_t max_messages,
+        std::size_t max_bytes, ReadHandler&& handler)
+{
+    static_assert(is_AsyncStream<next_layer_type>::value,
+        "AsyncStream requirements requirements not met");
+    static_assert(beast::is_DynamicBuffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+    beast::async_completion<
+        ReadHandler, void(error_code, std::size_t)
+            > completion(handler);
+    read_batch_op<DynamicBuffer, decltype(completion.handler)>{
+        completion.handler, *this, messages,
+            dynabuf, max_messages, max_bytes};
+    return completion.result.get();
+}
+
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 read_frame(frame_info& fi, DynamicBuffer& dynabuf)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -549,27 +855,40 @@ read_frame(frame_info& fi, DynamicBuffer& dynabuf)
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 read_frame(frame_info& fi, DynamicBuffer& dynabuf, error_code& ec)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
         "SyncStream requirements not met");
     static_assert(beast::is_DynamicBuffer<DynamicBuffer>::value,
         "DynamicBuffer requirements not met");
+    do_read_frame(fi, dynabuf,
+        std::numeric_limits<std::size_t>::max(), false, ec);
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+do_read_frame(frame_info& fi, DynamicBuffer& dynabuf,
+    std::size_t limit, bool view, error_code& ec)
+{
     close_code::value code{};
+    rd_release_view();
     for(;;)
     {
         if(rd_need_ == 0)
         {
             // read header
             detail::frame_streambuf fb;
-            do_read_fh(fb, code, ec);
+            do_read_fh(code, ec);
             failed_ = ec != 0;
             if(failed_)
                 return;
+            ka_rx_ = true;
             if(code != close_code::none)
                 break;
             if(detail::is_control(rd_fh_.op))
@@ -604,18 +923,19 @@ read_frame(frame_info& fi, DynamicBuffer& dynabuf, error_code& ec)
                 {
                     ping_data payload;
                     detail::read(payload, fb.data());
+                    ka_pong(payload);
                     if(pong_cb_)
                         pong_cb_(payload);
                     continue;
                 }
                 assert(rd_fh_.op == opcode::close);
                 {
-                    detail::read(cr_, fb.data(), code);
+                    detail::read(rd_close_reason(), fb.data(), code);
                     if(code != close_code::none)
                         break;
                     if(! wr_close_)
                     {
-                        auto cr = cr_;
+                        auto cr = *cr_;
                         if(cr.code == close_code::none)
                             cr.code = close_code::normal;
                         cr.reason = "";
@@ -635,33 +955,103 @@ read_frame(frame_info& fi, DynamicBuffer& dynabuf, error_code& ec)
                 // empty frame
                 continue;
             }
+            if(! view && ! (pmd_ && pmd_->rd_set) && limit ==
+                    std::numeric_limits<std::size_t>::max())
+                rd_reserve(dynabuf);
         }
-        // read payload
-        auto smb = dynabuf.prepare(
-            detail::clamp(rd_need_));
-        auto const bytes_transferred =
-            stream_.read_some(smb, ec);
-        failed_ = ec != 0;
-        if(failed_)
-            return;
-        rd_need_ -= bytes_transferred;
-        auto const pb = prepare_buffers(
-            bytes_transferred, smb);
-        if(rd_fh_.mask)
-            detail::mask_inplace(pb, rd_key_);
-        if(rd_opcode_ == opcode::text)
+        if(pmd_ && pmd_->rd_set)
         {
-            if(! rd_utf8_check_.write(pb) ||
-                (rd_need_ == 0 && rd_fh_.fin &&
-                    ! rd_utf8_check_.finish()))
+            // read compressed payload
+            std::size_t n = 0;
+            if(rd_need_ > 0)
             {
-                code = close_code::bad_payload;
+                auto const mb = boost::asio::buffer(
+                    pmd_->rd_buf, detail::clamp(rd_need_,
+                        std::min(sizeof(pmd_->rd_buf), limit)));
+                bool valid;
+                if(stream_.buffer().size() > 0)
+                {
+                    n = rd_drain(mb, valid);
+                }
+                else
+                {
+                    n = stream_.next_layer().read_some(mb, ec);
+                    failed_ = ec != 0;
+                    if(failed_)
+                        return;
+                    rd_unmask(prepare_buffers(n, mb));
+                }
+                rd_need_ -= n;
+                ka_rx_ = true;
+            }
+            rd_inflate(dynabuf, boost::asio::const_buffer{
+                pmd_->rd_buf, n}, rd_fh_.fin && rd_need_ == 0,
+                    code);
+            if(code != close_code::none)
                 break;
+            if(view && rd_need_ > 0)
+                continue;
+            fi.op = rd_opcode_;
+            fi.fin = rd_fh_.fin && rd_need_ == 0;
+            fi.frame_end = rd_need_ == 0;
+            return;
+        }
+        if(view)
+        {
+            // receive the whole frame into the read buffer
+            auto& sb = stream_.buffer();
+            auto const n = detail::clamp(rd_need_);
+            while(sb.size() < n)
+            {
+                sb.commit(stream_.next_layer().read_some(
+                    rd_refill(sb, n - sb.size()), ec));
+                failed_ = ec != 0;
+                if(failed_)
+                    return;
             }
+            ka_rx_ = true;
+            rd_need_ = 0;
+            rd_view_payload(n, code);
+            if(code != close_code::none)
+                break;
+            fi.op = rd_opcode_;
+            fi.fin = rd_fh_.fin;
+            fi.frame_end = true;
+            return;
+        }
+        // read payload
+        auto smb = dynabuf.prepare(
+            detail::clamp(rd_need_, limit));
+        std::size_t bytes_transferred;
+        bool valid;
+        if(stream_.buffer().size() > 0)
+        {
+            // payload data is already buffered
+            bytes_transferred = rd_drain(smb, valid);
+        }
+        else
+        {
+            bytes_transferred =
+                stream_.next_layer().read_some(smb, ec);
+            failed_ = ec != 0;
+            if(failed_)
+                return;
+            valid = rd_unmask(prepare_buffers(
+                bytes_transferred, smb));
+        }
+        ka_rx_ = true;
+        rd_need_ -= bytes_transferred;
+        if(! valid || (rd_opcode_ == opcode::text &&
+            rd_need_ == 0 && rd_fh_.fin &&
+                ! rd_utf8_check_.finish()))
+        {
+            code = close_code::bad_payload;
+            break;
         }
         dynabuf.commit(bytes_transferred);
         fi.op = rd_opcode_;
         fi.fin = rd_fh_.fin && rd_need_ == 0;
+        fi.frame_end = rd_need_ == 0;
         return;
     }
     if(code != close_code::none)
@@ -692,11 +1082,11 @@ read_frame(frame_info& fi, DynamicBuffer& dynabuf, error_code& ec)
     failed_ = ec != 0;
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class DynamicBuffer, class ReadHandler>
 typename async_completion<
     ReadHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_read_frame(frame_info& fi,
     DynamicBuffer& dynabuf, ReadHandler&& handler)
 {
@@ -711,10 +1101,114 @@ async_read_frame(frame_info& fi,
     return completion.result.get();
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer>
+std::size_t
+stream<NextLayer, ReadBuffer>::
+read_some(frame_info& fi,
+    DynamicBuffer& dynabuf, std::size_t limit)
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    static_assert(beast::is_DynamicBuffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+    error_code ec;
+    auto const bytes_transferred =
+        read_some(fi, dynabuf, limit, ec);
+    if(ec)
+        throw system_error{ec};
+    return bytes_transferred;
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer>
+std::size_t
+stream<NextLayer, ReadBuffer>::
+read_some(frame_info& fi, DynamicBuffer& dynabuf,
+    std::size_t limit, error_code& ec)
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    static_assert(beast::is_DynamicBuffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+    auto const size = dynabuf.size();
+    do_read_frame(fi, dynabuf, limit > 0 ? limit :
+        std::numeric_limits<std::size_t>::max(), false, ec);
+    if(ec)
+        return 0;
+    return dynabuf.size() - size;
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class DynamicBuffer, class ReadHandler>
+typename async_completion<
+    ReadHandler, void(error_code, std::size_t)>::result_type
+stream<NextLayer, ReadBuffer>::
+async_read_some(frame_info& fi, DynamicBuffer& dynabuf,
+    std::size_t limit, ReadHandler&& handler)
+{
+    static_assert(is_AsyncStream<next_layer_type>::value,
+        "AsyncStream requirements not met");
+    static_assert(beast::is_DynamicBuffer<DynamicBuffer>::value,
+        "DynamicBuffer requirements not met");
+    beast::async_completion<ReadHandler,
+        void(error_code, std::size_t)> completion(handler);
+    read_some_op<DynamicBuffer, decltype(completion.handler)>{
+        completion.handler, *this, fi, dynabuf, limit};
+    return completion.result.get();
+}
+
+template<class NextLayer, class ReadBuffer>
+auto
+stream<NextLayer, ReadBuffer>::
+read_view(frame_info& fi) ->
+    view_type
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    error_code ec;
+    auto const view = read_view(fi, ec);
+    if(ec)
+        throw system_error{ec};
+    return view;
+}
+
+template<class NextLayer, class ReadBuffer>
+auto
+stream<NextLayer, ReadBuffer>::
+read_view(frame_info& fi, error_code& ec) ->
+    view_type
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    do_read_frame(fi, rd_inflated(),
+        std::numeric_limits<std::size_t>::max(), true, ec);
+    if(ec)
+        return prepare_buffers(0, stream_.buffer().data());
+    return rd_view();
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class ReadHandler>
+typename async_completion<
+    ReadHandler, void(error_code,
+        typename stream<NextLayer, ReadBuffer>::view_type)>::result_type
+stream<NextLayer, ReadBuffer>::
+async_read_view(frame_info& fi, ReadHandler&& handler)
+{
+    static_assert(is_AsyncStream<next_layer_type>::value,
+        "AsyncStream requirements not met");
+    beast::async_completion<ReadHandler,
+        void(error_code, view_type)> completion(handler);
+    read_view_op<decltype(completion.handler)>{
+        completion.handler, *this, fi};
+    return completion.result.get();
+}
+
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 write(ConstBufferSequence const& buffers)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -728,10 +1222,10 @@ write(ConstBufferSequence const& buffers)
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 write(ConstBufferSequence const& bs, error_code& ec)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -742,10 +1236,14 @@ write(ConstBufferSequence const& bs, error_code& ec)
     using boost::asio::buffer_size;
     consuming_buffers<ConstBufferSequence> cb(bs);
     auto remain = buffer_size(cb);
+    // Compressed frames are sized by the deflater
+    auto const frag_size = pmd_ ?
+        std::numeric_limits<std::size_t>::max() :
+            wr_frag_size_;
     for(;;)
     {
         auto const n =
-            detail::clamp(remain, wr_frag_size_);
+            detail::clamp(remain, frag_size);
         remain -= n;
         auto const fin = remain <= 0;
         write_frame(fin, prepare_buffers(n, cb), ec);
@@ -757,11 +1255,11 @@ write(ConstBufferSequence const& bs, error_code& ec)
     }
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence, class WriteHandler>
 typename async_completion<
     WriteHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_write(ConstBufferSequence const& bs, WriteHandler&& handler)
 {
     static_assert(is_AsyncStream<next_layer_type>::value,
@@ -771,15 +1269,17 @@ async_write(ConstBufferSequence const& bs, WriteHandler&& handler)
             "ConstBufferSequence requirements not met");
     beast::async_completion<
         WriteHandler, void(error_code)> completion(handler);
-    write_op<ConstBufferSequence, decltype(completion.handler)>{
-        completion.handler, *this, bs};
+    // Compressed frames are sized by the deflater
+    write_frame_op<ConstBufferSequence, decltype(
+        completion.handler)>{completion.handler,
+            *this, true, bs, wr_frag_size_};
     return completion.result.get();
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 write_frame(bool fin, ConstBufferSequence const& buffers)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -793,10 +1293,10 @@ write_frame(bool fin, ConstBufferSequence const& buffers)
         throw system_error{ec};
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 write_frame(bool fin, ConstBufferSequence const& bs, error_code& ec)
 {
     static_assert(is_SyncStream<next_layer_type>::value,
@@ -817,8 +1317,45 @@ write_frame(bool fin, ConstBufferSequence const& bs, error_code& ec)
     fh.len = buffer_size(bs);
     fh.mask = role_ == detail::role_type::client;
     if(fh.mask)
-        fh.key = maskgen_();
+        fh.key = mask_key();
     detail::fh_streambuf fh_buf;
+    if(pmd_)
+    {
+        // Deflate the payload, sending each
+        // full buffer of output as a frame.
+        fh.rsv1 = fh.op != opcode::cont;
+        auto const tmp_size = pmd_buf_size();
+        auto const tmp = wr_buf(tmp_size);
+        consuming_buffers<ConstBufferSequence> cb(bs);
+        std::size_t used = 0;
+        for(;;)
+        {
+            bool done;
+            auto const n = wr_deflate(
+                tmp, tmp_size, used, cb, fin, done);
+            mutable_buffers_1 mb{tmp, n};
+            fh.fin = fin && done;
+            fh.len = n;
+            if(fh.mask)
+            {
+                fh.key = mask_key();
+                detail::prepared_key_type key;
+                detail::prepare_key(key, fh.key);
+                detail::mask_inplace(mb, key);
+            }
+            fh_buf.reset();
+            detail::write<static_streambuf>(fh_buf, fh);
+            boost::asio::write(stream_,
+                buffer_cat(fh_buf.data(), mb), ec);
+            failed_ = ec != 0;
+            if(failed_ || done)
+                return;
+            std::memmove(tmp, tmp + n, used - n);
+            used -= n;
+            fh.op = opcode::cont;
+            fh.rsv1 = false;
+        }
+    }
     detail::write<static_streambuf>(fh_buf, fh);
     if(! fh.mask)
     {
@@ -832,14 +1369,13 @@ write_frame(bool fin, ConstBufferSequence const& bs, error_code& ec)
     detail::prepare_key(key, fh.key);
     auto const tmp_size =
         detail::clamp(fh.len, mask_buf_size_);
-    std::unique_ptr<std::uint8_t[]> up(
-        new std::uint8_t[tmp_size]);
+    auto const tmp = wr_buf(tmp_size);
     std::uint64_t remain = fh.len;
     consuming_buffers<ConstBufferSequence> cb(bs);
     {
         auto const n =
             detail::clamp(remain, tmp_size);
-        mutable_buffers_1 mb{up.get(), n};
+        mutable_buffers_1 mb{tmp, n};
         buffer_copy(mb, cb);
         cb.consume(n);
         remain -= n;
@@ -857,7 +1393,7 @@ write_frame(bool fin, ConstBufferSequence const& bs, error_code& ec)
     {
         auto const n =
             detail::clamp(remain, tmp_size);
-        mutable_buffers_1 mb{up.get(), n};
+        mutable_buffers_1 mb{tmp, n};
         buffer_copy(mb, cb);
         cb.consume(n);
         remain -= n;
@@ -872,11 +1408,11 @@ write_frame(bool fin, ConstBufferSequence const& bs, error_code& ec)
     }
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class ConstBufferSequence, class WriteHandler>
 typename async_completion<
     WriteHandler, void(error_code)>::result_type
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 async_write_frame(bool fin,
     ConstBufferSequence const& bs, WriteHandler&& handler)
 {
@@ -894,49 +1430,710 @@ async_write_frame(bool fin,
     return completion.result.get();
 }
 
-//------------------------------------------------------------------------------
-
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
+template<class ConstBufferSequence>
 void
-stream<NextLayer>::
-reset()
+stream<NextLayer, ReadBuffer>::
+send(ConstBufferSequence const& buffers)
 {
-    failed_ = false;
-    rd_need_ = 0;
-    rd_cont_ = false;
-    wr_close_ = false;
-    wr_cont_ = false;
-    wr_block_ = nullptr;    // should be nullptr on close anyway
-    pong_data_ = nullptr;   // should be nullptr on close anyway
+    static_assert(beast::is_ConstBufferSequence<
+        ConstBufferSequence>::value,
+            "ConstBufferSequence requirements not met");
+    error_code ec;
+    send(buffers, ec);
+    if(ec)
+        throw system_error{ec};
+}
 
-    stream_.buffer().consume(
-        stream_.buffer().size());
+template<class NextLayer, class ReadBuffer>
+template<class ConstBufferSequence>
+void
+stream<NextLayer, ReadBuffer>::
+send(ConstBufferSequence const& bs, error_code& ec)
+{
+    static_assert(beast::is_ConstBufferSequence<
+        ConstBufferSequence>::value,
+            "ConstBufferSequence requirements not met");
+    do_send(wr_opcode_, bs, ec);
 }
 
-template<class NextLayer>
-http::request_v1<http::empty_body>
-stream<NextLayer>::
-build_request(boost::string_ref const& host,
-    boost::string_ref const& resource, std::string& key)
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+send(prepared_message const& m)
 {
-    http::request_v1<http::empty_body> req;
-    req.url = "/";
+    error_code ec;
+    send(m, ec);
+    if(ec)
+        throw system_error{ec};
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+send(prepared_message const& m, error_code& ec)
+{
+    // clients mask each frame with their own key
+    if(role_ == detail::role_type::client)
+        return do_send(m.code(), m.payload(), ec);
+    if(! sq_admit(m.size(), ec))
+        return;
+    sq()[sq_i_].append(m.p_);
+    ec = {};
+    sq_notify();
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+write(prepared_message const& m)
+{
+    error_code ec;
+    write(m, ec);
+    if(ec)
+        throw system_error{ec};
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+write(prepared_message const& m, error_code& ec)
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    send(m, ec);
+    if(ec)
+        return;
+    flush(ec);
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class WriteHandler>
+typename async_completion<
+    WriteHandler, void(error_code)>::result_type
+stream<NextLayer, ReadBuffer>::
+async_write(prepared_message const& m, WriteHandler&& handler)
+{
+    static_assert(is_AsyncStream<next_layer_type>::value,
+        "AsyncStream requirements not met");
+    beast::async_completion<
+        WriteHandler, void(error_code)> completion(handler);
+    error_code ec;
+    send(m, ec);
+    if(ec)
+        get_io_service().post(
+            bind_handler(completion.handler, ec));
+    else
+        flush_op<decltype(completion.handler)>{
+            completion.handler, *this};
+    return completion.result.get();
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+write_file(int fd, std::uint64_t offset, std::uint64_t size)
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    error_code ec;
+    write_file(fd, offset, size, ec);
+    if(ec)
+        throw system_error{ec};
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+write_file(int fd, std::uint64_t offset,
+    std::uint64_t size, error_code& ec)
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    using boost::asio::mutable_buffers_1;
+    std::uint64_t remain = size;
+    if(wr_sendfile())
+    {
+        detail::frame_header fh;
+        fh.op = wr_cont_ ? opcode::cont : opcode::binary;
+        wr_cont_ = false;
+        fh.fin = true;
+        fh.rsv1 = false;
+        fh.rsv2 = false;
+        fh.rsv3 = false;
+        fh.len = size;
+        fh.mask = false;
+        detail::fh_streambuf fh_buf;
+        detail::write<static_streambuf>(fh_buf, fh);
+        boost::asio::write(stream_, fh_buf.data(), ec);
+        failed_ = ec != 0;
+        if(failed_)
+            return;
+        // the kernel copies the payload
+        while(remain > 0)
+        {
+            auto const n = detail::send_file(next_layer(),
+                fd, offset, detail::clamp(remain), ec);
+            if(ec == boost::asio::error::would_block)
+            {
+                detail::wait_write(next_layer(), ec);
+                if(! ec)
+                    continue;
+            }
+            else if(! ec && n == 0)
+            {
+                ec = boost::asio::error::eof;
+            }
+            failed_ = ec != 0;
+            if(failed_)
+                return;
+            offset += n;
+            remain -= n;
+        }
+        return;
+    }
+    auto const chunk = wr_file_chunk(size);
+    std::unique_ptr<std::uint8_t[]> buf(
+        new std::uint8_t[chunk]);
+    auto const op = wr_opcode_;
+    wr_opcode_ = opcode::binary;
+    for(;;)
+    {
+        auto const n = detail::read_file(fd, offset, buf.get(),
+            detail::clamp(remain, chunk), ec);
+        if(! ec && n == 0 && remain > 0)
+            ec = boost::asio::error::eof;
+        if(ec)
+        {
+            // a partial message cannot be finished
+            failed_ = wr_cont_;
+            break;
+        }
+        offset += n;
+        remain -= n;
+        write_frame(remain == 0, mutable_buffers_1{
+            buf.get(), n}, ec);
+        if(ec || remain == 0)
+            break;
+    }
+    wr_opcode_ = op;
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class WriteHandler>
+typename async_completion<
+    WriteHandler, void(error_code)>::result_type
+stream<NextLayer, ReadBuffer>::
+async_write_file(int fd, std::uint64_t offset,
+    std::uint64_t size, WriteHandler&& handler)
+{
+    static_assert(is_AsyncStream<next_layer_type>::value,
+        "AsyncStream requirements not met");
+    beast::async_completion<
+        WriteHandler, void(error_code)> completion(handler);
+    write_file_op<decltype(completion.handler)>{
+        completion.handler, *this, fd, offset, size};
+    return completion.result.get();
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+flush()
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    error_code ec;
+    flush(ec);
+    if(ec)
+        throw system_error{ec};
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+flush(error_code& ec)
+{
+    static_assert(is_SyncStream<next_layer_type>::value,
+        "SyncStream requirements not met");
+    if(failed_ || wr_close_)
+    {
+        ec = boost::asio::error::operation_aborted;
+        return;
+    }
+    if(wr_cont_)
+    {
+        // a message started with write_frame is incomplete
+        ec = boost::system::errc::make_error_code(
+            boost::system::errc::operation_not_permitted);
+        return;
+    }
+    if(! sq_)
+    {
+        // nothing was ever queued
+        ec = {};
+        return;
+    }
+    auto& sb = sq_[sq_i_];
+    boost::asio::write(stream_, sb.data(), ec);
+    failed_ = ec != 0;
+    if(failed_)
+        return;
+    sb.clear();
+    sq_notify();
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class WriteHandler>
+typename async_completion<
+    WriteHandler, void(error_code)>::result_type
+stream<NextLayer, ReadBuffer>::
+async_flush(WriteHandler&& handler)
+{
+    static_assert(is_AsyncStream<next_layer_type>::value,
+        "AsyncStream requirements not met");
+    beast::async_completion<
+        WriteHandler, void(error_code)> completion(handler);
+    flush_op<decltype(completion.handler)>{
+        completion.handler, *this};
+    return completion.result.get();
+}
+
+//------------------------------------------------------------------------------
+
+template<class NextLayer, class ReadBuffer>
+bool
+stream<NextLayer, ReadBuffer>::
+sq_admit(std::uint64_t n, error_code& ec)
+{
+    if(failed_ || wr_close_)
+    {
+        ec = boost::asio::error::operation_aborted;
+        return false;
+    }
+    if(wr_cont_)
+    {
+        // a message started with write_frame is incomplete
+        ec = boost::system::errc::make_error_code(
+            boost::system::errc::operation_not_permitted);
+        return false;
+    }
+    auto const used = sq_size();
+    if(used <= sq_limit_ && n <= sq_limit_ - used)
+        return true;
+    ec = boost::asio::error::no_buffer_space;
+    if(sq_disconnect_)
+    {
+        // drop the slow consumer
+        failed_ = true;
+        error_code ignored;
+        stream_.lowest_layer().close(ignored);
+    }
+    return false;
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class ConstBufferSequence>
+void
+stream<NextLayer, ReadBuffer>::
+do_send(opcode op,
+    ConstBufferSequence const& bs, error_code& ec)
+{
+    using boost::asio::buffer_copy;
+    using boost::asio::buffer_size;
+    detail::frame_header fh;
+    fh.op = op;
+    fh.fin = true;
+    fh.rsv1 = false;
+    fh.rsv2 = false;
+    fh.rsv3 = false;
+    fh.len = buffer_size(bs);
+    fh.mask = role_ == detail::role_type::client;
+    if(fh.mask)
+        fh.key = mask_key();
+    detail::fh_streambuf fh_buf;
+    detail::write<static_streambuf>(fh_buf, fh);
+    auto const n = buffer_size(fh_buf.data());
+    if(! sq_admit(n + fh.len, ec))
+        return;
+    auto const len = static_cast<std::size_t>(fh.len);
+    auto& sb = sq()[sq_i_];
+    sb.commit(buffer_copy(sb.prepare(n), fh_buf.data()));
+    auto const mb = sb.prepare(len);
+    buffer_copy(mb, bs);
+    if(fh.mask)
+    {
+        detail::prepared_key_type key;
+        detail::prepare_key(key, fh.key);
+        detail::mask_inplace(mb, key);
+    }
+    sb.commit(len);
+    ec = {};
+    sq_notify();
+}
+
+template<class NextLayer, class ReadBuffer>
+bool
+stream<NextLayer, ReadBuffer>::
+release_read_buffer()
+{
+    rd_release_view();
+    rd_inflated_.reset();
+    if(stream_.buffer().size() > 0)
+        return false;
+    stream_.buffer() = ReadBuffer{};
+    return true;
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+reset()
+{
+    failed_ = false;
+    rd_need_ = 0;
+    rd_cont_ = false;
+    wr_close_ = false;
+    wr_cont_ = false;
+    wr_ctrl_ = false;
+    wr_block_ = nullptr;    // should be nullptr on close anyway
+    pong_data_ = nullptr;   // should be nullptr on close anyway
+    rd_view_ = 0;
+    rd_inflated_.reset();
+    pmd_config_.accept = false;
+    pmd_.reset();
+    sq_.reset();
+    sq_above_ = false;
+    ka_.cancel();
+    ka_rx_ = false;
+    ka_wait_ = false;
+    ka_ping_ = false;
+
+    stream_.buffer().consume(
+        stream_.buffer().size());
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+open(detail::role_type role)
+{
+    role_ = role;
+    if(ka_interval_ != ka_interval_.zero())
+        ka_schedule(ka_interval_);
+    if(! pmd_config_.accept)
+        return;
+    // The inflater window may exceed the sender's window,
+    // zlib cannot inflate raw streams with fewer than 9 bits.
+    auto const server_bits = std::max(9,
+        pmd_config_.server_max_window_bits);
+    auto const client_bits = std::max(9,
+        pmd_config_.client_max_window_bits);
+    if(role == detail::role_type::client)
+        pmd_.reset(new detail::pmd_t{
+            server_bits,
+            pmd_config_.server_no_context_takeover,
+            client_bits,
+            pmd_config_.client_no_context_takeover,
+            pmd_opts_.comp_level, pmd_opts_.mem_level});
+    else
+        pmd_.reset(new detail::pmd_t{
+            client_bits,
+            pmd_config_.client_no_context_takeover,
+            server_bits,
+            pmd_config_.server_no_context_takeover,
+            pmd_opts_.comp_level, pmd_opts_.mem_level});
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+ka_schedule(std::chrono::steady_clock::duration d)
+{
+    // replaces the pending check, if any
+    ka_.ws = this;
+    boost::asio::use_service<
+        detail::keepalive_service>(get_io_service()).schedule(ka_, d);
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+ka_expire()
+{
+    ka_ping_ = false;
+    if(failed_ || wr_close_ ||
+            ka_interval_ == ka_interval_.zero())
+        return;
+    if(ka_rx_)
+    {
+        // the peer is alive
+        ka_rx_ = false;
+        ka_wait_ = false;
+        ka_schedule(ka_interval_);
+        return;
+    }
+    if(ka_wait_)
+    {
+        // no reply in time, drop the connection
+        failed_ = true;
+        detail::close_lowest_layer(stream_,
+            std::integral_constant<bool, detail::is_closable<
+                lowest_layer_type>::value>{});
+        return;
+    }
+    if(wr_block_)
+    {
+        // a write is in progress, a message sent in fragments
+        // lets the ping through at the next frame boundary,
+        // otherwise try again shortly
+        ka_ping_ = true;
+        ka_schedule(detail::keepalive_service::tick());
+        return;
+    }
+    ka_send();
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+ka_send()
+{
+    ka_ping_ = false;
+    ++ka_seq_;
+    ka_sent_ = std::chrono::steady_clock::now();
+    ka_wait_ = true;
+    if(! ka_self_)
+        ka_self_ = std::make_shared<detail::stream_base*>(this);
+    ka_ping_op{*this, ka_payload(ka_seq_)};
+    ka_schedule(ka_timeout_);
+}
+
+template<class NextLayer, class ReadBuffer>
+detail::pmd_offer
+stream<NextLayer, ReadBuffer>::
+pmd_settings() const
+{
+    detail::pmd_offer ours;
+    ours.server_max_window_bits =
+        pmd_opts_.server_max_window_bits;
+    ours.client_max_window_bits =
+        pmd_opts_.client_max_window_bits;
+    ours.server_no_context_takeover =
+        pmd_opts_.server_no_context_takeover;
+    ours.client_no_context_takeover =
+        pmd_opts_.client_no_context_takeover;
+    return ours;
+}
+
+template<class NextLayer, class ReadBuffer>
+bool
+stream<NextLayer, ReadBuffer>::
+build_request(static_streambuf& sb,
+    boost::string_ref const& host,
+        boost::string_ref const& resource,
+            detail::sec_ws_key_type& key)
+{
+    using boost::asio::buffer;
+    // The decorator needs a message to adorn
+    if(d_)
+        return false;
+    auto const agent = detail::default_decorator::version();
+    std::string ext;
+    if(pmd_opts_.client_enable)
+        ext = detail::pmd_offer_request(pmd_settings());
+    // Everything except these strings takes less than 256 bytes
+    if(host.size() + resource.size() + ext.size() + 256 >
+            sb.max_size())
+        return false;
+    auto g = [&]{ return mask_key(); };
+    detail::make_sec_ws_key(key, g);
+    // Same as the message built by the function below
+    beast::write(sb, "GET ", buffer(resource.data(), resource.size()),
+        " HTTP/1.1\r\nHost: ", buffer(host.data(), host.size()),
+        "\r\nUpgrade: websocket\r\nSec-WebSocket-Key: ",
+            buffer(key.data(), key.size()),
+        "\r\nSec-WebSocket-Version: 13\r\n");
+    if(! ext.empty())
+        beast::write(sb, "Sec-WebSocket-Extensions: ",
+            buffer(ext), "\r\n");
+    beast::write(sb, "User-Agent: ", buffer(agent, std::strlen(agent)),
+        "\r\nConnection: upgrade\r\n\r\n");
+    return true;
+}
+
+template<class NextLayer, class ReadBuffer>
+http::request_v1<http::empty_body>
+stream<NextLayer, ReadBuffer>::
+build_request(boost::string_ref const& host,
+    boost::string_ref const& resource,
+        detail::sec_ws_key_type& key)
+{
+    http::request_v1<http::empty_body> req;
+    req.url = std::string{resource.data(), resource.size()};
     req.version = 11;
     req.method = "GET";
     req.headers.insert("Host", host);
     req.headers.insert("Upgrade", "websocket");
-    key = detail::make_sec_ws_key(maskgen_);
-    req.headers.insert("Sec-WebSocket-Key", key);
+    auto g = [&]{ return mask_key(); };
+    detail::make_sec_ws_key(key, g);
+    req.headers.insert("Sec-WebSocket-Key",
+        boost::string_ref{key.data(), key.size()});
     req.headers.insert("Sec-WebSocket-Version", "13");
-    (*d_)(req);
+    if(pmd_opts_.client_enable)
+        req.headers.insert("Sec-WebSocket-Extensions",
+            detail::pmd_offer_request(pmd_settings()));
+    decorate(req);
     http::prepare(req, http::connection::upgrade);
     return req;
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
+http::request_v1<http::empty_body>
+stream<NextLayer, ReadBuffer>::
+build_request(detail::upgrade_parser<true> const& p)
+{
+    auto const insert =
+        [](http::request_v1<http::empty_body>& req,
+            char const* name, boost::string_ref const& value,
+                bool exists)
+        {
+            if(exists)
+                req.headers.insert(name, value);
+        };
+    auto const& f = p.fields();
+    http::request_v1<http::empty_body> req;
+    req.method = std::string{
+        p.method().data(), p.method().size()};
+    req.url = "/";
+    req.version = p.version();
+    insert(req, "Host", f.host.str(), f.host.exists());
+    insert(req, "Upgrade", f.upgrade.str(), f.upgrade.exists());
+    {
+        // only the tokens the parser recognizes are kept
+        std::string value;
+        auto const token =
+            [&](int flag, char const* name)
+            {
+                if(! (p.flags() & flag))
+                    return;
+                if(! value.empty())
+                    value += ", ";
+                value += name;
+            };
+        token(http::parse_flag::connection_close, "close");
+        token(http::parse_flag::connection_keep_alive, "keep-alive");
+        token(http::parse_flag::connection_upgrade, "upgrade");
+        if(! value.empty())
+            req.headers.insert("Connection", value);
+    }
+    insert(req, "Sec-WebSocket-Key",
+        f.key.str(), f.key.exists() && ! f.key.truncated());
+    insert(req, "Sec-WebSocket-Version",
+        f.version.str(), f.version.exists());
+    insert(req, "Sec-WebSocket-Extensions", f.extensions.str(),
+        f.extensions.exists() && ! f.extensions.truncated());
+    return req;
+}
+
+template<class NextLayer, class ReadBuffer>
+error_code
+stream<NextLayer, ReadBuffer>::
+build_response(static_streambuf& sb,
+    detail::upgrade_parser<true> const& p)
+{
+    using boost::asio::buffer;
+    // Produces the same bytes as the message built by the
+    // function below, and the error which writing it gives.
+    auto const text =
+        [](char const* s)
+        {
+            return buffer(s, std::strlen(s));
+        };
+    auto const status =
+        [&](int code)
+        {
+            beast::write(sb, "HTTP/", p.version() / 10, ".",
+                p.version() % 10, " ", code, " ",
+                    text(http::reason_string(code)), "\r\n");
+        };
+    auto const finish =
+        [&](boost::string_ref const& body) -> error_code
+        {
+            error_code ec = error::handshake_failed;
+            beast::write(sb, "Content-Length: ", body.size(), "\r\n");
+            if(p.keep_alive() && keep_alive_)
+            {
+                if(p.version() < 11)
+                    beast::write(sb, "Connection: keep-alive\r\n");
+            }
+            else if(p.version() >= 11)
+            {
+                beast::write(sb, "Connection: close\r\n");
+                ec = boost::asio::error::eof;
+            }
+            beast::write(sb, "\r\n", buffer(body.data(), body.size()));
+            return ec;
+        };
+    auto const err =
+        [&](boost::string_ref const& body)
+        {
+            status(400);
+            beast::write(sb, "Server: ",
+                text(detail::default_decorator::version()), "\r\n");
+            return finish(body);
+        };
+    auto const& f = p.fields();
+    if(p.version() < 11)
+        return err("HTTP version 1.1 required");
+    if(p.method() != "GET")
+        return err("Wrong method");
+    if(! p.connection_upgrade())
+        return err("Expected Upgrade request");
+    if(! f.host.exists())
+        return err("Missing Host");
+    if(! f.key.exists())
+        return err("Missing Sec-WebSocket-Key");
+    if(f.key.truncated())
+        return err("Invalid Sec-WebSocket-Key");
+    if(! http::token_list{f.upgrade.str()}.exists("websocket"))
+        return err("Missing websocket Upgrade token");
+    if(f.version.str().empty())
+        return err("Missing Sec-WebSocket-Version");
+    if(f.version.str() != "13")
+    {
+        status(426);
+        beast::write(sb, "Sec-WebSocket-Version: 13\r\n");
+        return finish({});
+    }
+    status(101);
+    beast::write(sb, "Upgrade: websocket\r\n");
+    {
+        detail::sec_ws_accept_type accept;
+        detail::make_sec_ws_accept(accept, f.key.str());
+        beast::write(sb, "Sec-WebSocket-Accept: ",
+            buffer(accept.data(), accept.size()), "\r\n");
+    }
+    if(pmd_opts_.server_enable)
+    {
+        // An offer too long to keep is declined
+        auto const ext = detail::pmd_negotiate(pmd_config_,
+            f.extensions.truncated() ? boost::string_ref{} :
+                f.extensions.str(), pmd_settings(),
+                    pmd_opts_.memory_limit != 0);
+        if(pmd_config_.accept)
+            beast::write(sb, "Sec-WebSocket-Extensions: ",
+                buffer(ext), "\r\n");
+    }
+    beast::write(sb, "Server: ", text(detail::default_decorator::version()),
+        "\r\nConnection: upgrade\r\n\r\n");
+    return {};
+}
+
+template<class NextLayer, class ReadBuffer>
 template<class Body, class Headers>
 http::response_v1<http::string_body>
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 build_response(http::request_v1<Body, Headers> const& req)
 {
     auto err =
@@ -947,7 +2144,7 @@ build_response(http::request_v1<Body, Headers> const& req)
             res.reason = http::reason_string(res.status);
             res.version = req.version;
             res.body = text;
-            (*d_)(res);
+            decorate(res);
             prepare(res,
                 (is_keep_alive(req) && keep_alive_) ?
                     http::connection::keep_alive :
@@ -991,70 +2188,285 @@ build_response(http::request_v1<Body, Headers> const& req)
     res.version = req.version;
     res.headers.insert("Upgrade", "websocket");
     {
-        auto const key =
-            req.headers["Sec-WebSocket-Key"];
+        detail::sec_ws_accept_type accept;
+        detail::make_sec_ws_accept(accept,
+            req.headers["Sec-WebSocket-Key"]);
         res.headers.insert("Sec-WebSocket-Accept",
-            detail::make_sec_ws_accept(key));
+            boost::string_ref{accept.data(), accept.size()});
+    }
+    if(pmd_opts_.server_enable)
+    {
+        auto const ext = detail::pmd_negotiate(pmd_config_,
+            req.headers["Sec-WebSocket-Extensions"],
+                pmd_settings(), pmd_opts_.memory_limit != 0);
+        if(pmd_config_.accept)
+            res.headers.insert(
+                "Sec-WebSocket-Extensions", ext);
     }
     res.headers.replace("Server", "Beast.WSProto");
-    (*d_)(res);
+    decorate(res);
     http::prepare(res, http::connection::upgrade);
     return res;
 }
 
-template<class NextLayer>
-template<class Body, class Headers>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
-do_response(http::response_v1<Body, Headers> const& res,
+stream<NextLayer, ReadBuffer>::
+do_response(detail::upgrade_parser<false> const& p,
     boost::string_ref const& key, error_code& ec)
 {
     // VFALCO Review these error codes
     auto fail = [&]{ ec = error::response_failed; };
-    if(res.version < 11)
+    auto const& f = p.fields();
+    if(p.version() < 11)
         return fail();
-    if(res.status != 101)
+    if(p.status_code() != 101)
         return fail();
-    if(! is_upgrade(res))
+    if(! p.connection_upgrade())
         return fail();
-    if(! http::token_list{res.headers["Upgrade"]}.exists("websocket"))
+    if(! http::token_list{f.upgrade.str()}.exists("websocket"))
         return fail();
-    if(! res.headers.exists("Sec-WebSocket-Accept"))
-        return fail();
-    if(res.headers["Sec-WebSocket-Accept"] !=
-        detail::make_sec_ws_accept(key))
+    if(! f.accept.exists())
         return fail();
+    {
+        detail::sec_ws_accept_type accept;
+        detail::make_sec_ws_accept(accept, key);
+        if(f.accept.str() != boost::string_ref{
+                accept.data(), accept.size()})
+            return fail();
+    }
+    {
+        auto const ext = f.extensions.str();
+        if(f.extensions.truncated())
+            return fail();
+        if(! ext.empty())
+        {
+            // extensions we did not offer
+            if(! pmd_opts_.client_enable)
+                return fail();
+            if(! detail::pmd_accept(pmd_config_,
+                    ext, pmd_settings()))
+                return fail();
+        }
+    }
     open(detail::role_type::client);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 void
-stream<NextLayer>::
-do_read_fh(detail::frame_streambuf& fb,
-    close_code::value& code, error_code& ec)
+stream<NextLayer, ReadBuffer>::
+do_read_fh(close_code::value& code, error_code& ec)
 {
-    fb.commit(boost::asio::read(
-        stream_, fb.prepare(2), ec));
-    if(ec)
-        return;
-    auto const n = detail::read_fh1(
-        rd_fh_, fb, role_, code);
-    if(code != close_code::none)
-        return;
-    if(n > 0)
+    // Decode the header from the stream's buffer, reading
+    // ahead so later headers and payloads are buffered too.
+    auto& sb = stream_.buffer();
+    for(;;)
     {
-        fb.commit(boost::asio::read(
-            stream_, fb.prepare(n), ec));
+        auto const n = detail::fh_size(sb.data());
+        if(sb.size() >= n)
+            break;
+        sb.commit(stream_.next_layer().read_some(
+            rd_refill(sb, n - sb.size()), ec));
         if(ec)
             return;
     }
+    detail::read_fh1(
+        rd_fh_, sb, role_, code);
+    if(code != close_code::none)
+        return;
     detail::read_fh2(
-        rd_fh_, fb, role_, code);
+        rd_fh_, sb, role_, code);
     if(code != close_code::none)
         return;
     prepare_fh(code);
 }
 
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+rd_release_view()
+{
+    // The payload lent by the last view is
+    // discarded when the next read starts.
+    stream_.buffer().consume(rd_view_);
+    rd_view_ = 0;
+    if(rd_inflated_)
+        rd_inflated_->consume(rd_inflated_->size());
+}
+
+template<class NextLayer, class ReadBuffer>
+void
+stream<NextLayer, ReadBuffer>::
+rd_view_payload(std::size_t n, close_code::value& code)
+{
+    // Unmask and check the payload where it lies,
+    // at the front of the stream's read buffer.
+    auto const pb = prepare_buffers(n, stream_.buffer().data());
+    if(rd_fh_.mask)
+        for(auto const& b : pb)
+            detail::mask_inplace(boost::asio::mutable_buffers_1{
+                const_cast<void*>(boost::asio::buffer_cast<
+                    void const*>(b)), boost::asio::buffer_size(b)},
+                        rd_key_);
+    if(rd_opcode_ == opcode::text)
+    {
+        if(! rd_utf8_check_.write(pb) ||
+            (rd_fh_.fin && ! rd_utf8_check_.finish()))
+        {
+            code = close_code::bad_payload;
+            return;
+        }
+    }
+    rd_view_ = n;
+}
+
+template<class NextLayer, class ReadBuffer>
+auto
+stream<NextLayer, ReadBuffer>::
+rd_view() ->
+    view_type
+{
+    if(rd_view_ > 0 || ! rd_inflated_)
+        return prepare_buffers(
+            rd_view_, stream_.buffer().data());
+    return prepare_buffers(
+        rd_inflated_->size(), rd_inflated_->data());
+}
+
+template<class NextLayer, class ReadBuffer>
+bool
+stream<NextLayer, ReadBuffer>::
+rd_batch_next(std::size_t count, std::size_t bytes,
+    std::size_t max_messages, std::size_t max_bytes)
+{
+    // Only a message received in its entirety is taken,
+    // so that reading it never waits on the next layer.
+    if(count >= max_messages || bytes >= max_bytes || failed_)
+        return false;
+    std::uint64_t size;
+    if(! detail::is_message_buffered(
+            stream_.buffer().data(), size))
+        return false;
+    return size <= max_bytes - bytes;
+}
+
+template<class NextLayer, class ReadBuffer>
+ReadBuffer&
+stream<NextLayer, ReadBuffer>::
+rd_inflated()
+{
+    // Allocated on the first view, so that streams
+    // which do not use views do not pay for it.
+    if(! rd_inflated_)
+        rd_inflated_.reset(new ReadBuffer);
+    return *rd_inflated_;
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class MutableBufferSequence>
+std::size_t
+stream<NextLayer, ReadBuffer>::
+rd_drain(MutableBufferSequence const& mb, bool& valid)
+{
+    using boost::asio::buffer_cast;
+    using boost::asio::buffer_size;
+    // Compressed payload is checked after inflating
+    auto const check = rd_opcode_ == opcode::text &&
+        ! (pmd_ && pmd_->rd_set);
+    auto const cb = stream_.buffer().data();
+    auto it = cb.begin();
+    std::uint8_t const* in = nullptr;
+    std::size_t avail = 0;
+    std::size_t total = 0;
+    valid = true;
+    for(auto const& b : mb)
+    {
+        auto out = buffer_cast<std::uint8_t*>(b);
+        auto size = buffer_size(b);
+        while(size > 0)
+        {
+            while(avail == 0)
+            {
+                if(it == cb.end())
+                    goto done;
+                in = buffer_cast<std::uint8_t const*>(*it);
+                avail = buffer_size(*it);
+                ++it;
+            }
+            auto const n = std::min(detail::rd_piece_size,
+                std::min(size, avail));
+            // one pass copies and unmasks
+            if(rd_fh_.mask)
+                detail::mask_copy(out, in, n, rd_key_);
+            else
+                std::memcpy(out, in, n);
+            if(check && valid)
+                valid = rd_utf8_check_.write(out, n);
+            out += n;
+            size -= n;
+            in += n;
+            avail -= n;
+            total += n;
+        }
+    }
+done:
+    stream_.buffer().consume(total);
+    return total;
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class MutableBufferSequence>
+bool
+stream<NextLayer, ReadBuffer>::
+rd_unmask(MutableBufferSequence const& mb)
+{
+    using boost::asio::buffer_cast;
+    using boost::asio::buffer_size;
+    auto const check = rd_opcode_ == opcode::text &&
+        ! (pmd_ && pmd_->rd_set);
+    if(! rd_fh_.mask)
+        return ! check || rd_utf8_check_.write(mb);
+    for(auto const& b : mb)
+    {
+        auto p = buffer_cast<std::uint8_t*>(b);
+        auto size = buffer_size(b);
+        while(size > 0)
+        {
+            auto const n = std::min(detail::rd_piece_size, size);
+            detail::mask_inplace(
+                boost::asio::mutable_buffer{p, n}, rd_key_);
+            if(check && ! rd_utf8_check_.write(p, n))
+                return false;
+            p += n;
+            size -= n;
+        }
+    }
+    return true;
+}
+
+template<class NextLayer, class ReadBuffer>
+bool
+stream<NextLayer, ReadBuffer>::
+wr_sendfile() const
+{
+    // Masked and compressed payloads must
+    // pass through memory.
+    return detail::is_sendfile_stream<
+            next_layer_type>::value &&
+        role_ == detail::role_type::server && ! pmd_;
+}
+
+template<class NextLayer, class ReadBuffer>
+std::size_t
+stream<NextLayer, ReadBuffer>::
+wr_file_chunk(std::uint64_t size) const
+{
+    // The size of the pieces read from a file
+    // when the kernel cannot copy it for us.
+    return std::max<std::size_t>(1, detail::clamp(size,
+        std::min<std::size_t>(wr_frag_size_, 64 * 1024)));
+}
+
 } // websocket
 } // beast
 
@@ -0,0 +1,296 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_IMPL_WRITE_FILE_OP_HPP
+#define BEAST_WEBSOCKET_IMPL_WRITE_FILE_OP_HPP
+
+#include <beast/core/bind_handler.hpp>
+#include <beast/core/handler_alloc.hpp>
+#include <beast/core/static_streambuf.hpp>
+#include <beast/websocket/detail/frame.hpp>
+#include <beast/websocket/detail/op_pool.hpp>
+#include <beast/websocket/detail/sendfile.hpp>
+#include <cassert>
+#include <memory>
+
+namespace beast {
+namespace websocket {
+
+// write part of a file as a binary message
+//
+// When the kernel can copy the file to the next layer, the
+// frame header is written and the payload follows with
+// sendfile, waiting for the socket to become writable whenever
+// it is full. Otherwise the file is read in pieces, and each
+// piece is sent by a write_frame_op.
+//
+template<class NextLayer, class ReadBuffer>
+template<class Handler>
+class stream<NextLayer, ReadBuffer>::write_file_op
+{
+    struct data : op
+    {
+        stream<NextLayer, ReadBuffer>& ws;
+        Handler h;
+        int fd;
+        std::uint64_t offset;
+        std::uint64_t remain;
+        detail::frame_header fh;
+        detail::fh_streambuf fh_buf;
+        std::unique_ptr<std::uint8_t[]> buf;
+        std::size_t chunk;
+        bool sendfile;
+        bool cont;
+        int state = 0;
+
+        template<class DeducedHandler>
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
+                int fd_, std::uint64_t offset_, std::uint64_t size)
+            : ws(ws_)
+            , h(std::forward<DeducedHandler>(h_))
+            , fd(fd_)
+            , offset(offset_)
+            , remain(size)
+            , sendfile(ws.wr_sendfile())
+            , cont(boost_asio_handler_cont_helpers::
+                is_continuation(h))
+        {
+            if(! sendfile)
+            {
+                chunk = ws.wr_file_chunk(size);
+                buf.reset(new std::uint8_t[chunk]);
+                return;
+            }
+            fh.op = ws.wr_cont_ ?
+                opcode::cont : opcode::binary;
+            ws.wr_cont_ = false;
+            fh.fin = true;
+            fh.rsv1 = false;
+            fh.rsv2 = false;
+            fh.rsv3 = false;
+            fh.len = size;
+            fh.mask = false;
+            detail::write<static_streambuf>(fh_buf, fh);
+        }
+    };
+
+    std::shared_ptr<data> d_;
+
+public:
+    write_file_op(write_file_op&&) = default;
+    write_file_op(write_file_op const&) = default;
+
+    template<class DeducedHandler, class... Args>
+    write_file_op(DeducedHandler&& h,
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
+            std::forward<DeducedHandler>(h), ws,
+                std::forward<Args>(args)...))
+    {
+        (*this)(error_code{}, false);
+    }
+
+    void operator()()
+    {
+        (*this)(error_code{});
+    }
+
+    void operator()(error_code ec, std::size_t);
+
+    void operator()(error_code ec, bool again = true);
+
+    friend
+    void* asio_handler_allocate(
+        std::size_t size, write_file_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            allocate(size, op->d_->h);
+    }
+
+    friend
+    void asio_handler_deallocate(
+        void* p, std::size_t size, write_file_op* op)
+    {
+        return boost_asio_handler_alloc_helpers::
+            deallocate(p, size, op->d_->h);
+    }
+
+    friend
+    bool asio_handler_is_continuation(write_file_op* op)
+    {
+        return op->d_->cont;
+    }
+
+    template <class Function>
+    friend
+    void asio_handler_invoke(Function&& f, write_file_op* op)
+    {
+        return boost_asio_handler_invoke_helpers::
+            invoke(f, op->d_->h);
+    }
+};
+
+template<class NextLayer, class ReadBuffer>
+template<class Handler>
+void
+stream<NextLayer, ReadBuffer>::
+write_file_op<Handler>::
+operator()(error_code ec, std::size_t)
+{
+    auto& d = *d_;
+    if(ec)
+        d.ws.failed_ = true;
+    (*this)(ec);
+}
+
+template<class NextLayer, class ReadBuffer>
+template<class Handler>
+void
+stream<NextLayer, ReadBuffer>::
+write_file_op<Handler>::
+operator()(error_code ec, bool again)
+{
+    using boost::asio::mutable_buffers_1;
+    auto& d = *d_;
+    d.cont = d.cont || again;
+    if(ec)
+        goto upcall;
+    for(;;)
+    {
+        switch(d.state)
+        {
+        case 0:
+            if(! d.sendfile)
+            {
+                d.state = 5;
+                break;
+            }
+            if(d.ws.wr_block_)
+            {
+                // suspend
+                d.state = 3;
+                d.ws.wr_op_.template emplace<
+                    write_file_op>(std::move(*this));
+                return;
+            }
+            if(d.ws.failed_ || d.ws.wr_close_)
+            {
+                // call handler
+                d.state = 99;
+                d.ws.get_io_service().post(
+                    bind_handler(std::move(*this),
+                        boost::asio::error::operation_aborted));
+                return;
+            }
+            // fall through
+
+        case 1:
+            // send header
+            d.state = 2;
+            assert(! d.ws.wr_block_ || d.ws.wr_block_ == &d);
+            d.ws.wr_block_ = &d;
+            boost::asio::async_write(d.ws.stream_,
+                d.fh_buf.data(), std::move(*this));
+            return;
+
+        // send payload
+        case 2:
+        {
+            if(d.remain == 0)
+                goto upcall;
+            auto const n = detail::send_file(d.ws.next_layer(),
+                d.fd, d.offset, detail::clamp(d.remain), ec);
+            if(ec == boost::asio::error::would_block)
+            {
+                // wait for room in the socket
+                assert(d.ws.wr_block_ == &d);
+                detail::async_wait_write(
+                    d.ws.next_layer(), std::move(*this));
+                return;
+            }
+            if(! ec && n == 0)
+                ec = boost::asio::error::eof;
+            if(ec)
+            {
+                d.ws.failed_ = true;
+                goto upcall;
+            }
+            d.offset += n;
+            d.remain -= n;
+            break;
+        }
+
+        case 3:
+            d.state = 4;
+            d.ws.get_io_service().post(bind_handler(
+                std::move(*this), ec));
+            return;
+
+        case 4:
+            if(d.ws.failed_ || d.ws.wr_close_)
+            {
+                // call handler
+                ec = boost::asio::error::operation_aborted;
+                goto upcall;
+            }
+            if(d.ws.wr_block_)
+            {
+                // taken while resuming, suspend again
+                d.state = 3;
+                d.ws.wr_op_.template emplace<
+                    write_file_op>(std::move(*this));
+                return;
+            }
+            d.state = 1;
+            break;
+
+        // read and send the next piece
+        case 5:
+        {
+            auto const n = detail::read_file(d.fd, d.offset,
+                d.buf.get(), detail::clamp(d.remain, d.chunk), ec);
+            if(! ec && n == 0 && d.remain > 0)
+                ec = boost::asio::error::eof;
+            if(ec)
+            {
+                // a partial message cannot be finished
+                if(d.ws.wr_cont_)
+                    d.ws.failed_ = true;
+                d.state = 99;
+                d.ws.get_io_service().post(
+                    bind_handler(std::move(*this), ec));
+                return;
+            }
+            d.offset += n;
+            d.remain -= n;
+            d.state = d.remain > 0 ? 5 : 99;
+            // write_frame_op takes the opcode when constructed
+            auto const op = d.ws.wr_opcode_;
+            d.ws.wr_opcode_ = opcode::binary;
+            write_frame_op<mutable_buffers_1, write_file_op>{
+                std::move(*this), d.ws, d.remain == 0,
+                    mutable_buffers_1{d.buf.get(), n}};
+            d.ws.wr_opcode_ = op;
+            return;
+        }
+
+        case 99:
+            goto upcall;
+        }
+    }
+upcall:
+    if(d.ws.wr_block_ == &d)
+        d.ws.wr_block_ = nullptr;
+    d.ws.rd_op_.maybe_invoke();
+    d.h(ec);
+}
+
+} // websocket
+} // beast
+
+#endif
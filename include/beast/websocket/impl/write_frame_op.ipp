@@ -12,10 +12,14 @@
 #include <beast/core/bind_handler.hpp>
 #include <beast/core/consuming_buffers.hpp>
 #include <beast/core/handler_alloc.hpp>
+#include <beast/core/prepare_buffers.hpp>
 #include <beast/core/static_streambuf.hpp>
 #include <beast/websocket/detail/frame.hpp>
+#include <beast/websocket/detail/op_pool.hpp>
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <limits>
 #include <memory>
 
 namespace beast {
@@ -23,33 +27,47 @@ namespace websocket {
 
 // write a frame
 //
-template<class NextLayer>
+// When a fragment size is given, the payload is sent as a
+// series of frames no larger than the fragment size. Control
+// frames waiting for the write block are let through between
+// the frames, so that pongs and closes are not held back for
+// the duration of a large message.
+//
+template<class NextLayer, class ReadBuffer>
 template<class Buffers, class Handler>
-class stream<NextLayer>::write_frame_op
+class stream<NextLayer, ReadBuffer>::write_frame_op
 {
-    using alloc_type =
-        handler_alloc<char, Handler>;
-
     struct data : op
     {
-        stream<NextLayer>& ws;
+        stream<NextLayer, ReadBuffer>& ws;
         consuming_buffers<Buffers> cb;
         Handler h;
         detail::frame_header fh;
         detail::fh_streambuf fh_buf;
         detail::prepared_key_type key;
-        void* tmp;
+        std::uint8_t* tmp;
         std::size_t tmp_size;
         std::uint64_t remain;
+        std::size_t frag;
+        std::size_t n;
+        std::size_t used;
+        std::size_t sent;
+        bool fin;
+        bool deflate;
         bool cont;
         int state = 0;
 
         template<class DeducedHandler>
-        data(DeducedHandler&& h_, stream<NextLayer>& ws_,
-                bool fin, Buffers const& bs)
+        data(DeducedHandler&& h_, stream<NextLayer, ReadBuffer>& ws_,
+                bool fin_, Buffers const& bs, std::size_t frag_ = 0)
             : ws(ws_)
             , cb(bs)
             , h(std::forward<DeducedHandler>(h_))
+            , frag(frag_ > 0 ? frag_ :
+                std::numeric_limits<std::size_t>::max())
+            , used(0)
+            , fin(fin_)
+            , deflate(ws.pmd_ != nullptr)
             , cont(boost_asio_handler_cont_helpers::
                 is_continuation(h))
         {
@@ -60,30 +78,19 @@ class stream<NextLayer>::write_frame_op
             fh.rsv1 = false;
             fh.rsv2 = false;
             fh.rsv3 = false;
-            fh.len = boost::asio::buffer_size(cb);
             fh.mask = ws.role_ == detail::role_type::client;
-            if(fh.mask)
-            {
-                fh.key = ws.maskgen_();
-                detail::prepare_key(key, fh.key);
-                tmp_size = detail::clamp(
-                    fh.len, ws.mask_buf_size_);
-                tmp = boost_asio_handler_alloc_helpers::
-                    allocate(tmp_size, h);
-                remain = fh.len;
-            }
-            else
+            if(deflate)
             {
-                tmp = nullptr;
+                // headers are written for each
+                // frame of compressed output
+                fh.rsv1 = fh.op != opcode::cont;
+                tmp_size = ws.pmd_buf_size();
+                return;
             }
-            detail::write<static_streambuf>(fh_buf, fh);
-        }
-
-        ~data()
-        {
-            if(tmp)
-                boost_asio_handler_alloc_helpers::
-                    deallocate(tmp, tmp_size, h);
+            remain = boost::asio::buffer_size(cb);
+            if(fh.mask)
+                tmp_size = detail::clamp(std::min<std::uint64_t>(
+                    remain, frag), ws.mask_buf_size_);
         }
     };
 
@@ -95,8 +102,9 @@ public:
 
     template<class DeducedHandler, class... Args>
     write_frame_op(DeducedHandler&& h,
-            stream<NextLayer>& ws, Args&&... args)
-        : d_(std::make_shared<data>(
+            stream<NextLayer, ReadBuffer>& ws, Args&&... args)
+        : d_(std::allocate_shared<data>(
+            detail::op_alloc<data>{ws.get_op_pool()},
             std::forward<DeducedHandler>(h), ws,
                 std::forward<Args>(args)...))
     {
@@ -143,10 +151,10 @@ public:
     }
 };
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Buffers, class Handler>
 void 
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 write_frame_op<Buffers, Handler>::
 operator()(error_code ec, std::size_t)
 {
@@ -156,10 +164,10 @@ operator()(error_code ec, std::size_t)
     (*this)(ec);
 }
 
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer>
 template<class Buffers, class Handler>
 void
-stream<NextLayer>::
+stream<NextLayer, ReadBuffer>::
 write_frame_op<Buffers, Handler>::
 operator()(error_code ec, bool again)
 {
@@ -195,28 +203,46 @@ operator()(error_code ec, bool again)
 
         case 1:
         {
+            if(d.deflate)
+            {
+                d.state = 5;
+                break;
+            }
+            // send the next frame
+            auto const n = detail::clamp(d.remain, d.frag);
+            d.remain -= n;
+            d.fh.len = n;
+            d.fh.fin = d.remain > 0 ? false : d.fin;
+            if(d.fh.mask)
+            {
+                d.fh.key = d.ws.mask_key();
+                detail::prepare_key(d.key, d.fh.key);
+            }
+            d.fh_buf.reset();
+            detail::write<static_streambuf>(d.fh_buf, d.fh);
+            d.n = n;
+            assert(! d.ws.wr_block_ || d.ws.wr_block_ == &d);
+            d.ws.wr_block_ = &d;
             if(! d.fh.mask)
             {
-                // send header and entire payload
-                d.state = 99;
-                assert(! d.ws.wr_block_);
-                d.ws.wr_block_ = &d;
+                // send header and payload
+                d.state = 7;
                 boost::asio::async_write(d.ws.stream_,
-                    buffer_cat(d.fh_buf.data(), d.cb),
-                        std::move(*this));
+                    buffer_cat(d.fh_buf.data(),
+                        prepare_buffers(n, d.cb)),
+                            std::move(*this));
                 return;
             }
-            auto const n =
-                detail::clamp(d.remain, d.tmp_size);
-            mutable_buffers_1 mb{d.tmp, n};
+            // the scratch buffer belongs to the write block
+            d.tmp = d.ws.wr_buf(d.tmp_size);
+            auto const m = detail::clamp(d.n, d.tmp_size);
+            mutable_buffers_1 mb{d.tmp, m};
             buffer_copy(mb, d.cb);
-            d.cb.consume(n);
-            d.remain -= n;
+            d.cb.consume(m);
+            d.n -= m;
             detail::mask_inplace(mb, d.key);
             // send header and payload
-            d.state = d.remain > 0 ? 2 : 99;
-            assert(! d.ws.wr_block_);
-            d.ws.wr_block_ = &d;
+            d.state = d.n > 0 ? 2 : 7;
             boost::asio::async_write(d.ws.stream_,
                 buffer_cat(d.fh_buf.data(),
                     mb), std::move(*this));
@@ -226,17 +252,15 @@ operator()(error_code ec, bool again)
         // sent masked payload
         case 2:
         {
-            auto const n =
-                detail::clamp(d.remain, d.tmp_size);
-            mutable_buffers_1 mb{d.tmp,
-                static_cast<std::size_t>(n)};
+            auto const m = detail::clamp(d.n, d.tmp_size);
+            mutable_buffers_1 mb{d.tmp, m};
             buffer_copy(mb, d.cb);
-            d.cb.consume(n);
-            d.remain -= n;
+            d.cb.consume(m);
+            d.n -= m;
             detail::mask_inplace(mb, d.key);
             // send payload
-            if(d.remain == 0)
-                d.state = 99;
+            if(d.n == 0)
+                d.state = 7;
             assert(d.ws.wr_block_ == &d);
             boost::asio::async_write(
                 d.ws.stream_, mb, std::move(*this));
@@ -256,20 +280,119 @@ operator()(error_code ec, bool again)
                 ec = boost::asio::error::operation_aborted;
                 goto upcall;
             }
+            if(d.ws.wr_block_)
+            {
+                // taken while resuming, suspend again
+                d.state = 3;
+                d.ws.wr_op_.template emplace<
+                    write_frame_op>(std::move(*this));
+                return;
+            }
+            d.state = 1;
+            break;
+
+        // compress and send a frame
+        case 5:
+        {
+            bool done;
+            d.tmp = d.ws.wr_buf(d.tmp_size);
+            d.sent = d.ws.wr_deflate(
+                d.tmp, d.tmp_size, d.used, d.cb, d.fin, done);
+            mutable_buffers_1 mb{d.tmp, d.sent};
+            d.fh.fin = d.fin && done;
+            d.fh.len = d.sent;
+            if(d.fh.mask)
+            {
+                d.fh.key = d.ws.mask_key();
+                detail::prepare_key(d.key, d.fh.key);
+                detail::mask_inplace(mb, d.key);
+            }
+            d.fh_buf.reset();
+            detail::write<static_streambuf>(d.fh_buf, d.fh);
+            d.state = done ? 99 : 6;
+            assert(! d.ws.wr_block_ || d.ws.wr_block_ == &d);
+            d.ws.wr_block_ = &d;
+            boost::asio::async_write(d.ws.stream_,
+                buffer_cat(d.fh_buf.data(), mb),
+                    std::move(*this));
+            return;
+        }
+
+        // sent compressed frame
+        case 6:
+        {
+            std::memmove(d.tmp, d.tmp + d.sent, d.used - d.sent);
+            d.used -= d.sent;
+            d.fh.op = opcode::cont;
+            d.fh.rsv1 = false;
+            d.state = 8;
+            break;
+        }
+
+        // sent a frame
+        case 7:
+            if(! d.fh.mask)
+                d.cb.consume(d.n);
+            if(d.remain == 0)
+                goto upcall;
+            d.fh.op = opcode::cont;
+            d.state = 8;
+            // fall through
+
+        // between frames
+        case 8:
+            if(! d.ws.rd_op_ && ! d.ws.wr_ctrl_ && ! d.ws.ka_ping_)
+            {
+                // no control frame is waiting
+                d.state = 1;
+                break;
+            }
+            // let waiting control frames go first
+            d.ws.wr_block_ = nullptr;
+            if(d.ws.ka_ping_)
+                d.ws.ka_send();
+            d.ws.rd_op_.maybe_invoke();
+            if(d.ws.wr_ctrl_)
+            {
+                // a data write waiting in wr_op_ stays
+                // there until this message is complete
+                d.ws.wr_ctrl_ = false;
+                d.ws.wr_op_.maybe_invoke();
+            }
+            d.state = 9;
+            d.ws.get_io_service().post(bind_handler(
+                std::move(*this), ec));
+            return;
+
+        case 9:
+            if(d.ws.failed_ || d.ws.wr_close_)
+            {
+                // call handler
+                ec = boost::asio::error::operation_aborted;
+                goto upcall;
+            }
+            if(d.ws.wr_block_)
+            {
+                // suspend until the control frame is sent
+                d.state = 10;
+                d.ws.wr_yield_.template emplace<
+                    write_frame_op>(std::move(*this));
+                return;
+            }
             d.state = 1;
             break;
 
+        case 10:
+            d.state = 9;
+            d.ws.get_io_service().post(bind_handler(
+                std::move(*this), ec));
+            return;
+
         case 99:
             goto upcall;
         }
     }
 upcall:
-    if(d.tmp)
-    {
-        boost_asio_handler_alloc_helpers::
-            deallocate(d.tmp, d.tmp_size, d.h);
-        d.tmp = nullptr;
-    }
     if(d.ws.wr_block_ == &d)
         d.ws.wr_block_ = nullptr;
     d.ws.rd_op_.maybe_invoke();
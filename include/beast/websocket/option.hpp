@@ -11,6 +11,7 @@
 #include <beast/websocket/rfc6455.hpp>
 #include <beast/websocket/detail/stream_base.hpp>
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <stdexcept>
 #include <type_traits>
@@ -29,6 +30,10 @@ namespace websocket {
     This setting does not affect frames sent explicitly using
     @ref stream::write_frame or @ref stream::async_write_frame.
 
+    Control frames are sent between the fragments of a message written
+    with @ref stream::async_write, so the size also bounds how long a
+    pong or close may be held back by a large message.
+
     The default setting is to fragment messages into 16KB frames.
 
     @note Objects of this type are passed to @ref stream::set_option.
@@ -55,6 +60,68 @@ struct auto_fragment_size
 };
 #endif
 
+/** Automatic ping option.
+
+    Enables the automatic sending of pings on idle connections, and
+    the closing of connections which stop responding. When nothing
+    is received on the stream for `interval`, a ping is sent. If
+    nothing, not even the pong, is received within `timeout` after
+    that, the stream fails and its lowest layer is closed, which
+    completes any pending read with an error. The round trip time
+    of the last answered ping is reported by @ref stream::ping_rtt.
+
+    Pongs are only received during reads, so the application must
+    keep an asynchronous read pending on the stream, as it normally
+    would. Pings are sent between the application's writes, and
+    never interrupt a frame.
+
+    The checks for every stream on an `io_service` are driven by a
+    single timer with a resolution of 100 milliseconds, so enabling
+    the option on many connections adds no timers. Checks run from
+    the thread calling `io_service::run`, so the option may only be
+    used with an `io_service` run from one thread, or with streams
+    whose operations are otherwise serialized with it.
+
+    The option takes effect at the next successful handshake or
+    accept. The default is no automatic pings; to restore it,
+    construct the option with no parameters.
+
+    @note Objects of this type are passed to @ref stream::set_option.
+
+    @par Example
+    Pinging after 30 seconds of silence, and giving up 10 seconds later.
+    @code
+    ...
+    websocket::stream<ip::tcp::socket> ws(ios);
+    ws.set_option(auto_ping{std::chrono::seconds(30),
+        std::chrono::seconds(10)});
+    @endcode
+*/
+#if GENERATING_DOCS
+using auto_ping = implementation_defined;
+#else
+struct auto_ping
+{
+    std::chrono::milliseconds interval;
+    std::chrono::milliseconds timeout;
+
+    auto_ping()
+        : interval(0)
+        , timeout(0)
+    {
+    }
+
+    auto_ping(std::chrono::milliseconds interval_,
+            std::chrono::milliseconds timeout_)
+        : interval(interval_)
+        , timeout(timeout_)
+    {
+        if(interval.count() <= 0 || timeout.count() <= 0)
+            throw std::domain_error("invalid auto ping interval");
+    }
+};
+#endif
+
 /** HTTP decorator option.
 
     The decorator transforms the HTTP requests and responses used
@@ -159,6 +226,11 @@ struct keep_alive
     of the buffer can reduce the number of calls made to the next
     layer to write masked data.
 
+    When the permessage-deflate extension is active, this is also the
+    size of the buffer receiving compressed output in either role, and
+    thus the largest compressed frame sent. Values below 16 are raised
+    to 16 for that purpose.
+
     The default setting is 4096. The minimum value is 1.
 
     @note Objects of this type are passed to @ref stream::set_option.
@@ -188,6 +260,56 @@ struct mask_buffer_size
 };
 #endif
 
+/** Mask key generator option.
+
+    Sets the function called to obtain the masking key for each frame
+    sent in the client role, and the random Sec-WebSocket-Key sent in
+    the opening handshake. Only affects streams operating in the client
+    role. The signature of the function must be:
+    @code
+    std::uint32_t generate();
+    @endcode
+
+    The default uses a ChaCha20 generator private to each thread, seeded
+    from `std::random_device` when the thread first needs a key. Streams
+    then hold no generator state, and constructing a stream does not
+    consult the system's entropy source. A generator shared by many
+    streams may be supplied instead; it must be safe to call from every
+    thread running operations on those streams. Keys should be
+    unpredictable, as required by rfc6455 section 10.3.
+
+    @note Objects of this type are passed to @ref stream::set_option.
+    To restore the default, construct the option with no parameters:
+    `set_option(mask_generator{})`
+
+    @par Example
+    Using a generator shared by all connections made on one thread.
+    @code
+    ...
+    std::mt19937 g{std::random_device{}()};
+    websocket::stream<ip::tcp::socket> ws(ios);
+    ws.set_option(mask_generator{std::ref(g)});
+    @endcode
+*/
+#if GENERATING_DOCS
+using mask_generator = implementation_defined;
+#else
+struct mask_generator
+{
+    detail::mask_gen value;
+
+    mask_generator() = default;
+    mask_generator(mask_generator&&) = default;
+    mask_generator(mask_generator const&) = default;
+
+    explicit
+    mask_generator(detail::mask_gen f)
+        : value(std::move(f))
+    {
+    }
+};
+#endif
+
 /** Message type option.
 
     This controls the opcode set for outgoing messages. Valid
@@ -225,6 +347,92 @@ struct message_type
 };
 #endif
 
+/** permessage-deflate extension options.
+
+    These settings control the permessage-deflate extension (rfc7692),
+    which compresses message payloads. The extension is offered when
+    performing the handshake in the client role, and accepted from a
+    client's offer in the server role, only if the corresponding enable
+    flag is set. By default the extension is disabled in both roles.
+
+    Compression is streamed: incoming payloads are inflated directly
+    into the caller's dynamic buffer as each frame is received, and
+    outgoing messages are deflated into a buffer of size
+    @ref mask_buffer_size, each full buffer being sent as one frame.
+    Entire messages are never buffered. When compression is active,
+    @ref auto_fragment_size does not apply since frames are generated
+    from the compressed output.
+
+    Window bits and the memory level bound the memory allocated for
+    each stream once the extension is negotiated. The inflater uses
+    about `(1 << window_bits) + 7KB`, and the deflater about
+    `(1 << (window_bits + 2)) + (1 << (mem_level + 9))` bytes.
+    Set @ref memory_limit to have these lowered as needed to keep
+    each stream under a given number of bytes.
+
+    @note Objects of this type are passed to @ref stream::set_option.
+
+    @par Example
+    Offering compression with a small footprint in the client role.
+    @code
+    ...
+    websocket::stream<ip::tcp::socket> ws(ios);
+    websocket::permessage_deflate pmd;
+    pmd.client_enable = true;
+    pmd.memory_limit = 32 * 1024;
+    ws.set_option(pmd);
+    @endcode
+*/
+struct permessage_deflate
+{
+    /// `true` to accept the extension in the server role
+    bool server_enable = false;
+
+    /// `true` to offer the extension in the client role
+    bool client_enable = false;
+
+    /** Maximum window bits used by the server's deflater.
+
+        In the server role this caps the window used for sending, in
+        the client role a value below 15 asks the server to limit its
+        window, reducing the memory needed to inflate. Must be in the
+        range 9 to 15 inclusive, zlib does not support a window of 8.
+    */
+    int server_max_window_bits = 15;
+
+    /** Maximum window bits used by the client's deflater.
+
+        In the client role this caps the window used for sending, in
+        the server role a value below 15 asks the client to limit its
+        window, if the client indicates support. Must be in the range
+        9 to 15 inclusive.
+    */
+    int client_max_window_bits = 15;
+
+    /// `true` to ask the server to reset its deflater after each message
+    bool server_no_context_takeover = false;
+
+    /// `true` to ask the client to reset its deflater after each message
+    bool client_no_context_takeover = false;
+
+    /// Deflate compression level, 0 to 9 inclusive
+    int comp_level = 8;
+
+    /// Deflate memory level, 1 to 9 inclusive
+    int mem_level = 4;
+
+    /** Memory allowed for compression on each stream, in bytes.
+
+        When not zero, the window bits and memory level are lowered
+        as needed when the option is set, so that the zlib state of
+        a stream in either role stays under this many bytes. In the
+        server role, offers from clients which cannot be asked for
+        a smaller window are then declined. The smallest settings
+        need about 11KB, a lower limit is rejected.
+    */
+    std::size_t memory_limit = 0;
+};
+
 /** Pong callback option.
 
     Sets the callback to be invoked whenever a pong is received
@@ -272,11 +480,14 @@ struct pong_callback
 /** Read buffer size option.
 
     Sets the number of bytes allocated to the socket's read buffer.
-    If this is zero, then reads are not buffered. Setting this
-    higher can improve performance when expecting to receive
+    Frame headers are decoded from this buffer, and each read from
+    the next layer requests up to this many bytes, so that frames
+    arriving together are processed without further reads. Setting
+    this higher can improve performance when expecting to receive
     many small frames.
 
-    The default is no buffering.
+    The default is no buffering, in which case only enough is read
+    ahead to hold a frame header and a small payload.
 
     @note Objects of this type are passed to @ref stream::set_option.
 
@@ -312,6 +523,12 @@ struct read_buffer_size
     The default setting is 16 megabytes. A value of zero indicates
     a limit of `std::numeric_limits<std::uint64_t>::max()`.
 
+    While a limit is set, messages read in full into a dynamic
+    buffer which offers a `reserve` member, such as @ref streambuf,
+    have room for the payload of each frame reserved when its
+    header arrives, so that a message sent in one frame lands in a
+    single contiguous buffer.
+
     @note Objects of this type are passed to @ref stream::set_option.
 
     @par Example
@@ -337,6 +554,111 @@ struct read_message_max
 };
 #endif
 
+/// The action taken when a message would exceed the send queue limit
+enum class queue_overflow
+{
+    /// Reject the message, leaving the connection open
+    drop,
+
+    /// Reject the message, and close the connection
+    disconnect
+};
+
+/** Send queue limits option.
+
+    Sets the limits applied to messages queued with @ref stream::send.
+    A message which would bring the number of queued bytes over
+    `limit` is rejected with `boost::asio::error::no_buffer_space`.
+    If `overflow` is @ref queue_overflow::disconnect, the stream also
+    fails and closes its lowest layer, cancelling any pending reads.
+    This lets a server drop slow consumers of a broadcast without
+    tracking them separately.
+
+    When the queued bytes reach `high`, the @ref send_queue_callback
+    is invoked with `true`. Once flushing brings the queued bytes
+    back to `low` or below, it is invoked again with `false`. This
+    lets producers stop and resume without polling the stream.
+
+    The defaults are a limit of 16 megabytes, a high watermark of
+    64 kilobytes, a low watermark of 16 kilobytes, and dropping the
+    messages which do not fit.
+
+    @note Objects of this type are passed to @ref stream::set_option.
+
+    @par Example
+    Setting the send queue limits.
+    @code
+    ...
+    websocket::stream<ip::tcp::socket> ws(ios);
+    ws.set_option(send_queue{1024 * 1024, 256 * 1024, 64 * 1024});
+    @endcode
+*/
+#if GENERATING_DOCS
+using send_queue = implementation_defined;
+#else
+struct send_queue
+{
+    std::size_t limit;
+    std::size_t high;
+    std::size_t low;
+    queue_overflow overflow;
+
+    send_queue(std::size_t limit_,
+            std::size_t high_, std::size_t low_,
+                queue_overflow overflow_ = queue_overflow::drop)
+        : limit(limit_)
+        , high(high_)
+        , low(low_)
+        , overflow(overflow_)
+    {
+        if(low >= high || high > limit)
+            throw std::domain_error("invalid send queue limits");
+    }
+};
+#endif
+
+/** Send queue callback option.
+
+    Sets the callback to be invoked when the number of bytes queued
+    with @ref stream::send crosses the watermarks set with the
+    @ref send_queue option.
+
+    The callback is invoked with `true` from within the call to
+    @ref stream::send which brings the queue to the high watermark,
+    and with `false` from within the flush operation which drains
+    the queue to the low watermark. When flushing asynchronously,
+    the callback is invoked using the same method as that used to
+    invoke the final handler.
+
+    The signature of the callback must be:
+    @code
+    void callback(
+        bool above_high     // `true` if the high watermark was reached
+    );
+    @endcode
+
+    @note To remove the callback, construct the option with
+    no parameters: `set_option(send_queue_callback{})`
+*/
+#if GENERATING_DOCS
+using send_queue_callback = implementation_defined;
+#else
+struct send_queue_callback
+{
+    detail::send_queue_cb value;
+
+    send_queue_callback() = default;
+    send_queue_callback(send_queue_callback&&) = default;
+    send_queue_callback(send_queue_callback const&) = default;
+
+    explicit
+    send_queue_callback(detail::send_queue_cb f)
+        : value(std::move(f))
+    {
+    }
+};
+#endif
+
 } // websocket
 } // beast
 
@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BEAST_WEBSOCKET_PREPARED_MESSAGE_HPP
+#define BEAST_WEBSOCKET_PREPARED_MESSAGE_HPP
+
+#include <beast/websocket/rfc6455.hpp>
+#include <beast/websocket/detail/frame.hpp>
+#include <beast/websocket/detail/send_buffer.hpp>
+#include <beast/core/buffer_concepts.hpp>
+#include <beast/core/static_streambuf.hpp>
+#include <boost/asio/buffer.hpp>
+#include <memory>
+#include <stdexcept>
+
+namespace beast {
+namespace websocket {
+
+/** A message encoded once for sending on many streams.
+
+    Objects of this type hold a complete, unmasked message frame,
+    built when the object is constructed. Copies share the same
+    immutable frame, so a message may be handed to any number of
+    streams, on any number of threads, for the cost of a reference
+    count.
+
+    Streams in the server role send the shared frame as-is. Since
+    frames sent by clients must be masked with a key chosen per
+    frame, streams in the client role copy and mask the payload.
+    The message is always sent uncompressed, as a single frame.
+
+    @par Example
+    Broadcasting a message to a set of connected clients.
+    @code
+    websocket::prepared_message msg{
+        websocket::opcode::text, boost::asio::buffer(s)};
+    for(auto& ws : clients)
+        ws.async_write(msg, std::bind(&on_write, _1));
+    @endcode
+
+    @see stream::send, stream::write, stream::async_write
+*/
+class prepared_message
+{
+    friend class prepared_message_test;
+
+    template<class NextLayer, class ReadBuffer>
+    friend class stream;
+
+    std::shared_ptr<detail::shared_frame const> p_;
+
+public:
+    /// Copy constructor
+    prepared_message(prepared_message const&) = default;
+
+    /// Copy assignment
+    prepared_message& operator=(prepared_message const&) = default;
+
+    /** Construct a prepared message.
+
+        @param op The message opcode, which must be
+        @ref opcode::text or @ref opcode::binary.
+
+        @param buffers The buffers containing the entire message
+        payload, which is copied.
+
+        @throws std::domain_error if the opcode is invalid.
+    */
+    template<class ConstBufferSequence>
+    prepared_message(opcode op, ConstBufferSequence const& buffers)
+    {
+        static_assert(beast::is_ConstBufferSequence<
+            ConstBufferSequence>::value,
+                "ConstBufferSequence requirements not met");
+        using boost::asio::buffer;
+        using boost::asio::buffer_copy;
+        using boost::asio::buffer_size;
+        if(op != opcode::binary && op != opcode::text)
+            throw std::domain_error("bad opcode");
+        detail::frame_header fh;
+        fh.op = op;
+        fh.fin = true;
+        fh.rsv1 = false;
+        fh.rsv2 = false;
+        fh.rsv3 = false;
+        fh.mask = false;
+        fh.len = buffer_size(buffers);
+        detail::fh_streambuf fh_buf;
+        detail::write<static_streambuf>(fh_buf, fh);
+        auto const p = std::make_shared<detail::shared_frame>();
+        p->op = op;
+        p->header_size = buffer_size(fh_buf.data());
+        p->size = p->header_size +
+            static_cast<std::size_t>(fh.len);
+        p->data.reset(new std::uint8_t[p->size]);
+        buffer_copy(buffer(p->data.get(), p->header_size),
+            fh_buf.data());
+        buffer_copy(buffer(p->data.get() + p->header_size,
+            p->size - p->header_size), buffers);
+        p_ = p;
+    }
+
+    /// Returns the message opcode
+    opcode
+    code() const
+    {
+        return p_->op;
+    }
+
+    /// Returns the message payload
+    boost::asio::const_buffers_1
+    payload() const
+    {
+        return p_->payload();
+    }
+
+    /// Returns the size of the encoded frame, header included
+    std::size_t
+    size() const
+    {
+        return p_->size;
+    }
+};
+
+} // websocket
+} // beast
+
+#endif
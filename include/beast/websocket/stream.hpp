@@ -9,10 +9,18 @@
 #define BEAST_WEBSOCKET_STREAM_HPP
 
 #include <beast/websocket/option.hpp>
+#include <beast/websocket/prepared_message.hpp>
+#include <beast/websocket/detail/hybi13.hpp>
+#include <beast/websocket/detail/keepalive_service.hpp>
+#include <beast/websocket/detail/sendfile.hpp>
 #include <beast/websocket/detail/stream_base.hpp>
+#include <beast/websocket/detail/upgrade_parser.hpp>
 #include <beast/http/message_v1.hpp>
 #include <beast/http/string_body.hpp>
 #include <beast/core/dynabuf_readstream.hpp>
+#include <beast/core/prepare_buffers.hpp>
+#include <beast/core/static_streambuf.hpp>
+#include <beast/core/streambuf.hpp>
 #include <beast/core/async_completion.hpp>
 #include <beast/core/detail/get_lowest_layer.hpp>
 #include <boost/asio.hpp>
@@ -20,6 +28,8 @@
 #include <algorithm>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <vector>
 
 namespace beast {
 namespace websocket {
@@ -36,6 +46,26 @@ struct frame_info
 
     /// `true` if this is the last frame in the current message.
     bool fin;
+
+    /// `true` if the data read ends the current frame.
+    bool frame_end;
+};
+
+/** Describes a message received by @ref stream::read_batch.
+
+    The payload of each message is held in the dynamic buffer
+    passed to the read, at the given offset of its input sequence.
+*/
+struct batch_message
+{
+    /// The type of message (binary or text).
+    opcode op;
+
+    /// The position of the payload in the dynamic buffer.
+    std::size_t offset;
+
+    /// The size of the payload.
+    std::size_t size;
 };
 
 //--------------------------------------------------------------------
@@ -72,6 +102,14 @@ struct frame_info
     For asynchronous operations, the type must support the
     @b `AsyncStream` concept.
 
+    @tparam ReadBuffer The type of the buffer holding data received
+    from the next layer before it is processed. The type must meet the
+    requirements of @b `DynamicBuffer`, and be default constructible
+    and move assignable. The default @ref streambuf grows in blocks
+    of at least 1KB, while @ref flat_streambuf keeps the data in one
+    contiguous allocation which may be released while the stream is
+    idle, see @ref release_read_buffer.
+
     @note A stream object must not be destroyed while there are
     pending asynchronous operations associated with it.
 
@@ -81,12 +119,29 @@ struct frame_info
         @b `DynamicBuffer`,
         @b `SyncStream`
 */
-template<class NextLayer>
+template<class NextLayer, class ReadBuffer = streambuf>
 class stream : public detail::stream_base
 {
     friend class stream_test;
 
-    dynabuf_readstream<NextLayer, streambuf> stream_;
+    // Schedules the automatic pings of a stream
+    class ka_hook : public detail::timer_wheel::hook
+    {
+    public:
+        stream* ws = nullptr;
+
+    private:
+        void
+        on_expire() override
+        {
+            ws->ka_expire();
+        }
+    };
+
+    dynabuf_readstream<NextLayer, ReadBuffer> stream_;
+    std::unique_ptr<ReadBuffer> rd_inflated_;
+    permessage_deflate pmd_opts_;
+    ka_hook ka_;
 
 public:
     /// The type of the next layer.
@@ -102,25 +157,40 @@ public:
             next_layer_type>::type;
     #endif
 
+    /** The buffer sequence type of payloads returned by @ref read_view.
+
+        The buffers refer to memory owned by the stream.
+    */
+    using view_type =
+    #if GENERATING_DOCS
+        implementation_defined;
+    #else
+        prepared_buffers<typename ReadBuffer::const_buffers_type>;
+    #endif
+
     /** Move-construct a stream.
 
         If @c NextLayer is move constructible, this function
         will move-construct a new stream from the existing stream.
+        Automatic pings scheduled by the existing stream continue
+        on this stream, on the same schedule.
 
         @note The behavior of move assignment on or from streams
         with active or pending operations is undefined.
     */
-    stream(stream&&) = default;
+    stream(stream&& other);
 
     /** Move assignment.
 
         If `NextLayer` is move constructible, this function
         will move-construct a new stream from the existing stream.
+        Automatic pings scheduled by the existing stream continue
+        on this stream, on the same schedule.
 
         @note The behavior of move assignment on or from streams
         with active or pending operations is undefined.
     */
-    stream& operator=(stream&&) = default;
+    stream& operator=(stream&& other);
 
     /** Construct a WebSocket stream.
 
@@ -177,6 +247,16 @@ public:
             wr_frag_size_ = o.value;
     }
 
+    /// Set the automatic ping option
+    void
+    set_option(auto_ping const& o)
+    {
+        ka_interval_ = o.interval;
+        ka_timeout_ = o.timeout;
+        if(ka_interval_ == ka_interval_.zero())
+            ka_.cancel();
+    }
+
     /// Set the decorator used for HTTP messages
     void
     set_option(detail::decorator_type o)
@@ -198,6 +278,44 @@ public:
         wr_opcode_ = o.value;
     }
 
+    /// Set the permessage-deflate extension options
+    void
+    set_option(permessage_deflate const& o)
+    {
+        if( o.server_max_window_bits > 15 ||
+            o.server_max_window_bits < 9)
+            throw std::domain_error{
+                "invalid server_max_window_bits"};
+        if( o.client_max_window_bits > 15 ||
+            o.client_max_window_bits < 9)
+            throw std::domain_error{
+                "invalid client_max_window_bits"};
+        if( o.comp_level < 0 ||
+            o.comp_level > 9)
+            throw std::domain_error{
+                "invalid comp_level"};
+        if( o.mem_level < 1 ||
+            o.mem_level > 9)
+            throw std::domain_error{
+                "invalid mem_level"};
+        auto opts = o;
+        if( opts.memory_limit != 0 &&
+            ! detail::pmd_limit(
+                opts.server_max_window_bits,
+                opts.client_max_window_bits,
+                opts.mem_level, opts.memory_limit))
+            throw std::domain_error{
+                "invalid memory_limit"};
+        pmd_opts_ = opts;
+    }
+
+    /// Set the mask key generator
+    void
+    set_option(mask_generator o)
+    {
+        maskgen_ = std::move(o.value);
+    }
+
     /// Set the pong callback
     void
     set_option(pong_callback o)
@@ -209,6 +327,7 @@ public:
     void
     set_option(read_buffer_size const& o)
     {
+        rd_buf_size_ = o.value;
         stream_.capacity(o.value);
     }
 
@@ -227,6 +346,23 @@ public:
         stream_.capacity(o.value);
     }
 
+    /// Set the send queue limits
+    void
+    set_option(send_queue const& o)
+    {
+        sq_limit_ = o.limit;
+        sq_high_ = o.high;
+        sq_low_ = o.low;
+        sq_disconnect_ = o.overflow == queue_overflow::disconnect;
+    }
+
+    /// Set the send queue callback
+    void
+    set_option(send_queue_callback o)
+    {
+        sq_cb_ = std::move(o.value);
+    }
+
     /** Get the io_service associated with the stream.
 
         This function may be used to obtain the io_service object
@@ -306,9 +442,41 @@ public:
     close_reason const&
     reason() const
     {
-        return cr_;
+        static close_reason const none{};
+        return cr_ ? *cr_ : none;
+    }
+
+    /** Returns the round trip time of the last automatic ping.
+
+        This is the time between sending the last ping enabled by
+        the @ref auto_ping option and receiving its pong, or zero
+        if no such ping has been answered yet.
+    */
+    std::chrono::steady_clock::duration
+    ping_rtt() const
+    {
+        return ka_rtt_;
     }
 
+    /** Release the memory held by the read buffer.
+
+        This function replaces the buffer holding data received from
+        the next layer with a default constructed one, when it holds no
+        unprocessed data. Servers with many mostly idle connections
+        may call it after a message is read, before starting the next
+        read, so that idle streams do not keep their buffer allocated.
+        Any view returned by @ref read_view or @ref async_read_view is
+        invalidated.
+
+        The program must ensure that no read operation is pending on
+        the stream when this function is called.
+
+        @return `true` if the buffer was released, or `false` if it
+        holds data which was not yet processed.
+    */
+    bool
+    release_read_buffer();
+
     /** Read and respond to a WebSocket HTTP Upgrade request.
 
         This function is used to synchronously read a HTTP WebSocket
@@ -1111,6 +1279,170 @@ public:
 #endif
     async_read(opcode& op, DynamicBuffer& dynabuf, ReadHandler&& handler);
 
+    /** Read a batch of messages from the stream.
+
+        This function is used to synchronously read one message from
+        the stream, followed by any further messages which have already
+        been received in their entirety. The call blocks until one of
+        the following is true:
+
+        @li At least one complete message is received.
+
+        @li An error occurs on the stream.
+
+        This call is implemented in terms of one or more calls to the
+        stream's `read_some` and `write_some` operations.
+
+        After the first message, messages are taken from the stream's
+        read buffer for as long as each is complete there, without
+        waiting for more data. The batch also ends before a control
+        frame or a compressed message, which are left for the next
+        read, and when either limit would be exceeded. A peer sending
+        bursts of small messages may thus be served at the cost of one
+        read per burst.
+
+        For each message read, a @ref batch_message is appended to
+        `messages`, and the payload is appended to the input area of
+        the dynamic buffer.
+
+        @param messages A container to receive a description of each
+        message read.
+
+        @param dynabuf A dynamic buffer to hold the payload of the
+        messages after any masking has been removed.
+
+        @param max_messages The largest number of messages to read.
+        At least one message is always read.
+
+        @param max_bytes The largest total payload to read. The first
+        message is read regardless of its size.
+
+        @return The number of messages read.
+
+        @throws boost::system::system_error Thrown on failure.
+    */
+    template<class DynamicBuffer>
+    std::size_t
+    read_batch(std::vector<batch_message>& messages,
+        DynamicBuffer& dynabuf, std::size_t max_messages,
+            std::size_t max_bytes);
+
+    /** Read a batch of messages from the stream.
+
+        This function is used to synchronously read one message from
+        the stream, followed by any further messages which have already
+        been received in their entirety. The call blocks until one of
+        the following is true:
+
+        @li At least one complete message is received.
+
+        @li An error occurs on the stream.
+
+        This call is implemented in terms of one or more calls to the
+        stream's `read_some` and `write_some` operations.
+
+        After the first message, messages are taken from the stream's
+        read buffer for as long as each is complete there, without
+        waiting for more data. The batch also ends before a control
+        frame or a compressed message, which are left for the next
+        read, and when either limit would be exceeded.
+
+        For each message read, a @ref batch_message is appended to
+        `messages`, and the payload is appended to the input area of
+        the dynamic buffer. Messages read before an error remain.
+
+        @param messages A container to receive a description of each
+        message read.
+
+        @param dynabuf A dynamic buffer to hold the payload of the
+        messages after any masking has been removed.
+
+        @param max_messages The largest number of messages to read.
+        At least one message is always read.
+
+        @param max_bytes The largest total payload to read. The first
+        message is read regardless of its size.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @return The number of messages read.
+    */
+    template<class DynamicBuffer>
+    std::size_t
+    read_batch(std::vector<batch_message>& messages,
+        DynamicBuffer& dynabuf, std::size_t max_messages,
+            std::size_t max_bytes, error_code& ec);
+
+    /** Start an asynchronous operation to read a batch of messages from the stream.
+
+        This function is used to asynchronously read one message from
+        the stream, followed by any further messages which have already
+        been received in their entirety. The function call always
+        returns immediately. The asynchronous operation will continue
+        until one of the following is true:
+
+        @li At least one complete message is received.
+
+        @li An error occurs on the stream.
+
+        This operation is implemented in terms of one or more calls to the
+        next layer's `async_read_some` and `async_write_some` functions,
+        and is known as a <em>composed operation</em>. The program must
+        ensure that the stream performs no other reads until this operation
+        completes.
+
+        After the first message, messages are taken from the stream's
+        read buffer for as long as each is complete there, without
+        waiting for more data, and without an intermediate completion
+        for each message. The batch also ends before a control frame or
+        a compressed message, which are left for the next read, and
+        when either limit would be exceeded. A peer sending bursts of
+        small messages may thus be served with one handler invocation
+        per burst.
+
+        For each message read, a @ref batch_message is appended to
+        `messages`, and the payload is appended to the input area of
+        the dynamic buffer. Messages read before an error remain.
+
+        @param messages A container to receive a description of each
+        message read. This object must remain valid until the handler
+        is called.
+
+        @param dynabuf A dynamic buffer to hold the payload of the
+        messages after any masking has been removed. This object must
+        remain valid until the handler is called.
+
+        @param max_messages The largest number of messages to read.
+        At least one message is always read.
+
+        @param max_bytes The largest total payload to read. The first
+        message is read regardless of its size.
+
+        @param handler The handler to be called when the read operation
+        completes. Copies will be made of the handler as required. The
+        function signature of the handler must be:
+        @code
+        void handler(
+            error_code const& error,    // Result of operation
+            std::size_t n               // The number of messages read
+        );
+        @endcode
+        Regardless of whether the asynchronous operation completes
+        immediately or not, the handler will not be invoked from within
+        this function. Invocation of the handler will be performed in a
+        manner equivalent to using `boost::asio::io_service::post`.
+    */
+    template<class DynamicBuffer, class ReadHandler>
+#if GENERATING_DOCS
+    void_or_deduced
+#else
+    typename async_completion<ReadHandler,
+        void(error_code, std::size_t)>::result_type
+#endif
+    async_read_batch(std::vector<batch_message>& messages,
+        DynamicBuffer& dynabuf, std::size_t max_messages,
+            std::size_t max_bytes, ReadHandler&& handler);
+
     /** Read a message frame from the stream.
 
         This function is used to synchronously read a single message
@@ -1253,138 +1585,653 @@ public:
     async_read_frame(frame_info& fi,
         DynamicBuffer& dynabuf, ReadHandler&& handler);
 
-    /** Write a message to the stream.
+    /** Read some message data from the stream.
 
-        This function is used to synchronously write a message to
-        the stream. The call blocks until one of the following conditions
-        is met:
+        This function is used to synchronously read message data from
+        the stream as it arrives, without waiting for the rest of the
+        frame. The call blocks until one of the following is true:
 
-        @li The entire message is sent.
+        @li Some message data is received.
 
-        @li An error occurs.
+        @li A frame with no payload is received.
 
-        This operation is implemented in terms of one or more calls to the
-        next layer's `write_some` function.
+        @li An error occurs on the stream.
 
-        The current setting of the @ref message_type option controls
-        whether the message opcode is set to text or binary. If the
-        @ref auto_fragment_size option is set, the message will be split
-        into one or more frames as necessary. The actual payload contents
-        sent may be transformed as per the WebSocket protocol settings.
+        This call is implemented in terms of one or more calls to the
+        stream's `read_some` and `write_some` operations.
 
-        @param buffers The buffers containing the entire message
-        payload. The implementation will make copies of this object
-        as needed, but ownership of the underlying memory is not
-        transferred. The caller is responsible for ensuring that
-        the memory locations pointed to by buffers remains valid
-        until the completion handler is called.
+        The data is unmasked, decompressed and, for text messages,
+        checked for valid UTF-8 before it is placed in the buffer.
+        Upon success, fi is filled out to reflect the message payload
+        contents: op is set to binary or text, `fi.frame_end` is `true`
+        if the data ends the current frame, and `fi.fin` is `true` if
+        it ends the message. The next call after `fi.fin` is `true`
+        returns data from a new message.
 
-        @throws boost::system::system_error Thrown on failure.
+        Control frames are handled automatically, as described for
+        @ref read_frame.
 
-        @note This function always sends an entire message. To
-        send a message in fragments, use @ref write_frame.
+        @param fi An object to store metadata about the message.
+
+        @param dynabuf A dynamic buffer to hold the message data after
+        any masking or decompression has been applied.
+
+        @param limit The largest number of bytes to receive, or zero
+        for no limit other than the end of the frame. Decompression
+        may produce more bytes than this.
+
+        @return The number of bytes placed in the buffer.
+
+        @throws boost::system::system_error Thrown on failure.
     */
-    template<class ConstBufferSequence>
-    void
-    write(ConstBufferSequence const& buffers);
+    template<class DynamicBuffer>
+    std::size_t
+    read_some(frame_info& fi,
+        DynamicBuffer& dynabuf, std::size_t limit);
 
-    /** Write a message to the stream.
+    /** Read some message data from the stream.
 
-        This function is used to synchronously write a message to
-        the stream. The call blocks until one of the following conditions
-        is met:
+        This function is used to synchronously read message data from
+        the stream as it arrives, without waiting for the rest of the
+        frame. The call blocks until one of the following is true:
 
-        @li The entire message is sent.
+        @li Some message data is received.
 
-        @li An error occurs.
+        @li A frame with no payload is received.
 
-        This operation is implemented in terms of one or more calls to the
-        next layer's `write_some` function.
+        @li An error occurs on the stream.
 
-        The current setting of the @ref message_type option controls
-        whether the message opcode is set to text or binary. If the
-        @ref auto_fragment_size option is set, the message will be split
-        into one or more frames as necessary. The actual payload contents
-        sent may be transformed as per the WebSocket protocol settings.
+        This call is implemented in terms of one or more calls to the
+        stream's `read_some` and `write_some` operations.
 
-        @param buffers The buffers containing the entire message
-        payload. The implementation will make copies of this object
-        as needed, but ownership of the underlying memory is not
-        transferred. The caller is responsible for ensuring that
-        the memory locations pointed to by buffers remains valid
-        until the completion handler is called.
+        The data is unmasked, decompressed and, for text messages,
+        checked for valid UTF-8 before it is placed in the buffer.
+        Upon success, fi is filled out to reflect the message payload
+        contents: op is set to binary or text, `fi.frame_end` is `true`
+        if the data ends the current frame, and `fi.fin` is `true` if
+        it ends the message. The next call after `fi.fin` is `true`
+        returns data from a new message.
 
-        @param ec Set to indicate what error occurred, if any.
+        Control frames are handled automatically, as described for
+        @ref read_frame.
 
-        @throws boost::system::system_error Thrown on failure.
+        @param fi An object to store metadata about the message.
 
-        @note This function always sends an entire message. To
-        send a message in fragments, use @ref write_frame.
+        @param dynabuf A dynamic buffer to hold the message data after
+        any masking or decompression has been applied.
+
+        @param limit The largest number of bytes to receive, or zero
+        for no limit other than the end of the frame. Decompression
+        may produce more bytes than this.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @return The number of bytes placed in the buffer.
     */
-    template<class ConstBufferSequence>
-    void
-    write(ConstBufferSequence const& buffers, error_code& ec);
+    template<class DynamicBuffer>
+    std::size_t
+    read_some(frame_info& fi, DynamicBuffer& dynabuf,
+        std::size_t limit, error_code& ec);
 
-    /** Start an asynchronous operation to write a message to the stream.
+    /** Start an asynchronous operation to read some message data from the stream.
 
-        This function is used to asynchronously write a message to
-        the stream. The function call always returns immediately.
-        The asynchronous operation will continue until one of the
-        following conditions is true:
+        This function is used to asynchronously read message data from
+        the stream as it arrives, without waiting for the rest of the
+        frame. This lets applications such as proxies forward large
+        messages using bounded memory. The function call always returns
+        immediately. The asynchronous operation will continue until one
+        of the following conditions is true:
 
-        @li The entire message is sent.
+        @li Some message data is received.
 
-        @li An error occurs.
+        @li A frame with no payload is received.
 
-        This operation is implemented in terms of one or more calls
-        to the next layer's `async_write_some` functions, and is known
-        as a <em>composed operation</em>. The program must ensure that
-        the stream performs no other write operations (such as
-        stream::async_write, stream::async_write_frame, or
-        stream::async_close).
+        @li An error occurs on the stream.
 
-        The current setting of the @ref message_type option controls
-        whether the message opcode is set to text or binary. If the
-        @ref auto_fragment_size option is set, the message will be split
-        into one or more frames as necessary. The actual payload contents
-        sent may be transformed as per the WebSocket protocol settings.
+        This operation is implemented in terms of one or more calls to the
+        next layer's `async_read_some` and `async_write_some` functions,
+        and is known as a <em>composed operation</em>. The program must
+        ensure that the stream performs no other reads until this operation
+        completes.
 
-        @param buffers The buffers containing the entire message
-        payload. The implementation will make copies of this object
-        as needed, but ownership of the underlying memory is not
-        transferred. The caller is responsible for ensuring that
-        the memory locations pointed to by buffers remains valid
-        until the completion handler is called.
+        The data is unmasked, decompressed and, for text messages,
+        checked for valid UTF-8 before it is placed in the buffer.
+        Upon success, fi is filled out to reflect the message payload
+        contents: op is set to binary or text, `fi.frame_end` is `true`
+        if the data ends the current frame, and `fi.fin` is `true` if
+        it ends the message. The next read after `fi.fin` is `true`
+        returns data from a new message.
 
-        @param handler The handler to be called when the write operation
+        Control frames are handled automatically, as described for
+        @ref async_read_frame.
+
+        @param fi An object to store metadata about the message.
+        This object must remain valid until the handler is called.
+
+        @param dynabuf A dynamic buffer to hold the message data after
+        any masking or decompression has been applied. This object must
+        remain valid until the handler is called.
+
+        @param limit The largest number of bytes to receive, or zero
+        for no limit other than the end of the frame. Decompression
+        may produce more bytes than this.
+
+        @param handler The handler to be called when the read operation
         completes. Copies will be made of the handler as required. The
         function signature of the handler must be:
         @code
         void handler(
-            error_code const& error     // Result of operation
+            error_code const& error,        // Result of operation
+            std::size_t bytes_transferred   // Bytes placed in dynabuf
         );
         @endcode
         Regardless of whether the asynchronous operation completes
         immediately or not, the handler will not be invoked from within
         this function. Invocation of the handler will be performed in a
-        manner equivalent to using `boost::asio::io_service::post`.
+        manner equivalent to using boost::asio::io_service::post().
     */
-    template<class ConstBufferSequence, class WriteHandler>
+    template<class DynamicBuffer, class ReadHandler>
 #if GENERATING_DOCS
     void_or_deduced
 #else
-    typename async_completion<
-        WriteHandler, void(error_code)>::result_type
+    typename async_completion<ReadHandler,
+        void(error_code, std::size_t)>::result_type
 #endif
-    async_write(ConstBufferSequence const& buffers,
-        WriteHandler&& handler);
+    async_read_some(frame_info& fi, DynamicBuffer& dynabuf,
+        std::size_t limit, ReadHandler&& handler);
 
-    /** Send a message frame on the stream.
+    /** Read a message frame from the stream without copying it.
 
-        This function is used to write a frame to the stream. The
-        call will block until one of the following conditions is true:
+        This function is used to synchronously read a message frame
+        from the stream. The call blocks until one of the following
+        is true:
 
-        @li The entire frame is sent.
+        @li A complete frame is received.
+
+        @li An error occurs on the stream.
+
+        This call is implemented in terms of one or more calls to the
+        stream's `read_some` and `write_some` operations.
+
+        The frame is received into the stream's own read buffer, where
+        it is unmasked and, for text messages, checked for valid UTF-8
+        in place. Instead of being copied to a caller provided buffer,
+        the payload is returned as a view of the read buffer. This
+        saves a copy for applications which parse each message as it
+        arrives. Compressed frames are decompressed into a buffer which
+        is also owned by the stream.
+
+        The view remains valid until the next read operation on the
+        stream is started, or the stream is destroyed. The frame must
+        fit in memory; the maximum message size set with
+        @ref read_message_max applies.
+
+        Upon success, fi is filled out to reflect the message payload
+        contents: op is set to binary or text, and `fi.fin` is `true`
+        if this is the last frame of the message. A message sent as a
+        single frame is therefore seen in a single view.
+
+        Control frames are handled automatically, as described for
+        @ref read_frame.
+
+        @param fi An object to store metadata about the message.
+
+        @return The payload of the frame.
+
+        @throws boost::system::system_error Thrown on failure.
+    */
+    view_type
+    read_view(frame_info& fi);
+
+    /** Read a message frame from the stream without copying it.
+
+        This function is used to synchronously read a message frame
+        from the stream. The call blocks until one of the following
+        is true:
+
+        @li A complete frame is received.
+
+        @li An error occurs on the stream.
+
+        This call is implemented in terms of one or more calls to the
+        stream's `read_some` and `write_some` operations.
+
+        The frame is received into the stream's own read buffer, where
+        it is unmasked and, for text messages, checked for valid UTF-8
+        in place. Instead of being copied to a caller provided buffer,
+        the payload is returned as a view of the read buffer. This
+        saves a copy for applications which parse each message as it
+        arrives. Compressed frames are decompressed into a buffer which
+        is also owned by the stream.
+
+        The view remains valid until the next read operation on the
+        stream is started, or the stream is destroyed. The frame must
+        fit in memory; the maximum message size set with
+        @ref read_message_max applies.
+
+        Upon success, fi is filled out to reflect the message payload
+        contents: op is set to binary or text, and `fi.fin` is `true`
+        if this is the last frame of the message. A message sent as a
+        single frame is therefore seen in a single view.
+
+        Control frames are handled automatically, as described for
+        @ref read_frame.
+
+        @param fi An object to store metadata about the message.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @return The payload of the frame.
+    */
+    view_type
+    read_view(frame_info& fi, error_code& ec);
+
+    /** Start an asynchronous operation to read a message frame from the stream without copying it.
+
+        This function is used to asynchronously read a message frame
+        from the stream. The function call always returns immediately.
+        The asynchronous operation will continue until one of the
+        following conditions is true:
+
+        @li A complete frame is received.
+
+        @li An error occurs on the stream.
+
+        This operation is implemented in terms of one or more calls to the
+        next layer's `async_read_some` and `async_write_some` functions,
+        and is known as a <em>composed operation</em>. The program must
+        ensure that the stream performs no other reads until this operation
+        completes.
+
+        The frame is received into the stream's own read buffer, where
+        it is unmasked and, for text messages, checked for valid UTF-8
+        in place. Instead of being copied to a caller provided buffer,
+        the payload is returned as a view of the read buffer. This
+        saves a copy for applications which parse each message as it
+        arrives. Compressed frames are decompressed into a buffer which
+        is also owned by the stream.
+
+        The view remains valid until the next read operation on the
+        stream is started, or the stream is destroyed. The frame must
+        fit in memory; the maximum message size set with
+        @ref read_message_max applies.
+
+        Upon success, fi is filled out to reflect the message payload
+        contents: op is set to binary or text, and `fi.fin` is `true`
+        if this is the last frame of the message. A message sent as a
+        single frame is therefore seen in a single view.
+
+        Control frames are handled automatically, as described for
+        @ref async_read_frame.
+
+        @param fi An object to store metadata about the message.
+        This object must remain valid until the handler is called.
+
+        @param handler The handler to be called when the read operation
+        completes. Copies will be made of the handler as required. The
+        function signature of the handler must be:
+        @code
+        void handler(
+            error_code const& error,        // Result of operation
+            stream::view_type const& view   // The frame payload
+        );
+        @endcode
+        Regardless of whether the asynchronous operation completes
+        immediately or not, the handler will not be invoked from within
+        this function. Invocation of the handler will be performed in a
+        manner equivalent to using boost::asio::io_service::post().
+    */
+    template<class ReadHandler>
+#if GENERATING_DOCS
+    void_or_deduced
+#else
+    typename async_completion<ReadHandler,
+        void(error_code, view_type)>::result_type
+#endif
+    async_read_view(frame_info& fi, ReadHandler&& handler);
+
+    /** Write a message to the stream.
+
+        This function is used to synchronously write a message to
+        the stream. The call blocks until one of the following conditions
+        is met:
+
+        @li The entire message is sent.
+
+        @li An error occurs.
+
+        This operation is implemented in terms of one or more calls to the
+        next layer's `write_some` function.
+
+        The current setting of the @ref message_type option controls
+        whether the message opcode is set to text or binary. If the
+        @ref auto_fragment_size option is set, the message will be split
+        into one or more frames as necessary. The actual payload contents
+        sent may be transformed as per the WebSocket protocol settings.
+
+        @param buffers The buffers containing the entire message
+        payload. The implementation will make copies of this object
+        as needed, but ownership of the underlying memory is not
+        transferred. The caller is responsible for ensuring that
+        the memory locations pointed to by buffers remains valid
+        until the completion handler is called.
+
+        @throws boost::system::system_error Thrown on failure.
+
+        @note This function always sends an entire message. To
+        send a message in fragments, use @ref write_frame.
+    */
+    template<class ConstBufferSequence>
+    void
+    write(ConstBufferSequence const& buffers);
+
+    /** Write a message to the stream.
+
+        This function is used to synchronously write a message to
+        the stream. The call blocks until one of the following conditions
+        is met:
+
+        @li The entire message is sent.
+
+        @li An error occurs.
+
+        This operation is implemented in terms of one or more calls to the
+        next layer's `write_some` function.
+
+        The current setting of the @ref message_type option controls
+        whether the message opcode is set to text or binary. If the
+        @ref auto_fragment_size option is set, the message will be split
+        into one or more frames as necessary. The actual payload contents
+        sent may be transformed as per the WebSocket protocol settings.
+
+        @param buffers The buffers containing the entire message
+        payload. The implementation will make copies of this object
+        as needed, but ownership of the underlying memory is not
+        transferred. The caller is responsible for ensuring that
+        the memory locations pointed to by buffers remains valid
+        until the completion handler is called.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @throws boost::system::system_error Thrown on failure.
+
+        @note This function always sends an entire message. To
+        send a message in fragments, use @ref write_frame.
+    */
+    template<class ConstBufferSequence>
+    void
+    write(ConstBufferSequence const& buffers, error_code& ec);
+
+    /** Start an asynchronous operation to write a message to the stream.
+
+        This function is used to asynchronously write a message to
+        the stream. The function call always returns immediately.
+        The asynchronous operation will continue until one of the
+        following conditions is true:
+
+        @li The entire message is sent.
+
+        @li An error occurs.
+
+        This operation is implemented in terms of one or more calls
+        to the next layer's `async_write_some` functions, and is known
+        as a <em>composed operation</em>. The program must ensure that
+        the stream performs no other write operations (such as
+        stream::async_write, stream::async_write_frame, or
+        stream::async_close).
+
+        The current setting of the @ref message_type option controls
+        whether the message opcode is set to text or binary. If the
+        @ref auto_fragment_size option is set, the message will be split
+        into one or more frames as necessary. The actual payload contents
+        sent may be transformed as per the WebSocket protocol settings.
+
+        Control frames waiting to be sent, such as the pong answering
+        a ping received during a read, or a ping or close started while
+        this operation is outstanding, are sent between the frames of
+        the message. The delay they incur is bounded by the time to
+        send one fragment.
+
+        @param buffers The buffers containing the entire message
+        payload. The implementation will make copies of this object
+        as needed, but ownership of the underlying memory is not
+        transferred. The caller is responsible for ensuring that
+        the memory locations pointed to by buffers remains valid
+        until the completion handler is called.
+
+        @param handler The handler to be called when the write operation
+        completes. Copies will be made of the handler as required. The
+        function signature of the handler must be:
+        @code
+        void handler(
+            error_code const& error     // Result of operation
+        );
+        @endcode
+        Regardless of whether the asynchronous operation completes
+        immediately or not, the handler will not be invoked from within
+        this function. Invocation of the handler will be performed in a
+        manner equivalent to using `boost::asio::io_service::post`.
+    */
+    template<class ConstBufferSequence, class WriteHandler>
+#if GENERATING_DOCS
+    void_or_deduced
+#else
+    typename async_completion<
+        WriteHandler, void(error_code)>::result_type
+#endif
+    async_write(ConstBufferSequence const& buffers,
+        WriteHandler&& handler);
+
+    /** Write a prepared message to the stream.
+
+        This function is used to synchronously write a prepared message
+        to the stream. The message is appended to the send queue, and
+        the queue is flushed. The call blocks until one of the following
+        conditions is true:
+
+        @li The send queue is empty.
+
+        @li An error occurs.
+
+        @param message The message to send.
+
+        @throws boost::system::system_error Thrown on failure.
+
+        @see send, flush
+    */
+    void
+    write(prepared_message const& message);
+
+    /** Write a prepared message to the stream.
+
+        This function is used to synchronously write a prepared message
+        to the stream. The message is appended to the send queue, and
+        the queue is flushed. The call blocks until one of the following
+        conditions is true:
+
+        @li The send queue is empty.
+
+        @li An error occurs.
+
+        @param message The message to send.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @see send, flush
+    */
+    void
+    write(prepared_message const& message, error_code& ec);
+
+    /** Start an asynchronous operation to write a prepared message.
+
+        This function is used to asynchronously write a prepared message
+        to the stream. The message is appended to the send queue, and an
+        asynchronous operation equivalent to @ref async_flush is started.
+        The function call always returns immediately.
+
+        In the server role the stream refers to the shared frame until
+        it is written, so broadcasting a message to many streams copies
+        neither the header nor the payload. The program must ensure that
+        the stream performs no other write operations (such as
+        stream::async_write, stream::async_write_frame, or
+        stream::async_close) until this operation completes.
+
+        @param message The message to send.
+
+        @param handler The handler to be called when the write operation
+        completes. Copies will be made of the handler as required. The
+        function signature of the handler must be:
+        @code
+        void handler(
+            error_code const& error     // Result of operation
+        );
+        @endcode
+        If the message would bring the queue over the limit set with
+        the @ref send_queue option, the error will be
+        `boost::asio::error::no_buffer_space`. Regardless of whether the
+        asynchronous operation completes immediately or not, the handler
+        will not be invoked from within this function. Invocation of the
+        handler will be performed in a manner equivalent to using
+        `boost::asio::io_service::post`.
+    */
+    template<class WriteHandler>
+#if GENERATING_DOCS
+    void_or_deduced
+#else
+    typename async_completion<
+        WriteHandler, void(error_code)>::result_type
+#endif
+    async_write(prepared_message const& message,
+        WriteHandler&& handler);
+
+    /** Write part of a file to the stream as a binary message.
+
+        This function is used to synchronously write `size` bytes
+        starting at `offset` in a file to the stream, as the payload
+        of a binary message. The call blocks until one of the
+        following conditions is true:
+
+        @li The entire message is sent.
+
+        @li An error occurs.
+
+        In the server role, on platforms which support it, and when
+        the next layer is a plain TCP socket, the payload is sent as
+        one frame and copied to the socket by the kernel using
+        `sendfile`, without passing through user memory. Otherwise
+        the file is read in pieces no larger than the
+        @ref auto_fragment_size option (or 64KB when it is disabled),
+        and each piece is sent with @ref write_frame.
+
+        If a message was started with @ref write_frame and not
+        finished, the file is sent as its final fragment.
+
+        @param fd An open descriptor for a regular file. The
+        descriptor's file position is not used or changed.
+
+        @param offset The offset of the first byte to send.
+
+        @param size The number of bytes to send. If the file ends
+        first, the error will be `boost::asio::error::eof`, and the
+        stream will be unusable.
+
+        @throws boost::system::system_error Thrown on failure.
+    */
+    void
+    write_file(int fd, std::uint64_t offset, std::uint64_t size);
+
+    /** Write part of a file to the stream as a binary message.
+
+        This function is used to synchronously write `size` bytes
+        starting at `offset` in a file to the stream, as the payload
+        of a binary message. The call blocks until one of the
+        following conditions is true:
+
+        @li The entire message is sent.
+
+        @li An error occurs.
+
+        See the other overload for a description of how the payload
+        is sent.
+
+        @param fd An open descriptor for a regular file. The
+        descriptor's file position is not used or changed.
+
+        @param offset The offset of the first byte to send.
+
+        @param size The number of bytes to send. If the file ends
+        first, the error will be `boost::asio::error::eof`, and the
+        stream will be unusable.
+
+        @param ec Set to indicate what error occurred, if any.
+    */
+    void
+    write_file(int fd, std::uint64_t offset,
+        std::uint64_t size, error_code& ec);
+
+    /** Start an asynchronous operation to write part of a file.
+
+        This function is used to asynchronously write `size` bytes
+        starting at `offset` in a file to the stream, as the payload
+        of a binary message. The function call always returns
+        immediately. The asynchronous operation will continue until
+        one of the following conditions is true:
+
+        @li The entire message is sent.
+
+        @li An error occurs.
+
+        In the server role, on platforms which support it, and when
+        the next layer is a plain TCP socket, the payload is sent as
+        one frame and copied to the socket by the kernel using
+        `sendfile`. Otherwise the file is read in pieces which are
+        sent as with @ref async_write_frame, and control frames may
+        be sent between the pieces.
+
+        The program must ensure that the stream performs no other
+        write operations (such as stream::async_write,
+        stream::async_write_frame, or stream::async_close) until
+        this operation completes.
+
+        @param fd An open descriptor for a regular file, which
+        must remain open until the operation completes. The
+        descriptor's file position is not used or changed.
+
+        @param offset The offset of the first byte to send.
+
+        @param size The number of bytes to send. If the file ends
+        first, the error will be `boost::asio::error::eof`, and the
+        stream will be unusable.
+
+        @param handler The handler to be called when the write operation
+        completes. Copies will be made of the handler as required. The
+        function signature of the handler must be:
+        @code
+        void handler(
+            error_code const& error     // Result of operation
+        );
+        @endcode
+        Regardless of whether the asynchronous operation completes
+        immediately or not, the handler will not be invoked from within
+        this function. Invocation of the handler will be performed in a
+        manner equivalent to using `boost::asio::io_service::post`.
+    */
+    template<class WriteHandler>
+#if GENERATING_DOCS
+    void_or_deduced
+#else
+    typename async_completion<
+        WriteHandler, void(error_code)>::result_type
+#endif
+    async_write_file(int fd, std::uint64_t offset,
+        std::uint64_t size, WriteHandler&& handler);
+
+    /** Send a message frame on the stream.
+
+        This function is used to write a frame to the stream. The
+        call will block until one of the following conditions is true:
+
+        @li The entire frame is sent.
 
         @li An error occurs.
 
@@ -1488,37 +2335,311 @@ public:
     async_write_frame(bool fin,
         ConstBufferSequence const& buffers, WriteHandler&& handler);
 
+    /** Queue a message for sending.
+
+        This function appends a complete message to the stream's send
+        queue and returns immediately, without performing any I/O.
+        Queued messages are written by the next call to @ref flush or
+        @ref async_flush, which sends every message queued so far in
+        as few writes to the next layer as possible.
+
+        The message is framed when it is queued: the opcode is set to
+        text or binary as per the current setting of the
+        @ref message_type option, and the payload is copied and masked
+        if required by the role. The message is always sent as a single
+        uncompressed frame, even when permessage-deflate is in use.
+
+        If the @ref send_queue_callback option is set, and the message
+        brings the queue to the high watermark, the callback is invoked
+        from within this function.
+
+        @param buffers The buffers containing the entire message
+        payload. The payload is copied, so the memory may be released
+        as soon as this function returns.
+
+        @throws boost::system::system_error Thrown on failure.
+
+        @note While a message started with @ref write_frame or
+        @ref async_write_frame is incomplete, nothing is queued and the
+        error is `boost::system::errc::operation_not_permitted`.
+    */
+    template<class ConstBufferSequence>
+    void
+    send(ConstBufferSequence const& buffers);
+
+    /** Queue a message for sending.
+
+        This function appends a complete message to the stream's send
+        queue and returns immediately, without performing any I/O.
+        Queued messages are written by the next call to @ref flush or
+        @ref async_flush, which sends every message queued so far in
+        as few writes to the next layer as possible.
+
+        The message is framed when it is queued: the opcode is set to
+        text or binary as per the current setting of the
+        @ref message_type option, and the payload is copied and masked
+        if required by the role. The message is always sent as a single
+        uncompressed frame, even when permessage-deflate is in use.
+
+        If the @ref send_queue_callback option is set, and the message
+        brings the queue to the high watermark, the callback is invoked
+        from within this function.
+
+        @param buffers The buffers containing the entire message
+        payload. The payload is copied, so the memory may be released
+        as soon as this function returns.
+
+        @param ec Set to indicate what error occurred, if any. If the
+        message would bring the queue over the limit set with the
+        @ref send_queue option, the error will be
+        `boost::asio::error::no_buffer_space` and nothing is queued.
+
+        @note While a message started with @ref write_frame or
+        @ref async_write_frame is incomplete, nothing is queued and the
+        error is `boost::system::errc::operation_not_permitted`.
+    */
+    template<class ConstBufferSequence>
+    void
+    send(ConstBufferSequence const& buffers, error_code& ec);
+
+    /** Queue a prepared message for sending.
+
+        This function appends a prepared message to the stream's send
+        queue and returns immediately, without performing any I/O.
+        In the server role the queue holds a reference to the shared
+        frame, which is written as-is. In the client role the payload
+        is copied and masked as for any other message.
+
+        @param message The message to queue.
+
+        @throws boost::system::system_error Thrown on failure.
+
+        @note While a message started with @ref write_frame or
+        @ref async_write_frame is incomplete, nothing is queued and the
+        error is `boost::system::errc::operation_not_permitted`.
+    */
+    void
+    send(prepared_message const& message);
+
+    /** Queue a prepared message for sending.
+
+        This function appends a prepared message to the stream's send
+        queue and returns immediately, without performing any I/O.
+        In the server role the queue holds a reference to the shared
+        frame, which is written as-is. In the client role the payload
+        is copied and masked as for any other message.
+
+        @param message The message to queue.
+
+        @param ec Set to indicate what error occurred, if any. If the
+        message would bring the queue over the limit set with the
+        @ref send_queue option, the error will be
+        `boost::asio::error::no_buffer_space` and nothing is queued.
+
+        @note While a message started with @ref write_frame or
+        @ref async_write_frame is incomplete, nothing is queued and the
+        error is `boost::system::errc::operation_not_permitted`.
+    */
+    void
+    send(prepared_message const& message, error_code& ec);
+
+    /** Write the queued messages to the stream.
+
+        This function is used to synchronously write the messages queued
+        with @ref send. The call blocks until one of the following
+        conditions is true:
+
+        @li The send queue is empty.
+
+        @li An error occurs.
+
+        This operation is implemented in terms of one or more calls to the
+        next layer's `write_some` function.
+
+        @throws boost::system::system_error Thrown on failure.
+
+        @note While a message started with @ref write_frame or
+        @ref async_write_frame is incomplete, nothing is written and the
+        error is `boost::system::errc::operation_not_permitted`.
+    */
+    void
+    flush();
+
+    /** Write the queued messages to the stream.
+
+        This function is used to synchronously write the messages queued
+        with @ref send. The call blocks until one of the following
+        conditions is true:
+
+        @li The send queue is empty.
+
+        @li An error occurs.
+
+        This operation is implemented in terms of one or more calls to the
+        next layer's `write_some` function.
+
+        @param ec Set to indicate what error occurred, if any.
+
+        @note While a message started with @ref write_frame or
+        @ref async_write_frame is incomplete, nothing is written and the
+        error is `boost::system::errc::operation_not_permitted`.
+    */
+    void
+    flush(error_code& ec);
+
+    /** Start an asynchronous operation to write the queued messages.
+
+        This function is used to asynchronously write the messages queued
+        with @ref send. The function call always returns immediately.
+        The asynchronous operation will continue until one of the
+        following conditions is true:
+
+        @li The send queue is empty.
+
+        @li An error occurs.
+
+        Messages queued while the operation is pending are written by
+        the same operation, each write to the next layer gathering all
+        of the frames queued since the previous one.
+
+        This operation is implemented in terms of one or more calls
+        to the next layer's `async_write_some` functions, and is known
+        as a <em>composed operation</em>. The program must ensure that
+        the stream performs no other write operations (such as
+        stream::async_write, stream::async_write_frame, or
+        stream::async_close) until this operation completes.
+
+        @param handler The handler to be called when the write operation
+        completes. Copies will be made of the handler as required. The
+        function signature of the handler must be:
+        @code
+        void handler(
+            error_code const& error     // Result of operation
+        );
+        @endcode
+        Regardless of whether the asynchronous operation completes
+        immediately or not, the handler will not be invoked from within
+        this function. Invocation of the handler will be performed in a
+        manner equivalent to using `boost::asio::io_service::post`.
+
+        @note While a message started with @ref write_frame or
+        @ref async_write_frame is incomplete, nothing is written and the
+        error is `boost::system::errc::operation_not_permitted`.
+    */
+    template<class WriteHandler>
+#if GENERATING_DOCS
+    void_or_deduced
+#else
+    typename async_completion<
+        WriteHandler, void(error_code)>::result_type
+#endif
+    async_flush(WriteHandler&& handler);
+
 private:
     template<class Handler> class accept_op;
     template<class Handler> class close_op;
+    template<class Handler> class flush_op;
+    class ka_ping_op;
     template<class Handler> class handshake_op;
     template<class Handler> class ping_op;
     template<class Handler> class response_op;
-    template<class Buffers, class Handler> class write_op;
     template<class Buffers, class Handler> class write_frame_op;
     template<class DynamicBuffer, class Handler> class read_op;
+    template<class DynamicBuffer, class Handler> class read_batch_op;
     template<class DynamicBuffer, class Handler> class read_frame_op;
+    template<class DynamicBuffer, class Handler> class read_some_op;
+    template<class Handler> class read_view_op;
+    template<class Handler> class write_file_op;
 
     void
     reset();
 
+    void
+    open(detail::role_type role);
+
+    detail::pmd_offer
+    pmd_settings() const;
+
+    bool
+    build_request(static_streambuf& sb,
+        boost::string_ref const& host,
+            boost::string_ref const& resource,
+                detail::sec_ws_key_type& key);
+
     http::request_v1<http::empty_body>
     build_request(boost::string_ref const& host,
         boost::string_ref const& resource,
-            std::string& key);
+            detail::sec_ws_key_type& key);
+
+    http::request_v1<http::empty_body>
+    build_request(detail::upgrade_parser<true> const& p);
+
+    error_code
+    build_response(static_streambuf& sb,
+        detail::upgrade_parser<true> const& p);
 
     template<class Body, class Headers>
     http::response_v1<http::string_body>
     build_response(http::request_v1<Body, Headers> const& req);
 
-    template<class Body, class Headers>
     void
-    do_response(http::response_v1<Body, Headers> const& resp,
+    do_response(detail::upgrade_parser<false> const& p,
         boost::string_ref const& key, error_code& ec);
 
     void
-    do_read_fh(detail::frame_streambuf& fb,
-        close_code::value& code, error_code& ec);
+    do_read_fh(close_code::value& code, error_code& ec);
+
+    template<class DynamicBuffer>
+    void
+    do_read_frame(frame_info& fi, DynamicBuffer& dynabuf,
+        std::size_t limit, bool view, error_code& ec);
+
+    template<class MutableBufferSequence>
+    std::size_t
+    rd_drain(MutableBufferSequence const& mb, bool& valid);
+
+    template<class MutableBufferSequence>
+    bool
+    rd_unmask(MutableBufferSequence const& mb);
+
+    void
+    rd_release_view();
+
+    void
+    rd_view_payload(std::size_t n, close_code::value& code);
+
+    view_type
+    rd_view();
+
+    ReadBuffer&
+    rd_inflated();
+
+    bool
+    rd_batch_next(std::size_t count, std::size_t bytes,
+        std::size_t max_messages, std::size_t max_bytes);
+
+    bool
+    sq_admit(std::uint64_t n, error_code& ec);
+
+    void
+    ka_schedule(std::chrono::steady_clock::duration d);
+
+    void
+    ka_expire();
+
+    void
+    ka_send();
+
+    bool
+    wr_sendfile() const;
+
+    std::size_t
+    wr_file_chunk(std::uint64_t size) const;
+
+    template<class ConstBufferSequence>
+    void
+    do_send(opcode op,
+        ConstBufferSequence const& bs, error_code& ec);
 };
 
 } // websocket
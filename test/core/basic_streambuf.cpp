@@ -271,13 +271,72 @@ public:
 
     void testConsume()
     {
+        using boost::asio::buffer_cast;
         using boost::asio::buffer_size;
-        streambuf sb(1);
-        expect_size(5, sb.prepare(5));
-        sb.commit(3);
-        expect_size(3, sb.data());
-        sb.consume(1);
-        expect_size(2, sb.data());
+        {
+            streambuf sb(1);
+            expect_size(5, sb.prepare(5));
+            sb.commit(3);
+            expect_size(3, sb.data());
+            sb.consume(1);
+            expect_size(2, sb.data());
+        }
+        {
+            // emptying both sequences rewinds the storage
+            streambuf sb(1024);
+            auto const p = buffer_cast<char*>(*sb.prepare(500).begin());
+            sb.commit(100);
+            sb.consume(100);
+            BEAST_EXPECT(buffer_cast<char*>(
+                *sb.prepare(500).begin()) == p + 100);
+            sb.prepare(0);
+            sb.consume(0);
+            BEAST_EXPECT(buffer_cast<char*>(
+                *sb.prepare(500).begin()) == p);
+            BEAST_EXPECT(sb.capacity() == 1024);
+        }
+    }
+
+    void testReserve()
+    {
+        using boost::asio::buffer_copy;
+        {
+            // an empty buffer releases a small block
+            streambuf sb(4);
+            sb.prepare(4);
+            sb.reserve(10);
+            BEAST_EXPECT(sb.capacity() == 0);
+            BEAST_EXPECT(test::buffer_count(sb.prepare(10)) == 1);
+        }
+        {
+            // the input sequence ends on a block boundary
+            streambuf sb(4);
+            sb.commit(buffer_copy(sb.prepare(4),
+                boost::asio::buffer("abcd", 4)));
+            sb.prepare(8);
+            sb.reserve(10);
+            BEAST_EXPECT(test::buffer_count(sb.prepare(10)) == 1);
+            BEAST_EXPECT(to_string(sb.data()) == "abcd");
+        }
+        {
+            // enough room already
+            streambuf sb(16);
+            sb.commit(buffer_copy(sb.prepare(2),
+                boost::asio::buffer("ab", 2)));
+            auto const capacity = sb.capacity();
+            sb.reserve(10);
+            BEAST_EXPECT(sb.capacity() == capacity);
+            BEAST_EXPECT(test::buffer_count(sb.prepare(10)) == 1);
+        }
+        {
+            // the input sequence ends inside a block
+            streambuf sb(4);
+            sb.commit(buffer_copy(sb.prepare(2),
+                boost::asio::buffer("ab", 2)));
+            sb.reserve(10);
+            BEAST_EXPECT(test::buffer_count(sb.prepare(10)) == 2);
+            BEAST_EXPECT(to_string(sb.data()) == "ab");
+        }
     }
 
     void testMatrix()
@@ -450,6 +509,7 @@ public:
         testPrepare();
         testCommit();
         testConsume();
+        testReserve();
         testMatrix();
         testIterators();
         testOutputStream();
@@ -22,6 +22,12 @@ public:
         auto const encoded = base64_encode (in);
         BEAST_EXPECT(encoded == out);
         BEAST_EXPECT(base64_decode (encoded) == in);
+
+        std::string buf(base64_encoded_size (in.size()), '*');
+        auto const n = base64_encode (&buf[0], reinterpret_cast<
+            std::uint8_t const*>(in.data()), in.size());
+        BEAST_EXPECT(n == buf.size());
+        BEAST_EXPECT(buf == out);
     }
 
     void
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/core/flat_streambuf.hpp>
+
+#include <beast/core/buffer_concepts.hpp>
+#include <beast/core/to_string.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/asio/buffer.hpp>
+#include <string>
+
+namespace beast {
+
+static_assert(is_DynamicBuffer<flat_streambuf>::value, "");
+
+class flat_streambuf_test : public beast::unit_test::suite
+{
+public:
+    void testPrepareCommit()
+    {
+        using boost::asio::buffer;
+        using boost::asio::buffer_copy;
+        using boost::asio::buffer_size;
+        std::string const s = "Hello, world";
+        for(std::size_t i = 0; i <= s.size(); ++i)
+        {
+            flat_streambuf b;
+            BEAST_EXPECT(b.capacity() == 0);
+            b.commit(buffer_copy(b.prepare(i), buffer(s.data(), i)));
+            BEAST_EXPECT(b.size() == i);
+            auto const mb = b.prepare(s.size() - i);
+            BEAST_EXPECT(buffer_size(mb) == s.size() - i);
+            b.commit(buffer_copy(mb,
+                buffer(s.data() + i, s.size() - i)));
+            BEAST_EXPECT(b.size() == s.size());
+            BEAST_EXPECT(to_string(b.data()) == s);
+            b.commit(1);
+            BEAST_EXPECT(b.size() == s.size());
+        }
+    }
+
+    void testConsume()
+    {
+        using boost::asio::buffer;
+        using boost::asio::buffer_copy;
+        flat_streambuf b;
+        b.commit(buffer_copy(b.prepare(8), buffer("abcdefgh", 8)));
+        auto const cap = b.capacity();
+        b.consume(5);
+        BEAST_EXPECT(to_string(b.data()) == "fgh");
+        // the input sequence moves to the front
+        // instead of growing the buffer
+        b.commit(buffer_copy(b.prepare(5), buffer("ijklm", 5)));
+        BEAST_EXPECT(b.capacity() == cap);
+        BEAST_EXPECT(to_string(b.data()) == "fghijklm");
+        b.consume(100);
+        BEAST_EXPECT(b.size() == 0);
+        BEAST_EXPECT(b.capacity() == cap);
+        b.commit(buffer_copy(b.prepare(cap), buffer("12345678", 8)));
+        BEAST_EXPECT(b.capacity() == cap);
+        BEAST_EXPECT(to_string(b.data()) == "12345678");
+    }
+
+    void testShrink()
+    {
+        using boost::asio::buffer;
+        using boost::asio::buffer_copy;
+        flat_streambuf b;
+        b.commit(buffer_copy(b.prepare(1000), buffer("*****", 5)));
+        BEAST_EXPECT(b.capacity() >= 1000);
+        b.shrink_to_fit();
+        BEAST_EXPECT(b.capacity() == 5);
+        BEAST_EXPECT(to_string(b.data()) == "*****");
+        b.consume(5);
+        b.shrink_to_fit();
+        BEAST_EXPECT(b.capacity() == 0);
+        b.commit(buffer_copy(b.prepare(3), buffer("abc", 3)));
+        BEAST_EXPECT(to_string(b.data()) == "abc");
+    }
+
+    void testMove()
+    {
+        using boost::asio::buffer;
+        using boost::asio::buffer_copy;
+        flat_streambuf b1;
+        b1.commit(buffer_copy(b1.prepare(5), buffer("Hello", 5)));
+        flat_streambuf b2{std::move(b1)};
+        BEAST_EXPECT(b1.size() == 0);
+        BEAST_EXPECT(b1.capacity() == 0);
+        BEAST_EXPECT(to_string(b2.data()) == "Hello");
+        flat_streambuf b3;
+        b3.commit(buffer_copy(b3.prepare(5), buffer("World", 5)));
+        b3 = std::move(b2);
+        BEAST_EXPECT(b2.capacity() == 0);
+        BEAST_EXPECT(to_string(b3.data()) == "Hello");
+        b3 = flat_streambuf{};
+        BEAST_EXPECT(b3.size() == 0);
+        BEAST_EXPECT(b3.capacity() == 0);
+    }
+
+    void run() override
+    {
+        testPrepareCommit();
+        testConsume();
+        testShrink();
+        testMove();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(flat_streambuf,core,beast);
+
+} // beast
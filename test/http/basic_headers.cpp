@@ -82,10 +82,53 @@ public:
         BEAST_EXPECT(h.size() == 2);
     }
 
+    void testKnown()
+    {
+        bh h;
+        h.insert("X-Custom", "1");
+        h.insert("connection", "close");
+        h.insert(field::host, "example.com");
+        h.insert("CONNECTION", "upgrade");
+        h.insert(field::content_length, 42);
+        BEAST_EXPECT(h.exists(field::connection));
+        BEAST_EXPECT(h.exists("Connection"));
+        BEAST_EXPECT(! h.exists(field::upgrade));
+        BEAST_EXPECT(h[field::connection] == "close");
+        BEAST_EXPECT(h["Content-Length"] == "42");
+        BEAST_EXPECT(h.find("Host")->name() == "Host");
+        BEAST_EXPECT(h.find(field::upgrade) == h.end());
+        BEAST_EXPECT(h.count(field::connection) == 2);
+        BEAST_EXPECT(h.count("Connection") == 2);
+        BEAST_EXPECT(h.count(field::upgrade) == 0);
+
+        // copies and moves keep the index
+        bh h2(h);
+        BEAST_EXPECT(h2[field::host] == "example.com");
+        bh h3(std::move(h2));
+        BEAST_EXPECT(h3[field::host] == "example.com");
+        BEAST_EXPECT(! h2.exists(field::host));
+        h2 = std::move(h3);
+        BEAST_EXPECT(h2[field::host] == "example.com");
+        BEAST_EXPECT(! h3.exists(field::host));
+
+        BEAST_EXPECT(h.erase(field::connection) == 2);
+        BEAST_EXPECT(! h.exists("connection"));
+        BEAST_EXPECT(h.size() == 3);
+        h.replace("Host", "other");
+        BEAST_EXPECT(h[field::host] == "other");
+        h.replace(field::host, "third");
+        BEAST_EXPECT(h.count(field::host) == 1);
+        BEAST_EXPECT(h["host"] == "third");
+        BEAST_EXPECT(h.erase("X-Custom") == 1);
+        h.clear();
+        BEAST_EXPECT(! h.exists(field::content_length));
+    }
+
     void run() override
     {
         testHeaders();
         testRFC2616();
+        testKnown();
     }
 };
 
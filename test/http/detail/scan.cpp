@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/http/detail/scan.hpp>
+
+#include <beast/unit_test/suite.hpp>
+#include <array>
+
+namespace beast {
+namespace http {
+namespace detail {
+
+class scan_test : public beast::unit_test::suite
+{
+public:
+    // Compare a kernel against the byte at a time reference,
+    // placing each octet value at every position of inputs
+    // of various sizes and alignments.
+    void
+    testKernel(char const* name, scan_kernel_type f)
+    {
+        testcase << name;
+        std::array<char, 128> buf;
+        for(char lo : {' ', '!'})
+        {
+            for(std::size_t off = 0; off < 4; ++off)
+            {
+                for(std::size_t n = 0; n <= 80; n += (n < 40 ? 1 : 7))
+                {
+                    for(int c = 0; c < 256; ++c)
+                    {
+                        for(std::size_t i = 0; i < n;
+                            i += (i < 36 ? 1 : 5))
+                        {
+                            buf.fill('a');
+                            buf[off + i] = static_cast<char>(c);
+                            auto const p = buf.data() + off;
+                            if(f(p, p + n, lo) !=
+                                scan_bytes(p, p + n, lo))
+                            {
+                                fail();
+                                return;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        pass();
+    }
+
+    void
+    testStops()
+    {
+        char const s[] = "a\tb\x80 c\x7f";
+        BEAST_EXPECT(scan_bytes(s, s + 8, ' ') == s + 6);
+        BEAST_EXPECT(scan_bytes(s, s + 8, '!') == s + 4);
+        BEAST_EXPECT(scan_bytes(s, s + 3, '!') == s + 3);
+        BEAST_EXPECT(*scan_text(s, s + 8, ' ') == '\x7f');
+    }
+
+    void
+    run() override
+    {
+        testStops();
+        testKernel("bytes", &scan_bytes);
+    #if BEAST_SIMD_X86
+        auto const& ci = beast::detail::get_cpu_info();
+        if(ci.sse42)
+            testKernel("sse42", &scan_bytes_sse42<>);
+        if(ci.avx2)
+            testKernel("avx2", &scan_bytes_avx2<>);
+    #endif
+        testKernel("dispatch", scan_kernel());
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(scan,http,beast);
+
+} // detail
+} // http
+} // beast
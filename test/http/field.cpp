@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/http/field.hpp>
+
+#include <beast/unit_test/suite.hpp>
+#include <cctype>
+#include <string>
+
+namespace beast {
+namespace http {
+
+class field_test : public beast::unit_test::suite
+{
+public:
+    void
+    run() override
+    {
+        // every well-known name hashes to its own slot
+        for(std::size_t i = 1; i <= field_count; ++i)
+        {
+            auto const f = static_cast<field>(i);
+            auto const s = to_string(f);
+            BEAST_EXPECT(! s.empty());
+            BEAST_EXPECT(string_to_field(s) == f);
+            std::string u(s.data(), s.size());
+            for(auto& c : u)
+                c = static_cast<char>(std::toupper(
+                    static_cast<unsigned char>(c)));
+            BEAST_EXPECT(string_to_field(u) == f);
+            u.push_back('x');
+            BEAST_EXPECT(string_to_field(u) == field::unknown);
+        }
+        BEAST_EXPECT(to_string(field::unknown).empty());
+        BEAST_EXPECT(to_string(field::content_length) == "Content-Length");
+        BEAST_EXPECT(string_to_field("") == field::unknown);
+        BEAST_EXPECT(string_to_field("X-Custom") == field::unknown);
+        BEAST_EXPECT(string_to_field("Hosts") == field::unknown);
+        BEAST_EXPECT(string_to_field("\xff\x80") == field::unknown);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(field,http,beast);
+
+} // http
+} // beast
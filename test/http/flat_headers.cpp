@@ -0,0 +1,193 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/http/flat_headers.hpp>
+
+#include <beast/http/headers.hpp>
+#include <beast/http/parser_v1.hpp>
+#include <beast/http/string_body.hpp>
+#include <beast/http/write.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/lexical_cast.hpp>
+#include <string>
+
+namespace beast {
+namespace http {
+
+class flat_headers_test : public beast::unit_test::suite
+{
+public:
+    template<class Headers>
+    static
+    void
+    fill(std::size_t n, Headers& h)
+    {
+        for(std::size_t i = 1; i<= n; ++i)
+            h.insert(std::to_string(i), i);
+    }
+
+    template<class Headers>
+    static
+    std::string
+    str(Headers const& h)
+    {
+        std::string s;
+        for(auto const& f : h)
+        {
+            s.append(f.name().data(), f.name().size());
+            s.append(": ");
+            s.append(f.value().data(), f.value().size());
+            s.append("\r\n");
+        }
+        return s;
+    }
+
+    void
+    testHeaders()
+    {
+        flat_headers h1;
+        BEAST_EXPECT(h1.empty());
+        fill(1, h1);
+        BEAST_EXPECT(h1.size() == 1);
+        flat_headers h2;
+        h2 = h1;
+        BEAST_EXPECT(h2.size() == 1);
+        h2.insert("2", "2");
+        BEAST_EXPECT(std::distance(h2.begin(), h2.end()) == 2);
+        h1 = std::move(h2);
+        BEAST_EXPECT(h1.size() == 2);
+        BEAST_EXPECT(h2.size() == 0);
+        flat_headers h3(std::move(h1));
+        BEAST_EXPECT(h3.size() == 2);
+        BEAST_EXPECT(h1.size() == 0);
+        BEAST_EXPECT(h3["2"] == "2");
+        BEAST_EXPECT(h2.erase("Not-Present") == 0);
+        flat_headers h4(h3.begin(), h3.end());
+        BEAST_EXPECT(str(h4) == str(h3));
+    }
+
+    void
+    testLookup()
+    {
+        flat_headers h;
+        h.insert("a", "w");
+        h.insert(field::host, "example.com");
+        h.insert("A", " x ");
+        h.insert("aa", "y");
+        h.insert("HOST", "other");
+        BEAST_EXPECT(h.count("a") == 2);
+        BEAST_EXPECT(h["a"] == "w");
+        BEAST_EXPECT(h.find("A")->value() == "w");
+        BEAST_EXPECT(h.count(field::host) == 2);
+        BEAST_EXPECT(h[field::host] == "example.com");
+        BEAST_EXPECT(h["host"] == "example.com");
+        BEAST_EXPECT(h.find("b") == h.end());
+        BEAST_EXPECT(! h.exists(field::connection));
+        BEAST_EXPECT(h.erase("a") == 2);
+        BEAST_EXPECT(h.size() == 3);
+        BEAST_EXPECT(str(h) ==
+            "Host: example.com\r\naa: y\r\nHOST: other\r\n");
+        h.replace(field::host, h["aa"]);
+        BEAST_EXPECT(str(h) == "aa: y\r\nHost: y\r\n");
+        h.replace("aa", h["aa"]);
+        BEAST_EXPECT(str(h) == "Host: y\r\naa: y\r\n");
+        // name refers to the arena, which grows
+        h.replace(h.begin()->name(), std::string(5000, 'v'));
+        BEAST_EXPECT(h.size() == 2);
+        BEAST_EXPECT(h.count(field::host) == 1);
+        BEAST_EXPECT(h[field::host] == std::string(5000, 'v'));
+        h.replace(h.begin()->name(), std::string(5000, 'w'));
+        BEAST_EXPECT(h.size() == 2);
+        BEAST_EXPECT(h.count("aa") == 1);
+        BEAST_EXPECT(h["aa"] == std::string(5000, 'w'));
+        h.insert("Content-Length", 5);
+        BEAST_EXPECT(h[field::content_length] == "5");
+        h.clear();
+        BEAST_EXPECT(h.empty());
+        BEAST_EXPECT(h.begin() == h.end());
+    }
+
+    // Compare against basic_headers across the
+    // threshold for the hash index
+    void
+    testIndex()
+    {
+        flat_headers h;
+        headers b;
+        for(std::size_t i = 0; i < 100; ++i)
+        {
+            auto const name = "X-" + std::to_string(i % 37);
+            auto const value = std::to_string(i);
+            h.insert(name, value);
+            b.insert(name, value);
+            if(i % 5 == 0)
+            {
+                h.insert(field::accept, value);
+                b.insert(field::accept, value);
+            }
+            if(i % 11 == 0)
+            {
+                auto const e = "x-" + std::to_string((i * 7) % 37);
+                BEAST_EXPECT(h.erase(e) == b.erase(e));
+            }
+            if(i % 13 == 0)
+            {
+                auto const r = "X-" + std::to_string(i % 3);
+                h.replace(r, "r");
+                b.replace(r, "r");
+            }
+            for(std::size_t j = 0; j < 40; ++j)
+            {
+                auto const s = "x-" + std::to_string(j);
+                if(! BEAST_EXPECT(h[s] == b[s]) ||
+                        ! BEAST_EXPECT(h.count(s) == b.count(s)))
+                    return;
+            }
+            BEAST_EXPECT(h[field::accept] == b[field::accept]);
+            BEAST_EXPECT(h.size() == b.size());
+        }
+    }
+
+    void
+    testMessage()
+    {
+        using boost::asio::buffer;
+        error_code ec;
+        parser_v1<true, string_body, flat_headers> p;
+        std::string const s =
+            "GET / HTTP/1.1\r\n"
+            "User-Agent: test\r\n"
+            "Content-Length: 1\r\n"
+            "\r\n"
+            "*";
+        p.write(buffer(s), ec);
+        BEAST_EXPECT(! ec);
+        BEAST_EXPECT(p.complete());
+        auto m = p.release();
+        BEAST_EXPECT(m.headers["User-Agent"] == "test");
+        BEAST_EXPECT(boost::lexical_cast<std::string>(m) == s);
+        m.headers.erase(field::content_length);
+        prepare(m, connection::close);
+        BEAST_EXPECT(m.headers[field::connection] == "close");
+        BEAST_EXPECT(m.headers[field::content_length] == "1");
+    }
+
+    void
+    run() override
+    {
+        testHeaders();
+        testLookup();
+        testIndex();
+        testMessage();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(flat_headers,http,beast);
+
+} // http
+} // beast
@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <beast/http/flat_headers.hpp>
+#include <beast/http/headers.hpp>
+#include <beast/http/write.hpp>
+#include <beast/core/streambuf.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace beast {
+namespace http {
+
+class headers_bench_test : public beast::unit_test::suite
+{
+public:
+    using fields_type =
+        std::vector<std::pair<std::string, std::string>>;
+
+    // The fields of a request sent by a web browser
+    static
+    fields_type
+    browser_fields()
+    {
+        return {
+            {"Host", "www.kittyhell.com"},
+            {"User-Agent", "Mozilla/5.0 (Macintosh; U; Intel Mac OS X 10.6; "
+                "ja-JP-mac; rv:1.9.2.3) Gecko/20100401 Firefox/3.6.3"},
+            {"Accept", "text/html,application/xhtml+xml,application/xml;"
+                "q=0.9,*/*;q=0.8"},
+            {"Accept-Language", "ja,en-us;q=0.7,en;q=0.3"},
+            {"Accept-Encoding", "gzip,deflate"},
+            {"Accept-Charset", "Shift_JIS,utf-8;q=0.7,*;q=0.7"},
+            {"Keep-Alive", "115"},
+            {"Connection", "keep-alive"},
+            {"Cookie", "wp_ozh_wsa_visits=2; wp_ozh_wsa_visit_lasttime=xxxxxxxxxx"},
+            {"X-Requested-With", "XMLHttpRequest"}
+        };
+    }
+
+    // Many fields with names which are not well-known
+    static
+    fields_type
+    custom_fields(std::size_t n)
+    {
+        fields_type v;
+        for(std::size_t i = 0; i < n; ++i)
+            v.emplace_back("X-Custom-Field-" + std::to_string(i),
+                "value-" + std::to_string(i));
+        return v;
+    }
+
+    template<class Function>
+    void
+    timedTest(std::size_t repeat, std::string const& name, Function&& f)
+    {
+        using namespace std::chrono;
+        using clock_type = std::chrono::high_resolution_clock;
+        log << name << std::endl;
+        for(std::size_t trial = 1; trial <= repeat; ++trial)
+        {
+            auto const t0 = clock_type::now();
+            f();
+            auto const elapsed = clock_type::now() - t0;
+            log <<
+                "Trial " << trial << ": " <<
+                duration_cast<milliseconds>(elapsed).count() << " ms" << std::endl;
+        }
+    }
+
+    template<class Headers>
+    static
+    void
+    fill(Headers& h, fields_type const& v)
+    {
+        for(auto const& f : v)
+            h.insert(f.first, f.second);
+    }
+
+    template<class Headers>
+    void
+    testInsert(std::string const& name, fields_type const& v)
+    {
+        std::size_t n = 0;
+        timedTest(Trials, name,
+            [&]
+            {
+                for(std::size_t i = 0; i < Repeat; ++i)
+                {
+                    Headers h;
+                    fill(h, v);
+                    n += h.size();
+                }
+            });
+        expect(n == Trials * Repeat * v.size());
+    }
+
+    template<class Headers>
+    void
+    testLookup(std::string const& name, fields_type const& v,
+        std::vector<std::string> const& names)
+    {
+        Headers h;
+        fill(h, v);
+        std::size_t n = 0;
+        timedTest(Trials, name,
+            [&]
+            {
+                for(std::size_t i = 0; i < Repeat; ++i)
+                    for(auto const& s : names)
+                        n += h[s].size();
+            });
+        expect(n > 0);
+    }
+
+    template<class Headers>
+    void
+    testSerialize(std::string const& name, fields_type const& v)
+    {
+        Headers h;
+        fill(h, v);
+        streambuf sb;
+        std::size_t n = 0;
+        timedTest(Trials, name,
+            [&]
+            {
+                for(std::size_t i = 0; i < Repeat / 10; ++i)
+                {
+                    detail::write_fields(sb, h);
+                    n += sb.size();
+                    sb.consume(sb.size());
+                }
+            });
+        expect(n > 0);
+    }
+
+    static std::size_t constexpr Trials = 3;
+    static std::size_t constexpr Repeat = 200000;
+
+    void
+    run() override
+    {
+        auto const browser = browser_fields();
+        auto const custom = custom_fields(40);
+        std::vector<std::string> const known = {
+            "Host", "Connection", "Content-Length", "Transfer-Encoding"};
+        std::vector<std::string> const unknown = {
+            "X-Custom-Field-3", "X-Custom-Field-37", "X-Missing"};
+
+        testcase << "Insert " << browser.size() << " browser fields";
+        testInsert<headers>("headers", browser);
+        testInsert<flat_headers>("flat_headers", browser);
+
+        testcase << "Look up " << known.size() << " well-known fields";
+        testLookup<headers>("headers", browser, known);
+        testLookup<flat_headers>("flat_headers", browser, known);
+
+        testcase << "Look up " << unknown.size() <<
+            " fields among " << custom.size();
+        testLookup<headers>("headers", custom, unknown);
+        testLookup<flat_headers>("flat_headers", custom, unknown);
+
+        testcase << "Serialize " << browser.size() << " browser fields";
+        testSerialize<headers>("headers", browser);
+        testSerialize<flat_headers>("flat_headers", browser);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(headers_bench,http,beast);
+
+} // http
+} // beast
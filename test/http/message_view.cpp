@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/http/message_view.hpp>
+
+#include <beast/http/write.hpp>
+#include <beast/core/streambuf.hpp>
+#include <beast/core/to_string.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <type_traits>
+
+namespace beast {
+namespace http {
+
+class message_view_test : public beast::unit_test::suite
+{
+public:
+    void
+    testFields()
+    {
+        fields_view<2> f;
+        BEAST_EXPECT(f.empty());
+        BEAST_EXPECT(f.capacity() == 2);
+        BEAST_EXPECT(f.insert("Host", "example.com"));
+        BEAST_EXPECT(f.insert("host", "other"));
+        BEAST_EXPECT(! f.insert("Server", "test"));
+        BEAST_EXPECT(f.size() == 2);
+        BEAST_EXPECT(f.exists("HOST"));
+        BEAST_EXPECT(! f.exists("Server"));
+        BEAST_EXPECT(f["hOsT"] == "example.com");
+        BEAST_EXPECT(f["Server"].empty());
+        BEAST_EXPECT(f.find("Server") == f.end());
+        BEAST_EXPECT(std::next(f.begin(), 2) == f.end());
+        f.clear();
+        BEAST_EXPECT(f.begin() == f.end());
+    }
+
+    void
+    testWrite()
+    {
+        // FieldSequence
+        message_view<true, 4> m;
+        BEAST_EXPECT(decltype(m)::is_request::value);
+        m.fields.insert("User-Agent", "test");
+        m.fields.insert("Accept", "*/*");
+        streambuf sb;
+        detail::write_fields(sb, m.fields);
+        BEAST_EXPECT(to_string(sb.data()) ==
+            "User-Agent: test\r\nAccept: */*\r\n");
+    }
+
+    void
+    run() override
+    {
+        static_assert(std::is_same<decltype(
+            message_view<false>{}.status), int>::value, "");
+        testFields();
+        testWrite();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(message_view,http,beast);
+
+} // http
+} // beast
@@ -28,12 +28,46 @@ public:
 
     corpus creq_;
     corpus cres_;
+    corpus cbrowser_;
     std::size_t size_ = 0;
 
     parser_bench_test()
     {
         creq_ = build_corpus(N/2, std::true_type{});
         cres_ = build_corpus(N/2, std::false_type{});
+        cbrowser_ = build_browser_corpus(N);
+    }
+
+    // Requests as sent by a web browser, with
+    // a long target and long header values.
+    static
+    corpus
+    build_browser_corpus(std::size_t n)
+    {
+        std::string const s =
+            "GET /wp-content/uploads/2010/03/hello-kitty-darth-vader-pink.jpg"
+                "?width=1280&height=720&quality=90 HTTP/1.1\r\n"
+            "Host: www.kittyhell.com\r\n"
+            "User-Agent: Mozilla/5.0 (Macintosh; U; Intel Mac OS X 10.6; ja-JP-mac; "
+                "rv:1.9.2.3) Gecko/20100401 Firefox/3.6.3 Pathtraq/0.9\r\n"
+            "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+                "*/*;q=0.8\r\n"
+            "Accept-Language: ja,en-us;q=0.7,en;q=0.3\r\n"
+            "Accept-Encoding: gzip,deflate\r\n"
+            "Accept-Charset: Shift_JIS,utf-8;q=0.7,*;q=0.7\r\n"
+            "Keep-Alive: 115\r\n"
+            "Connection: keep-alive\r\n"
+            "Cookie: wp_ozh_wsa_visits=2; wp_ozh_wsa_visit_lasttime=xxxxxxxxxx; "
+                "__utma=xxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.x; "
+                "__utmz=xxxxxxxxx.xxxxxxxxxx.x.x.utmccn=(referral)|utmcsr=reader."
+                "livedoor.com|utmcct=/reader/|utmcmd=referral\r\n"
+            "\r\n";
+        corpus v;
+        v.resize(n);
+        for(auto& sb : v)
+            sb.commit(boost::asio::buffer_copy(
+                sb.prepare(s.size()), boost::asio::buffer(s)));
+        return v;
     }
 
     corpus
@@ -138,6 +172,38 @@ public:
                     false, streambuf_body, headers>>(
                         Repeat, cres_);
             });
+
+        testcase << "Browser requests, " <<
+            ((Repeat * cbrowser_.size() *
+                boost::asio::buffer_size(cbrowser_[0].data()) +
+                    512) / 1024) <<
+                    "KB in " << (Repeat * cbrowser_.size()) << " messages";
+        timedTest(Trials, "nodejs_parser",
+            [&]
+            {
+                testParser<nodejs_parser<
+                    true, streambuf_body, headers>>(
+                        Repeat, cbrowser_);
+            });
+        timedTest(Trials, "http::basic_parser_v1",
+            [&]
+            {
+                testParser<parser_v1<
+                    true, streambuf_body, headers>>(
+                        Repeat, cbrowser_);
+            });
+        timedTest(Trials, "http::view_parser_v1",
+            [&]
+            {
+                testParser<view_parser_v1<true>>(
+                    Repeat, cbrowser_);
+            });
+        timedTest(Trials, "http::basic_parser_v1, no callbacks",
+            [&]
+            {
+                testParser<null_parser<true>>(
+                    Repeat, cbrowser_);
+            });
         pass();
     }
 
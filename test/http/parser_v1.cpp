@@ -8,7 +8,9 @@
 // Test that header file is self-contained.
 #include <beast/http/parser_v1.hpp>
 
+#include <beast/http/flat_headers.hpp>
 #include <beast/http/headers.hpp>
+#include <beast/http/streambuf_body.hpp>
 #include <beast/http/string_body.hpp>
 #include <beast/unit_test/suite.hpp>
 
@@ -18,7 +20,8 @@ namespace http {
 class parser_v1_test : public beast::unit_test::suite
 {
 public:
-    void run() override
+    void
+    testParse()
     {
         using boost::asio::buffer;
         {
@@ -75,6 +78,169 @@ public:
             BEAST_EXPECT(p.complete());
         }
     }
+
+    template<class Parser>
+    void
+    parse(Parser& p, std::string const& s)
+    {
+        error_code ec;
+        auto const n = p.write(
+            boost::asio::buffer(s), ec);
+        BEAST_EXPECT(! ec);
+        BEAST_EXPECT(n == s.size());
+        BEAST_EXPECT(p.complete());
+    }
+
+    void
+    testReset()
+    {
+        // several messages on one connection
+        {
+            parser_v1<true, string_body, flat_headers> p;
+            parse(p,
+                "POST /a HTTP/1.1\r\n"
+                "Host: x\r\n"
+                "User-Agent: test\r\n"
+                "Content-Length: 32\r\n"
+                "\r\n"
+                "********************************");
+            BEAST_EXPECT(p.get().url == "/a");
+            BEAST_EXPECT(p.get().body.size() == 32);
+            auto const body = p.get().body.data();
+            auto const cap = p.get().body.capacity();
+            p.reset();
+            BEAST_EXPECT(! p.complete());
+            BEAST_EXPECT(p.get().method.empty());
+            BEAST_EXPECT(p.get().url.empty());
+            BEAST_EXPECT(p.get().version == 0);
+            BEAST_EXPECT(p.get().headers.empty());
+            BEAST_EXPECT(p.get().body.empty());
+            parse(p,
+                "GET /b HTTP/1.0\r\n"
+                "Host: y\r\n"
+                "Content-Length: 3\r\n"
+                "\r\n"
+                "abc");
+            auto const& m = p.get();
+            BEAST_EXPECT(m.method == "GET");
+            BEAST_EXPECT(m.url == "/b");
+            BEAST_EXPECT(m.version == 10);
+            BEAST_EXPECT(m.headers.size() == 2);
+            BEAST_EXPECT(m.headers["Host"] == "y");
+            BEAST_EXPECT(! m.headers.exists("User-Agent"));
+            BEAST_EXPECT(m.body == "abc");
+            BEAST_EXPECT(m.body.data() == body);
+            BEAST_EXPECT(m.body.capacity() == cap);
+        }
+        // reset after an error
+        {
+            error_code ec;
+            parser_v1<false, string_body, headers> p;
+            std::string const s = "HTTP/1.1 2x";
+            p.write(boost::asio::buffer(s), ec);
+            BEAST_EXPECT(ec);
+            p.reset();
+            parse(p,
+                "HTTP/1.1 404 Not Found\r\n"
+                "Content-Length: 0\r\n"
+                "\r\n");
+            BEAST_EXPECT(p.get().status == 404);
+            BEAST_EXPECT(p.get().reason == "Not Found");
+        }
+        // reset in the middle of a message
+        {
+            error_code ec;
+            parser_v1<true, streambuf_body, headers> p;
+            std::string const s =
+                "PUT / HTTP/1.1\r\n"
+                "Content-Length: 10\r\n"
+                "\r\n"
+                "abc";
+            p.write(boost::asio::buffer(s), ec);
+            BEAST_EXPECT(! ec);
+            BEAST_EXPECT(! p.complete());
+            p.reset();
+            BEAST_EXPECT(p.get().body.size() == 0);
+            parse(p,
+                "PUT / HTTP/1.1\r\n"
+                "Content-Length: 2\r\n"
+                "\r\n"
+                "xy");
+            BEAST_EXPECT(p.get().body.size() == 2);
+        }
+        // reset through the base class
+        {
+            parser_v1<true, string_body, headers> p;
+            parse(p,
+                "POST /a HTTP/1.1\r\n"
+                "User-Agent: test\r\n"
+                "Content-Length: 3\r\n"
+                "\r\n"
+                "abc");
+            basic_parser_v1<true,
+                parser_v1<true, string_body, headers>>& b = p;
+            b.reset();
+            BEAST_EXPECT(p.get().url.empty());
+            BEAST_EXPECT(p.get().headers.empty());
+            BEAST_EXPECT(p.get().body.empty());
+            parse(p,
+                "GET /b HTTP/1.1\r\n"
+                "Host: y\r\n"
+                "Content-Length: 2\r\n"
+                "\r\n"
+                "xy");
+            BEAST_EXPECT(p.get().url == "/b");
+            BEAST_EXPECT(! p.get().headers.exists("User-Agent"));
+            BEAST_EXPECT(p.get().body == "xy");
+        }
+        // options are kept
+        {
+            parser_v1<false, string_body, headers> p;
+            p.set_option(skip_body{true});
+            p.reset();
+            parse(p,
+                "HTTP/1.1 200 OK\r\n"
+                "Content-Length: 5\r\n"
+                "\r\n");
+            BEAST_EXPECT(p.get().body.empty());
+        }
+    }
+
+    void
+    testRecycle()
+    {
+        using message_type = request_v1<string_body, flat_headers>;
+        std::string const s =
+            "POST / HTTP/1.1\r\n"
+            "Host: x\r\n"
+            "Content-Length: 20\r\n"
+            "\r\n"
+            "12345678901234567890";
+        parser_v1<true, string_body, flat_headers> p;
+        parse(p, s);
+        auto m = p.release();
+        BEAST_EXPECT(m.body == "12345678901234567890");
+        auto const body = m.body.data();
+        auto const cap = m.body.capacity();
+        p.reset(std::move(m));
+        BEAST_EXPECT(p.get().body.empty());
+        BEAST_EXPECT(p.get().headers.empty());
+        parse(p, s);
+        BEAST_EXPECT(p.get().headers["Host"] == "x");
+        BEAST_EXPECT(p.get().body == "12345678901234567890");
+        BEAST_EXPECT(p.get().body.data() == body);
+        BEAST_EXPECT(p.get().body.capacity() == cap);
+        message_type m2 = p.release();
+        BEAST_EXPECT(m2.method == "POST");
+    }
+
+    void
+    run() override
+    {
+        testParse();
+        testReset();
+        testRecycle();
+    }
 };
 
 BEAST_DEFINE_TESTSUITE(parser_v1,http,beast);
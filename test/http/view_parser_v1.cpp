@@ -0,0 +1,225 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/http/view_parser_v1.hpp>
+
+#include <beast/unit_test/suite.hpp>
+#include <string>
+
+namespace beast {
+namespace http {
+
+class view_parser_v1_test : public beast::unit_test::suite
+{
+public:
+    // `true` if `v` refers to the octets of `s`
+    static
+    bool
+    within(boost::string_ref const& v, std::string const& s)
+    {
+        return v.data() >= s.data() &&
+            v.data() + v.size() <= s.data() + s.size();
+    }
+
+    void
+    testRequest()
+    {
+        using boost::asio::buffer;
+        error_code ec;
+        view_parser_v1<true> p;
+        std::string const s =
+            "GET /index.html HTTP/1.1\r\n"
+            "User-Agent: test\r\n"
+            "Accept:\r\n"
+            "Content-Length: 1\r\n"
+            "\r\n"
+            "*";
+        auto const n = p.write(buffer(s), ec);
+        BEAST_EXPECT(! ec);
+        BEAST_EXPECT(p.complete());
+        BEAST_EXPECT(n == s.size() - 1);
+        BEAST_EXPECT(p.content_length() == 1);
+        auto const& m = p.get();
+        BEAST_EXPECT(m.method == "GET");
+        BEAST_EXPECT(m.url == "/index.html");
+        BEAST_EXPECT(m.version == 11);
+        BEAST_EXPECT(m.fields.size() == 3);
+        BEAST_EXPECT(m.fields["user-agent"] == "test");
+        BEAST_EXPECT(m.fields.exists("Accept"));
+        BEAST_EXPECT(m.fields["Accept"].empty());
+        BEAST_EXPECT(m.fields["Content-Length"] == "1");
+        BEAST_EXPECT(within(m.method, s));
+        BEAST_EXPECT(within(m.url, s));
+        for(auto const& f : m.fields)
+        {
+            BEAST_EXPECT(within(f.name(), s));
+            BEAST_EXPECT(f.value().empty() || within(f.value(), s));
+        }
+    }
+
+    void
+    testResponse()
+    {
+        using boost::asio::buffer;
+        error_code ec;
+        view_parser_v1<false> p;
+        std::string const s =
+            "HTTP/1.0 404 Not Found\r\n"
+            "Server: test\r\n"
+            "\r\n";
+        auto const n = p.write(buffer(s), ec);
+        BEAST_EXPECT(! ec);
+        BEAST_EXPECT(p.complete());
+        BEAST_EXPECT(n == s.size());
+        BEAST_EXPECT(p.content_length() == no_content_length);
+        auto const& m = p.get();
+        BEAST_EXPECT(m.status == 404);
+        BEAST_EXPECT(m.reason == "Not Found");
+        BEAST_EXPECT(m.version == 10);
+        BEAST_EXPECT(m.fields["Server"] == "test");
+        BEAST_EXPECT(within(m.reason, s));
+    }
+
+    // The header presented in pieces of the same buffer
+    void
+    testIncremental()
+    {
+        using boost::asio::buffer;
+        std::string const s =
+            "POST /upload HTTP/1.1\r\n"
+            "Host: example.com\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "\r\n";
+        for(std::size_t step = 1; step <= 7; ++step)
+        {
+            error_code ec;
+            view_parser_v1<true> p;
+            std::size_t used = 0;
+            std::size_t size = 0;
+            while(! p.complete())
+            {
+                size = std::min(size + step, s.size());
+                used += p.write(buffer(
+                    s.data() + used, size - used), ec);
+                if(! BEAST_EXPECT(! ec))
+                    return;
+            }
+            BEAST_EXPECT(used == s.size());
+            auto const& m = p.get();
+            BEAST_EXPECT(m.method == "POST");
+            BEAST_EXPECT(m.url == "/upload");
+            BEAST_EXPECT(m.fields["Host"] == "example.com");
+            BEAST_EXPECT(m.fields["Transfer-Encoding"] == "chunked");
+            BEAST_EXPECT(p.flags() & parse_flag::chunked);
+        }
+    }
+
+    void
+    testNonContiguous()
+    {
+        using boost::asio::buffer;
+        // element split across separate buffers
+        {
+            error_code ec;
+            view_parser_v1<true> p;
+            std::string const s1 = "GET /ind";
+            std::string const s2 = "ex.html HTTP/1.1\r\n\r\n";
+            p.write(buffer(s1), ec);
+            BEAST_EXPECT(! ec);
+            p.write(buffer(s2), ec);
+            BEAST_EXPECT(ec == parse_error::non_contiguous);
+        }
+        // obs-fold
+        {
+            error_code ec;
+            view_parser_v1<true> p;
+            std::string const s =
+                "GET / HTTP/1.1\r\n"
+                "X-Folded: a\r\n"
+                " b\r\n"
+                "\r\n";
+            p.write(buffer(s), ec);
+            BEAST_EXPECT(ec == parse_error::non_contiguous);
+        }
+    }
+
+    void
+    testLimit()
+    {
+        using boost::asio::buffer;
+        std::string const s =
+            "GET / HTTP/1.1\r\n"
+            "A: 1\r\n"
+            "B: 2\r\n"
+            "\r\n";
+        {
+            error_code ec;
+            view_parser_v1<true, 2> p;
+            p.write(buffer(s), ec);
+            BEAST_EXPECT(! ec);
+            BEAST_EXPECT(p.get().fields["B"] == "2");
+        }
+        {
+            error_code ec;
+            view_parser_v1<true, 1> p;
+            p.write(buffer(s), ec);
+            BEAST_EXPECT(ec == parse_error::headers_too_big);
+        }
+    }
+
+    void
+    testReset()
+    {
+        using boost::asio::buffer;
+        error_code ec;
+        view_parser_v1<true> p;
+        std::string const s1 =
+            "POST /a HTTP/1.1\r\n"
+            "Content-Length: 3\r\n"
+            "\r\n"
+            "abc";
+        std::string const s2 =
+            "GET /b HTTP/1.0\r\n"
+            "Host: x\r\n"
+            "\r\n";
+        p.write(buffer(s1), ec);
+        BEAST_EXPECT(! ec);
+        BEAST_EXPECT(p.complete());
+        BEAST_EXPECT(p.content_length() == 3);
+        p.reset();
+        BEAST_EXPECT(! p.complete());
+        BEAST_EXPECT(p.get().fields.empty());
+        auto const n = p.write(buffer(s2), ec);
+        BEAST_EXPECT(! ec);
+        BEAST_EXPECT(p.complete());
+        BEAST_EXPECT(n == s2.size());
+        BEAST_EXPECT(p.content_length() == no_content_length);
+        auto const& m = p.get();
+        BEAST_EXPECT(m.method == "GET");
+        BEAST_EXPECT(m.url == "/b");
+        BEAST_EXPECT(m.version == 10);
+        BEAST_EXPECT(m.fields.size() == 1);
+        BEAST_EXPECT(within(m.url, s2));
+    }
+
+    void
+    run() override
+    {
+        testRequest();
+        testResponse();
+        testIncremental();
+        testNonContiguous();
+        testLimit();
+        testReset();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(view_parser_v1,http,beast);
+
+} // http
+} // beast
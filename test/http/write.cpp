@@ -14,6 +14,7 @@
 #include <beast/http/string_body.hpp>
 #include <beast/http/write.hpp>
 #include <beast/core/error.hpp>
+#include <beast/core/detail/ci_char_traits.hpp>
 #include <beast/core/streambuf.hpp>
 #include <beast/core/to_string.hpp>
 #include <beast/test/fail_stream.hpp>
@@ -22,6 +23,7 @@
 #include <boost/asio/error.hpp>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace beast {
 namespace http {
@@ -609,6 +611,128 @@ public:
             "GET / HTTP/1.1\r\nUser-Agent: test\r\nContent-Length: 1\r\n\r\n*");
     }
 
+    // A field sequence offering only the interface by name
+    class name_headers
+    {
+    public:
+        class value_type
+        {
+            std::string name_;
+            std::string value_;
+
+        public:
+            value_type(boost::string_ref const& name,
+                    boost::string_ref const& value)
+                : name_(name.data(), name.size())
+                , value_(value.data(), value.size())
+            {
+            }
+
+            boost::string_ref
+            name() const
+            {
+                return name_;
+            }
+
+            boost::string_ref
+            value() const
+            {
+                return value_;
+            }
+        };
+
+        using iterator =
+            std::vector<value_type>::const_iterator;
+
+        using const_iterator = iterator;
+
+        iterator
+        begin() const
+        {
+            return v_.begin();
+        }
+
+        iterator
+        end() const
+        {
+            return v_.end();
+        }
+
+        bool
+        exists(boost::string_ref const& name) const
+        {
+            return find(name) != end();
+        }
+
+        iterator
+        find(boost::string_ref const& name) const
+        {
+            for(auto it = begin(); it != end(); ++it)
+                if(beast::detail::ci_equal(it->name(), name))
+                    return it;
+            return end();
+        }
+
+        boost::string_ref
+        operator[](boost::string_ref const& name) const
+        {
+            auto const it = find(name);
+            if(it == end())
+                return {};
+            return it->value();
+        }
+
+        void
+        insert(boost::string_ref const& name,
+            boost::string_ref const& value)
+        {
+            v_.emplace_back(name, value);
+        }
+
+    private:
+        std::vector<value_type> v_;
+    };
+
+    void testNameHeaders()
+    {
+        {
+            message_v1<true, string_body, name_headers> m;
+            m.method = "GET";
+            m.url = "/";
+            m.version = 11;
+            m.headers.insert("User-Agent", "test");
+            m.body = "*";
+            prepare(m);
+            BEAST_EXPECT(is_keep_alive(m));
+            BEAST_EXPECT(! is_upgrade(m));
+            BEAST_EXPECT(str(m) ==
+                "GET / HTTP/1.1\r\n"
+                "User-Agent: test\r\n"
+                "Content-Length: 1\r\n"
+                "\r\n"
+                "*");
+        }
+        {
+            message_v1<true, empty_body, name_headers> m;
+            m.method = "GET";
+            m.url = "/";
+            m.version = 11;
+            prepare(m, connection::close);
+            BEAST_EXPECT(m.headers["Connection"] == "close");
+            BEAST_EXPECT(! is_keep_alive(m));
+        }
+        {
+            message_v1<false, empty_body, name_headers> m;
+            m.status = 101;
+            m.reason = "Switching Protocols";
+            m.version = 11;
+            m.headers.insert("Upgrade", "test");
+            prepare(m, connection::upgrade);
+            BEAST_EXPECT(is_upgrade(m));
+            BEAST_EXPECT(m.headers["Connection"] == "upgrade");
+        }
+    }
+
     void testOstream()
     {
         message_v1<true, string_body, headers> m;
@@ -640,6 +764,7 @@ public:
             this, std::placeholders::_1));
         testOutput();
         testConvert();
+        testNameHeaders();
         testOstream();
     }
 };
@@ -9,6 +9,8 @@
 #include <beast/websocket/detail/mask.hpp>
 
 #include <beast/unit_test/suite.hpp>
+#include <algorithm>
+#include <array>
 
 namespace beast {
 namespace websocket {
@@ -35,10 +37,168 @@ public:
         }
     };
 
-    void run() override
+    // Fills the seed with zeroes
+    struct zero_seed
+    {
+        template<class It>
+        void
+        generate(It first, It last)
+        {
+            std::fill(first, last, 0);
+        }
+    };
+
+    void
+    testMaskgen()
     {
         maskgen_t<test_generator> mg;
         BEAST_EXPECT(mg() != 0);
+
+        // rfc7539 appendix A.1, test vectors #1 and #2
+        chacha20 g;
+        zero_seed ss;
+        g.seed(ss);
+        BEAST_EXPECT(g() == 0xade0b876);
+        for(int i = 1; i < 15; ++i)
+            g();
+        BEAST_EXPECT(g() == 0x8665eeb2);
+        BEAST_EXPECT(g() == 0xbee7079f);
+
+        maskgen_t<chacha20> mg2;
+        BEAST_EXPECT(mg2() != 0);
+        BEAST_EXPECT(thread_maskgen()() != 0);
+    }
+
+    // Compare a kernel against the byte at a time reference,
+    // splitting the input at every position to check that
+    // the key rotates correctly across buffer boundaries.
+    void
+    testKernel(char const* name, mask_kernel_type f)
+    {
+        testcase << name;
+        std::uint32_t const key = 0xd1c2b3a4;
+        std::array<std::uint8_t, 256 + 64> buf;
+        for(std::size_t i = 0; i < buf.size(); ++i)
+            buf[i] = static_cast<std::uint8_t>(i * 7);
+        for(std::size_t off = 0; off < 32; ++off)
+        {
+            for(std::size_t n = 0; n <= 256; n += (n < 72 ? 1 : 23))
+            {
+                std::array<std::uint8_t, 256 + 64> v0 = buf;
+                std::uint64_t k0;
+                prepare_key(k0, key);
+                mask_inplace_general(boost::asio::mutable_buffer{
+                    v0.data() + off, n}, k0);
+                for(std::size_t split = 0; split <= n;
+                    split += (split < 40 ? 1 : 17))
+                {
+                    std::array<std::uint8_t, 256 + 64> v1 = buf;
+                    std::uint32_t k1 = key;
+                    f(v1.data() + off, split, k1);
+                    f(v1.data() + off + split, n - split, k1);
+                    BEAST_EXPECT(v0 == v1);
+                    BEAST_EXPECT(k1 == static_cast<std::uint32_t>(k0));
+                }
+            }
+        }
+    }
+
+    // Compare a copying kernel against the in place reference,
+    // with the source and destination at different alignments.
+    void
+    testCopyKernel(char const* name, mask_copy_kernel_type f)
+    {
+        testcase << name;
+        std::uint32_t const key = 0xd1c2b3a4;
+        std::array<std::uint8_t, 256 + 64> buf;
+        for(std::size_t i = 0; i < buf.size(); ++i)
+            buf[i] = static_cast<std::uint8_t>(i * 7);
+        for(std::size_t off = 0; off < 32; off += 3)
+        {
+            for(std::size_t n = 0; n <= 256; n += (n < 72 ? 1 : 23))
+            {
+                std::array<std::uint8_t, 256 + 64> v0 = buf;
+                std::uint64_t k0;
+                prepare_key(k0, key);
+                mask_inplace_general(boost::asio::mutable_buffer{
+                    v0.data(), n}, k0);
+                for(std::size_t split = 0; split <= n;
+                    split += (split < 40 ? 1 : 17))
+                {
+                    std::array<std::uint8_t, 256 + 64> v1{};
+                    std::uint32_t k1 = key;
+                    f(v1.data() + off, buf.data(), split, k1);
+                    f(v1.data() + off + split,
+                        buf.data() + split, n - split, k1);
+                    BEAST_EXPECT(std::equal(v0.begin(),
+                        v0.begin() + n, v1.begin() + off));
+                    BEAST_EXPECT(k1 == static_cast<std::uint32_t>(k0));
+                }
+            }
+        }
+    }
+
+    void
+    testMaskInplace()
+    {
+        testcase("mask_inplace");
+        std::uint32_t const key = 0x01234567;
+        std::array<std::uint8_t, 1000> buf;
+        for(std::size_t i = 0; i < buf.size(); ++i)
+            buf[i] = static_cast<std::uint8_t>(i);
+        for(std::size_t n = 0; n < 200; n += 3)
+        {
+            auto v0 = buf;
+            auto v1 = buf;
+            auto v2 = buf;
+            std::uint32_t k0 = key;
+            std::uint32_t k1 = key;
+            std::uint64_t k2;
+            prepare_key(k2, key);
+            std::array<boost::asio::mutable_buffer, 3> b1{{
+                {v1.data() + 1, n}, {v1.data() + 1 + n, 7},
+                {v1.data() + 8 + n, 700}}};
+            std::array<boost::asio::mutable_buffer, 3> b2{{
+                {v2.data() + 1, n}, {v2.data() + 1 + n, 7},
+                {v2.data() + 8 + n, 700}}};
+            mask_inplace_general(boost::asio::mutable_buffer{
+                v0.data() + 1, n + 707}, k0);
+            mask_inplace(b1, k1);
+            mask_inplace(b2, k2);
+            BEAST_EXPECT(v0 == v1);
+            BEAST_EXPECT(v0 == v2);
+            BEAST_EXPECT(k0 == k1);
+            BEAST_EXPECT(k0 == static_cast<std::uint32_t>(k2));
+            // masking twice restores the original
+            k1 = key;
+            mask_inplace(b1, k1);
+            BEAST_EXPECT(v1 == buf);
+        }
+    }
+
+    void run() override
+    {
+        testMaskgen();
+        testKernel("bytes", &mask_bytes);
+        testKernel("word", &mask_bytes_word<>);
+    #if BEAST_SIMD_X86
+        auto const& ci = beast::detail::get_cpu_info();
+        if(ci.sse2)
+            testKernel("sse2", &mask_bytes_sse2<>);
+        if(ci.avx2)
+            testKernel("avx2", &mask_bytes_avx2<>);
+    #endif
+        testKernel("dispatch", mask_kernel());
+        testCopyKernel("copy bytes", &mask_copy_bytes);
+        testCopyKernel("copy word", &mask_copy_word<>);
+    #if BEAST_SIMD_X86
+        if(ci.sse2)
+            testCopyKernel("copy sse2", &mask_copy_sse2<>);
+        if(ci.avx2)
+            testCopyKernel("copy avx2", &mask_copy_avx2<>);
+    #endif
+        testCopyKernel("copy dispatch", mask_copy_kernel());
+        testMaskInplace();
     }
 };
 
@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/websocket/detail/op_pool.hpp>
+
+#include <beast/unit_test/suite.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+class op_pool_test : public beast::unit_test::suite
+{
+public:
+    void testReuse()
+    {
+        op_pool pool;
+        auto const p1 = pool.allocate(100);
+        auto const p2 = pool.allocate(200);
+        BEAST_EXPECT(p1 != p2);
+        pool.deallocate(p1, 100);
+        pool.deallocate(p2, 200);
+        // smaller or equal requests reuse a block
+        BEAST_EXPECT(pool.allocate(200) == p2);
+        BEAST_EXPECT(pool.allocate(50) == p1);
+        pool.deallocate(p1, 50);
+        pool.deallocate(p2, 200);
+        // a larger request grows a free block
+        auto const p3 = pool.allocate(1000);
+        pool.deallocate(p3, 1000);
+        BEAST_EXPECT(pool.allocate(1000) == p3);
+        pool.deallocate(p3, 1000);
+    }
+
+    void testOverflow()
+    {
+        op_pool pool;
+        std::vector<void*> v;
+        for(std::size_t i = 0; i < 100; ++i)
+            v.push_back(pool.allocate(16));
+        std::sort(v.begin(), v.end());
+        BEAST_EXPECT(std::adjacent_find(
+            v.begin(), v.end()) == v.end());
+        for(auto p : v)
+            pool.deallocate(p, 16);
+    }
+
+    void testAlloc()
+    {
+        auto pool = std::make_shared<op_pool>();
+        op_alloc<int> a{pool};
+        op_alloc<char> b{a};
+        BEAST_EXPECT(a == b);
+        BEAST_EXPECT(a != op_alloc<int>{
+            std::make_shared<op_pool>()});
+        auto sp = std::allocate_shared<int>(a, 42);
+        BEAST_EXPECT(*sp == 42);
+        pool.reset();
+        // the pool outlives its last owner
+        sp.reset();
+        pass();
+    }
+
+    // Threads grow and release blocks while others overflow to
+    // operator new, each checking that no other thread wrote
+    // into the memory it holds.
+    void testConcurrent()
+    {
+        op_pool pool;
+        std::atomic<bool> ok{true};
+        std::vector<std::thread> threads;
+        for(unsigned char id = 1; id <= 4; ++id)
+        {
+            threads.emplace_back(
+                [&pool, &ok, id]
+                {
+                    std::vector<std::pair<void*, std::size_t>> v;
+                    std::size_t size = 16;
+                    for(std::size_t i = 0; i < 20000; ++i)
+                    {
+                        size = 16 + (size * 7 + i) % 1024;
+                        auto const p = pool.allocate(size);
+                        std::memset(p, id, size);
+                        v.emplace_back(p, size);
+                        if(v.size() < 8)
+                            continue;
+                        for(auto const& e : v)
+                        {
+                            auto const c = static_cast<
+                                unsigned char const*>(e.first);
+                            if(c[0] != id || c[e.second - 1] != id)
+                                ok = false;
+                            pool.deallocate(e.first, e.second);
+                        }
+                        v.clear();
+                    }
+                    for(auto const& e : v)
+                        pool.deallocate(e.first, e.second);
+                });
+        }
+        for(auto& t : threads)
+            t.join();
+        BEAST_EXPECT(ok);
+    }
+
+    void run() override
+    {
+        testReuse();
+        testOverflow();
+        testAlloc();
+        testConcurrent();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(op_pool,websocket,beast);
+
+} // detail
+} // websocket
+} // beast
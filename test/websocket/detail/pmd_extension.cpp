@@ -0,0 +1,293 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/websocket/detail/pmd_extension.hpp>
+
+#include <beast/unit_test/suite.hpp>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+class pmd_extension_test : public beast::unit_test::suite
+{
+public:
+    static
+    pmd_offer
+    settings(int server_bits = 15, int client_bits = 15)
+    {
+        pmd_offer ours;
+        ours.server_max_window_bits = server_bits;
+        ours.client_max_window_bits = client_bits;
+        return ours;
+    }
+
+    void testRead()
+    {
+        auto const good =
+            [&](std::string const& s)
+            {
+                pmd_offer offer;
+                ext_reader r{s};
+                boost::string_ref token;
+                expect(r.next(token) &&
+                    pmd_read(offer, r), s);
+                return offer;
+            };
+        auto const bad =
+            [&](std::string const& s)
+            {
+                pmd_offer offer;
+                ext_reader r{s};
+                boost::string_ref token;
+                expect(! r.next(token) ||
+                    ! pmd_read(offer, r), s);
+            };
+
+        BEAST_EXPECT(good("permessage-deflate").accept);
+        BEAST_EXPECT(good("permessage-deflate; server_max_window_bits=10")
+            .server_max_window_bits == 10);
+        BEAST_EXPECT(good("permessage-deflate; server_max_window_bits=\"8\"")
+            .server_max_window_bits == 8);
+        BEAST_EXPECT(good("permessage-deflate; client_max_window_bits")
+            .client_max_window_bits == -1);
+        BEAST_EXPECT(good("permessage-deflate; CLIENT_MAX_WINDOW_BITS=15")
+            .client_max_window_bits == 15);
+        BEAST_EXPECT(good("permessage-deflate; server_no_context_takeover")
+            .server_no_context_takeover);
+        BEAST_EXPECT(good("permessage-deflate; client_no_context_takeover")
+            .client_no_context_takeover);
+
+        bad("permessage-deflate; server_max_window_bits");
+        bad("permessage-deflate; server_max_window_bits=7");
+        bad("permessage-deflate; server_max_window_bits=16");
+        bad("permessage-deflate; server_max_window_bits=010");
+        bad("permessage-deflate; server_max_window_bits=1x");
+        bad("permessage-deflate; server_max_window_bits=9; server_max_window_bits=9");
+        bad("permessage-deflate; client_max_window_bits=100");
+        bad("permessage-deflate; client_max_window_bits; client_max_window_bits");
+        bad("permessage-deflate; server_no_context_takeover=1");
+        bad("permessage-deflate; client_no_context_takeover; client_no_context_takeover");
+        bad("permessage-deflate; unknown");
+        bad("permessage-deflate; server_max_window_bits=");
+        bad("permessage-deflate; server_max_window_bits=\"9");
+        bad("permessage-deflate; ;");
+    }
+
+    void testWrite()
+    {
+        BEAST_EXPECT(pmd_offer_request(settings()) ==
+            "permessage-deflate; client_max_window_bits");
+        {
+            auto ours = settings(10, 9);
+            ours.server_no_context_takeover = true;
+            ours.client_no_context_takeover = true;
+            BEAST_EXPECT(pmd_offer_request(ours) ==
+                "permessage-deflate; server_max_window_bits=10; "
+                "client_max_window_bits=9; server_no_context_takeover; "
+                "client_no_context_takeover");
+        }
+    }
+
+    void testNegotiate()
+    {
+        pmd_offer config;
+
+        // no offer
+        BEAST_EXPECT(pmd_negotiate(config, "", settings()).empty());
+        BEAST_EXPECT(! config.accept);
+        BEAST_EXPECT(pmd_negotiate(config,
+            "x-webkit-deflate-frame", settings()).empty());
+        BEAST_EXPECT(! config.accept);
+
+        // plain offer
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate", settings()) ==
+                "permessage-deflate");
+        BEAST_EXPECT(config.accept);
+        BEAST_EXPECT(config.server_max_window_bits == 15);
+        BEAST_EXPECT(config.client_max_window_bits == 15);
+
+        // server window is limited without telling the client
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate", settings(10, 10)) ==
+                "permessage-deflate");
+        BEAST_EXPECT(config.server_max_window_bits == 10);
+        BEAST_EXPECT(config.client_max_window_bits == 15);
+
+        // client accepts a limit
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate; client_max_window_bits",
+                settings(15, 10)) ==
+            "permessage-deflate; client_max_window_bits=10");
+        BEAST_EXPECT(config.client_max_window_bits == 10);
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate; client_max_window_bits=9",
+                settings(15, 10)) == "permessage-deflate");
+        BEAST_EXPECT(config.client_max_window_bits == 9);
+
+        // client asks for a limit
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate; server_max_window_bits=12",
+                settings()) ==
+            "permessage-deflate; server_max_window_bits=12");
+        BEAST_EXPECT(config.server_max_window_bits == 12);
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate; server_max_window_bits=12",
+                settings(10, 15)) ==
+            "permessage-deflate; server_max_window_bits=10");
+        BEAST_EXPECT(config.server_max_window_bits == 10);
+
+        // context takeover
+        {
+            auto ours = settings();
+            ours.client_no_context_takeover = true;
+            BEAST_EXPECT(pmd_negotiate(config,
+                "permessage-deflate; server_no_context_takeover",
+                    ours) == "permessage-deflate; "
+                "server_no_context_takeover; "
+                "client_no_context_takeover");
+            BEAST_EXPECT(config.server_no_context_takeover);
+            BEAST_EXPECT(config.client_no_context_takeover);
+        }
+
+        // a client which can't be limited is declined
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate, "
+            "permessage-deflate; client_max_window_bits",
+                settings(10, 10), true) ==
+            "permessage-deflate; client_max_window_bits=10");
+        BEAST_EXPECT(config.accept);
+        BEAST_EXPECT(config.client_max_window_bits == 10);
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate", settings(10, 10), true).empty());
+        BEAST_EXPECT(! config.accept);
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate", settings(10, 15), true) ==
+                "permessage-deflate");
+        BEAST_EXPECT(config.accept);
+
+        // first acceptable offer wins
+        BEAST_EXPECT(pmd_negotiate(config,
+            "permessage-deflate; server_max_window_bits=8, "
+            "permessage-deflate; bogus, "
+            "permessage-deflate; server_no_context_takeover, "
+            "permessage-deflate", settings()) ==
+            "permessage-deflate; server_no_context_takeover");
+        BEAST_EXPECT(config.accept);
+    }
+
+    void testLimit()
+    {
+        BEAST_EXPECT(pmd_memory(15, 15, 8) == 302080);
+        BEAST_EXPECT(pmd_memory(9, 9, 1) == 10752);
+        {
+            // windows are lowered first
+            int s = 15, c = 15, m = 4;
+            BEAST_EXPECT(pmd_limit(s, c, m, 32 * 1024));
+            BEAST_EXPECT(s == 11 && c == 11 && m == 4);
+            BEAST_EXPECT(pmd_memory(s, c, m) <= 32 * 1024);
+        }
+        {
+            // then the memory level
+            int s = 15, c = 15, m = 4;
+            BEAST_EXPECT(pmd_limit(s, c, m, 16 * 1024));
+            BEAST_EXPECT(s == 10 && c == 10 && m == 3);
+        }
+        {
+            // smaller settings are kept
+            int s = 9, c = 15, m = 4;
+            BEAST_EXPECT(pmd_limit(s, c, m, 32 * 1024));
+            BEAST_EXPECT(s == 9 && c == 11 && m == 4);
+            s = 15, c = 15, m = 8;
+            BEAST_EXPECT(pmd_limit(s, c, m, 1024 * 1024));
+            BEAST_EXPECT(s == 15 && c == 15 && m == 8);
+        }
+        {
+            // too small
+            int s = 15, c = 15, m = 4;
+            BEAST_EXPECT(! pmd_limit(s, c, m, 10000));
+        }
+    }
+
+    void testAccept()
+    {
+        pmd_offer config;
+
+        // not accepted
+        BEAST_EXPECT(pmd_accept(config, "", settings()));
+        BEAST_EXPECT(! config.accept);
+
+        BEAST_EXPECT(pmd_accept(config,
+            "permessage-deflate", settings()));
+        BEAST_EXPECT(config.accept);
+        BEAST_EXPECT(config.server_max_window_bits == 15);
+        BEAST_EXPECT(config.client_max_window_bits == 15);
+
+        BEAST_EXPECT(pmd_accept(config,
+            "permessage-deflate; server_max_window_bits=8; "
+            "client_max_window_bits=10; "
+            "server_no_context_takeover",
+                settings(10, 15)));
+        BEAST_EXPECT(config.server_max_window_bits == 8);
+        BEAST_EXPECT(config.client_max_window_bits == 10);
+        BEAST_EXPECT(config.server_no_context_takeover);
+        BEAST_EXPECT(! config.client_no_context_takeover);
+
+        // our own preference applies
+        {
+            auto ours = settings(15, 12);
+            ours.client_no_context_takeover = true;
+            BEAST_EXPECT(pmd_accept(config,
+                "permessage-deflate", ours));
+            BEAST_EXPECT(config.client_max_window_bits == 12);
+            BEAST_EXPECT(config.client_no_context_takeover);
+        }
+
+        // invalid responses
+        BEAST_EXPECT(! pmd_accept(config,
+            "permessage-deflate, permessage-deflate", settings()));
+        BEAST_EXPECT(! pmd_accept(config,
+            "permessage-deflate; bogus", settings()));
+        BEAST_EXPECT(! pmd_accept(config,
+            "x-webkit-deflate-frame", settings()));
+        BEAST_EXPECT(! pmd_accept(config,
+            "permessage-deflate; client_max_window_bits", settings()));
+        BEAST_EXPECT(! pmd_accept(config,
+            "permessage-deflate; client_max_window_bits=8", settings()));
+        BEAST_EXPECT(! pmd_accept(config,
+            "permessage-deflate; client_max_window_bits=12",
+                settings(15, 10)));
+        BEAST_EXPECT(! pmd_accept(config,
+            "permessage-deflate; server_max_window_bits=12",
+                settings(10, 15)));
+
+        // a reduced server window must be acknowledged
+        BEAST_EXPECT(! pmd_accept(config,
+            "permessage-deflate", settings(10, 15)));
+        BEAST_EXPECT(! config.accept);
+        BEAST_EXPECT(! pmd_accept(config,
+            "permessage-deflate; client_max_window_bits=10",
+                settings(12, 12)));
+    }
+
+    void run() override
+    {
+        testRead();
+        testWrite();
+        testNegotiate();
+        testLimit();
+        testAccept();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(pmd_extension,websocket,beast);
+
+} // detail
+} // websocket
+} // beast
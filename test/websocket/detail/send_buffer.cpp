@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/websocket/detail/send_buffer.hpp>
+
+#include <beast/core/to_string.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <string>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+class send_buffer_test : public beast::unit_test::suite
+{
+public:
+    static
+    std::shared_ptr<shared_frame const>
+    make_frame(std::string const& s)
+    {
+        auto const p = std::make_shared<shared_frame>();
+        p->op = opcode::text;
+        p->header_size = 0;
+        p->size = s.size();
+        p->data.reset(new std::uint8_t[s.size()]);
+        std::copy(s.begin(), s.end(), p->data.get());
+        return p;
+    }
+
+    static
+    void
+    append(send_buffer& sb, std::string const& s)
+    {
+        using boost::asio::buffer;
+        using boost::asio::buffer_copy;
+        sb.commit(buffer_copy(
+            sb.prepare(s.size()), buffer(s)));
+    }
+
+    void testSplice()
+    {
+        using boost::asio::buffer_size;
+        auto const f1 = make_frame("[one]");
+        auto const f2 = make_frame("[two]");
+        send_buffer sb;
+        expect(buffer_size(sb.data()) == 0);
+        sb.append(f1);
+        append(sb, "abc");
+        sb.append(f2);
+        sb.append(f1);
+        append(sb, "def");
+        expect(sb.size() == 21);
+        expect(to_string(sb.data()) ==
+            "[one]abc[two][one]def");
+        sb.clear();
+        expect(sb.size() == 0);
+        expect(buffer_size(sb.data()) == 0);
+        append(sb, "xyz");
+        sb.append(f2);
+        expect(to_string(sb.data()) == "xyz[two]");
+    }
+
+    void testBlocks()
+    {
+        // Frames land inside and on the edges
+        // of the streambuf's storage blocks.
+        auto const f = make_frame("*");
+        for(std::size_t i = 0; i < 40; ++i)
+        {
+            send_buffer sb;
+            std::string s;
+            for(std::size_t j = 0; j < 40; ++j)
+            {
+                std::string const t(i + j * 37, 'a' + j % 26);
+                append(sb, t);
+                s += t;
+                sb.append(f);
+                s += "*";
+            }
+            expect(sb.size() == s.size());
+            expect(to_string(sb.data()) == s);
+        }
+    }
+
+    void run() override
+    {
+        testSplice();
+        testBlocks();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(send_buffer,websocket,beast);
+
+} // detail
+} // websocket
+} // beast
@@ -0,0 +1,222 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/websocket/detail/timer_wheel.hpp>
+
+#include <beast/unit_test/suite.hpp>
+#include <functional>
+#include <string>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+class timer_wheel_test : public beast::unit_test::suite
+{
+public:
+    // Records its name when it expires
+    class timer : public timer_wheel::hook
+    {
+        std::string& log_;
+        char name_;
+
+    public:
+        std::function<void()> f;
+
+        timer(std::string& log, char name)
+            : log_(log)
+            , name_(name)
+        {
+        }
+
+    private:
+        void
+        on_expire() override
+        {
+            log_ += name_;
+            if(f)
+                f();
+        }
+    };
+
+    static
+    void
+    advance(timer_wheel& w, std::size_t n)
+    {
+        while(n--)
+            w.advance();
+    }
+
+    void
+    testExpire()
+    {
+        std::string log;
+        timer_wheel w(4);
+        timer a(log, 'a');
+        timer b(log, 'b');
+        timer c(log, 'c');
+        timer d(log, 'd');
+        w.insert(a, 2);
+        w.insert(b, 1);
+        w.insert(c, 6);     // one turn of the wheel
+        w.insert(d, 0);     // same as one tick
+        expect(w.size() == 4);
+        w.advance();
+        expect(log == "bd");
+        expect(! b.linked());
+        expect(a.linked());
+        w.advance();
+        expect(log == "bda");
+        advance(w, 3);
+        expect(log == "bda");
+        expect(c.linked());
+        w.advance();
+        expect(log == "bdac");
+        expect(w.size() == 0);
+    }
+
+    void
+    testCancel()
+    {
+        std::string log;
+        timer_wheel w(8);
+        timer a(log, 'a');
+        timer b(log, 'b');
+        w.insert(a, 3);
+        w.insert(b, 3);
+        a.cancel();
+        expect(! a.linked());
+        expect(w.size() == 1);
+        {
+            // destroying a hook removes it
+            timer c(log, 'c');
+            w.insert(c, 1);
+        }
+        expect(w.size() == 1);
+        {
+            // moving a hook removes both
+            timer e(log, 'e');
+            w.insert(e, 2);
+            timer_wheel::hook& h = e;
+            timer f(log, 'f');
+            static_cast<timer_wheel::hook&>(f) = std::move(h);
+            expect(! e.linked());
+        }
+        advance(w, 8);
+        expect(log == "b");
+        w.insert(a, 1);
+        w.clear();
+        expect(w.size() == 0);
+        expect(! a.linked());
+        w.advance();
+        expect(log == "b");
+    }
+
+    void
+    testReschedule()
+    {
+        std::string log;
+        timer_wheel w(4);
+        timer a(log, 'a');
+        timer b(log, 'b');
+        w.insert(a, 1);
+        w.insert(b, 2);
+        // the hook moves to the new time
+        w.insert(a, 3);
+        expect(w.size() == 2);
+        w.advance();
+        expect(log == "");
+        w.advance();
+        expect(log == "b");
+        w.advance();
+        expect(log == "ba");
+        expect(w.size() == 0);
+        {
+            // from another wheel
+            timer_wheel w2(4);
+            w2.insert(a, 1);
+            w.insert(a, 1);
+            expect(w2.size() == 0);
+            expect(w.size() == 1);
+        }
+        w.clear();
+        expect(! a.linked());
+    }
+
+    void
+    testTake()
+    {
+        std::string log;
+        timer_wheel w(4);
+        timer a(log, 'a');
+        timer b(log, 'b');
+        timer c(log, 'c');
+        timer d(log, 'd');
+        w.insert(a, 1);
+        w.insert(b, 6);
+        w.insert(c, 1);
+        // the new hook keeps the remaining delay
+        d.take(b);
+        expect(! b.linked());
+        expect(d.linked());
+        expect(w.size() == 3);
+        {
+            // taking an unscheduled hook does nothing
+            timer e(log, 'e');
+            b.take(e);
+            expect(! b.linked());
+        }
+        w.advance();
+        expect(log == "ac");
+        advance(w, 4);
+        expect(log == "ac");
+        w.advance();
+        expect(log == "acd");
+        expect(w.size() == 0);
+    }
+
+    void
+    testReinsert()
+    {
+        std::string log;
+        timer_wheel w(3);
+        timer a(log, 'a');
+        timer b(log, 'b');
+        int n = 0;
+        // a hook may schedule itself, and cancel others
+        a.f =
+            [&]
+            {
+                if(++n < 3)
+                    w.insert(a, 2);
+                else
+                    b.cancel();
+            };
+        w.insert(a, 2);
+        w.insert(b, 7);
+        advance(w, 6);
+        expect(log == "aaa");
+        expect(! b.linked());
+        expect(w.size() == 0);
+    }
+
+    void run() override
+    {
+        testExpire();
+        testCancel();
+        testReschedule();
+        testTake();
+        testReinsert();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(timer_wheel,websocket,beast);
+
+} // detail
+} // websocket
+} // beast
@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/websocket/detail/upgrade_parser.hpp>
+
+#include <beast/unit_test/suite.hpp>
+#include <boost/asio/buffer.hpp>
+#include <string>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+class upgrade_parser_test : public beast::unit_test::suite
+{
+public:
+    // Parse the message in every possible pair of pieces
+    template<bool isRequest, class Check>
+    void
+    check(std::string const& s, Check const& f)
+    {
+        using boost::asio::buffer;
+        for(std::size_t i = 0; i < s.size(); ++i)
+        {
+            upgrade_parser<isRequest> p;
+            error_code ec;
+            auto const n = p.write(buffer(s.data(), i), ec);
+            if(! expect(! ec, ec.message()))
+                return;
+            p.write(buffer(s.data() + n, s.size() - n), ec);
+            if(! expect(! ec, ec.message()))
+                return;
+            if(! BEAST_EXPECT(p.complete()))
+                return;
+            f(p);
+        }
+    }
+
+    void
+    testRequest()
+    {
+        check<true>(
+            "GET /chat HTTP/1.1\r\n"
+            "Host: server.example.com\r\n"
+            "User-Agent: test\r\n"
+            "upgrade: websocket\r\n"
+            "Connection: keep-alive, Upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "SEC-WEBSOCKET-EXTENSIONS: x-webkit-deflate-frame\r\n"
+            "\r\n",
+            [&](upgrade_parser<true> const& p)
+            {
+                auto const& f = p.fields();
+                BEAST_EXPECT(p.method() == "GET");
+                BEAST_EXPECT(p.version() == 11);
+                BEAST_EXPECT(p.connection_upgrade());
+                BEAST_EXPECT(! p.connection_close());
+                BEAST_EXPECT(p.upgrade());
+                BEAST_EXPECT(f.host.str() == "server.example.com");
+                BEAST_EXPECT(f.upgrade.str() == "websocket");
+                BEAST_EXPECT(f.key.str() == "dGhlIHNhbXBsZSBub25jZQ==");
+                BEAST_EXPECT(f.version.str() == "13");
+                BEAST_EXPECT(f.extensions.str() ==
+                    "permessage-deflate, x-webkit-deflate-frame");
+                BEAST_EXPECT(! f.accept.exists());
+            });
+
+        // empty values, unknown and oversized names
+        check<true>(
+            "GET / HTTP/1.0\r\n"
+            "X-Empty:\r\n"
+            "Host:\r\n"
+            "X-A-Very-Long-Field-Name-Which-Is-Ignored: 1\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n",
+            [&](upgrade_parser<true> const& p)
+            {
+                auto const& f = p.fields();
+                BEAST_EXPECT(p.version() == 10);
+                BEAST_EXPECT(! p.connection_upgrade());
+                BEAST_EXPECT(f.host.exists());
+                BEAST_EXPECT(f.host.str().empty());
+                BEAST_EXPECT(f.version.str() == "13");
+                BEAST_EXPECT(! f.key.exists());
+            });
+
+        // oversized value
+        check<true>(
+            "GET / HTTP/1.1\r\n"
+            "Sec-WebSocket-Key: " + std::string(40, 'A') + "\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n",
+            [&](upgrade_parser<true> const& p)
+            {
+                auto const& f = p.fields();
+                BEAST_EXPECT(f.key.truncated());
+                BEAST_EXPECT(f.key.str() == std::string(32, 'A'));
+                BEAST_EXPECT(f.version.str() == "13");
+            });
+    }
+
+    void
+    testResponse()
+    {
+        check<false>(
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: upgrade\r\n"
+            "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+            "\r\n",
+            [&](upgrade_parser<false> const& p)
+            {
+                auto const& f = p.fields();
+                BEAST_EXPECT(p.status_code() == 101);
+                BEAST_EXPECT(p.connection_upgrade());
+                BEAST_EXPECT(f.upgrade.str() == "websocket");
+                BEAST_EXPECT(f.accept.str() ==
+                    "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+                BEAST_EXPECT(! f.extensions.exists());
+            });
+
+        // the body is discarded
+        check<false>(
+            "HTTP/1.1 400 Bad Request\r\n"
+            "Content-Length: 5\r\n"
+            "Connection: close\r\n"
+            "\r\n"
+            "*****",
+            [&](upgrade_parser<false> const& p)
+            {
+                BEAST_EXPECT(p.status_code() == 400);
+                BEAST_EXPECT(! p.connection_upgrade());
+                BEAST_EXPECT(p.connection_close());
+            });
+    }
+
+    void
+    run() override
+    {
+        testRequest();
+        testResponse();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(upgrade_parser,websocket,beast);
+
+} // detail
+} // websocket
+} // beast
@@ -12,6 +12,7 @@
 #include <beast/core/streambuf.hpp>
 #include <beast/unit_test/suite.hpp>
 #include <array>
+#include <string>
 
 namespace beast {
 namespace websocket {
@@ -264,6 +265,52 @@ public:
         }
     }
 
+    void
+    testAsciiRuns()
+    {
+        // Invalid bytes and split sequences at every
+        // position relative to the block boundaries.
+        for(std::size_t n = 0; n < 100; ++n)
+        {
+            std::string s(n, 'a');
+            {
+                utf8_checker utf8;
+                BEAST_EXPECT(utf8.write(s.data(), s.size()));
+                BEAST_EXPECT(utf8.finish());
+            }
+            {
+                auto t = s + "\xff" + s;
+                utf8_checker utf8;
+                BEAST_EXPECT(! utf8.write(t.data(), t.size()));
+            }
+            {
+                // U+20AC EURO SIGN
+                auto t = s + "\xe2\x82\xac" + s;
+                for(std::size_t i = 0; i <= t.size(); ++i)
+                {
+                    utf8_checker utf8;
+                    BEAST_EXPECT(utf8.write(t.data(), i));
+                    BEAST_EXPECT(utf8.write(
+                        t.data() + i, t.size() - i));
+                    BEAST_EXPECT(utf8.finish());
+                }
+            }
+            {
+                // truncated sequence followed by ASCII
+                auto t = s + "\xe2\x82" + s + "a";
+                utf8_checker utf8;
+                BEAST_EXPECT(! utf8.write(t.data(), t.size()));
+            }
+            {
+                // truncated sequence at the end
+                auto t = s + "\xe2\x82";
+                utf8_checker utf8;
+                BEAST_EXPECT(utf8.write(t.data(), t.size()));
+                BEAST_EXPECT(! utf8.finish());
+            }
+        }
+    }
+
     void run() override
     {
         testOneByteSequence();
@@ -271,6 +318,7 @@ public:
         testThreeByteSequence();
         testFourByteSequence();
         testWithStreamBuffer();
+        testAsciiRuns();
     }
 };
 
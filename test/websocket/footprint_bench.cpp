@@ -0,0 +1,223 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <beast/websocket/stream.hpp>
+#include <beast/core/flat_streambuf.hpp>
+#include <beast/core/streambuf.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace beast {
+namespace websocket {
+
+/*  Per-connection memory budget
+
+    These limits apply to 64-bit builds. The size budget is checked
+    on every run. The memory used by live connections, which is the
+    stream object plus the heap it holds, including the memory held
+    by Boost.Asio for the socket and pending operations, is only
+    reported, because it depends on the platform and the allocator.
+
+    sizeof(stream<ip::tcp::socket>)             768 bytes
+
+    Idle connection, read pending               4 KB
+    Active connection, one message each way     8 KB
+
+    The send queue, the received close reason, the inflated view
+    buffer and the permessage-deflate state are allocated when first
+    needed, so connections which do not use them do not pay for them.
+*/
+class footprint_bench_test : public beast::unit_test::suite
+{
+public:
+    static std::size_t constexpr SizeBudget = 768;
+    static std::size_t constexpr Connections = 400;
+
+    using socket_type = boost::asio::ip::tcp::socket;
+    using endpoint_type = boost::asio::ip::tcp::endpoint;
+    using address_type = boost::asio::ip::address;
+
+    // Exposes the sizes of the members of stream_base
+    struct layout : detail::stream_base
+    {
+        template<class Log>
+        static
+        void
+        print(Log& log)
+        {
+            auto const row =
+                [&](char const* name, std::size_t n)
+                {
+                    log <<
+                        std::setw(36) << std::left << name <<
+                        std::setw(6) << std::right << n << "\n";
+                };
+            row("mask_gen", sizeof(maskgen_));
+            row("decorator_type", sizeof(d_));
+            row("pong_cb", sizeof(pong_cb_));
+            row("send_queue_cb", sizeof(sq_cb_));
+            row("frame_header", sizeof(rd_fh_));
+            row("prepared_key_type", sizeof(rd_key_));
+            row("utf8_checker", sizeof(rd_utf8_check_));
+            row("invokable (x3)", sizeof(rd_op_));
+            row("close_reason (on first use)",
+                sizeof(close_reason));
+            row("pmd_offer", sizeof(pmd_config_));
+            row("send_buffer (x2, on first use)",
+                sizeof(detail::send_buffer));
+            row("stream_base", sizeof(stream_base));
+        }
+    };
+
+    template<class Size>
+    void
+    row(std::string const& name, Size n)
+    {
+        log <<
+            std::setw(36) << std::left << name <<
+            std::setw(6) << std::right << n << "\n";
+    }
+
+    // Returns the number of bytes allocated on the heap, or zero.
+    // Pages touched by the process are not a useful measure here,
+    // since memory freed by one test is reused by the next.
+    static
+    std::size_t
+    allocated()
+    {
+    #if defined(__GLIBC__) && \
+        (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        auto const mi = mallinfo2();
+        return mi.uordblks + mi.hblkhd;
+    #elif defined(__GLIBC__)
+        auto const mi = mallinfo();
+        return static_cast<std::size_t>(mi.uordblks + mi.hblkhd);
+    #else
+        return 0;
+    #endif
+    }
+
+    void
+    testSizes()
+    {
+        testcase << "Layout";
+        layout::print(log);
+        row("streambuf", sizeof(streambuf));
+        row("flat_streambuf", sizeof(flat_streambuf));
+        row("dynabuf_readstream<socket>",
+            sizeof(dynabuf_readstream<socket_type, streambuf>));
+        row("permessage_deflate", sizeof(permessage_deflate));
+        row("socket", sizeof(socket_type));
+        row("stream<socket>", sizeof(stream<socket_type>));
+        row("stream<socket, flat_streambuf>",
+            sizeof(stream<socket_type, flat_streambuf>));
+        log.flush();
+        expect(sizeof(stream<socket_type>) <= SizeBudget,
+            "over budget");
+    }
+
+    template<class ReadBuffer>
+    void
+    testResident(std::string const& name)
+    {
+        using stream_type = stream<socket_type, ReadBuffer>;
+        testcase << "Per connection, " << name;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        std::vector<std::unique_ptr<stream_type>> v;
+        v.reserve(2 * Connections);
+        std::vector<streambuf> sb(2 * Connections);
+        std::vector<opcode> op(2 * Connections);
+        auto const n0 = allocated();
+        if(n0 == 0)
+        {
+            log << "heap size not available" << std::endl;
+            pass();
+            return;
+        }
+        for(std::size_t i = 0; i < Connections; ++i)
+        {
+            v.emplace_back(new stream_type(ios));
+            v.emplace_back(new stream_type(ios));
+            auto& c = *v[v.size() - 2];
+            auto& s = *v.back();
+            c.next_layer().connect(acceptor.local_endpoint());
+            acceptor.accept(s.next_layer());
+            s.async_accept([](error_code const&){});
+            c.async_handshake("localhost", "/",
+                [](error_code const&){});
+        }
+        ios.run();
+        ios.reset();
+        auto const per = [&](std::size_t n)
+            {
+                return sizeof(stream_type) + (n - n0) / v.size();
+            };
+        auto const n1 = allocated();
+        row("connected", per(n1));
+
+        // every stream waits for a message
+        std::size_t count = 0;
+        auto const read_all =
+            [&]
+            {
+                for(std::size_t i = 0; i < v.size(); ++i)
+                    v[i]->async_read(op[i], sb[i],
+                        [&, i](error_code const& ec)
+                        {
+                            // only the stream's memory is counted
+                            sb[i] = streambuf{};
+                            if(! ec)
+                                ++count;
+                        });
+            };
+        read_all();
+        ios.poll();
+        auto const n2 = allocated();
+        row("idle, read pending", per(n2));
+
+        // one message each way, then wait again
+        std::string const m(4000, '*');
+        for(auto& ws : v)
+            ws->async_write(boost::asio::buffer(m),
+                [](error_code const&){});
+        while(count < v.size())
+            ios.run_one();
+        read_all();
+        ios.poll();
+        auto const n3 = allocated();
+        row("active, read pending", per(n3));
+        log.flush();
+        BEAST_EXPECT(count == v.size());
+
+        for(auto& ws : v)
+            ws->next_layer().close();
+        ios.run();
+    }
+
+    void run() override
+    {
+        testSizes();
+        testResident<streambuf>("streambuf");
+        testResident<flat_streambuf>("flat_streambuf");
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(footprint_bench,websocket,beast);
+
+} // websocket
+} // beast
@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/websocket/frame_codec.hpp>
+
+#include <beast/unit_test/suite.hpp>
+#include <boost/asio/buffer.hpp>
+#include <string>
+#include <vector>
+
+namespace beast {
+namespace websocket {
+
+class frame_codec_test : public beast::unit_test::suite
+{
+public:
+    // What the decoder reported, in a form easy to compare
+    struct result
+    {
+        std::string text;   // events and payloads
+        close_code::value code = close_code::none;
+    };
+
+    // Feed the input to a decoder `chunk` bytes at a time
+    static
+    result
+    decode(role_type role, std::string s,
+        std::size_t chunk, std::size_t limit = 0)
+    {
+        using boost::asio::buffer_cast;
+        using boost::asio::buffer_size;
+        result r;
+        frame_decoder d{role};
+        if(limit)
+            d.read_message_max(limit);
+        std::size_t pos = 0;
+        std::string payload;
+        while(pos < s.size())
+        {
+            auto const n = std::min(chunk, s.size() - pos);
+            frame_decoder::event ev;
+            auto const used = d.write(
+                boost::asio::buffer(&s[pos], n), ev, r.code);
+            if(r.code != close_code::none)
+                return r;
+            pos += used;
+            auto const b = d.payload();
+            switch(ev)
+            {
+            case frame_decoder::event::need_more:
+                if(! used)
+                    return r;
+                break;
+
+            case frame_decoder::event::header:
+                break;
+
+            case frame_decoder::event::payload:
+                payload.append(buffer_cast<char const*>(b),
+                    buffer_size(b));
+                break;
+
+            case frame_decoder::event::control:
+                r.text += "[" + std::to_string(
+                    static_cast<int>(d.op())) + ":" +
+                        std::string(buffer_cast<char const*>(b),
+                            buffer_size(b)) + "]";
+                if(d.op() == opcode::close)
+                    r.text += std::to_string(d.reason().code) +
+                        std::string(d.reason().reason.data(),
+                            d.reason().reason.size());
+                break;
+            }
+            if(d.is_message_done())
+            {
+                r.text += std::string(d.op() == opcode::text ?
+                    "text:" : "binary:") + payload + ";";
+                payload.clear();
+            }
+        }
+        return r;
+    }
+
+    void
+    testRoundTrip()
+    {
+        for(auto role : {role_type::client, role_type::server})
+        {
+            auto const peer = role == role_type::client ?
+                role_type::server : role_type::client;
+            frame_encoder e{role};
+            std::string s;
+            auto const add =
+                [&](opcode op, bool fin, std::string const& p)
+                {
+                    std::vector<char> b(
+                        e.header_size(p.size()) + p.size());
+                    auto const n = e.frame(b.data(), op, fin,
+                        boost::asio::buffer(p));
+                    BEAST_EXPECT(n == b.size());
+                    s.append(b.data(), n);
+                };
+            add(opcode::text, true, "Hello");
+            add(opcode::binary, true, "");
+            add(opcode::text, false, "Hel");
+            add(opcode::ping, true, "*");
+            add(opcode::text, false, "");
+            add(opcode::text, true, "lo");
+            add(opcode::binary, true, std::string(200, 'x'));
+            add(opcode::binary, true, std::string(70000, 'y'));
+            {
+                char b[2 + 4 + 125];
+                s.append(b, e.close(b,
+                    close_reason{close_code::going_away, "bye"}));
+            }
+            std::string const expected =
+                "text:Hello;binary:;[9:*]text:Hello;binary:" +
+                std::string(200, 'x') + ";binary:" +
+                std::string(70000, 'y') + ";[8:\x03\xe9" + "bye]1001bye";
+            for(std::size_t chunk : {1, 2, 3, 7, 1000, 100000})
+            {
+                auto const r = decode(peer, s, chunk);
+                BEAST_EXPECT(r.code == close_code::none);
+                BEAST_EXPECT(r.text == expected);
+            }
+            // masked frames are rejected by clients and
+            // unmasked frames are rejected by servers
+            BEAST_EXPECT(decode(role, s, 100000).code ==
+                close_code::protocol_error);
+        }
+    }
+
+    void
+    testPieces()
+    {
+        // writing a frame in pieces gives the same
+        // result as writing it whole, for servers
+        frame_encoder e1{role_type::server};
+        frame_encoder e2{role_type::server};
+        std::string const p = "Hello, world";
+        char b1[64];
+        char b2[64];
+        auto const n1 = e1.frame(b1, opcode::binary, true,
+            boost::asio::buffer(p));
+        auto n2 = e2.header(b2, opcode::binary, true, p.size());
+        BEAST_EXPECT(e2.remain() == p.size());
+        n2 += e2.payload(b2 + n2, boost::asio::buffer(p.data(), 5));
+        n2 += e2.payload(b2 + n2, boost::asio::buffer(p.data() + 5, 7));
+        BEAST_EXPECT(e2.remain() == 0);
+        BEAST_EXPECT(std::string(b1, n1) == std::string(b2, n2));
+
+        // header sizes
+        frame_encoder c{role_type::client};
+        BEAST_EXPECT(c.header_size(0) == 6);
+        BEAST_EXPECT(c.header_size(126) == 8);
+        BEAST_EXPECT(c.header_size(65536) == 14);
+        BEAST_EXPECT(e1.header_size(125) == 2);
+        BEAST_EXPECT(c.header(b1, opcode::text, true, 65536) == 14);
+
+        // invalid frames
+        try
+        {
+            e1.header(b1, opcode::ping, false, 0);
+            fail();
+        }
+        catch(std::domain_error const&)
+        {
+            pass();
+        }
+        try
+        {
+            e1.header(b1, opcode::cont, true, 0);
+            fail();
+        }
+        catch(std::domain_error const&)
+        {
+            pass();
+        }
+    }
+
+    template<std::size_t N>
+    static
+    std::string
+    str(char const(&s)[N])
+    {
+        return std::string(s, N - 1);
+    }
+
+    void
+    testErrors()
+    {
+        auto const check =
+            [&](std::string const& s, close_code::value code,
+                std::size_t limit)
+            {
+                for(std::size_t chunk : {1, 100})
+                    BEAST_EXPECT(decode(role_type::client,
+                        s, chunk, limit).code == code);
+            };
+        // continuation without a message
+        check(str("\x80\x00"), close_code::protocol_error, 0);
+        // data frame while a continuation is expected
+        check(str("\x01\x00\x01\x00"), close_code::protocol_error, 0);
+        // reserved bits
+        check(str("\xc1\x00"), close_code::protocol_error, 0);
+        // fragmented control frame
+        check(str("\x09\x00"), close_code::protocol_error, 0);
+        // length not canonical
+        check(str("\x82\x7e\x00\x01\x00"), close_code::protocol_error, 0);
+        // invalid utf8
+        check(str("\x81\x02\xc3\x28"), close_code::bad_payload, 0);
+        // incomplete utf8 at the end of the message
+        check(str("\x01\x01\xc3\x80\x00"), close_code::bad_payload, 0);
+        // invalid close code
+        check(str("\x88\x02\x03\xed"), close_code::protocol_error, 0);
+        // message too big
+        check(str("\x02\x03***\x80\x03***"), close_code::too_big, 5);
+        check(str("\x82\x03***"), close_code::none, 5);
+    }
+
+    void
+    run() override
+    {
+        testRoundTrip();
+        testPieces();
+        testErrors();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(frame_codec,websocket,beast);
+
+} // websocket
+} // beast
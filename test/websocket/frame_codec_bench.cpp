@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <beast/websocket/frame_codec.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/asio/buffer.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace beast {
+namespace websocket {
+
+class frame_codec_bench_test : public beast::unit_test::suite
+{
+public:
+    static std::size_t constexpr Bytes = 64 * 1024 * 1024;
+    static std::size_t constexpr Trials = 5;
+
+    // Encode client frames of the given payload size,
+    // totalling at least Bytes of payload.
+    static
+    std::vector<char>
+    make_input(opcode op, std::size_t size)
+    {
+        frame_encoder e{role_type::client};
+        std::string const p(size, 'a');
+        std::vector<char> v;
+        std::vector<char> b(e.header_size(size) + size);
+        for(std::size_t n = 0; n < Bytes; n += size)
+            v.insert(v.end(), b.data(), b.data() + e.frame(
+                b.data(), op, true, boost::asio::buffer(p)));
+        return v;
+    }
+
+    void
+    testDecode(std::string const& name, opcode op, std::size_t size)
+    {
+        using namespace std::chrono;
+        using clock_type = std::chrono::high_resolution_clock;
+        auto const input = make_input(op, size);
+        std::vector<char> v;
+        std::size_t messages = 0;
+        duration<double> best{1e9};
+        for(std::size_t i = 0; i < Trials; ++i)
+        {
+            // decoding unmasks in place, start from a fresh copy
+            v = input;
+            frame_decoder d{role_type::server};
+            auto const t0 = clock_type::now();
+            auto p = v.data();
+            auto n = v.size();
+            messages = 0;
+            while(n > 0)
+            {
+                frame_decoder::event ev;
+                close_code::value code;
+                auto const used = d.write(
+                    boost::asio::buffer(p, n), ev, code);
+                if(code != close_code::none)
+                {
+                    fail("protocol error");
+                    return;
+                }
+                p += used;
+                n -= used;
+                if(d.is_message_done())
+                    ++messages;
+            }
+            auto const elapsed = duration_cast<
+                duration<double>>(clock_type::now() - t0);
+            if(elapsed < best)
+                best = elapsed;
+        }
+        BEAST_EXPECT(messages == (Bytes + size - 1) / size);
+        log <<
+            std::setw(24) << std::left << name <<
+            std::fixed << std::setprecision(0) <<
+            (input.size() / best.count() / (1024 * 1024)) << " MB/s, " <<
+            (messages / best.count()) << " frames/s" << std::endl;
+    }
+
+    void
+    run() override
+    {
+        pass();
+        testDecode("binary 16", opcode::binary, 16);
+        testDecode("binary 1024", opcode::binary, 1024);
+        testDecode("binary 65536", opcode::binary, 65536);
+        testDecode("text 1024", opcode::text, 1024);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(frame_codec_bench,websocket,beast);
+
+} // websocket
+} // beast
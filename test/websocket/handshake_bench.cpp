@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <beast/websocket/stream.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace beast {
+namespace websocket {
+
+class handshake_bench_test : public beast::unit_test::suite
+{
+public:
+    static std::size_t constexpr Connections = 5000;
+
+    using endpoint_type = boost::asio::ip::tcp::endpoint;
+    using address_type = boost::asio::ip::address;
+    using socket_type = boost::asio::ip::tcp::socket;
+
+    // Produces the same fields as the default, but
+    // forces the stream to build the messages.
+    struct default_like
+    {
+        template<class Message>
+        void
+        operator()(Message& m)
+        {
+            detail::default_decorator{}(m);
+        }
+    };
+
+    // Open a loopback connection and perform the opening
+    // handshake on both ends, returning the number of
+    // successful handshakes.
+    template<class Setup>
+    std::size_t
+    connect(boost::asio::io_service& ios,
+        boost::asio::ip::tcp::acceptor& acceptor,
+            Setup const& setup)
+    {
+        std::size_t n = 0;
+        stream<socket_type> server(ios);
+        stream<socket_type> client(ios);
+        setup(server);
+        setup(client);
+        acceptor.async_accept(server.next_layer(),
+            [&](error_code ec)
+            {
+                if(ec)
+                    return;
+                server.async_accept(
+                    [&](error_code ec)
+                    {
+                        if(! ec)
+                            ++n;
+                    });
+            });
+        client.next_layer().async_connect(
+            acceptor.local_endpoint(),
+            [&](error_code ec)
+            {
+                if(ec)
+                    return;
+                client.async_handshake("localhost", "/",
+                    [&](error_code ec)
+                    {
+                        if(! ec)
+                            ++n;
+                    });
+            });
+        ios.run();
+        ios.reset();
+        return n;
+    }
+
+    template<class Setup>
+    void
+    timedTest(std::string const& name, Setup const& setup)
+    {
+        using namespace std::chrono;
+        using clock_type = std::chrono::high_resolution_clock;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios, endpoint_type{
+            address_type::from_string("127.0.0.1"), 0});
+        std::size_t total = 0;
+        auto const t0 = clock_type::now();
+        for(std::size_t i = 0; i < Connections; ++i)
+            total += connect(ios, acceptor, setup);
+        auto const elapsed = duration_cast<
+            duration<double>>(clock_type::now() - t0);
+        log <<
+            std::setw(24) << std::left << name <<
+            std::fixed << std::setprecision(0) <<
+            (Connections / elapsed.count()) << " conn/s" << std::endl;
+        BEAST_EXPECT(total == 2 * Connections);
+    }
+
+    void
+    testHandshake()
+    {
+        testcase << "Loopback handshakes";
+        timedTest("default",
+            [](stream<socket_type>&)
+            {
+            });
+        timedTest("decorated",
+            [](stream<socket_type>& ws)
+            {
+                ws.set_option(decorate(default_like{}));
+            });
+    }
+
+    void run() override
+    {
+        pass();
+        testHandshake();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(handshake_bench,websocket,beast);
+
+} // websocket
+} // beast
@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <beast/websocket/detail/mask.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+class mask_bench_test : public beast::unit_test::suite
+{
+public:
+    static std::size_t constexpr Size = 64 * 1024;
+    static std::size_t constexpr Repeat = 20000;
+
+    std::vector<std::uint8_t> buf_;
+    std::vector<std::uint8_t> src_;
+
+    mask_bench_test()
+        : buf_(Size + 1)
+        , src_(Size + 1)
+    {
+    }
+
+    template<class Function>
+    void
+    timedTest(std::string const& name, Function&& f)
+    {
+        using namespace std::chrono;
+        using clock_type = std::chrono::high_resolution_clock;
+        // Start one byte in, so heads and tails are exercised
+        auto const p = buf_.data() + 1;
+        auto const t0 = clock_type::now();
+        for(std::size_t i = 0; i < Repeat; ++i)
+            f(p, Size);
+        auto const elapsed = duration_cast<
+            duration<double>>(clock_type::now() - t0);
+        auto const gbps = (double(Size) * Repeat) /
+            elapsed.count() / (1024. * 1024 * 1024);
+        log <<
+            std::setw(10) << std::left << name <<
+            std::fixed << std::setprecision(2) << gbps <<
+            " GB/s" << std::endl;
+    }
+
+    void
+    testKernel(std::string const& name, mask_kernel_type f)
+    {
+        std::uint32_t key = 0x12345678;
+        timedTest(name,
+            [&](std::uint8_t* p, std::size_t n)
+            {
+                f(p, n, key);
+            });
+    }
+
+    void
+    testSpeed()
+    {
+        testcase << "Mask speed test, " <<
+            ((Size * Repeat + 512 * 1024) / (1024 * 1024)) << "MB";
+        {
+            prepared_key_type key;
+            prepare_key(key, 0x12345678);
+            timedTest("general",
+                [&](std::uint8_t* p, std::size_t n)
+                {
+                    mask_inplace_general(
+                        boost::asio::mutable_buffer{p, n}, key);
+                });
+        }
+        testKernel("bytes", &mask_bytes);
+        testKernel("word", &mask_bytes_word<>);
+    #if BEAST_SIMD_X86
+        auto const& ci = beast::detail::get_cpu_info();
+        if(ci.sse2)
+            testKernel("sse2", &mask_bytes_sse2<>);
+        if(ci.avx2)
+            testKernel("avx2", &mask_bytes_avx2<>);
+    #endif
+        {
+            prepared_key_type key;
+            prepare_key(key, 0x12345678);
+            timedTest("dispatch",
+                [&](std::uint8_t* p, std::size_t n)
+                {
+                    mask_inplace(
+                        boost::asio::mutable_buffer{p, n}, key);
+                });
+        }
+        pass();
+    }
+
+    // Moving payload out of the read buffer: a copy
+    // followed by a pass in place, against one pass.
+    void
+    testCopySpeed()
+    {
+        testcase << "Mask copy speed test, " <<
+            ((Size * Repeat + 512 * 1024) / (1024 * 1024)) << "MB";
+        auto const src = src_.data();
+        {
+            prepared_key_type key;
+            prepare_key(key, 0x12345678);
+            timedTest("two pass",
+                [&](std::uint8_t* p, std::size_t n)
+                {
+                    std::memcpy(p, src, n);
+                    mask_inplace(
+                        boost::asio::mutable_buffer{p, n}, key);
+                });
+        }
+        {
+            prepared_key_type key;
+            prepare_key(key, 0x12345678);
+            timedTest("fused",
+                [&](std::uint8_t* p, std::size_t n)
+                {
+                    mask_copy(p, src, n, key);
+                });
+        }
+        pass();
+    }
+
+    void run() override
+    {
+        pass();
+        testSpeed();
+        testCopySpeed();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(mask_bench,websocket,beast);
+
+} // detail
+} // websocket
+} // beast
+
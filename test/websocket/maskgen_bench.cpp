@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <beast/websocket/stream.hpp>
+#include <beast/websocket/detail/hybi13.hpp>
+#include <beast/websocket/detail/mask.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+class maskgen_bench_test : public beast::unit_test::suite
+{
+public:
+    static std::size_t constexpr Connections = 20000;
+    static std::size_t constexpr Keys = 50000000;
+
+    using socket_type = boost::asio::ip::tcp::socket;
+
+    template<class Function>
+    void
+    timedTest(std::string const& name,
+        std::size_t n, char const* unit, Function&& f)
+    {
+        using namespace std::chrono;
+        using clock_type = std::chrono::high_resolution_clock;
+        auto const t0 = clock_type::now();
+        for(std::size_t i = 0; i < n; ++i)
+            f();
+        auto const elapsed = duration_cast<
+            duration<double>>(clock_type::now() - t0);
+        log <<
+            std::setw(24) << std::left << name <<
+            std::fixed << std::setprecision(0) <<
+            (n / elapsed.count()) << " " << unit << std::endl;
+    }
+
+    void
+    testSize()
+    {
+        testcase << "Per-stream size";
+        log <<
+            "maskgen_t<std::mt19937>  " <<
+                sizeof(maskgen_t<std::mt19937>) << "\n" <<
+            "maskgen_t<chacha20>      " <<
+                sizeof(maskgen) << " (one per thread)\n" <<
+            "mask_gen                 " <<
+                sizeof(mask_gen) << " (in each stream)\n" <<
+            "stream<socket>           " <<
+                sizeof(stream<socket_type>) << std::endl;
+        pass();
+    }
+
+    void
+    testSetup()
+    {
+        testcase << "Client setup";
+        boost::asio::io_service ios;
+        std::size_t total = 0;
+        // What each connection used to pay: seeding a
+        // Mersenne Twister from std::random_device.
+        timedTest("mt19937 per stream", Connections, "conn/s",
+            [&]
+            {
+                stream<socket_type> ws(ios);
+                maskgen_t<std::mt19937> g;
+                sec_ws_key_type key;
+                make_sec_ws_key(key, g);
+                total += key.size();
+            });
+        timedTest("thread generator", Connections, "conn/s",
+            [&]
+            {
+                stream<socket_type> ws(ios);
+                sec_ws_key_type key;
+                make_sec_ws_key(key, thread_maskgen());
+                total += key.size();
+            });
+        BEAST_EXPECT(total == 2 * Connections * 24);
+    }
+
+    void
+    testSpeed()
+    {
+        testcase << "Key generation";
+        std::uint32_t x = 0;
+        {
+            maskgen_t<std::mt19937> g;
+            timedTest("mt19937", Keys, "keys/s",
+                [&]{ x ^= g(); });
+        }
+        {
+            maskgen g;
+            timedTest("chacha20", Keys, "keys/s",
+                [&]{ x ^= g(); });
+        }
+        log << "checksum " << x << std::endl;
+        pass();
+    }
+
+    void run() override
+    {
+        pass();
+        testSize();
+        testSetup();
+        testSpeed();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(maskgen_bench,websocket,beast);
+
+} // detail
+} // websocket
+} // beast
+
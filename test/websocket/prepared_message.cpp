@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Test that header file is self-contained.
+#include <beast/websocket/prepared_message.hpp>
+
+#include <beast/core/to_string.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <string>
+
+namespace beast {
+namespace websocket {
+
+class prepared_message_test : public beast::unit_test::suite
+{
+public:
+    void testEncode()
+    {
+        using boost::asio::buffer;
+        using boost::asio::buffer_size;
+        prepared_message m{opcode::text, buffer("Hello", 5)};
+        expect(m.code() == opcode::text);
+        expect(m.size() == 7);
+        expect(to_string(m.payload()) == "Hello");
+        expect(to_string(m.p_->buffer()) == "\x81\x05Hello");
+
+        std::string const s(300, '*');
+        prepared_message m2{opcode::binary, buffer(s)};
+        expect(m2.size() == 4 + s.size());
+        expect(to_string(m2.payload()) == s);
+        expect(to_string(m2.p_->buffer()).substr(0, 4) ==
+            std::string("\x82\x7e\x01\x2c", 4));
+
+        prepared_message m3{opcode::binary, buffer("", 0)};
+        expect(m3.size() == 2);
+        expect(buffer_size(m3.payload()) == 0);
+    }
+
+    void testShare()
+    {
+        using boost::asio::buffer;
+        prepared_message m{opcode::text, buffer("*", 1)};
+        auto const m2 = m;
+        expect(m2.p_ == m.p_);
+        try
+        {
+            prepared_message{opcode::ping, buffer("*", 1)};
+            fail();
+        }
+        catch(std::exception const&)
+        {
+            pass();
+        }
+    }
+
+    void run() override
+    {
+        testEncode();
+        testShare();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(prepared_message,websocket,beast);
+
+} // websocket
+} // beast
@@ -11,6 +11,7 @@
 #include "websocket_async_echo_peer.hpp"
 #include "websocket_sync_echo_peer.hpp"
 
+#include <beast/core/flat_streambuf.hpp>
 #include <beast/core/streambuf.hpp>
 #include <beast/core/to_string.hpp>
 #include <beast/test/fail_stream.hpp>
@@ -20,9 +21,36 @@
 #include <boost/asio.hpp>
 #include <boost/asio/spawn.hpp>
 #include <boost/optional.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
 #include <mutex>
+#include <new>
+#include <vector>
 #include <condition_variable>
 
+namespace {
+
+// Number of heap allocations made by the current thread
+thread_local std::size_t thread_allocations = 0;
+
+} // (anon)
+
+void*
+operator new(std::size_t size)
+{
+    ++thread_allocations;
+    if(auto const p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc{};
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
 namespace beast {
 namespace websocket {
 
@@ -153,9 +181,15 @@ public:
         ws.set_option(decorate(identity{}));
         ws.set_option(keep_alive{false});
         ws.set_option(mask_buffer_size(2048));
+        ws.set_option(mask_generator{});
         ws.set_option(message_type{opcode::text});
         ws.set_option(read_buffer_size(8192));
         ws.set_option(read_message_max(1 * 1024 * 1024));
+        ws.set_option(send_queue{65536, 4096, 1024});
+        ws.set_option(send_queue_callback{});
+        ws.set_option(auto_ping{std::chrono::seconds(30),
+            std::chrono::seconds(10)});
+        ws.set_option(auto_ping{});
         try
         {
             ws.set_option(mask_buffer_size(0));
@@ -166,6 +200,15 @@ public:
             pass();
         }
         try
+        {
+            send_queue{65536, 4096, 4096};
+            fail();
+        }
+        catch(std::exception const&)
+        {
+            pass();
+        }
+        try
         {
             message_type{opcode::close};
             fail();
@@ -174,6 +217,60 @@ public:
         {
             pass();
         }
+        try
+        {
+            auto_ping{std::chrono::seconds(0),
+                std::chrono::seconds(10)};
+            fail();
+        }
+        catch(std::exception const&)
+        {
+            pass();
+        }
+        {
+            permessage_deflate pmd;
+            pmd.client_enable = true;
+            pmd.server_max_window_bits = 9;
+            ws.set_option(pmd);
+            pmd.server_max_window_bits = 8;
+            try
+            {
+                ws.set_option(pmd);
+                fail();
+            }
+            catch(std::exception const&)
+            {
+                pass();
+            }
+            pmd.server_max_window_bits = 15;
+            pmd.mem_level = 10;
+            try
+            {
+                ws.set_option(pmd);
+                fail();
+            }
+            catch(std::exception const&)
+            {
+                pass();
+            }
+            // a memory limit lowers the settings
+            pmd.mem_level = 4;
+            pmd.memory_limit = 16 * 1024;
+            ws.set_option(pmd);
+            expect(ws.pmd_opts_.server_max_window_bits == 10);
+            expect(ws.pmd_opts_.client_max_window_bits == 10);
+            expect(ws.pmd_opts_.mem_level == 3);
+            pmd.memory_limit = 10000;
+            try
+            {
+                ws.set_option(pmd);
+                fail();
+            }
+            catch(std::exception const&)
+            {
+                pass();
+            }
+        }
     }
 
     void testAccept()
@@ -433,6 +530,221 @@ public:
         );
     }
 
+    // A string_stream which keeps what is written to it
+    class capture_stream : public test::string_stream
+    {
+        std::string& out_;
+
+    public:
+        capture_stream(boost::asio::io_service& ios,
+                std::string s, std::string& out)
+            : test::string_stream(ios, std::move(s))
+            , out_(out)
+        {
+        }
+
+        template<class ConstBufferSequence>
+        std::size_t
+        write_some(ConstBufferSequence const& buffers)
+        {
+            error_code ec;
+            return write_some(buffers, ec);
+        }
+
+        template<class ConstBufferSequence>
+        std::size_t
+        write_some(ConstBufferSequence const& buffers,
+            error_code&)
+        {
+            using boost::asio::buffer_cast;
+            using boost::asio::buffer_size;
+            for(auto const& b : buffers)
+                out_.append(buffer_cast<char const*>(b),
+                    buffer_size(b));
+            return buffer_size(buffers);
+        }
+
+        template<class ConstBufferSequence, class WriteHandler>
+        typename async_completion<WriteHandler,
+            void(error_code, std::size_t)>::result_type
+        async_write_some(ConstBufferSequence const& buffers,
+            WriteHandler&& handler)
+        {
+            error_code ec;
+            auto const n = write_some(buffers, ec);
+            async_completion<WriteHandler,
+                void(error_code, std::size_t)> completion(handler);
+            get_io_service().post(bind_handler(
+                completion.handler, ec, n));
+            return completion.result.get();
+        }
+    };
+
+    // Adorns messages as the default decorator does,
+    // through the path taken by user decorators.
+    struct default_like
+    {
+        template<class Message>
+        void
+        operator()(Message& m)
+        {
+            detail::default_decorator{}(m);
+        }
+    };
+
+    void testUpgradeWire()
+    {
+        std::string const valid =
+            "GET / HTTP/1.1\r\n"
+            "Host: localhost:80\r\n"
+            "Upgrade: WebSocket\r\n"
+            "Connection: upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n";
+        // Responses written without a decorator are the same
+        // as those built as messages for a decorator.
+        auto const accept =
+            [&](std::string const& req, bool decorated,
+                bool async, bool keep, std::string& out)
+            {
+                boost::asio::io_service ios;
+                stream<capture_stream> ws(ios, req, out);
+                if(decorated)
+                    ws.set_option(decorate(default_like{}));
+                ws.set_option(keep_alive{keep});
+                permessage_deflate pmd;
+                pmd.server_enable = true;
+                ws.set_option(pmd);
+                error_code ec;
+                if(! async)
+                {
+                    ws.accept(ec);
+                    return ec;
+                }
+                ws.async_accept(
+                    [&](error_code const& ev)
+                    {
+                        ec = ev;
+                    });
+                ios.run();
+                return ec;
+            };
+        auto const check =
+            [&](std::string const& req)
+            {
+                for(auto keep : {false, true})
+                {
+                    std::string s0, s1, s2;
+                    auto const ec0 = accept(req, false, false, keep, s0);
+                    auto const ec1 = accept(req, true, false, keep, s1);
+                    auto const ec2 = accept(req, false, true, keep, s2);
+                    expect(! s0.empty());
+                    expect(s0 == s1, s1);
+                    expect(s0 == s2, s2);
+                    expect(ec0 == ec1, ec1.message());
+                    expect(ec0 == ec2, ec2.message());
+                }
+            };
+        check(valid);
+        check(
+            "GET / HTTP/1.1\r\n"
+            "Host: localhost:80\r\n"
+            "Upgrade: WebSocket\r\n"
+            "Connection: keep-alive, upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "Sec-WebSocket-Extensions: permessage-deflate; "
+                "client_max_window_bits\r\n"
+            "\r\n");
+        check(
+            "GET / HTTP/1.0\r\n"
+            "\r\n");
+        check(
+            "GET / HTTP/1.0\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n");
+        check(
+            "POST / HTTP/1.1\r\n"
+            "Host: localhost:80\r\n"
+            "Upgrade: WebSocket\r\n"
+            "Connection: upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n");
+        check(
+            "GET / HTTP/1.1\r\n"
+            "Upgrade: WebSocket\r\n"
+            "Connection: close, upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n");
+        check(
+            "GET / HTTP/1.1\r\n"
+            "Host: localhost:80\r\n"
+            "Upgrade: h2c\r\n"
+            "Connection: upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n");
+        check(
+            "GET / HTTP/1.1\r\n"
+            "Host: localhost:80\r\n"
+            "Upgrade: WebSocket\r\n"
+            "Connection: upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 12\r\n"
+            "\r\n");
+
+        // The same goes for the upgrade request
+        auto const handshake =
+            [&](bool decorated)
+            {
+                std::string out;
+                stream<capture_stream> ws(ios_,
+                    "HTTP/1.1 101 Switching Protocols\r\n\r\n", out);
+                if(decorated)
+                    ws.set_option(decorate(default_like{}));
+                permessage_deflate pmd;
+                pmd.client_enable = true;
+                ws.set_option(pmd);
+                error_code ec;
+                ws.handshake("localhost:80", "/chat?id=1", ec);
+                expect(ec == error::response_failed, ec.message());
+                // the key is random
+                auto const pos = out.find("Sec-WebSocket-Key: ");
+                if(expect(pos != std::string::npos))
+                    out.erase(pos + 19, 24);
+                return out;
+            };
+        auto const req = handshake(false);
+        expect(req == handshake(true), req);
+        expect(req.compare(0, 25, "GET /chat?id=1 HTTP/1.1\r\n") == 0);
+
+        // Only the read buffer is allocated
+        {
+            std::string out;
+            out.reserve(1024);
+            stream<capture_stream> ws(ios_, valid, out);
+            auto const n0 = thread_allocations;
+            ws.accept();
+            auto const n = thread_allocations - n0;
+            expect(n == 1, std::to_string(n) + " allocations");
+        }
+        {
+            std::string out;
+            out.reserve(1024);
+            stream<capture_stream> ws(ios_,
+                "HTTP/1.1 101 Switching Protocols\r\n\r\n", out);
+            auto const n0 = thread_allocations;
+            error_code ec;
+            ws.handshake("localhost:80", "/", ec);
+            auto const n = thread_allocations - n0;
+            expect(ec == error::response_failed, ec.message());
+            expect(n == 1, std::to_string(n) + " allocations");
+        }
+    }
+
     void testMask(endpoint_type const& ep,
         yield_context do_yield)
     {
@@ -1328,6 +1640,1509 @@ public:
         expect(n < limit);
     }
 
+    void testMaskGenerator(endpoint_type const& ep)
+    {
+        std::size_t calls = 0;
+        stream<socket_type> ws(ios_);
+        ws.set_option(mask_generator{
+            [&]
+            {
+                return static_cast<std::uint32_t>(
+                    0x12345678 + calls++);
+            }});
+        ws.next_layer().connect(ep);
+        ws.handshake("localhost", "/");
+        // four calls make the Sec-WebSocket-Key
+        expect(calls == 4);
+        ws.write(sbuf("Hello"));
+        expect(calls == 5);
+        opcode op;
+        streambuf sb;
+        ws.read(op, sb);
+        expect(to_string(sb.data()) == "Hello");
+        ws.close({});
+        error_code ec;
+        ws.read(op, sb, ec);
+        expect(ec == error::closed, ec.message());
+    }
+
+    void testBufferedFrames(endpoint_type const& ep)
+    {
+        // Frames arriving together are decoded
+        // from the stream's read buffer.
+        for(std::size_t size : {0, 4096})
+        {
+            stream<socket_type> ws(ios_);
+            if(size > 0)
+                ws.set_option(read_buffer_size(size));
+            ws.next_layer().connect(ep);
+            ws.handshake("localhost", "/");
+            ws.set_option(message_type(opcode::binary));
+            ws.write(buffer_cat(sbuf("RAW"), cbuf(
+                0x81, 0x03, 'o', 'n', 'e',
+                0x89, 0x01, '*',
+                0x81, 0x03, 't', 'w', 'o')));
+            opcode op;
+            streambuf sb;
+            ws.read(op, sb);
+            expect(to_string(sb.data()) == "one");
+            sb.consume(sb.size());
+            ws.read(op, sb);
+            expect(to_string(sb.data()) == "two");
+            ws.close({});
+            error_code ec;
+            ws.read(op, sb, ec);
+            expect(ec == error::closed, ec.message());
+        }
+    }
+
+    void testBufferedFramesAsync(
+        endpoint_type const& ep, yield_context do_yield)
+    {
+        for(std::size_t size : {0, 4096})
+        {
+            stream<socket_type> ws(ios_);
+            if(size > 0)
+                ws.set_option(read_buffer_size(size));
+            error_code ec;
+            ws.next_layer().connect(ep, ec);
+            if(! expect(! ec, ec.message()))
+                return;
+            ws.async_handshake("localhost", "/", do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            ws.set_option(message_type(opcode::binary));
+            ws.async_write(buffer_cat(sbuf("RAW"), cbuf(
+                0x81, 0x03, 'o', 'n', 'e',
+                0x89, 0x01, '*',
+                0x81, 0x03, 't', 'w', 'o')), do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            opcode op;
+            streambuf sb;
+            ws.async_read(op, sb, do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            expect(to_string(sb.data()) == "one");
+            sb.consume(sb.size());
+            ws.async_read(op, sb, do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            expect(to_string(sb.data()) == "two");
+            ws.async_close({}, do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            ws.async_read(op, sb, do_yield[ec]);
+            expect(ec == error::closed, ec.message());
+        }
+    }
+
+    // Repetitive text, and incompressible binary
+    static
+    std::string
+    make_payload(std::size_t size, bool text)
+    {
+        std::string s;
+        s.reserve(size);
+        if(text)
+        {
+            while(s.size() < size)
+                s.append("{\"id\":" + std::to_string(s.size()) +
+                    ",\"name\":\"example\",\"ok\":true}\n");
+            s.resize(size);
+            return s;
+        }
+        std::uint32_t x = 1;
+        while(s.size() < size)
+        {
+            x = x * 1103515245 + 12345;
+            s.push_back(static_cast<char>(x >> 24));
+        }
+        return s;
+    }
+
+    template<class NextLayer>
+    void
+    echo(stream<NextLayer>& ws, std::string const& s, bool text)
+    {
+        using boost::asio::buffer;
+        ws.set_option(message_type(
+            text ? opcode::text : opcode::binary));
+        ws.write(buffer(s.data(), s.size()));
+        opcode op;
+        streambuf sb;
+        ws.read(op, sb);
+        expect(op == (text ? opcode::text : opcode::binary));
+        expect(to_string(sb.data()) == s);
+    }
+
+    void testPermessageDeflate(endpoint_type const& ep)
+    {
+        using boost::asio::buffer;
+        auto const check =
+            [&](permessage_deflate const& pmd,
+                std::size_t mask_size)
+            {
+                stream<socket_type> ws(ios_);
+                ws.set_option(pmd);
+                ws.set_option(mask_buffer_size(mask_size));
+                ws.next_layer().connect(ep);
+                ws.handshake("localhost", "/");
+                if(! expect(ws.pmd_ != nullptr))
+                    return;
+                echo(ws, "Hello", true);
+                echo(ws, "", true);
+                echo(ws, make_payload(100000, true), true);
+                echo(ws, make_payload(70000, false), false);
+                echo(ws, make_payload(100000, true), true);
+                echo(ws, "", false);
+                {
+                    // fragmented message, one
+                    // compressed frame per call
+                    ws.set_option(message_type(opcode::text));
+                    ws.write_frame(false, sbuf("Hello, "));
+                    ws.write_frame(false, sbuf(""));
+                    ws.write_frame(true, sbuf("World!"));
+                    opcode op;
+                    streambuf sb;
+                    ws.read(op, sb);
+                    expect(to_string(sb.data()) == "Hello, World!");
+                }
+                ws.close({});
+                {
+                    opcode op;
+                    streambuf sb;
+                    error_code ec;
+                    ws.read(op, sb, ec);
+                    expect(ec == error::closed, ec.message());
+                }
+            };
+
+        permessage_deflate pmd;
+        pmd.client_enable = true;
+        check(pmd, 4096);
+        check(pmd, 16);
+        pmd.client_no_context_takeover = true;
+        pmd.server_no_context_takeover = true;
+        check(pmd, 4096);
+        pmd.client_max_window_bits = 9;
+        pmd.server_max_window_bits = 9;
+        pmd.comp_level = 9;
+        pmd.mem_level = 1;
+        check(pmd, 1200);
+        pmd.client_no_context_takeover = false;
+        pmd.server_no_context_takeover = false;
+        pmd.comp_level = 0;
+        check(pmd, 4096);
+
+        // not offered
+        {
+            stream<socket_type> ws(ios_);
+            ws.next_layer().connect(ep);
+            ws.handshake("localhost", "/");
+            expect(ws.pmd_ == nullptr);
+            echo(ws, make_payload(1000, true), true);
+
+            // rsv1 set without the extension
+            ws.set_option(message_type(opcode::binary));
+            ws.write(buffer_cat(sbuf("RAW"),
+                cbuf(0xc1, 0x00)));
+            opcode op;
+            streambuf sb;
+            error_code ec;
+            ws.read(op, sb, ec);
+            expect(ec == error::failed, ec.message());
+        }
+
+        // inflated message size exceeds max
+        {
+            stream<socket_type> ws(ios_);
+            permessage_deflate pmd;
+            pmd.client_enable = true;
+            ws.set_option(pmd);
+            ws.next_layer().connect(ep);
+            ws.handshake("localhost", "/");
+            ws.set_option(read_message_max{1000});
+            std::string const s(100000, '*');
+            ws.write(buffer(s.data(), s.size()));
+            opcode op;
+            streambuf sb;
+            error_code ec;
+            ws.read(op, sb, ec);
+            expect(ec == error::failed, ec.message());
+        }
+    }
+
+    void testPermessageDeflateAsync(
+        endpoint_type const& ep, yield_context do_yield)
+    {
+        using boost::asio::buffer;
+        stream<socket_type> ws(ios_);
+        permessage_deflate pmd;
+        pmd.client_enable = true;
+        ws.set_option(pmd);
+        ws.set_option(mask_buffer_size(100));
+        error_code ec;
+        ws.next_layer().connect(ep, ec);
+        if(! expect(! ec, ec.message()))
+            return;
+        ws.async_handshake("localhost", "/", do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        if(! expect(ws.pmd_ != nullptr))
+            return;
+        for(auto const text : {true, false, true})
+        {
+            auto const s = make_payload(50000, text);
+            ws.set_option(message_type(
+                text ? opcode::text : opcode::binary));
+            ws.async_write(buffer(s.data(), s.size()),
+                do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            opcode op;
+            streambuf sb;
+            ws.async_read(op, sb, do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            expect(to_string(sb.data()) == s);
+        }
+        ws.async_write_frame(false, sbuf("Hello, "), do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        ws.async_write_frame(true, sbuf("World!"), do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        {
+            opcode op;
+            streambuf sb;
+            ws.async_read(op, sb, do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            expect(to_string(sb.data()) == "Hello, World!");
+        }
+        ws.async_close({}, do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        opcode op;
+        streambuf sb;
+        ws.async_read(op, sb, do_yield[ec]);
+        expect(ec == error::closed, ec.message());
+    }
+
+    // Echoes messages between two streams on one thread,
+    // the client writing and the server writing back.
+    class echo_loop
+    {
+        // Provides the memory for the socket operations,
+        // as an application avoiding the heap would.
+        template<class Function>
+        struct handler
+        {
+            detail::op_pool& pool;
+            Function f;
+
+            void
+            operator()(error_code const& ec)
+            {
+                f(ec);
+            }
+
+            friend
+            void*
+            asio_handler_allocate(std::size_t size, handler* h)
+            {
+                return h->pool.allocate(size);
+            }
+
+            friend
+            void
+            asio_handler_deallocate(
+                void* p, std::size_t size, handler* h)
+            {
+                h->pool.deallocate(p, size);
+            }
+        };
+
+        stream<socket_type>& client_;
+        stream<socket_type>& server_;
+        std::string const msg_;
+        detail::op_pool pool_;
+        streambuf cb_{8192};
+        streambuf sb_{8192};
+        opcode op_;
+        std::size_t nc_;
+        std::size_t ns_;
+
+    public:
+        error_code ec;
+
+        echo_loop(stream<socket_type>& client,
+                stream<socket_type>& server, std::string msg)
+            : client_(client)
+            , server_(server)
+            , msg_(std::move(msg))
+        {
+        }
+
+        void
+        start(std::size_t n)
+        {
+            nc_ = n;
+            ns_ = n;
+            serve();
+            send();
+        }
+
+    private:
+        template<class Function>
+        handler<typename std::decay<Function>::type>
+        wrap(Function&& f)
+        {
+            return {pool_, std::forward<Function>(f)};
+        }
+
+        bool
+        ok(error_code const& ec_)
+        {
+            if(ec_ && ! ec)
+                ec = ec_;
+            return ! ec_;
+        }
+
+        void
+        send()
+        {
+            if(nc_ == 0)
+                return;
+            --nc_;
+            client_.async_write(boost::asio::buffer(msg_), wrap(
+                [this](error_code const& ec_)
+                {
+                    if(! ok(ec_))
+                        return;
+                    client_.async_read(op_, cb_, wrap(
+                        [this](error_code const& ec_)
+                        {
+                            if(! ok(ec_))
+                                return;
+                            if(cb_.size() != msg_.size())
+                                ec = error::failed;
+                            cb_.consume(cb_.size());
+                            send();
+                        }));
+                }));
+        }
+
+        void
+        serve()
+        {
+            if(ns_ == 0)
+                return;
+            --ns_;
+            server_.async_read(op_, sb_, wrap(
+                [this](error_code const& ec_)
+                {
+                    if(! ok(ec_))
+                        return;
+                    server_.async_write(sb_.data(), wrap(
+                        [this](error_code const& ec_)
+                        {
+                            if(! ok(ec_))
+                                return;
+                            sb_.consume(sb_.size());
+                            serve();
+                        }));
+                }));
+        }
+    };
+
+    void testSteadyState(bool deflate)
+    {
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        stream<socket_type> client(ios);
+        stream<socket_type> server(ios);
+        if(deflate)
+        {
+            permessage_deflate pmd;
+            pmd.client_enable = true;
+            pmd.server_enable = true;
+            client.set_option(pmd);
+            server.set_option(pmd);
+        }
+        client.next_layer().connect(acceptor.local_endpoint());
+        acceptor.accept(server.next_layer());
+        server.async_accept(
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        client.async_handshake("localhost", "/",
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        ios.run();
+        ios.reset();
+        if(! expect(! deflate || client.pmd_ != nullptr))
+            return;
+        echo_loop loop(client, server,
+            std::string(2000, '*'));
+        loop.start(10);
+        ios.run();
+        ios.reset();
+        auto const allocations = thread_allocations;
+        loop.start(100);
+        ios.run();
+        auto const n = thread_allocations - allocations;
+        expect(! loop.ec, loop.ec.message());
+        expect(n == 0, std::to_string(n) + " allocations");
+    }
+
+    void testSendQueue(endpoint_type const& ep)
+    {
+        stream<socket_type> ws(ios_);
+        ws.next_layer().connect(ep);
+        ws.handshake("localhost", "/");
+        std::vector<bool> marks;
+        ws.set_option(send_queue{1000, 100, 50});
+        ws.set_option(send_queue_callback{
+            [&](bool above)
+            {
+                marks.push_back(above);
+            }});
+        ws.send(sbuf("one"));
+        ws.send(sbuf(""));
+        ws.set_option(message_type(opcode::binary));
+        ws.send(boost::asio::buffer(std::string(200, '*')));
+        expect(marks == std::vector<bool>{true});
+        error_code ec;
+        ws.send(boost::asio::buffer(std::string(1000, '*')), ec);
+        expect(ec == boost::asio::error::no_buffer_space,
+            ec.message());
+        ws.flush();
+        expect(marks == std::vector<bool>{true, false});
+        opcode op;
+        streambuf sb;
+        ws.read(op, sb);
+        expect(op == opcode::text);
+        expect(to_string(sb.data()) == "one");
+        sb.consume(sb.size());
+        ws.read(op, sb);
+        expect(sb.size() == 0);
+        ws.read(op, sb);
+        expect(op == opcode::binary);
+        expect(to_string(sb.data()) == std::string(200, '*'));
+        sb.consume(sb.size());
+        // queued frames cannot interrupt a fragmented message
+        ws.set_option(message_type(opcode::text));
+        ws.write_frame(false, sbuf("frag"));
+        ws.send(sbuf("two"), ec);
+        expect(ec == boost::system::errc::operation_not_permitted,
+            ec.message());
+        ws.flush(ec);
+        expect(ec == boost::system::errc::operation_not_permitted,
+            ec.message());
+        ws.write_frame(true, sbuf("ment"));
+        ws.send(sbuf("two"));
+        ws.flush();
+        ws.read(op, sb);
+        expect(to_string(sb.data()) == "fragment");
+        sb.consume(sb.size());
+        ws.read(op, sb);
+        expect(to_string(sb.data()) == "two");
+        // nothing queued
+        ws.flush();
+        ws.close({});
+        ws.send(sbuf("late"), ec);
+        expect(ec == boost::asio::error::operation_aborted,
+            ec.message());
+        ws.read(op, sb, ec);
+        expect(ec == error::closed, ec.message());
+    }
+
+    void testSendQueueAsync(
+        endpoint_type const& ep, yield_context do_yield)
+    {
+        stream<socket_type> ws(ios_);
+        error_code ec;
+        ws.next_layer().connect(ep, ec);
+        if(! expect(! ec, ec.message()))
+            return;
+        ws.async_handshake("localhost", "/", do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        // nothing queued
+        ws.async_flush(do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        std::size_t const count = 50;
+        std::size_t i = 0;
+        ws.send(boost::asio::buffer(std::to_string(i++)));
+        bool done = false;
+        ws.async_flush(
+            [&](error_code ec)
+            {
+                expect(! ec, ec.message());
+                done = true;
+            });
+        // messages queued during the flush go out with it
+        while(i < count)
+            ws.send(boost::asio::buffer(std::to_string(i++)));
+        opcode op;
+        streambuf sb;
+        for(i = 0; i < count; ++i)
+        {
+            ws.async_read(op, sb, do_yield[ec]);
+            if(! expect(! ec, ec.message()))
+                return;
+            expect(to_string(sb.data()) == std::to_string(i));
+            sb.consume(sb.size());
+        }
+        expect(done);
+        sb.consume(sb.size());
+        // queued frames cannot interrupt a fragmented message
+        ws.async_write_frame(false, sbuf("frag"), do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        ws.async_flush(do_yield[ec]);
+        expect(ec == boost::system::errc::operation_not_permitted,
+            ec.message());
+        ws.async_write_frame(true, sbuf("ment"), do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        ws.async_read(op, sb, do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        expect(to_string(sb.data()) == "fragment");
+        ws.async_close({}, do_yield[ec]);
+        if(! expect(! ec, ec.message()))
+            return;
+        ws.async_read(op, sb, do_yield[ec]);
+        expect(ec == error::closed, ec.message());
+    }
+
+    // Connect a client and server stream over loopback
+    template<class Client, class Server>
+    void
+    connect(boost::asio::io_service& ios,
+        boost::asio::ip::tcp::acceptor& acceptor,
+            Client& client, Server& server)
+    {
+        client.next_layer().connect(acceptor.local_endpoint());
+        acceptor.accept(server.next_layer());
+        server.async_accept(
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        client.async_handshake("localhost", "/",
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        ios.run();
+        ios.reset();
+    }
+
+    void testPreparedMessage()
+    {
+        using boost::asio::buffer;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        stream<socket_type> c1(ios);
+        stream<socket_type> c2(ios);
+        stream<socket_type> s1(ios);
+        stream<socket_type> s2(ios);
+        connect(ios, acceptor, c1, s1);
+        connect(ios, acceptor, c2, s2);
+        std::string const s(300, '*');
+        prepared_message const m{opcode::binary, buffer(s)};
+        opcode op;
+        streambuf sb;
+        error_code ec;
+        {
+            // shared frames interleave with copied ones
+            s1.send(sbuf("first"));
+            s1.send(m);
+            s1.send(sbuf("last"));
+            s1.flush();
+            s2.async_write(m,
+                [&](error_code const& ec)
+                {
+                    expect(! ec, ec.message());
+                });
+            ios.run();
+            ios.reset();
+            c1.read(op, sb);
+            expect(op == opcode::text);
+            expect(to_string(sb.data()) == "first");
+            sb.consume(sb.size());
+            c1.read(op, sb);
+            expect(op == opcode::binary);
+            expect(to_string(sb.data()) == s);
+            sb.consume(sb.size());
+            c1.read(op, sb);
+            expect(op == opcode::text);
+            expect(to_string(sb.data()) == "last");
+            sb.consume(sb.size());
+            c2.read(op, sb);
+            expect(op == opcode::binary);
+            expect(to_string(sb.data()) == s);
+            sb.consume(sb.size());
+        }
+        {
+            // clients mask their copy
+            c1.write(m);
+            s1.read(op, sb);
+            expect(op == opcode::binary);
+            expect(to_string(sb.data()) == s);
+            sb.consume(sb.size());
+        }
+        {
+            // drop a slow consumer
+            s1.set_option(send_queue{200, 100, 50});
+            s1.send(m, ec);
+            expect(ec == boost::asio::error::no_buffer_space,
+                ec.message());
+            s1.send(sbuf("*"));
+            s2.set_option(send_queue{200, 100, 50,
+                queue_overflow::disconnect});
+            s2.send(m, ec);
+            expect(ec == boost::asio::error::no_buffer_space,
+                ec.message());
+            s2.send(sbuf("*"), ec);
+            expect(ec == boost::asio::error::operation_aborted,
+                ec.message());
+            c2.read(op, sb, ec);
+            expect(ec, ec.message());
+        }
+    }
+
+    void testAutoPing()
+    {
+        using std::chrono::milliseconds;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        opcode op;
+        streambuf sb;
+        {
+            // an idle peer which reads answers the pings
+            stream<socket_type> c(ios);
+            stream<socket_type> s(ios);
+            s.set_option(auto_ping{
+                milliseconds(100), milliseconds(300)});
+            c.next_layer().connect(acceptor.local_endpoint());
+            acceptor.accept(s.next_layer());
+            streambuf csb;
+            opcode cop;
+            boost::asio::steady_timer t(ios);
+            s.async_accept(
+                [&](error_code const& ec)
+                {
+                    if(! expect(! ec, ec.message()))
+                        return;
+                    expect(s.ping_rtt() == s.ping_rtt().zero());
+                    s.async_read(op, sb,
+                        [&](error_code const& ec)
+                        {
+                            expect(ec == error::closed, ec.message());
+                            s.next_layer().close();
+                        });
+                    t.expires_from_now(milliseconds(600));
+                    t.async_wait(
+                        [&](error_code const&)
+                        {
+                            expect(s.ping_rtt() > s.ping_rtt().zero());
+                            s.async_close({},
+                                [&](error_code const& ec)
+                                {
+                                    expect(! ec, ec.message());
+                                });
+                        });
+                });
+            c.async_handshake("localhost", "/",
+                [&](error_code const& ec)
+                {
+                    if(! expect(! ec, ec.message()))
+                        return;
+                    c.async_read(cop, csb,
+                        [&](error_code const& ec)
+                        {
+                            expect(ec == error::closed, ec.message());
+                        });
+                });
+            ios.run();
+            ios.reset();
+        }
+        {
+            // automatic pings follow a stream which is moved
+            stream<socket_type> c(ios);
+            stream<socket_type> s0(ios);
+            stream<socket_type> s(ios);
+            s0.set_option(auto_ping{
+                milliseconds(100), milliseconds(300)});
+            c.next_layer().connect(acceptor.local_endpoint());
+            acceptor.accept(s0.next_layer());
+            streambuf csb;
+            opcode cop;
+            boost::asio::steady_timer t(ios);
+            s0.async_accept(
+                [&](error_code const& ec)
+                {
+                    if(! expect(! ec, ec.message()))
+                        return;
+                    stream<socket_type> tmp(std::move(s0));
+                    s = std::move(tmp);
+                    s.async_read(op, sb,
+                        [&](error_code const& ec)
+                        {
+                            expect(ec == error::closed, ec.message());
+                            s.next_layer().close();
+                        });
+                    t.expires_from_now(milliseconds(600));
+                    t.async_wait(
+                        [&](error_code const&)
+                        {
+                            expect(s.ping_rtt() > s.ping_rtt().zero());
+                            s.async_close({},
+                                [&](error_code const& ec)
+                                {
+                                    expect(! ec, ec.message());
+                                });
+                        });
+                });
+            c.async_handshake("localhost", "/",
+                [&](error_code const& ec)
+                {
+                    if(! expect(! ec, ec.message()))
+                        return;
+                    c.async_read(cop, csb,
+                        [&](error_code const& ec)
+                        {
+                            expect(ec == error::closed, ec.message());
+                        });
+                });
+            ios.run();
+            ios.reset();
+        }
+        {
+            // a peer which stops reading is dropped
+            stream<socket_type> c(ios);
+            stream<socket_type> s(ios);
+            s.set_option(auto_ping{
+                milliseconds(100), milliseconds(200)});
+            c.next_layer().connect(acceptor.local_endpoint());
+            acceptor.accept(s.next_layer());
+            bool failed = false;
+            s.async_accept(
+                [&](error_code const& ec)
+                {
+                    if(! expect(! ec, ec.message()))
+                        return;
+                    s.async_read(op, sb,
+                        [&](error_code const& ec)
+                        {
+                            failed = ec != 0;
+                        });
+                });
+            c.async_handshake("localhost", "/",
+                [&](error_code const& ec)
+                {
+                    expect(! ec, ec.message());
+                });
+            ios.run();
+            ios.reset();
+            expect(failed);
+            expect(s.ping_rtt() == s.ping_rtt().zero());
+        }
+    }
+
+    void testReadSome()
+    {
+        using boost::asio::buffer;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        stream<socket_type> c(ios);
+        stream<socket_type> s(ios);
+        connect(ios, acceptor, c, s);
+        {
+            // a large frame arrives in parts, multi-byte
+            // characters may be split between parts
+            std::string m;
+            while(m.size() < 100000)
+                m += "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5";
+            s.set_option(auto_fragment_size{0});
+            s.set_option(message_type{opcode::text});
+            s.async_write(buffer(m),
+                [&](error_code const& ec)
+                {
+                    expect(! ec, ec.message());
+                });
+            frame_info fi;
+            streambuf sb;
+            std::size_t total = 0;
+            std::size_t reads = 0;
+            bool done = false;
+            std::function<void()> next =
+                [&]
+                {
+                    c.async_read_some(fi, sb, 1001,
+                        [&](error_code const& ec, std::size_t n)
+                        {
+                            if(! expect(! ec, ec.message()))
+                                return;
+                            expect(n > 0 && n <= 1001);
+                            expect(fi.op == opcode::text);
+                            ++reads;
+                            total += n;
+                            expect(sb.size() == total);
+                            if(fi.fin)
+                            {
+                                expect(fi.frame_end);
+                                done = true;
+                                return;
+                            }
+                            expect(! fi.frame_end);
+                            next();
+                        });
+                };
+            next();
+            ios.run();
+            ios.reset();
+            expect(done);
+            expect(reads >= m.size() / 1001);
+            expect(to_string(sb.data()) == m);
+        }
+        {
+            // frame and message boundaries are reported
+            s.set_option(message_type{opcode::binary});
+            s.write_frame(false, sbuf("Hello"));
+            s.write_frame(true, sbuf("World"));
+            s.write(sbuf("!"));
+            std::vector<std::string> frames;
+            std::vector<bool> fins;
+            std::string frame;
+            frame_info fi;
+            streambuf sb;
+            while(frames.size() < 3)
+            {
+                auto const n = c.read_some(fi, sb, 3);
+                expect(n <= 3);
+                expect(fi.op == opcode::binary);
+                frame += to_string(sb.data());
+                sb.consume(sb.size());
+                if(fi.frame_end)
+                {
+                    frames.push_back(frame);
+                    fins.push_back(fi.fin);
+                    frame.clear();
+                }
+                else
+                {
+                    expect(! fi.fin);
+                }
+            }
+            expect(frames[0] == "Hello");
+            expect(frames[1] == "World");
+            expect(frames[2] == "!");
+            expect(! fins[0]);
+            expect(fins[1]);
+            expect(fins[2]);
+        }
+    }
+
+    void testReadView()
+    {
+        using boost::asio::buffer;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        {
+            stream<socket_type> c(ios);
+            stream<socket_type> s(ios);
+            connect(ios, acceptor, c, s);
+            // messages arriving together are each seen in place
+            s.set_option(message_type{opcode::text});
+            s.write(sbuf("Hello"));
+            s.write(sbuf("World"));
+            std::string const m(100000, '*');
+            s.set_option(auto_fragment_size{0});
+            s.set_option(message_type{opcode::binary});
+            s.write(buffer(m));
+            std::vector<std::string> v;
+            frame_info fi;
+            std::function<void()> next =
+                [&]
+                {
+                    c.async_read_view(fi,
+                        [&](error_code const& ec,
+                            stream<socket_type>::view_type const& view)
+                        {
+                            if(! expect(! ec, ec.message()))
+                                return;
+                            expect(fi.fin);
+                            expect(fi.op == (v.size() < 2 ?
+                                opcode::text : opcode::binary));
+                            v.push_back(to_string(view));
+                            if(v.size() < 3)
+                                next();
+                        });
+                };
+            next();
+            ios.run();
+            ios.reset();
+            if(expect(v.size() == 3))
+            {
+                expect(v[0] == "Hello");
+                expect(v[1] == "World");
+                expect(v[2] == m);
+            }
+
+            // masked frames are unmasked in place
+            c.write_frame(false, sbuf("Hello, "));
+            c.write_frame(true, sbuf("World!"));
+            auto view = s.read_view(fi);
+            expect(! fi.fin);
+            expect(to_string(view) == "Hello, ");
+            view = s.read_view(fi);
+            expect(fi.fin);
+            expect(to_string(view) == "World!");
+
+            // invalid utf8 fails the connection
+            c.set_option(message_type{opcode::text});
+            c.write(sbuf("\xff"));
+            s.async_read_view(fi,
+                [&](error_code const& ec,
+                    stream<socket_type>::view_type const&)
+                {
+                    expect(ec == error::failed, ec.message());
+                });
+            streambuf sb;
+            c.async_read_frame(fi, sb,
+                [&](error_code const& ec)
+                {
+                    expect(ec == error::closed, ec.message());
+                });
+            ios.run();
+            ios.reset();
+        }
+        {
+            // compressed frames are seen inflated
+            permessage_deflate pmd;
+            pmd.client_enable = true;
+            pmd.server_enable = true;
+            stream<socket_type> c(ios);
+            stream<socket_type> s(ios);
+            c.set_option(pmd);
+            s.set_option(pmd);
+            connect(ios, acceptor, c, s);
+            if(! expect(c.pmd_ != nullptr))
+                return;
+            auto const m = make_payload(50000, true);
+            s.set_option(message_type{opcode::text});
+            s.write(buffer(m));
+            c.write(buffer(m));
+            frame_info fi;
+            expect(to_string(c.read_view(fi)) == m);
+            expect(fi.fin);
+            bool done = false;
+            s.async_read_view(fi,
+                [&](error_code const& ec,
+                    stream<socket_type>::view_type const& view)
+                {
+                    expect(! ec, ec.message());
+                    expect(to_string(view) == m);
+                    done = true;
+                });
+            ios.run();
+            expect(done);
+        }
+    }
+
+    void testReadBatch()
+    {
+        using boost::asio::buffer;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        stream<socket_type> c(ios);
+        stream<socket_type> s(ios);
+        connect(ios, acceptor, c, s);
+        // frames written separately arrive together
+        s.next_layer().set_option(
+            boost::asio::ip::tcp::no_delay{true});
+        std::vector<batch_message> v;
+        streambuf sb;
+        auto const payload =
+            [&](std::size_t i)
+            {
+                return to_string(sb.data()).substr(
+                    v[i].offset, v[i].size);
+            };
+        auto const async_batch =
+            [&](std::size_t max_messages, std::size_t max_bytes,
+                error_code& result)
+            {
+                v.clear();
+                sb.consume(sb.size());
+                std::size_t calls = 0;
+                std::size_t n = 0;
+                c.async_read_batch(v, sb, max_messages, max_bytes,
+                    [&](error_code const& ec, std::size_t n_)
+                    {
+                        ++calls;
+                        result = ec;
+                        n = n_;
+                    });
+                ios.run();
+                ios.reset();
+                expect(calls == 1);
+                expect(n == v.size());
+                return n;
+            };
+        error_code ec;
+
+        // everything buffered up to the control frame,
+        // fragmented messages count once
+        s.set_option(message_type{opcode::text});
+        s.write(sbuf("a"));
+        s.write(sbuf("bb"));
+        s.write_frame(false, sbuf("cc"));
+        s.write_frame(true, sbuf("c"));
+        s.set_option(message_type{opcode::binary});
+        s.write(sbuf(""));
+        s.write(sbuf("dddd"));
+        s.ping({});
+        s.write(sbuf("e"));
+        if(expect(async_batch(100, 1000, ec) == 5))
+        {
+            expect(! ec, ec.message());
+            expect(v[0].op == opcode::text);
+            expect(payload(0) == "a");
+            expect(payload(1) == "bb");
+            expect(payload(2) == "ccc");
+            expect(v[3].op == opcode::binary);
+            expect(v[3].size == 0);
+            expect(payload(4) == "dddd");
+        }
+        if(expect(async_batch(100, 1000, ec) == 1))
+            expect(payload(0) == "e");
+
+        // limits
+        s.write(sbuf("12345"));
+        s.write(sbuf("12345"));
+        s.write(sbuf("12345"));
+        expect(async_batch(2, 1000, ec) == 2);
+        expect(async_batch(100, 8, ec) == 1);
+
+        // the first message is read regardless of size
+        s.write(sbuf("123456789"));
+        expect(async_batch(100, 8, ec) == 1);
+
+        // synchronous
+        s.write(sbuf("x"));
+        s.write(sbuf("y"));
+        v.clear();
+        sb.consume(sb.size());
+        if(expect(c.read_batch(v, sb, 100, 1000) == 2))
+            expect(to_string(sb.data()) == "xy");
+
+        // messages read before an error are kept
+        s.set_option(message_type{opcode::text});
+        s.write(sbuf("ok"));
+        s.write(sbuf("\xff"));
+        // the server answers the close sent by the client
+        opcode op;
+        streambuf sb2;
+        s.async_read(op, sb2,
+            [&](error_code const& ec)
+            {
+                expect(ec == error::closed, ec.message());
+            });
+        expect(async_batch(100, 1000, ec) == 1);
+        expect(ec == error::failed, ec.message());
+        expect(payload(0) == "ok");
+    }
+
+    void testReadReserve()
+    {
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        stream<socket_type> c(ios);
+        stream<socket_type> s(ios);
+        connect(ios, acceptor, c, s);
+        opcode op;
+        streambuf sb;
+        // leave a small block in the buffer
+        s.write(sbuf("Hello"));
+        c.read(op, sb);
+        expect(to_string(sb.data()) == "Hello");
+        sb.consume(sb.size());
+        // a single frame message lands in one buffer
+        s.set_option(auto_fragment_size(0));
+        std::string const m(100000, '*');
+        s.write(boost::asio::buffer(m));
+        c.read(op, sb);
+        expect(to_string(sb.data()) == m);
+        expect(std::distance(
+            sb.data().begin(), sb.data().end()) == 1);
+        sb.consume(sb.size());
+        s.write(boost::asio::buffer(m));
+        c.async_read(op, sb,
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        ios.run();
+        expect(to_string(sb.data()) == m);
+        expect(std::distance(
+            sb.data().begin(), sb.data().end()) == 1);
+    }
+
+    void testReadBuffer()
+    {
+        using boost::asio::buffer;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        stream<socket_type, flat_streambuf> c(ios);
+        stream<socket_type, flat_streambuf> s(ios);
+        connect(ios, acceptor, c, s);
+        std::string const m(10000, '*');
+        s.write(buffer(m));
+        opcode op;
+        streambuf sb;
+        c.read(op, sb);
+        expect(to_string(sb.data()) == m);
+        // the buffer is released between messages
+        expect(c.release_read_buffer());
+        expect(c.stream_.buffer().capacity() == 0);
+        s.write(sbuf("Hello"));
+        frame_info fi;
+        auto const view = c.read_view(fi);
+        expect(std::distance(view.begin(), view.end()) == 1);
+        expect(to_string(view) == "Hello");
+        expect(c.release_read_buffer());
+        expect(c.stream_.buffer().capacity() == 0);
+        c.write(sbuf("World"));
+        sb.consume(sb.size());
+        s.async_read(op, sb,
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        ios.run();
+        expect(to_string(sb.data()) == "World");
+    }
+
+    // Masked text arriving both in the read buffer and directly
+    // from the socket, with characters split between pieces.
+    void testReadPayload()
+    {
+        using boost::asio::buffer;
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        std::string m;
+        while(m.size() < 50000)
+            m += "\xe2\x82\xac*";
+        stream<socket_type> c(ios);
+        stream<socket_type> s(ios);
+        connect(ios, acceptor, c, s);
+        c.set_option(message_type{opcode::text});
+        opcode op;
+        streambuf sb;
+        c.write(buffer(m));
+        s.read(op, sb);
+        expect(op == opcode::text);
+        expect(to_string(sb.data()) == m);
+        sb.consume(sb.size());
+        c.write(buffer(m));
+        s.async_read(op, sb,
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        ios.run();
+        ios.reset();
+        expect(to_string(sb.data()) == m);
+        sb.consume(sb.size());
+        c.write(buffer(m));
+        frame_info fi;
+        do
+        {
+            s.read_some(fi, sb, 1000);
+        }
+        while(! fi.fin);
+        expect(to_string(sb.data()) == m);
+        sb.consume(sb.size());
+        // invalid utf8 at the end of a piece
+        m[4095] = '\xff';
+        c.write(buffer(m));
+        s.async_read(op, sb,
+            [&](error_code const& ec)
+            {
+                expect(ec == error::failed, ec.message());
+            });
+        opcode cop;
+        streambuf csb;
+        c.async_read(cop, csb,
+            [&](error_code const& ec)
+            {
+                expect(ec == error::closed, ec.message());
+            });
+        ios.run();
+        expect(s.reason().code == close_code::none);
+        expect(c.reason().code == close_code::bad_payload);
+    }
+
+    void testWriteFile()
+    {
+        std::FILE* f = std::tmpfile();
+        if(! expect(f != nullptr))
+            return;
+        std::string data;
+        data.reserve(4 * 1024 * 1024);
+        while(data.size() < 4 * 1024 * 1024)
+            data += std::to_string(data.size()) + ",";
+        std::fwrite(data.data(), 1, data.size(), f);
+        std::fflush(f);
+        auto const fd = fileno(f);
+
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        auto const check =
+            [&](stream<socket_type>& from,
+                stream<socket_type>& to)
+            {
+                opcode op;
+                streambuf sb;
+                // sync
+                from.write_file(fd, 7, 100000);
+                to.read(op, sb);
+                expect(op == opcode::binary);
+                expect(to_string(sb.data()) ==
+                    data.substr(7, 100000));
+                sb.consume(sb.size());
+                from.write_file(fd, 0, 0);
+                to.read(op, sb);
+                expect(op == opcode::binary);
+                expect(sb.size() == 0);
+                // finishes a message in progress
+                from.write_frame(false, sbuf("Hello"));
+                from.write_file(fd, 0, 10);
+                to.read(op, sb);
+                expect(to_string(sb.data()) ==
+                    "Hello" + data.substr(0, 10));
+                sb.consume(sb.size());
+                // async, larger than the socket buffers
+                to.set_option(read_message_max(data.size()));
+                from.async_write_file(fd, 0, data.size(),
+                    [&](error_code const& ec)
+                    {
+                        expect(! ec, ec.message());
+                    });
+                to.async_read(op, sb,
+                    [&](error_code const& ec)
+                    {
+                        expect(! ec, ec.message());
+                    });
+                ios.run();
+                ios.reset();
+                expect(sb.size() == data.size());
+                expect(to_string(sb.data()) == data);
+                sb.consume(sb.size());
+                // past the end of the file
+                error_code ec;
+                from.write_file(fd, data.size() - 5, 10, ec);
+                expect(ec == boost::asio::error::eof, ec.message());
+            };
+        {
+            // sendfile, where available
+            stream<socket_type> c(ios);
+            stream<socket_type> s(ios);
+            connect(ios, acceptor, c, s);
+            check(s, c);
+        }
+        {
+            // masked frames are read from the file
+            stream<socket_type> c(ios);
+            stream<socket_type> s(ios);
+            connect(ios, acceptor, c, s);
+            check(c, s);
+        }
+        std::fclose(f);
+    }
+
+    // Ping from the receiving end of a large message,
+    // the pong must not wait for the end of the message.
+    void
+    pingDuringBulk(boost::asio::io_service& ios,
+        stream<socket_type>& sender, stream<socket_type>& receiver)
+    {
+        using clock_type = std::chrono::steady_clock;
+        std::string const s(32 * 1024 * 1024, '*');
+        clock_type::time_point when;
+        clock_type::duration rtt{};
+        bool ponged = false;
+        receiver.set_option(read_message_max(s.size()));
+        receiver.set_option(pong_callback{
+            [&](ping_data const&)
+            {
+                rtt = clock_type::now() - when;
+                ponged = true;
+            }});
+        sender.set_option(message_type{opcode::binary});
+        sender.async_write(boost::asio::buffer(s),
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        opcode sop;
+        streambuf ssb;
+        sender.async_read(sop, ssb,
+            [&](error_code const& ec)
+            {
+                expect(ec == boost::asio::error::operation_aborted,
+                    ec.message());
+            });
+        when = clock_type::now();
+        receiver.async_ping({},
+            [&](error_code const& ec)
+            {
+                expect(! ec, ec.message());
+            });
+        opcode rop;
+        streambuf rsb;
+        receiver.async_read(rop, rsb,
+            [&](error_code const& ec)
+            {
+                if(! expect(! ec, ec.message()))
+                    return;
+                expect(rsb.size() == s.size());
+                expect(ponged);
+                auto const total = clock_type::now() - when;
+                expect(rtt < total);
+                log << "ping rtt " <<
+                    std::chrono::duration_cast<
+                        std::chrono::microseconds>(rtt).count() <<
+                    "us during a " <<
+                    std::chrono::duration_cast<
+                        std::chrono::microseconds>(total).count() <<
+                    "us transfer" << std::endl;
+                error_code ignored;
+                sender.next_layer().cancel(ignored);
+            });
+        ios.run();
+        ios.reset();
+    }
+
+    // An automatic ping which comes due while a large message is
+    // being written goes out between its fragments.
+    void
+    autoPingDuringBulk(boost::asio::io_service& ios,
+        boost::asio::ip::tcp::acceptor& acceptor)
+    {
+        using std::chrono::milliseconds;
+        std::string const s(32 * 1024 * 1024, '*');
+        stream<socket_type> sender(ios);
+        stream<socket_type> receiver(ios);
+        sender.set_option(auto_ping{
+            milliseconds(100), milliseconds(10000)});
+        sender.set_option(message_type{opcode::binary});
+        receiver.set_option(read_message_max(s.size()));
+        receiver.next_layer().connect(acceptor.local_endpoint());
+        acceptor.accept(sender.next_layer());
+        opcode sop;
+        streambuf ssb;
+        sender.async_accept(
+            [&](error_code const& ec)
+            {
+                if(! expect(! ec, ec.message()))
+                    return;
+                sender.async_write(boost::asio::buffer(s),
+                    [&](error_code const& ec)
+                    {
+                        expect(! ec, ec.message());
+                    });
+                sender.async_read(sop, ssb,
+                    [&](error_code const& ec)
+                    {
+                        expect(ec == boost::asio::error::operation_aborted,
+                            ec.message());
+                    });
+            });
+        opcode rop;
+        streambuf rsb;
+        boost::asio::steady_timer t(ios);
+        receiver.async_handshake("localhost", "/",
+            [&](error_code const& ec)
+            {
+                if(! expect(! ec, ec.message()))
+                    return;
+                // stall the transfer until the ping is due
+                t.expires_from_now(milliseconds(300));
+                t.async_wait(
+                    [&](error_code const&)
+                    {
+                        receiver.async_read(rop, rsb,
+                            [&](error_code const& ec)
+                            {
+                                if(! expect(! ec, ec.message()))
+                                    return;
+                                expect(rsb.size() == s.size());
+                                expect(sender.ping_rtt() >
+                                    sender.ping_rtt().zero());
+                                sender.set_option(auto_ping{});
+                                error_code ignored;
+                                sender.next_layer().cancel(ignored);
+                            });
+                    });
+            });
+        ios.run();
+        ios.reset();
+    }
+
+    void testControlDuringBulk()
+    {
+        boost::asio::io_service ios;
+        boost::asio::ip::tcp::acceptor acceptor(ios,
+            endpoint_type{address_type::from_string(
+                "127.0.0.1"), 0});
+        {
+            stream<socket_type> c(ios);
+            stream<socket_type> s(ios);
+            connect(ios, acceptor, c, s);
+            pingDuringBulk(ios, s, c);
+        }
+        {
+            // masked frames
+            stream<socket_type> c(ios);
+            stream<socket_type> s(ios);
+            connect(ios, acceptor, c, s);
+            pingDuringBulk(ios, c, s);
+        }
+        autoPingDuringBulk(ios, acceptor);
+    }
+
     void testAsyncWriteFrame(endpoint_type const& ep)
     {
         for(;;)
@@ -1388,6 +3203,19 @@ public:
             testAccept();
             testBadHandshakes();
             testBadResponses();
+            testUpgradeWire();
+            testSteadyState(false);
+            testSteadyState(true);
+            testPreparedMessage();
+            testAutoPing();
+            testReadSome();
+            testReadView();
+            testReadBatch();
+            testReadReserve();
+            testReadBuffer();
+            testReadPayload();
+            testWriteFile();
+            testControlDuringBulk();
             {
                 sync_echo_peer server(true, any);
                 auto const ep = server.local_endpoint();
@@ -1401,6 +3229,13 @@ public:
                 testSyncClient(ep);
                 testAsyncWriteFrame(ep);
                 yield_to_mf(ep, &stream_test::testAsyncClient);
+                testMaskGenerator(ep);
+                testBufferedFrames(ep);
+                yield_to_mf(ep, &stream_test::testBufferedFramesAsync);
+                testPermessageDeflate(ep);
+                yield_to_mf(ep, &stream_test::testPermessageDeflateAsync);
+                testSendQueue(ep);
+                yield_to_mf(ep, &stream_test::testSendQueueAsync);
             }
             {
                 async_echo_peer server(true, any, 4);
@@ -1408,6 +3243,12 @@ public:
                 testSyncClient(ep);
                 testAsyncWriteFrame(ep);
                 yield_to_mf(ep, &stream_test::testAsyncClient);
+                testBufferedFrames(ep);
+                yield_to_mf(ep, &stream_test::testBufferedFramesAsync);
+                testPermessageDeflate(ep);
+                yield_to_mf(ep, &stream_test::testPermessageDeflateAsync);
+                testSendQueue(ep);
+                yield_to_mf(ep, &stream_test::testSendQueueAsync);
             }
         }
     }
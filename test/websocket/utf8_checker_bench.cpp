@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2013-2016 Vinnie Falco (vinnie dot falco at gmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <beast/websocket/detail/utf8_checker.hpp>
+#include <beast/unit_test/suite.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace beast {
+namespace websocket {
+namespace detail {
+
+class utf8_checker_bench_test : public beast::unit_test::suite
+{
+public:
+    static std::size_t constexpr Size = 1024 * 1024;
+    static std::size_t constexpr Repeat = 200;
+
+    // JSON-like text, entirely ASCII
+    static
+    std::string
+    make_ascii()
+    {
+        std::string s;
+        while(s.size() < Size)
+            s.append(
+                "{\"id\":12345,\"name\":\"example\","
+                "\"tags\":[\"alpha\",\"beta\"],\"ok\":true}\n");
+        s.resize(Size);
+        return s;
+    }
+
+    // Mostly three byte CJK characters with ASCII punctuation
+    static
+    std::string
+    make_cjk()
+    {
+        std::string s;
+        while(s.size() + 32 < Size)
+            s.append(
+                "{\"\xe5\x90\x8d\xe5\x89\x8d\":"
+                "\"\xe4\xb8\xad\xe6\x96\x87\xe6\xb5\x8b\xe8\xaf\x95\"}");
+        return s;
+    }
+
+    // Alternating single ASCII bytes and two byte sequences,
+    // which defeats any attempt to skip ahead in blocks.
+    static
+    std::string
+    make_adversarial()
+    {
+        std::mt19937 g;
+        std::string s;
+        while(s.size() + 4 < Size)
+        {
+            s.push_back(static_cast<char>(0x20 + g() % 0x5f));
+            s.push_back(static_cast<char>(0xc2 + g() % 0x1e));
+            s.push_back(static_cast<char>(0x80 + g() % 0x40));
+        }
+        return s;
+    }
+
+    void
+    timedTest(std::string const& name, std::string const& s)
+    {
+        using namespace std::chrono;
+        using clock_type = std::chrono::high_resolution_clock;
+        utf8_checker c;
+        bool ok = true;
+        auto const t0 = clock_type::now();
+        for(std::size_t i = 0; i < Repeat; ++i)
+        {
+            ok = c.write(s.data(), s.size()) && ok;
+            ok = c.finish() && ok;
+        }
+        auto const elapsed = duration_cast<
+            duration<double>>(clock_type::now() - t0);
+        BEAST_EXPECT(ok);
+        auto const mbps = (double(s.size()) * Repeat) /
+            elapsed.count() / (1024. * 1024);
+        log <<
+            std::setw(12) << std::left << name <<
+            std::fixed << std::setprecision(0) << mbps <<
+            " MB/s" << std::endl;
+    }
+
+    void
+    testSpeed()
+    {
+        testcase << "UTF8 checker speed test, " <<
+            ((Size * Repeat + 512 * 1024) / (1024 * 1024)) << "MB";
+        timedTest("ascii", make_ascii());
+        timedTest("cjk", make_cjk());
+        timedTest("adversarial", make_adversarial());
+    }
+
+    void run() override
+    {
+        pass();
+        testSpeed();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(utf8_checker_bench,websocket,beast);
+
+} // detail
+} // websocket
+} // beast
+
@@ -159,6 +159,11 @@ private:
             auto& d = *d_;
             d.ws.set_option(decorate(identity{}));
             d.ws.set_option(read_message_max(64 * 1024 * 1024));
+            {
+                permessage_deflate pmd;
+                pmd.server_enable = true;
+                d.ws.set_option(pmd);
+            }
             run();
         }
 
@@ -178,6 +178,11 @@ private:
         stream<socket_type> ws(std::move(sock));
         ws.set_option(decorate(identity{}));
         ws.set_option(read_message_max(64 * 1024 * 1024));
+        {
+            permessage_deflate pmd;
+            pmd.server_enable = true;
+            ws.set_option(pmd);
+        }
         error_code ec;
         ws.accept(ec);
         if(ec)